@@ -0,0 +1,248 @@
+#include "background_jobs.h"
+#include "storage_backend.h"
+#include <stdarg.h>
+#include <vector>
+#ifndef NATIVE_SIMULATION
+#include <esp_timer.h>
+#endif
+
+extern bool debugSerial;
+
+static BackgroundJob jobs[MAX_BACKGROUND_JOBS];
+static uint16_t nextJobId = 1;
+static uint8_t nextSlot = 0;        // Round-robin start
+static uint32_t sliceUs = BACKGROUND_JOB_SLICE_US;
+static int64_t sliceDeadlineUs = 0;
+
+static bool jobFinished(const BackgroundJob& job) {
+  return job.state == JOB_DONE || job.state == JOB_FAILED || job.state == JOB_CANCELLED;
+}
+
+static void endJob(BackgroundJob& job, JobState state) {
+  job.state = state;
+  job.finishedMs = millis();
+  if (job.cleanup) job.cleanup(job);
+  job.cleanup = nullptr;
+  job.ctx = nullptr;
+  if (debugSerial) {
+    Serial.printf("[JOB] #%u %s %s after %lu ms (%lu steps, max step %lu us)%s%s\n", job.id, job.name,
+                  backgroundJobStateName(state), job.finishedMs - job.startedMs, (unsigned long)job.steps,
+                  (unsigned long)job.maxStepUs, job.message[0] ? ": " : "", job.message);
+  }
+}
+
+uint16_t backgroundJobStart(const char* name, JobFunction step, void* ctx, JobCleanup cleanup) {
+  // Free slot first, then the slot of the job that finished longest ago
+  int slot = -1;
+  for (uint8_t i = 0; i < MAX_BACKGROUND_JOBS; i++) {
+    if (jobs[i].id == 0) { slot = i; break; }
+  }
+  if (slot < 0) {
+    for (uint8_t i = 0; i < MAX_BACKGROUND_JOBS; i++) {
+      if (jobFinished(jobs[i]) && (slot < 0 || jobs[i].finishedMs < jobs[slot].finishedMs)) slot = i;
+    }
+  }
+  if (slot < 0 || !step) {
+    BackgroundJob rejected;
+    rejected.ctx = ctx;
+    if (cleanup) cleanup(rejected);
+    if (debugSerial) Serial.printf("[JOB] No free slot for %s\n", name);
+    return 0;
+  }
+
+  BackgroundJob& job = jobs[slot];
+  job = BackgroundJob();
+  job.id = nextJobId++;
+  if (nextJobId == 0) nextJobId = 1;
+  job.name = name;
+  job.step = step;
+  job.ctx = ctx;
+  job.cleanup = cleanup;
+  job.queuedMs = millis();
+  if (debugSerial) Serial.printf("[JOB] #%u %s queued\n", job.id, name);
+  return job.id;
+}
+
+// One step of one job; returns false once the job has ended
+static bool stepJob(BackgroundJob& job) {
+  if (job.cancelRequested) {
+    endJob(job, JOB_CANCELLED);
+    return false;
+  }
+  if (job.state == JOB_QUEUED) {
+    job.state = JOB_RUNNING;
+    job.startedMs = millis();
+  }
+  int64_t startUs = esp_timer_get_time();
+  JobStep result = job.step(job);
+  uint32_t stepUs = (uint32_t)(esp_timer_get_time() - startUs);
+  job.steps++;
+  job.busyUs += stepUs;
+  if (stepUs > job.maxStepUs) job.maxStepUs = stepUs;
+
+  if (result == JOB_FINISHED) {
+    endJob(job, JOB_DONE);
+    return false;
+  }
+  if (result == JOB_ERROR) {
+    endJob(job, JOB_FAILED);
+    return false;
+  }
+  return true;
+}
+
+void backgroundJobsService() {
+  if (backgroundJobsActive() == 0) return;
+  sliceDeadlineUs = esp_timer_get_time() + sliceUs;
+
+  // Rounds of one step per job until the slice is used up
+  for (;;) {
+    bool anyRunning = false;
+    for (uint8_t k = 0; k < MAX_BACKGROUND_JOBS; k++) {
+      BackgroundJob& job = jobs[(nextSlot + k) % MAX_BACKGROUND_JOBS];
+      if (job.id == 0 || jobFinished(job)) continue;
+      if (stepJob(job)) anyRunning = true;
+      if (backgroundJobSliceExpired()) break;
+    }
+    if (!anyRunning || backgroundJobSliceExpired()) break;
+  }
+  nextSlot = (nextSlot + 1) % MAX_BACKGROUND_JOBS;
+}
+
+JobState backgroundJobRunNow(uint16_t id) {
+  for (uint8_t i = 0; i < MAX_BACKGROUND_JOBS; i++) {
+    BackgroundJob& job = jobs[i];
+    if (job.id != id) continue;
+    sliceDeadlineUs = INT64_MAX;
+    while (!jobFinished(job) && stepJob(job)) {
+      yield();
+    }
+    return job.state;
+  }
+  return JOB_FAILED;
+}
+
+bool backgroundJobCancel(uint16_t id) {
+  for (uint8_t i = 0; i < MAX_BACKGROUND_JOBS; i++) {
+    if (jobs[i].id == id && !jobFinished(jobs[i])) {
+      jobs[i].cancelRequested = true;
+      return true;
+    }
+  }
+  return false;
+}
+
+const BackgroundJob* backgroundJobGet(uint16_t id) {
+  for (uint8_t i = 0; i < MAX_BACKGROUND_JOBS; i++) {
+    if (jobs[i].id == id && id != 0) return &jobs[i];
+  }
+  return nullptr;
+}
+
+const BackgroundJob* backgroundJobAt(uint8_t slot) {
+  if (slot >= MAX_BACKGROUND_JOBS || jobs[slot].id == 0) return nullptr;
+  return &jobs[slot];
+}
+
+uint8_t backgroundJobsActive() {
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < MAX_BACKGROUND_JOBS; i++) {
+    if (jobs[i].id != 0 && !jobFinished(jobs[i])) n++;
+  }
+  return n;
+}
+
+const char* backgroundJobStateName(JobState state) {
+  switch (state) {
+    case JOB_QUEUED: return "queued";
+    case JOB_RUNNING: return "running";
+    case JOB_DONE: return "done";
+    case JOB_FAILED: return "failed";
+    case JOB_CANCELLED: return "cancelled";
+  }
+  return "unknown";
+}
+
+void backgroundJobSetSlice(uint32_t us) {
+  sliceUs = us < 500 ? 500 : us;
+}
+
+uint32_t backgroundJobSlice() {
+  return sliceUs;
+}
+
+void backgroundJobSetMessage(BackgroundJob& job, const char* fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(job.message, sizeof(job.message), fmt, args);
+  va_end(args);
+}
+
+bool backgroundJobSliceExpired() {
+  return esp_timer_get_time() >= sliceDeadlineUs;
+}
+
+// --- Folder delete ---
+// Depth-first with an explicit stack: each step removes one file or one emptied
+// directory, reopening the directory at the top of the stack to find what's left.
+
+struct DeleteFolderCtx {
+  std::vector<String> stack;
+};
+
+static JobStep deleteFolderStep(BackgroundJob& job) {
+  DeleteFolderCtx& c = *(DeleteFolderCtx*)job.ctx;
+  if (c.stack.empty()) return JOB_FINISHED;
+
+  const String& top = c.stack.back();
+  File dir = storageFS().open(top);
+  if (!dir || !dir.isDirectory()) {
+    backgroundJobSetMessage(job, "Not a folder: %s", top.c_str());
+    return JOB_ERROR;
+  }
+  File entry = dir.openNextFile();
+  if (entry) {
+    char path[128];
+    snprintf(path, sizeof(path), "%s/%s", top.c_str(), entry.name());
+    bool isDir = entry.isDirectory();
+    entry.close();
+    dir.close();
+    if (isDir) {
+      c.stack.push_back(String(path));
+      return JOB_CONTINUE;
+    }
+    if (!storageFS().remove(path)) {
+      backgroundJobSetMessage(job, "Failed to remove %s", path);
+      return JOB_ERROR;
+    }
+    job.done++;
+    return JOB_CONTINUE;
+  }
+  dir.close();
+  if (!storageFS().rmdir(top)) {
+    backgroundJobSetMessage(job, "Failed to remove folder %s", top.c_str());
+    return JOB_ERROR;
+  }
+  job.done++;
+  c.stack.pop_back();
+  if (!c.stack.empty()) return JOB_CONTINUE;
+  backgroundJobSetMessage(job, "%lu entries removed", (unsigned long)job.done);
+  return JOB_FINISHED;
+}
+
+static void deleteFolderCleanup(BackgroundJob& job) {
+  delete (DeleteFolderCtx*)job.ctx;
+}
+
+uint16_t startDeleteFolderJob(const String& path) {
+  if (!storageFS().exists(path)) {
+    if (debugSerial) Serial.printf("[deleteFolderRecursive] WARNING: Path '%s' does not exist.\n", path.c_str());
+    return 0;
+  }
+  DeleteFolderCtx* ctx = new DeleteFolderCtx();
+  ctx->stack.push_back(path);
+  uint16_t id = backgroundJobStart("delete_folder", deleteFolderStep, ctx, deleteFolderCleanup);
+  BackgroundJob* job = (BackgroundJob*)backgroundJobGet(id);
+  if (job) backgroundJobSetMessage(*job, "%s", path.c_str());
+  return id;
+}
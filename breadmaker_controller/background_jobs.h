@@ -0,0 +1,78 @@
+#pragma once
+#include <Arduino.h>
+
+// Sliced background jobs for long maintenance operations (folder deletes, the
+// programs.json split, activity-log truncation).
+// A job is a step function that does one bounded piece of work per call and keeps
+// its position in the job (pc) and its own context, protothread style: locals don't
+// survive a JOB_YIELD(), so anything that must is kept in the context.
+// backgroundJobsService(), called once per loop() pass, steps jobs round-robin until
+// the per-pass slice is used up, so a job can't hold loop() for more than about one
+// slice plus one step.
+//
+//   static JobStep myStep(BackgroundJob& job) {
+//     MyCtx& c = *(MyCtx*)job.ctx;
+//     JOB_BEGIN(job);
+//     while (c.remaining) { ...one unit...; job.done++; JOB_YIELD(job); }
+//     JOB_END(job);
+//   }
+
+constexpr uint8_t MAX_BACKGROUND_JOBS = 6;          // Finished jobs stay listed until their slot is reused
+constexpr uint32_t BACKGROUND_JOB_SLICE_US = 5000;  // Default per-pass time slice (all jobs)
+
+enum JobState : uint8_t { JOB_QUEUED, JOB_RUNNING, JOB_DONE, JOB_FAILED, JOB_CANCELLED };
+enum JobStep : uint8_t { JOB_CONTINUE, JOB_FINISHED, JOB_ERROR };
+
+struct BackgroundJob;
+typedef JobStep (*JobFunction)(BackgroundJob& job);
+typedef void (*JobCleanup)(BackgroundJob& job);
+
+struct BackgroundJob {
+  uint16_t id = 0;                // 0 = free slot
+  const char* name = "";
+  JobState state = JOB_QUEUED;
+  uint16_t pc = 0;                // Resume point (JOB_BEGIN/JOB_YIELD)
+  JobFunction step = nullptr;
+  JobCleanup cleanup = nullptr;   // Runs once when the job ends for any reason (frees ctx)
+  void* ctx = nullptr;
+  uint32_t done = 0;              // Progress: done of total units (total 0 = unknown)
+  uint32_t total = 0;
+  char message[64] = "";
+  volatile bool cancelRequested = false;
+  unsigned long queuedMs = 0;
+  unsigned long startedMs = 0;
+  unsigned long finishedMs = 0;
+  uint32_t steps = 0;
+  uint32_t maxStepUs = 0;
+  uint64_t busyUs = 0;            // Time spent in step() - what the job cost loop()
+};
+
+#define JOB_BEGIN(job) switch ((job).pc) { case 0:
+#define JOB_YIELD(job) do { (job).pc = __LINE__; return JOB_CONTINUE; case __LINE__:; } while (0)
+#define JOB_END(job) } return JOB_FINISHED
+
+// Queues a job; ctx is owned by the job and released through cleanup. Returns its id,
+// or 0 if every slot holds an unfinished job (cleanup is called on ctx in that case).
+uint16_t backgroundJobStart(const char* name, JobFunction step, void* ctx, JobCleanup cleanup);
+
+// Steps jobs round-robin within the slice; call once per loop() pass
+void backgroundJobsService();
+
+// Runs one job to completion inside the caller (boot-time use, before loop() starts)
+JobState backgroundJobRunNow(uint16_t id);
+
+bool backgroundJobCancel(uint16_t id);       // Honoured at the job's next step
+const BackgroundJob* backgroundJobGet(uint16_t id);
+const BackgroundJob* backgroundJobAt(uint8_t slot);   // For listing; nullptr for free slots
+uint8_t backgroundJobsActive();
+const char* backgroundJobStateName(JobState state);
+
+void backgroundJobSetSlice(uint32_t sliceUs);
+uint32_t backgroundJobSlice();
+
+// Helpers for step functions
+void backgroundJobSetMessage(BackgroundJob& job, const char* fmt, ...);
+bool backgroundJobSliceExpired();   // True once the current pass's slice is used up
+
+// Built-in jobs
+uint16_t startDeleteFolderJob(const String& path);
@@ -22,7 +22,6 @@ FEATURES:
 #include <WiFi.h>          // ESP32 WiFi library
 #include <ESPmDNS.h>       // ESP32 mDNS library
 #include <ArduinoOTA.h>    // ESP32 OTA updates
-#include <FFat.h>      // ESP32 FATFS support for 16MB
 #include <WebServer.h>     // Standard ESP32 WebServer (stable alternative to AsyncWebServer)
 #include <PID_v1.h>
 #include <EEPROM.h>
@@ -39,6 +38,23 @@ FEATURES:
 #include "missing_stubs.h"    // Missing function implementations
 // #include "capacitive_buttons.h" // REMOVED: Capacitive touch buttons (GPIO conflicts)
 #include "calibration.h"
+#include "rtd_sampler.h"     // Oversampled RTD acquisition
+#include "sensor_service.h"  // Shared sensor reading and health
+#include "temperature_estimator.h" // Kalman temperature estimator
+#include "thermal_monitor.h"  // Predictive heater/runaway fault detection
+#include "enhanced_motor_control.h" // Hardware-timed mix pattern pulses
+#include "control_task.h"   // Control path on its own core
+#include "control_commands.h" // Web command queue into the control tick
+#include "file_transfer.h"   // Budgeted, incremental file responses
+#include "background_jobs.h" // Sliced maintenance jobs (folder delete, log truncation, program split)
+#include "persistence_manager.h" // Deferred, coalescing flash writes
+#include "storage_backend.h" // Filesystem backend (FFat, LittleFS or host directory)
+#include "storage_stats.h"   // Flash write accounting
+#include "web_routes.h"      // Route table with per-route metrics
+#include "mqtt_publisher.h"  // Change-driven MQTT state for Home Assistant
+#include "telemetry_stream.h" // Binary telemetry frames over Serial
+#include "debug_log.h"       // Levelled, rate-limited debug log drained from loop()
+#include "trace_recorder.h"  // Span ring for /api/trace
 #include "programs_manager.h"
 #include "wifi_manager.h"
 #include "outputs_manager.h"
@@ -50,7 +66,7 @@ FEATURES:
 #define FIRMWARE_BUILD_DATE __DATE__ " " __TIME__
 
 // --- Web server---
-WebServer server(80); // Standard ESP32 WebServer (stable, no crashes)
+RoutedWebServer server(80); // Standard ESP32 WebServer, dispatched through the route table (web_routes.h)
 
 // --- Temperature safety flags ---
 bool thermalRunawayDetected = false;
@@ -110,6 +126,9 @@ unsigned long startupTime = 0;           // Time when system started (millis())
 // --- Function prototypes ---
 void loadSettings();
 void saveSettings();
+void serializeSettingsJson(Print& f);
+void serializeResumeStateJson(Print& f);
+extern const char* RESUME_FILE;
 void loadPIDProfiles();
 void savePIDProfiles();
 PIDProfile* findProfileForTemperature(float temperature);
@@ -135,32 +154,9 @@ bool isStartupDelayComplete();
 
 // --- Delete Folder API endpoint ---
 // Recursively deletes a folder and all its contents from the FFat filesystem.
+// Runs as a background job (one file per step) so large folders don't stall loop().
 void deleteFolderRecursive(const String& path) {
-  if (!FFat.exists(path)) {
-    if (debugSerial) Serial.printf("[deleteFolderRecursive] WARNING: Path '%s' does not exist.\n", path.c_str());
-    return;
-  }
-  File root = FFat.open(path);
-  if (root && root.isDirectory()) {
-    File file = root.openNextFile();
-    while (file) {
-      // Use pre-allocated buffer to avoid String concatenation
-      char filePath[128];
-      snprintf(filePath, sizeof(filePath), "%s/%s", path.c_str(), file.name());
-      
-      if (file.isDirectory()) {
-        deleteFolderRecursive(String(filePath));
-      } else {
-        if (!FFat.remove(filePath) && debugSerial) {
-          Serial.printf("[deleteFolderRecursive] ERROR: Failed to remove file '%s'\n", filePath);
-        }
-      }
-      file = root.openNextFile();
-    }
-  }
-  if (!FFat.rmdir(path) && debugSerial) {
-    Serial.printf("[deleteFolderRecursive] ERROR: Failed to remove directory '%s'\n", path.c_str());
-  }
+  startDeleteFolderJob(path);
 }
 
 // Helper function to send a JSON error response (WebServer compatible)
@@ -240,20 +236,31 @@ void initialState(){
   });
   */
   
-  // Initialize FFat with better error handling
-  Serial.println(F("[setup] Initializing FFat filesystem..."));
-  if (!FFat.begin(false)) {
-    Serial.println(F("[setup] FFat mount failed, attempting format..."));
-    if (!FFat.begin(true)) {
-      Serial.println(F("[setup] FFat format failed! Continuing without filesystem."));
-      // Don't halt - continue without FFat for debugging
+  // Initialize the filesystem backend with better error handling
+  Serial.printf("[setup] Initializing %s filesystem...\n", storageBackendName());
+  if (!storageBegin(false)) {
+    Serial.println(F("[setup] Filesystem mount failed, attempting format..."));
+    if (!storageBegin(true)) {
+      Serial.println(F("[setup] Filesystem format failed! Continuing without filesystem."));
+      // Don't halt - continue without the filesystem for debugging
     } else {
-      Serial.println(F("[setup] FFat formatted and mounted successfully."));
+      Serial.println(F("[setup] Filesystem formatted and mounted successfully."));
     }
   } else {
-    Serial.println(F("[setup] FFat mounted successfully."));
+    Serial.println(F("[setup] Filesystem mounted successfully."));
   }
-  Serial.println(F("[setup] FFat mounted."));
+  Serial.println(F("[setup] Filesystem mounted."));
+  
+  // Flash write counters carried over from previous boots
+  storageStatsLoad();
+  
+  // Deferred, coalescing writes for everything persisted (before anything can save)
+  persistRegister(PERSIST_RESUME, RESUME_FILE, serializeResumeStateJson, 2000);
+  persistRegister(PERSIST_SETTINGS, SETTINGS_FILE, serializeSettingsJson, 1000);
+  persistRegister(PERSIST_PID_PROFILES, "/pid-profiles.json", serializePIDProfilesJson, 1000);
+  persistRegister(PERSIST_CALIBRATION, CALIB_FILE, serializeCalibrationJson, 500);
+  persistRegister(PERSIST_ACTIVITY_LOG, ACTIVITY_LOG_FILE, serializeActivityLogBuffer, 5000, true);
+  persistRegister(PERSIST_STORAGE_STATS, STORAGE_STATS_FILE, serializeStorageStatsJson, 600000);
   
   // Initialize activity logging after FFat is ready
   Serial.println(F("[setup] Initializing activity logging..."));
@@ -276,6 +283,8 @@ void initialState(){
   loadCalibration();
   Serial.println(F("[setup] Calibration loaded."));
   
+  sensorServiceInit(); // Prime the RTD pipeline and publish the first reading before anyone reads temperature
+  
   // Take some initial temperature samples before fermentation tracking
   Serial.println(F("[setup] Taking initial temperature samples..."));
   for (int i = 0; i < 5; i++) {
@@ -319,7 +328,7 @@ void initializeWiFi() {
     
     // Check if wifi.json exists
     Serial.println(F("[wifi] Checking for WiFi configuration..."));
-    File wf = FFat.open("/wifi.json", "r");
+    File wf = storageFS().open("/wifi.json", "r");
     if (!wf) {
       Serial.println(F("[wifi] No WiFi config found. Starting WiFiManager captive portal."));
       Serial.println(F("[wifi] Note: Web server temporarily disabled to save memory during WiFi setup"));
@@ -331,6 +340,7 @@ void initializeWiFi() {
       // After WiFi setup, we could restart to enable full web server
       Serial.println(F("[wifi] Restarting to enable full web interface..."));
       delay(2000);
+      persistFlushAll();
       ESP.restart();
       return;
     } else {
@@ -424,6 +434,7 @@ void setup() {
   
   // Initialize WebServer AFTER WiFi is stable to prevent LWIP crashes
   Serial.println(F("[setup] WiFi initialization complete, now starting WebServer..."));
+  controlCommandsBegin(applyControlCommand, flushResumeState);  // Before any handler can submit
   registerWebEndpoints(server);  // Now compatible with standard WebServer
   // server.serveStatic("/", FFat, "/");  // Static files handled by onNotFound in registerWebEndpoints
   // Note: server.begin() is now called inside registerWebEndpoints()
@@ -479,41 +490,25 @@ void setup() {
   if (time(nullptr) < 100000 && debugSerial) {
     Serial.println("[setup] WARNING: NTP time sync timed out after 15 seconds.");
   }
+  
+  // --- Move the control path onto its own core (falls back to loop() on failure) ---
+  controlTaskBegin(controlTick);
 }
 
 const char* RESUME_FILE = "/resume.json";
-unsigned long lastResumeSave = 0;
 
 // Saves the current breadmaker state (program, stage, timing, etc.) to FFat for resume after reboot.
-// Optimized for minimal memory usage and reduced performance impact during critical operations.
+// Marks it dirty for the persistence worker: saves within 2 s of each other (stage
+// advance, periodic save) coalesce into one write, and the last state is always the
+// one written - the old throttle dropped the later saves instead.
 void saveResumeState() {
-  // Throttle saves: minimum 2 seconds between saves to reduce wear and memory pressure
-  unsigned long now = millis();
-  if (lastResumeSave > 0 && (now - lastResumeSave) < 2000) {
-    return; // Skip this save to reduce load
-  }
-  
-  // FIXED: Don't skip saves during temperature control - this is critical for resume functionality!
-  // The original code was preventing saves during active programs, breaking resume after OTA updates.
-  // Instead, we'll save regularly but with throttling to reduce filesystem pressure.
-  
-  lastResumeSave = now;
-  
-  // Open file with minimal error handling to reduce code size
-  File f = FFat.open(RESUME_FILE, "w");
-  if (!f) {
-    if (debugSerial) Serial.println(F("[saveResumeState] ERROR: Failed to open resume file"));
-    return;
-  }
-  
-  // Stream directly to file - no intermediate buffers
-  serializeResumeStateJson(f);
-  f.close();
-  
-  // Optional: Track save performance for debugging
-  if (debugSerial && ((now - lastResumeSave) > 100)) {
-    Serial.printf("[saveResumeState] Save took %lums\n", now - lastResumeSave);
-  }
+  persistMarkDirty(PERSIST_RESUME);
+}
+
+// Saves on the next loop() pass, skipping the coalescing window - used after queued
+// web commands (stage changes, pause/resume) so a reboot right after one can't lose it.
+void flushResumeState() {
+  persistMarkDirty(PERSIST_RESUME, true);
 }
 
 // Helper to serialize resume state as JSON using memory-efficient streaming
@@ -589,13 +584,13 @@ void serializeResumeStateJson(Print& f) {
 
 // Removes the saved resume state file from FFat.
 void clearResumeState() {
-  FFat.remove(RESUME_FILE);
+  storageFS().remove(RESUME_FILE);
 }
 
 // Loads the breadmaker's previous state from FFat and restores program, stage, and timing.
 // Optimized for memory efficiency and better error handling.
 void loadResumeState() {
-  File f = FFat.open(RESUME_FILE, "r");
+  File f = storageFS().open(RESUME_FILE, "r");
   if (!f) return;
   
   // Use a smaller buffer since resume files are typically <400 bytes
@@ -956,6 +951,14 @@ void handleManualMode();
 void handleScheduledStart(bool &scheduledStartTriggered);
 // Handles the main custom stage logic for the breadmaker program.
 void handleCustomStages(bool &stageJustAdvanced);
+// Control path, run by the control task or by loop() as a fallback.
+void controlTick();
+void flushResumeState();
+void runControlSampling();
+void runControlStep();
+
+// Set when an emergency shutdown is raised on the control core; loop() shows it
+static volatile bool displayErrorPending = false;
 
 // Low-impact safety monitoring with emergency shutdown capabilities
 void performSafetyChecks() {
@@ -982,35 +985,37 @@ void performSafetyChecks() {
   
   double currentTemp = getAveragedTemperature();
   
+  // Sensor validity comes from the sensor service - the single source of truth for sensor faults
+  const SensorReading& reading = sensorGetReading();
+  safetySystem.temperatureRate = getTemperatureRate();
+  
   // --- Critical Temperature Checks ---
   
-  // Emergency temperature shutdown (immediate)
-  if (safetySystem.isEmergencyShutdownNeeded(currentTemp)) {
+  // Emergency temperature shutdown (immediate) - latest unsmoothed reading so EMA lag can't delay it
+  if (reading.health == SENSOR_VALID && safetySystem.isEmergencyShutdownNeeded(reading.temperature)) {
     triggerEmergencyShutdown(F("Emergency: Temperature exceeds 240°C"));
     return;
   }
   
   // Temperature sensor validation
-  if (!safetySystem.isTemperatureValid(currentTemp)) {
+  if (reading.health == SENSOR_FAULT) {
     safetySystem.invalidTempCount++;
-    if (currentTemp == 0.0) {
-      safetySystem.zeroTempCount++;
-    }
+    safetySystem.temperatureValid = false;
     
     // Multiple consecutive invalid readings trigger shutdown
-    if (safetySystem.invalidTempCount >= SafetySystem::MAX_INVALID_TEMP || 
-        safetySystem.zeroTempCount >= SafetySystem::MAX_ZERO_TEMP) {
+    if (safetySystem.invalidTempCount >= SafetySystem::MAX_INVALID_TEMP) {
       triggerEmergencyShutdown(F("Shutdown: Temperature sensor fault detected"));
       return;
     }
-  } else {
+  } else if (reading.health == SENSOR_VALID) {
     // Valid temperature - reset counters and update tracking
     safetySystem.invalidTempCount = 0;
     safetySystem.zeroTempCount = 0;
-    safetySystem.lastValidTempTime = now;
-    safetySystem.lastValidTemperature = currentTemp;
+    safetySystem.lastValidTempTime = reading.timestampMs;
+    safetySystem.lastValidTemperature = reading.temperature;
     safetySystem.temperatureValid = true;
   }
+  // SENSOR_STALE: lastValidTempTime stops advancing, so the timeout below catches a dead sampler
   
   // Temperature timeout check (no valid readings for too long)
   if (now - safetySystem.lastValidTempTime > SafetySystem::TEMP_TIMEOUT_MS) {
@@ -1024,6 +1029,45 @@ void performSafetyChecks() {
     return;
   }
   
+  // --- Predictive Thermal Monitoring ---
+  
+  // Monitor state from before an emergency shutdown is stale once the shutdown is cleared
+  if (thermalMonitor.stats.fault != THERMAL_OK) {
+    thermalMonitor.clearFault();
+  }
+  if (reading.health == SENSOR_VALID) {
+    ThermalSample sample;
+    sample.timeSec = now / 1000.0f;
+    sample.temperature = reading.temperature;
+    sample.heaterOnSeconds = getHeaterOnTimeMs() / 1000.0f;
+    sample.rawAdc = reading.rawAdc;
+    sample.sequence = reading.sequence;
+    sample.setpoint = pid.Setpoint;
+    ThermalFault fault = thermalMonitor.update(sample);
+    if (fault != THERMAL_OK && debugSerial) {
+      const ThermalMonitorStats& ts = thermalMonitor.stats;
+      Serial.printf("[THERMAL] %s: gain=%.4f slope=%.4f duty=%.2f cusum=%.1f/%.1f latency=%.0fs\n",
+                    thermalFaultName(fault), ts.heaterGain, ts.slope, ts.dutyMean,
+                    ts.cusumNoRise, ts.cusumRunaway, ts.lastDecisionLatency);
+    }
+    switch (fault) {
+      case THERMAL_HEATER_NO_RISE:
+        triggerEmergencyShutdown(F("Shutdown: Heater failure (no temperature response)"));
+        return;
+      case THERMAL_RUNAWAY:
+        triggerEmergencyShutdown(F("Emergency: Temperature rising with heater off"));
+        return;
+      case THERMAL_PREDICTED_OVERTEMP:
+        triggerEmergencyShutdown(F("Emergency: Predicted over-temperature"));
+        return;
+      case THERMAL_STUCK_SENSOR:
+        triggerEmergencyShutdown(F("Shutdown: Temperature sensor stuck"));
+        return;
+      default:
+        break;
+    }
+  }
+  
   // --- Heating Effectiveness Monitoring ---
   
   // Check if heater is running
@@ -1111,9 +1155,14 @@ void triggerEmergencyShutdown(const String& reason) {
   Serial.print(F("[EMERGENCY SHUTDOWN] "));
   Serial.println(reason);
   logEmergencyShutdown(reason, readTemperature());
+  persistExpedite();   // The stopped state and anything else pending go out on the next pass
   
-  // Update display to show shutdown reason
-  displayError(reason);
+  // Update display to show shutdown reason (loop() draws it when raised on the control core)
+  if (onControlCore()) {
+    displayErrorPending = true;
+  } else {
+    displayError(reason);
+  }
   
   // Force immediate output update
   setHeater(outputStates.heater);
@@ -1125,8 +1174,11 @@ void triggerEmergencyShutdown(const String& reason) {
 // Arduino main loop. Handles temperature sampling, fermentation, manual mode, scheduled start,
 // and custom stage logic for breadmaker operation.
 void loop() {
+  TraceSpan pass(TRACE_LOOP, "loop");  // Recorded only when the pass is slow
+  
   // --- Handle deferred settings save ---
   if (pendingSettingsSaveTime > 0 && millis() >= pendingSettingsSaveTime) {
+    TraceSpan span(TRACE_LOOP, "settings save");
     pendingSettingsSaveTime = 0;
     if (debugSerial) Serial.println("[DEBUG] Executing deferred settings save...");
     
@@ -1145,26 +1197,43 @@ void loop() {
     }
   }
   
-  // --- Safety monitoring (low-impact, every 1 second) ---
-  safetySystem.loopStartTime = micros();
-  performSafetyChecks();
-  checkHeaterWatchdog(); // CRITICAL: Check heater safety watchdog every loop
+  // Without the control task, sampling and safety share this loop with the web server
+  if (!controlTaskRunning()) {
+    safetySystem.loopStartTime = micros();
+    TraceSpan span(TRACE_CONTROL, "control sampling");
+    runControlSampling();
+  }
   
   updatePerformanceMetrics(); // Track performance for Home Assistant endpoint
-  updateTemperatureSampling();
   // REMOVED: updateFermentationFactor(); // Redundant - fermentation handled in updateFermentationTiming()
   updateBuzzerTone();
-  updateDisplay(); // Update TFT display
-  otaManagerLoop(); // Handle OTA updates via OTA manager
-  server.handleClient(); // Handle web server requests - CRITICAL for web interface!
+  if (displayErrorPending) {
+    // Raised on the control core; the display belongs to this one
+    String reason;
+    {
+      ControlLockGuard guard;
+      reason = safetySystem.shutdownReason;
+      displayErrorPending = false;
+    }
+    displayError(reason);
+  }
+  { TraceSpan span(TRACE_LOOP, "display"); updateDisplay(); } // Update TFT display
+  { TraceSpan span(TRACE_LOOP, "ota"); otaManagerLoop(); } // Handle OTA updates via OTA manager
+  { TraceSpan span(TRACE_LOOP, "http"); server.handleClient(); } // Handle web server requests - CRITICAL for web interface!
+  { TraceSpan span(TRACE_LOOP, "file transfers"); fileTransfersService(); } // Next slice of any file downloads (bounded per pass)
+  { TraceSpan span(TRACE_LOOP, "background jobs"); backgroundJobsService(); } // Next slice of any maintenance jobs (bounded per pass)
+  { TraceSpan span(TRACE_LOOP, "persist"); persistService(); } // At most one deferred flash write per pass
+  { TraceSpan span(TRACE_LOOP, "mqtt"); mqttLoop(); } // Publish changed state to the MQTT broker, serve HA commands
+  logService(); // Drain queued debug log lines as the UART has room
   // REMOVED: capacitiveButtonsUpdate(); // Capacitive touch buttons disabled due to GPIO boot conflicts
   checkSerialWifiConfig(); // Check for serial WiFi configuration commands
   
   // WiFiManager handles DNS internally, no need for manual processing
   
-  double temp = getAveragedTemperature();
-  static bool stageJustAdvanced = false;
-  static bool scheduledStartTriggered = false;
+  if (controlTaskRunning()) {
+    yield();
+    return;
+  }
   
   // Rate limiting for main loop - IMPROVED for heating responsiveness
   static unsigned long lastMainLoopUpdate = 0;
@@ -1184,7 +1253,68 @@ void loop() {
     return;
   }
   lastMainLoopUpdate = nowMs;
+  
+  {
+    TraceSpan span(TRACE_CONTROL, "control step");
+    runControlStep();
+  }
+  yield();
+  // Removed final delay - timing now handled by rate limiting above for better responsiveness
+}
 
+// Control task tick (every CONTROL_TICK_MS, control lock held). Applies queued
+// web commands, then runs the same
+// sampling, safety and program steps loop() runs when the task is unavailable,
+// then publishes the state the display and status readers need.
+void controlTick() {
+  safetySystem.loopStartTime = micros();
+  controlCommandsProcess();  // Web commands apply at the tick boundary, in submission order
+  runControlSampling();
+  runControlStep();
+  
+  static uint32_t tickCount = 0;
+  ControlSnapshot snap;
+  snap.tick = ++tickCount;
+  snap.atMs = millis();
+  snap.temperature = getAveragedTemperature();
+  snap.sensorTemperature = readTemperature();
+  snap.setpoint = pid.Setpoint;
+  snap.pidOutput = pid.Output;
+  snap.running = programState.isRunning;
+  snap.manualMode = programState.manualMode;
+  snap.heater = outputStates.heater;
+  snap.motor = outputStates.motor;
+  snap.light = outputStates.light;
+  snap.buzzer = outputStates.buzzer;
+  snap.stageIdx = programState.customStageIdx;
+  snap.mixIdx = programState.customMixIdx;
+  snap.stageStart = programState.customStageStart;
+  controlSnapshotPublish(snap);
+  telemetrySample();
+}
+
+// Sensor sampling and safety: every control tick (or every loop() pass without the task)
+void runControlSampling() {
+  // --- Safety monitoring (low-impact, every 1 second) ---
+  performSafetyChecks();
+  checkHeaterWatchdog(); // CRITICAL: Check heater safety watchdog every loop
+  
+  // Sole owner of RTD sampling; publishes a reading + health every output interval.
+  // Each new reading also steps the Kalman estimator with the current heater state.
+  if (sensorServiceUpdate()) {
+    const SensorReading& reading = sensorGetReading();
+    temperatureEstimatorUpdate(reading.temperature, reading.health == SENSOR_VALID, outputStates.heater, reading.timestampMs);
+  }
+  updateTemperatureSampling();
+}
+
+// Program execution: PID profile, fermentation timing, resume saves, manual mode,
+// scheduled start and custom stages
+void runControlStep() {
+  static bool stageJustAdvanced = false;
+  static bool scheduledStartTriggered = false;
+  unsigned long nowMs = millis();
+  
   // Check and switch PID profile based on temperature
   checkAndSwitchPIDProfile();
 
@@ -1195,7 +1325,7 @@ void loop() {
   if (programState.isRunning && (nowMs - lastResumeStateSave) >= 30000) { // Save every 30 seconds during execution
     lastResumeStateSave = nowMs;
     saveResumeState();
-    if (debugSerial) Serial.println("[RESUME] Periodic state save during program execution");
+    LOG_VERBOSE(LOG_STORAGE, "[RESUME] Periodic state save during program execution\n");
   }
 
   // --- Check for stage advancement and log ---
@@ -1204,9 +1334,9 @@ void loop() {
     if (p && programState.customStageIdx < p->customStages.size()) {
       CustomStage &st = p->customStages[programState.customStageIdx];
       if (st.isFermentation) {
-        if (debugSerial) Serial.printf("[STAGE ADVANCE] Fermentation stage advanced to %d\n", (int)programState.customStageIdx);
+        LOG_DEBUG(LOG_STAGE, "[STAGE ADVANCE] Fermentation stage advanced to %d\n", (int)programState.customStageIdx);
       } else {
-        if (debugSerial) Serial.printf("[STAGE ADVANCE] Non-fermentation stage advanced to %d\n", (int)programState.customStageIdx);
+        LOG_DEBUG(LOG_STAGE, "[STAGE ADVANCE] Non-fermentation stage advanced to %d\n", (int)programState.customStageIdx);
       }
     }
   }
@@ -1216,14 +1346,13 @@ void loop() {
     checkDelayedResume();
     handleManualMode();
     handleScheduledStart(scheduledStartTriggered);
-    yield(); return;  // Removed delay(100) for better web responsiveness
+    return;  // Removed delay(100) for better web responsiveness
   }
   if (getProgramCount() == 0 || programState.activeProgramId >= getProgramCount()) {
     stageJustAdvanced = false;
-    stopBreadmaker(); yield(); return;  // Removed delay(100) for better web responsiveness
+    stopBreadmaker(); return;  // Removed delay(100) for better web responsiveness
   }
   handleCustomStages(stageJustAdvanced);
-  temp = getAveragedTemperature();
   
   // --- Track loop performance (low-impact) ---
   if (safetySystem.loopStartTime > 0) {
@@ -1236,14 +1365,9 @@ void loop() {
     
     // Warn about critical loop times (but don't shutdown)
     if (loopTime > SafetySystem::CRITICAL_LOOP_TIME * 1000) { // Convert to microseconds
-      if (debugSerial) {
-        Serial.printf("[SAFETY] Critical loop time: %lu μs\n", loopTime);
-      }
+      LOG_WARN(LOG_SYSTEM, "[SAFETY] Critical loop time: %lu μs\n", loopTime);
     }
   }
-  
-  yield();
-  // Removed final delay - timing now handled by rate limiting above for better responsiveness
 }
 
 // --- Helper function definitions ---
@@ -1270,14 +1394,14 @@ void updateFermentationTiming(bool &stageJustAdvanced) {
         
         // If stage has already exceeded its planned duration, advance immediately
         if (stageElapsedSec >= plannedStageSec) {
-          if (debugSerial) Serial.printf("[FERMENT-TIMEOUT] Stage %d (%s) has exceeded planned duration (%.1fs >= %.1fs), advancing immediately\n", 
-                                        programState.customStageIdx, st.label.c_str(), stageElapsedSec, plannedStageSec);
+          LOG_DEBUG(LOG_FERMENT, "[FERMENT-TIMEOUT] Stage %d (%s) has exceeded planned duration (%.1fs >= %.1fs), advancing immediately\n", 
+                                (int)programState.customStageIdx, st.label.c_str(), stageElapsedSec, plannedStageSec);
           
           // Record when the current stage ended (BEFORE advancing)
           time_t now = time(nullptr);
           if (now > 1640995200 && programState.customStageIdx < 20) { // Valid NTP time and within bounds
             programState.actualStageEndTimes[programState.customStageIdx] = now;
-            if (debugSerial) Serial.printf("[TIMING] Stage %d ended at %lu (timeout)\n", programState.customStageIdx, (unsigned long)now);
+            LOG_DEBUG(LOG_FERMENT, "[TIMING] Stage %d ended at %lu (timeout)\n", (int)programState.customStageIdx, (unsigned long)now);
           }
           
           // Log stage completion before advancing
@@ -1297,6 +1421,7 @@ void updateFermentationTiming(bool &stageJustAdvanced) {
           
           programState.customStageIdx++;
           programState.customStageStart = millis();
+          traceInstant(TRACE_CONTROL, "stage advance");
           stageJustAdvanced = true;
           
           // Reset fermentation timing for next stage
@@ -1306,7 +1431,7 @@ void updateFermentationTiming(bool &stageJustAdvanced) {
           fermentState.realElapsedSeconds = 0.0;
           fermentState.accumulatedFermentMinutes = 0.0;
           
-          if (debugSerial) Serial.printf("[FERMENT-ADVANCE] Advanced from timed-out stage to stage %d\n", programState.customStageIdx);
+          LOG_DEBUG(LOG_FERMENT, "[FERMENT-ADVANCE] Advanced from timed-out stage to stage %d\n", (int)programState.customStageIdx);
           return; // Exit early after advancement
         }
         
@@ -1318,7 +1443,7 @@ void updateFermentationTiming(bool &stageJustAdvanced) {
           fermentState.scheduledElapsedSeconds = 0.0;
           fermentState.realElapsedSeconds = 0.0;
           fermentState.accumulatedFermentMinutes = 0.0;
-          if (debugSerial) Serial.printf("[FERMENT-RESET] New fermentation stage %d detected, forcing complete reset\n", programState.customStageIdx);
+          LOG_DEBUG(LOG_FERMENT, "[FERMENT-RESET] New fermentation stage %d detected, forcing complete reset\n", (int)programState.customStageIdx);
         }
         
         float baseline = p->fermentBaselineTemp > 0 ? p->fermentBaselineTemp : 20.0;
@@ -1326,8 +1451,9 @@ void updateFermentationTiming(bool &stageJustAdvanced) {
         double actualTemp = getAveragedTemperature();
         
         // Debug output to see actual values being used
-        Serial.printf("[FERMENT-TIMING] Program: %s, baseline=%.1f (raw=%.1f), Q10=%.1f (raw=%.1f), actualTemp=%.1f\n", 
-                     p->name.c_str(), baseline, p->fermentBaselineTemp, q10, p->fermentQ10, actualTemp);
+        // Every control tick: verbose only
+        LOG_VERBOSE(LOG_FERMENT, "[FERMENT-TIMING] Program: %s, baseline=%.1f (raw=%.1f), Q10=%.1f (raw=%.1f), actualTemp=%.1f\n", 
+                    p->name.c_str(), baseline, p->fermentBaselineTemp, q10, p->fermentQ10, actualTemp);
         
         unsigned long nowMs = millis();
         
@@ -1364,20 +1490,20 @@ void updateFermentationTiming(bool &stageJustAdvanced) {
         if (fermentState.fermentLastUpdateMs == 0) {
           fermentState.fermentLastTemp = actualTemp;
           fermentState.fermentLastFactor = calculateFermentationFactor(actualTemp); // Use proper biological calculation
-          Serial.printf("[FERMENT-TIMING-CALC] Initial factor calculation: temp=%.1f°C -> factor=%.3f\n", 
-                       actualTemp, fermentState.fermentLastFactor);
+          LOG_DEBUG(LOG_FERMENT, "[FERMENT-TIMING-CALC] Initial factor calculation: temp=%.1f°C -> factor=%.3f\n", 
+                    actualTemp, fermentState.fermentLastFactor);
           fermentState.fermentLastUpdateMs = nowMs;
           // Initialize new time tracking system - CRITICAL: Reset for each stage
           fermentState.scheduledElapsedSeconds = 0.0;
           fermentState.realElapsedSeconds = 0.0;
           fermentState.accumulatedFermentMinutes = 0.0;
-          if (debugSerial) Serial.printf("[FERMENT] Stage %d (%s) initialized: temp=%.1f, baseline=%.1f, q10=%.1f, factor=%.3f, planned=%.1fs (%.1f hours)\n", 
-                                        programState.customStageIdx, st.label.c_str(), actualTemp, baseline, q10, 
-                                        fermentState.fermentLastFactor, programState.adjustedStageDurations[programState.customStageIdx], programState.adjustedStageDurations[programState.customStageIdx] / 3600.0);
+          LOG_DEBUG(LOG_FERMENT, "[FERMENT] Stage %d (%s) initialized: temp=%.1f, baseline=%.1f, q10=%.1f, factor=%.3f, planned=%lus (%.1f hours)\n", 
+                                (int)programState.customStageIdx, st.label.c_str(), actualTemp, baseline, q10, 
+                                fermentState.fermentLastFactor, programState.adjustedStageDurations[programState.customStageIdx], programState.adjustedStageDurations[programState.customStageIdx] / 3600.0);
         } else if (programState.isRunning) {
           // Prevent overflow: Check if millis() has wrapped around
           if (nowMs < fermentState.fermentLastUpdateMs) {
-            if (debugSerial) Serial.println("[FERMENT] WARNING: millis() overflow detected, adjusting tracking");
+            LOG_WARN(LOG_FERMENT, "[FERMENT] WARNING: millis() overflow detected, adjusting tracking\n");
             // Don't reset completely - just adjust the last update time
             fermentState.fermentLastUpdateMs = nowMs;
             // Continue processing instead of returning to preserve accumulated progress
@@ -1386,7 +1512,7 @@ void updateFermentationTiming(bool &stageJustAdvanced) {
           double realElapsedSec = (nowMs - fermentState.fermentLastUpdateMs) / 1000.0;
           // Sanity check: prevent accumulation of unreasonably large time periods
           if (realElapsedSec > 1800.0) { // More than 30 minutes since last update
-            if (debugSerial) Serial.printf("[FERMENT] WARNING: Large time gap detected (%.1fs), capping at 1800s\n", realElapsedSec);
+            LOG_WARN(LOG_FERMENT, "[FERMENT] WARNING: Large time gap detected (%.1fs), capping at 1800s\n", realElapsedSec);
             realElapsedSec = 1800.0;
           }
           
@@ -1406,8 +1532,8 @@ void updateFermentationTiming(bool &stageJustAdvanced) {
           double previousFactor = fermentState.fermentLastFactor; // Store for debug message
           fermentState.fermentLastTemp = actualTemp;
           fermentState.fermentLastFactor = calculateFermentationFactor(actualTemp); // Use proper biological calculation
-          Serial.printf("[FERMENT-TIMING-UPDATE] Used previous factor %.3f for elapsed %.1fs (%.1f secs/sched_min), updated to new factor %.3f for temp %.1f°C\n", 
-                       previousFactor, realElapsedSec, secondsPerScheduledMinute, fermentState.fermentLastFactor, actualTemp);
+          LOG_DEBUG(LOG_FERMENT, "[FERMENT-TIMING-UPDATE] Used previous factor %.3f for elapsed %.1fs (%.1f secs/sched_min), updated to new factor %.3f for temp %.1f°C\n", 
+                    previousFactor, realElapsedSec, secondsPerScheduledMinute, fermentState.fermentLastFactor, actualTemp);
           
           // Convert accumulated minutes back to scheduled seconds for comparison
           double previousScheduledSec = fermentState.scheduledElapsedSeconds;
@@ -1438,7 +1564,7 @@ void updateFermentationTiming(bool &stageJustAdvanced) {
           }
           
           // Enhanced debug output with clear real vs scheduled time
-          if (debugSerial) {
+          if (logEnabled(LOG_FERMENT, LOG_LEVEL_DEBUG)) {
             // Use adjusted duration for accurate completion percentage
             double targetDurationSec = (double)st.min * 60.0; // Original
             if (programState.adjustedStageDurations && programState.customStageIdx < 20) {
@@ -1447,11 +1573,11 @@ void updateFermentationTiming(bool &stageJustAdvanced) {
               }
             }
             
-            Serial.printf("[FERMENT] Stage %d (%s): real_elapsed=%.1fs, sched_elapsed=%.1fs, factor=%.3f, secs_per_sched_min=%.1f, temp=%.1f, target=%.1fs (%.1f%% complete)\n", 
-                         programState.customStageIdx, st.label.c_str(), 
-                         fermentState.realElapsedSeconds, fermentState.scheduledElapsedSeconds, 
-                         fermentState.fermentLastFactor, secondsPerScheduledMinute, actualTemp, 
-                         targetDurationSec, (fermentState.scheduledElapsedSeconds / targetDurationSec) * 100.0);
+            LOG_DEBUG(LOG_FERMENT, "[FERMENT] Stage %d (%s): real_elapsed=%.1fs, sched_elapsed=%.1fs, factor=%.3f, secs_per_sched_min=%.1f, temp=%.1f, target=%.1fs (%.1f%% complete)\n", 
+                      (int)programState.customStageIdx, st.label.c_str(), 
+                      fermentState.realElapsedSeconds, fermentState.scheduledElapsedSeconds, 
+                      fermentState.fermentLastFactor, secondsPerScheduledMinute, actualTemp, 
+                      targetDurationSec, (fermentState.scheduledElapsedSeconds / targetDurationSec) * 100.0);
           }
         }
         fermentState.fermentationFactor = fermentState.fermentLastFactor; // For reference: multiply planned time by this factor for Q10
@@ -1468,23 +1594,23 @@ void updateFermentationTiming(bool &stageJustAdvanced) {
           // }
           if (programState.adjustedStageDurations[programState.customStageIdx] > 0) {
             finalPlannedStageSec = programState.adjustedStageDurations[programState.customStageIdx];
-            if (debugSerial) Serial.printf("[FERMENT-FIX] Using adjusted duration %.1fs instead of original %.1fs\n", 
-                                          finalPlannedStageSec, (double)st.min * 60.0);
+            LOG_DEBUG(LOG_FERMENT, "[FERMENT-FIX] Using adjusted duration %.1fs instead of original %.1fs\n", 
+                                  finalPlannedStageSec, (double)st.min * 60.0);
           }
         }
         
         double epsilon = 0.05;
         if (!stageJustAdvanced && (fermentState.scheduledElapsedSeconds + epsilon >= finalPlannedStageSec)) {
-          if (debugSerial) Serial.printf("[FERMENT] Auto-advance: Stage %d (%s) COMPLETE - scheduled %.1fs >= planned %.1fs (%.1f%% complete, real %.1fs actual, ratio %.2f)\n", 
-                                        programState.customStageIdx, st.label.c_str(), fermentState.scheduledElapsedSeconds, finalPlannedStageSec, 
-                                        (fermentState.scheduledElapsedSeconds / finalPlannedStageSec) * 100.0, fermentState.realElapsedSeconds,
-                                        fermentState.realElapsedSeconds / fermentState.scheduledElapsedSeconds);
+          LOG_DEBUG(LOG_FERMENT, "[FERMENT] Auto-advance: Stage %d (%s) COMPLETE - scheduled %.1fs >= planned %.1fs (%.1f%% complete, real %.1fs actual, ratio %.2f)\n", 
+                                (int)programState.customStageIdx, st.label.c_str(), fermentState.scheduledElapsedSeconds, finalPlannedStageSec, 
+                                (fermentState.scheduledElapsedSeconds / finalPlannedStageSec) * 100.0, fermentState.realElapsedSeconds,
+                                fermentState.realElapsedSeconds / fermentState.scheduledElapsedSeconds);
           
           // Record when the current stage ended (BEFORE advancing)
           time_t now = time(nullptr);
           if (now > 1640995200 && programState.customStageIdx < 20) { // Valid NTP time and within bounds
             programState.actualStageEndTimes[programState.customStageIdx] = now;
-            if (debugSerial) Serial.printf("[TIMING] Stage %d ended at %lu\n", programState.customStageIdx, (unsigned long)now);
+            LOG_DEBUG(LOG_FERMENT, "[TIMING] Stage %d ended at %lu\n", (int)programState.customStageIdx, (unsigned long)now);
           }
           
           // Log stage completion before advancing
@@ -1504,6 +1630,7 @@ void updateFermentationTiming(bool &stageJustAdvanced) {
           
           programState.customStageIdx++;
           programState.customStageStart = millis();
+          traceInstant(TRACE_CONTROL, "stage advance");
           
           // **CRITICAL FIX: Reset fermentation timing completely for next stage**
           fermentState.scheduledElapsedSeconds = 0.0;  // Reset to zero!
@@ -1514,7 +1641,7 @@ void updateFermentationTiming(bool &stageJustAdvanced) {
           // Record when the new stage started for timing display
           if (now > 1640995200 && programState.customStageIdx < 20) { // Valid NTP time and within bounds
             programState.actualStageStartTimes[programState.customStageIdx] = now;
-            if (debugSerial) Serial.printf("[TIMING] Stage %d started at %lu\n", programState.customStageIdx, (unsigned long)now);
+            LOG_DEBUG(LOG_FERMENT, "[TIMING] Stage %d started at %lu\n", (int)programState.customStageIdx, (unsigned long)now);
           }
           
           // Log new stage start
@@ -1555,13 +1682,13 @@ void checkDelayedResume() {
   static bool delayedResumeChecked = false;
   if (!delayedResumeChecked && isStartupDelayComplete()) {
     delayedResumeChecked = true;
-    File f = FFat.open(RESUME_FILE, "r");
+    File f = storageFS().open(RESUME_FILE, "r");
     if (f) {
       DynamicJsonDocument doc(256);
       DeserializationError err = deserializeJson(doc, f);
       f.close();
       if (!err && (doc["isRunning"] | false)) {
-        if (debugSerial) Serial.println("[RESUME] Startup delay complete, resuming program");
+        LOG_INFO(LOG_SYSTEM, "[RESUME] Startup delay complete, resuming program\n");
         loadResumeState();
       }
     }
@@ -1626,10 +1753,10 @@ void handleScheduledStart(bool &scheduledStartTriggered) {
     programState.isRunning = true;
     if (scheduledStartStage >= 0 && scheduledStartStage < programState.maxCustomStages) {
       programState.customStageIdx = scheduledStartStage;
-      if (debugSerial) Serial.printf("[SCHEDULED] Starting at stage %d\n", scheduledStartStage);
+      LOG_INFO(LOG_STAGE, "[SCHEDULED] Starting at stage %d\n", scheduledStartStage);
     } else {
       programState.customStageIdx = 0;
-      if (debugSerial) Serial.printf("[SCHEDULED] Starting from beginning\n");
+      LOG_INFO(LOG_STAGE, "[SCHEDULED] Starting from beginning\n");
     }
     programState.customMixIdx = 0;
     programState.customStageStart = millis();
@@ -1649,6 +1776,91 @@ void handleScheduledStart(bool &scheduledStartTriggered) {
   if (!scheduledStart) scheduledStartTriggered = false;
 }
 
+// Resolves a mix step's timing in milliseconds; returns true for knockdown steps.
+// A step whose duration does not exceed mix + wait runs a single cycle.
+static bool getMixStepTiming(const MixStep &step, unsigned long &mixTimeMs, unsigned long &waitTimeMs, unsigned long &stepDurationMs) {
+  bool knockdown = step.knockdown || step.label.indexOf("knockdown") >= 0 || step.label.indexOf("Knockdown") >= 0;
+  if (knockdown) {
+    // Knockdown mode: use 100ms mix, rest as wait
+    mixTimeMs = (step.mixMs > 0) ? step.mixMs : 100;  // Default 100ms for knockdown
+    waitTimeMs = (step.waitMs > 0) ? step.waitMs : (step.waitSec * 1000);
+    if (waitTimeMs == 0) waitTimeMs = 5000; // Default 5 second wait
+  } else {
+    // Normal mode: use seconds or milliseconds
+    mixTimeMs = (step.mixMs > 0) ? step.mixMs : (step.mixSec * 1000);
+    waitTimeMs = (step.waitMs > 0) ? step.waitMs : (step.waitSec * 1000);
+  }
+  stepDurationMs = (step.durationSec > 0) ? (step.durationSec * 1000) : (mixTimeMs + waitTimeMs);
+  return knockdown;
+}
+
+// Hardware-timed mix pattern: loads the stage's pattern into the motor pulse engine
+// once, then mirrors the engine's segment and motor state into programState (UI,
+// resume file) and the activity log. Each call renews the engine's lease; after an
+// expiry the pattern is no longer running and is reloaded here, mid-step.
+// Edge timing errors are reported under debugSerial.
+static void updatePulsedMixPattern(const CustomStage &st) {
+  static int loadedStageIdx = -1;
+  static unsigned long loadedStageStart = 0;
+  static uint8_t lastSegment = 0;
+
+  uint8_t count = st.mixPattern.size() > MOTOR_PATTERN_MAX ? MOTOR_PATTERN_MAX : st.mixPattern.size();
+  bool reload = !motorPulseRunning() || programState.customMixStepStart == 0 ||
+                loadedStageIdx != (int)programState.customStageIdx || loadedStageStart != programState.customStageStart;
+  if (reload) {
+    if (programState.customMixIdx >= count) programState.customMixIdx = 0;
+    MotorPulseSegment segments[MOTOR_PATTERN_MAX];
+    for (uint8_t i = 0; i < count; i++) {
+      unsigned long mixTimeMs, waitTimeMs, stepDurationMs;
+      getMixStepTiming(st.mixPattern[i], mixTimeMs, waitTimeMs, stepDurationMs);
+      // Single-cycle steps end after mix + wait, as in the loop-driven mixer
+      segments[i] = {(uint32_t)mixTimeMs, (uint32_t)waitTimeMs, (uint32_t)max(stepDurationMs, mixTimeMs + waitTimeMs)};
+    }
+    if (st.mixPattern.size() > MOTOR_PATTERN_MAX) {
+      LOG_DEBUG(LOG_MIX, "[MIX] Pattern has %d steps, pulse engine runs the first %d\n", (int)st.mixPattern.size(), (int)MOTOR_PATTERN_MAX);
+    }
+    // Resume mid-step: customMixStepStart survives from the resume file
+    unsigned long elapsedMs = programState.customMixStepStart ? millis() - programState.customMixStepStart : 0;
+    motorPulseLoad(segments, count, programState.customMixIdx, elapsedMs);
+    loadedStageIdx = programState.customStageIdx;
+    loadedStageStart = programState.customStageStart;
+    lastSegment = programState.customMixIdx;
+  } else {
+    motorPulseRenew();
+  }
+
+  // Segments advance in the interrupt; report them as the loop-driven mixer did
+  uint8_t segment = motorPulseSegment();
+  if (segment != lastSegment) {
+    if (segment == 0) {
+      LOG_DEBUG(LOG_MIX, "[MIX] All %d patterns complete, restarting from pattern 0\n", count);
+      logMixCycleComplete(count);
+    } else {
+      LOG_DEBUG(LOG_MIX, "[MIX] Advancing to pattern %d\n", segment);
+      logMixPatternAdvance(segment + 1);
+    }
+    lastSegment = segment;
+  }
+  programState.customMixIdx = segment;
+  programState.customMixStepStart = millis() - motorPulseSegmentElapsedMs();
+  if (programState.customMixStepStart == 0) programState.customMixStepStart = 1;  // 0 means "not started"
+
+  bool previousMotorState = outputStates.motor;
+  bool motorOn = syncMotorFromPulseEngine();
+  if (motorOn && !previousMotorState) {
+    logMixStart(segment + 1, millis() - programState.customMixStepStart);
+  } else if (!motorOn && previousMotorState) {
+    logMixStop(segment + 1, millis() - programState.customMixStepStart);
+  }
+
+  MotorEdgeRecord edges[8];
+  uint8_t n = motorPulseDrainEdges(edges, 8);
+  for (uint8_t i = 0; i < n; i++) {
+    LOG_VERBOSE(LOG_MIX, "[MOTOR-PULSE] %s pattern %u at %lums, error %ldus\n", edges[i].on ? "ON " : "OFF",
+                edges[i].segment + 1, (unsigned long)edges[i].atMs, (long)edges[i].errorUs);
+  }
+}
+
 // Handles the execution and advancement of custom program stages, including mixing and fermentation.
 void handleCustomStages(bool &stageJustAdvanced) {
   Program *p = getActiveProgramMutable();
@@ -1829,47 +2041,36 @@ void handleCustomStages(bool &stageJustAdvanced) {
       if (st.noMix) {
         setMotor(false);
         hasMix = false;
+      } else if (!st.mixPattern.empty() && motorPulseActive()) {
+        // Hardware-timed mixing: the pulse engine owns the motor pin
+        hasMix = true;
+        updatePulsedMixPattern(st);
       } else if (!st.mixPattern.empty()) {
         hasMix = true;
         if (programState.customMixIdx >= st.mixPattern.size()) {
           programState.customMixIdx = 0;
-          if (debugSerial) Serial.printf("[MIX] Index out of bounds, reset to 0 (total patterns: %d)\n", st.mixPattern.size());
+          LOG_DEBUG(LOG_MIX, "[MIX] Index out of bounds, reset to 0 (total patterns: %d)\n", (int)st.mixPattern.size());
         }
         
         MixStep &step = st.mixPattern[programState.customMixIdx];
         
         // **NEW: Knockdown detection and millisecond support**
         unsigned long mixTimeMs, waitTimeMs, stepDurationMs;
-        
-        if (step.knockdown || step.label.indexOf("knockdown") >= 0 || step.label.indexOf("Knockdown") >= 0) {
-          // Knockdown mode: use 100ms mix, rest as wait
-          mixTimeMs = (step.mixMs > 0) ? step.mixMs : 100;  // Default 100ms for knockdown
-          waitTimeMs = (step.waitMs > 0) ? step.waitMs : (step.waitSec * 1000);
-          if (waitTimeMs == 0) waitTimeMs = 5000; // Default 5 second wait
-          stepDurationMs = (step.durationSec > 0) ? (step.durationSec * 1000) : (mixTimeMs + waitTimeMs);
-          
-          if (debugSerial && programState.customMixStepStart == 0) {
-            Serial.printf("[MIX] KNOCKDOWN mode: mix=%lums, wait=%lums, duration=%lums\n", 
-                         mixTimeMs, waitTimeMs, stepDurationMs);
-          }
-        } else {
-          // Normal mode: use seconds or milliseconds
-          mixTimeMs = (step.mixMs > 0) ? step.mixMs : (step.mixSec * 1000);
-          waitTimeMs = (step.waitMs > 0) ? step.waitMs : (step.waitSec * 1000);
-          stepDurationMs = (step.durationSec > 0) ? (step.durationSec * 1000) : (mixTimeMs + waitTimeMs);
+        bool knockdown = getMixStepTiming(step, mixTimeMs, waitTimeMs, stepDurationMs);
+        if (knockdown && programState.customMixStepStart == 0) {
+          LOG_DEBUG(LOG_MIX, "[MIX] KNOCKDOWN mode: mix=%lums, wait=%lums, duration=%lums\n", 
+                    mixTimeMs, waitTimeMs, stepDurationMs);
         }
         
         if (programState.customMixStepStart == 0) {
           programState.customMixStepStart = millis();
-          if (debugSerial) {
-            if (stepDurationMs > (mixTimeMs + waitTimeMs)) {
-              unsigned long expectedCycles = stepDurationMs / (mixTimeMs + waitTimeMs);
-              Serial.printf("[MIX] Starting pattern %d/%d: mix=%lums, wait=%lums, duration=%lums (≈%lu cycles)\n", 
-                          programState.customMixIdx + 1, st.mixPattern.size(), mixTimeMs, waitTimeMs, stepDurationMs, expectedCycles);
-            } else {
-              Serial.printf("[MIX] Starting pattern %d/%d: mix=%lums, wait=%lums, duration=%lums (single cycle)\n", 
-                          programState.customMixIdx + 1, st.mixPattern.size(), mixTimeMs, waitTimeMs, stepDurationMs);
-            }
+          if (stepDurationMs > (mixTimeMs + waitTimeMs)) {
+            unsigned long expectedCycles = stepDurationMs / (mixTimeMs + waitTimeMs);
+            LOG_DEBUG(LOG_MIX, "[MIX] Starting pattern %d/%d: mix=%lums, wait=%lums, duration=%lums (≈%lu cycles)\n", 
+                      (int)programState.customMixIdx + 1, (int)st.mixPattern.size(), mixTimeMs, waitTimeMs, stepDurationMs, expectedCycles);
+          } else {
+            LOG_DEBUG(LOG_MIX, "[MIX] Starting pattern %d/%d: mix=%lums, wait=%lums, duration=%lums (single cycle)\n", 
+                      (int)programState.customMixIdx + 1, (int)st.mixPattern.size(), mixTimeMs, waitTimeMs, stepDurationMs);
           }
         }
         
@@ -1886,8 +2087,8 @@ void handleCustomStages(bool &stageJustAdvanced) {
             if (!previousMotorState && outputStates.motor) {
               logMixStart(programState.customMixIdx + 1, millis() - programState.customMixStepStart);
             }
-            if (debugSerial && (elapsedMs / cycleTimeMs) != ((elapsedMs - 1000) / cycleTimeMs)) {
-              Serial.printf("[MIX] Pattern %d cycle %lu: mixing (%lums elapsed)\n", programState.customMixIdx + 1, elapsedMs / cycleTimeMs + 1, elapsedMs);
+            if ((elapsedMs / cycleTimeMs) != ((elapsedMs - 1000) / cycleTimeMs)) {
+              LOG_VERBOSE(LOG_MIX, "[MIX] Pattern %d cycle %lu: mixing (%lums elapsed)\n", (int)programState.customMixIdx + 1, elapsedMs / cycleTimeMs + 1, elapsedMs);
             }
           } else {
             bool previousMotorState = outputStates.motor;
@@ -1902,10 +2103,10 @@ void handleCustomStages(bool &stageJustAdvanced) {
             programState.customMixStepStart = millis();
             if (programState.customMixIdx >= st.mixPattern.size()) {
               programState.customMixIdx = 0;
-              if (debugSerial) Serial.printf("[MIX] All %d patterns complete, restarting from pattern 0\n", st.mixPattern.size());
+              LOG_DEBUG(LOG_MIX, "[MIX] All %d patterns complete, restarting from pattern 0\n", (int)st.mixPattern.size());
               logMixCycleComplete(st.mixPattern.size());
             } else {
-              if (debugSerial) Serial.printf("[MIX] Advancing to pattern %d\n", programState.customMixIdx);
+              LOG_DEBUG(LOG_MIX, "[MIX] Advancing to pattern %d\n", (int)programState.customMixIdx);
               logMixPatternAdvance(programState.customMixIdx + 1);
             }
           }
@@ -1928,10 +2129,10 @@ void handleCustomStages(bool &stageJustAdvanced) {
             programState.customMixStepStart = millis();
             if (programState.customMixIdx >= st.mixPattern.size()) {
               programState.customMixIdx = 0;
-              if (debugSerial) Serial.printf("[MIX] All %d patterns complete, restarting from pattern 0\n", st.mixPattern.size());
+              LOG_DEBUG(LOG_MIX, "[MIX] All %d patterns complete, restarting from pattern 0\n", (int)st.mixPattern.size());
               logMixCycleComplete(st.mixPattern.size());
             } else {
-              if (debugSerial) Serial.printf("[MIX] Advancing to pattern %d\n", programState.customMixIdx);
+              LOG_DEBUG(LOG_MIX, "[MIX] Advancing to pattern %d\n", (int)programState.customMixIdx);
               logMixPatternAdvance(programState.customMixIdx + 1);
             }
           }
@@ -1940,6 +2141,8 @@ void handleCustomStages(bool &stageJustAdvanced) {
         setMotor(true);
         hasMix = false;
       }
+    } else if (motorPulseRunning()) {
+      setMotor(false);  // Manual mode takes the motor back from the stage's pattern
     }
     bool stageComplete = false;
     // Note: Fermentation stage advancement is handled in updateFermentationTiming()
@@ -1954,15 +2157,19 @@ void handleCustomStages(bool &stageJustAdvanced) {
       unsigned long elapsedMs = millis() - programState.customStageStart;
       // Prevent integer overflow: limit stage time to ~71 minutes (2^32 / 60000)
       unsigned long safeMin = (st.min > 71) ? 71 : st.min;
-      if (st.min > 71 && debugSerial) {
-        Serial.printf("[WARN] Stage duration %u minutes exceeds safe limit, capping at 71 minutes\n", st.min);
+      static unsigned long capWarnedStart = 0, zeroWarnedStart = 0;   // Each warning once per stage
+      if (st.min > 71 && capWarnedStart != programState.customStageStart) {
+        capWarnedStart = programState.customStageStart;
+        LOG_WARN(LOG_STAGE, "[WARN] Stage duration %u minutes exceeds safe limit, capping at 71 minutes\n", st.min);
       }
       unsigned long stageMs = safeMin * 60000UL;
       if (elapsedMs >= stageMs) {
         stageComplete = true;
-      } else if (stageMs > 0 && elapsedMs >= stageMs - 1000 && !stageComplete) {
+      } else if (stageMs > 0 && elapsedMs >= stageMs - 1000 && !stageComplete &&
+                 zeroWarnedStart != programState.customStageStart) {
         // Safety: If time left is 0 but not advancing, log warning
-        if (debugSerial) Serial.printf("[WARN] Time left is 0 for non-fermentation stage %d but not advancing (elapsed=%lu, stageMs=%lu)\n", (int)programState.customStageIdx, elapsedMs, stageMs);
+        zeroWarnedStart = programState.customStageStart;
+        LOG_WARN(LOG_STAGE, "[WARN] Time left is 0 for non-fermentation stage %d but not advancing (elapsed=%lu, stageMs=%lu)\n", (int)programState.customStageIdx, elapsedMs, stageMs);
       }
     }
     // Extra safety mechanisms for stuck stages
@@ -1972,7 +2179,7 @@ void handleCustomStages(bool &stageJustAdvanced) {
       unsigned long safeMin = (st.min > 71) ? 71 : st.min;
       unsigned long stageMs = safeMin * 60000UL;
       if (stageMs > 0 && elapsedMs > stageMs + 2000 && !stageComplete) {
-        if (debugSerial) Serial.printf("[FORCE ADVANCE] Forcing advancement of non-fermentation stage %d after time expired (elapsed=%lu, stageMs=%lu)\n", (int)programState.customStageIdx, elapsedMs, stageMs);
+        LOG_DEBUG(LOG_STAGE, "[FORCE ADVANCE] Forcing advancement of non-fermentation stage %d after time expired (elapsed=%lu, stageMs=%lu)\n", (int)programState.customStageIdx, elapsedMs, stageMs);
         stageComplete = true;
       }
     } else {
@@ -1993,10 +2200,10 @@ void handleCustomStages(bool &stageJustAdvanced) {
       // 2. Manual /advance endpoint for emergency override
       // 3. Resume state saves to prevent data loss
       
-      if (debugSerial && (millis() - programState.customStageStart) > (unsigned long)st.min * 60000UL * 6) {
+      if ((millis() - programState.customStageStart) > (unsigned long)st.min * 60000UL * 6) {
         // Log warning if fermentation takes very long, but don't force advance
-        Serial.printf("[FERMENT-SAFETY] Fermentation stage %d running long: %lu minutes elapsed (planned: %u minutes). Use /advance to override if needed.\n", 
-                     (int)programState.customStageIdx, (millis() - programState.customStageStart) / 60000UL, st.min);
+        LOG_DEBUG(LOG_FERMENT, "[FERMENT-SAFETY] Fermentation stage %d running long: %lu minutes elapsed (planned: %u minutes). Use /advance to override if needed.\n", 
+                  (int)programState.customStageIdx, (millis() - programState.customStageStart) / 60000UL, st.min);
       }
     }
     if (stageComplete) {
@@ -2014,10 +2221,10 @@ void handleCustomStages(bool &stageJustAdvanced) {
         if (ntpValid) {
           time_t predicted = now + (time_t)(remainScheduledSec * factor); // Multiply: higher temp = less time
           fermentState.predictedCompleteTime = predicted;
-          if (debugSerial) Serial.printf("[FERMENT] Stage advanced, predictedCompleteTime set to %lu (now=%lu, remainScheduledSec=%.2f, factor=%.3f) [MULTIPLY]\n", (unsigned long)predicted, (unsigned long)now, remainScheduledSec, factor);
+          LOG_DEBUG(LOG_FERMENT, "[FERMENT] Stage advanced, predictedCompleteTime set to %lu (now=%lu, remainScheduledSec=%.2f, factor=%.3f) [MULTIPLY]\n", (unsigned long)predicted, (unsigned long)now, remainScheduledSec, factor);
         } else {
           fermentState.predictedCompleteTime = 0; // NTP not synced, disable timestamp predictions
-          if (debugSerial) Serial.printf("[FERMENT] Stage advanced, NTP not synced (now=%lu), predictedCompleteTime disabled\n", (unsigned long)now);
+          LOG_DEBUG(LOG_FERMENT, "[FERMENT] Stage advanced, NTP not synced (now=%lu), predictedCompleteTime disabled\n", (unsigned long)now);
         }
       }
       
@@ -2028,6 +2235,7 @@ void handleCustomStages(bool &stageJustAdvanced) {
       
       programState.customStageIdx++;
       programState.customStageStart = millis();
+      traceInstant(TRACE_CONTROL, "stage advance");
       programState.customMixIdx = 0;
       programState.customMixStepStart = 0;
       
@@ -2045,20 +2253,18 @@ void handleCustomStages(bool &stageJustAdvanced) {
       yield(); // Allow other tasks to run
       
       stageJustAdvanced = true;
-      if (debugSerial) Serial.printf("[ADVANCE] Stage advanced to %d\n", programState.customStageIdx);
+      LOG_DEBUG(LOG_STAGE, "[ADVANCE] Stage advanced to %d\n", (int)programState.customStageIdx);
       
-      // Reduce CPU load during transition
+      // No delay here: the control task paces itself, and loop() is rate limited
       yield();
-      delay(50); // Increased delay to reduce CPU spike
       return;
     } else {
       yield();
-      delay(100);
       return;
     }
 }
 
-// Serial WiFi configuration helper
+// Serial configuration commands (WiFi credentials, telemetry mode)
 void checkSerialWifiConfig() {
   if (Serial.available()) {
     String cmd = Serial.readStringUntil('\n');
@@ -2078,13 +2284,14 @@ void checkSerialWifiConfig() {
         doc["ssid"] = ssid;
         doc["pass"] = pass;
         
-        File f = FFat.open("/wifi.json", "w");
+        StorageFile f = storageOpen("/wifi.json", "w", "wifi");
         if (f) {
           serializeJson(doc, f);
           f.close();
           Serial.println("[WIFI CONFIG] WiFi configuration saved!");
           Serial.println("[WIFI CONFIG] Restarting to apply new WiFi settings...");
           delay(1000);
+          persistFlushAll();
           ESP.restart();
         } else {
           Serial.println("[WIFI CONFIG] ERROR: Failed to save WiFi configuration");
@@ -2106,10 +2313,17 @@ void checkSerialWifiConfig() {
       } else if (WiFi.getMode() == WIFI_AP) {
         Serial.printf("[WIFI CONFIG] AP Mode IP: %s\n", WiFi.softAPIP().toString().c_str());
       }
+    } else if (cmd.startsWith("telemetry:on")) {
+      // Format: telemetry:on[,INTERVAL_MS]
+      int commaIndex = cmd.indexOf(',');
+      telemetryStart(commaIndex > 0 ? cmd.substring(commaIndex + 1).toInt() : TELEMETRY_DEFAULT_INTERVAL_MS);
+    } else if (cmd == "telemetry:off") {
+      telemetryStop();
     } else if (cmd == "wifi:reset") {
-      if (FFat.remove("/wifi.json")) {
+      if (storageFS().remove("/wifi.json")) {
         Serial.println("[WIFI CONFIG] WiFi configuration reset. Restarting...");
         delay(1000);
+        persistFlushAll();
         ESP.restart();
       } else {
         Serial.println("[WIFI CONFIG] No WiFi configuration to reset");
@@ -2127,14 +2341,14 @@ void checkSerialWifiConfig() {
 // Loads breadmaker settings (PID, temperature, program selection, etc.) from FFat.
 void loadSettings() {
   if (debugSerial) Serial.println("[loadSettings] Loading settings...");
-  File f = FFat.open(SETTINGS_FILE, "r");
+  File f = storageFS().open(SETTINGS_FILE, "r");
   if (!f) {
     if (debugSerial) Serial.println("[loadSettings] settings.json not found, using defaults.");
     debugSerial = true;
     return;
   }
   
-  DynamicJsonDocument doc(512);
+  DynamicJsonDocument doc(1536); // ~35 keys incl. sampler, estimator, thermal monitor and MQTT
   DeserializationError err = deserializeJson(doc, f);
   if (err) {
     if (debugSerial) {
@@ -2152,6 +2366,46 @@ void loadSettings() {
   // Load safety system settings (default to enabled for production)
   safetySystem.safetyEnabled = doc["safetyEnabled"] | true;
   
+  // Load RTD oversampling pipeline settings
+  if (doc.containsKey("adcBurstSamples")) {
+    RTDSamplerConfig adcCfg = rtdSamplerGetConfig();
+    adcCfg.burstSamples = doc["adcBurstSamples"] | adcCfg.burstSamples;
+    adcCfg.decimation = doc["adcDecimation"] | adcCfg.decimation;
+    adcCfg.burstIntervalMs = doc["adcBurstIntervalMs"] | adcCfg.burstIntervalMs;
+    adcCfg.rejectFraction = doc["adcRejectFraction"] | adcCfg.rejectFraction;
+    rtdSamplerConfigure(adcCfg);
+  }
+  
+  // Load temperature filter selection and Kalman model parameters
+  tempKalman.enabled = (strcmp(doc["tempFilter"] | "ema", "kalman") == 0);
+  tempKalman.heatRate = doc["kalmanHeatRate"] | tempKalman.heatRate;
+  tempKalman.lossRate = doc["kalmanLossRate"] | tempKalman.lossRate;
+  tempKalman.ambient = doc["kalmanAmbient"] | tempKalman.ambient;
+  tempKalman.processNoise = doc["kalmanProcessNoise"] | tempKalman.processNoise;
+  tempKalman.biasNoise = doc["kalmanBiasNoise"] | tempKalman.biasNoise;
+  tempKalman.measurementNoise = doc["kalmanMeasurementNoise"] | tempKalman.measurementNoise;
+  
+  // Load predictive thermal monitor thresholds
+  thermalMonitor.config.minHeaterGain = doc["thermalMinHeaterGain"] | thermalMonitor.config.minHeaterGain;
+  thermalMonitor.config.runawaySlope = doc["thermalRunawaySlope"] | thermalMonitor.config.runawaySlope;
+  thermalMonitor.config.predictionHorizon = doc["thermalPredictionHorizon"] | thermalMonitor.config.predictionHorizon;
+  
+  // Load MQTT publisher settings
+  if (doc.containsKey("mqttHost")) {
+    MqttConfig mqttCfg = mqttGetConfig();
+    mqttCfg.enabled = doc["mqttEnabled"] | false;
+    snprintf(mqttCfg.host, sizeof(mqttCfg.host), "%s", doc["mqttHost"] | "");
+    mqttCfg.port = doc["mqttPort"] | mqttCfg.port;
+    snprintf(mqttCfg.user, sizeof(mqttCfg.user), "%s", doc["mqttUser"] | "");
+    snprintf(mqttCfg.password, sizeof(mqttCfg.password), "%s", doc["mqttPassword"] | "");
+    snprintf(mqttCfg.baseTopic, sizeof(mqttCfg.baseTopic), "%s", doc["mqttBaseTopic"] | mqttCfg.baseTopic);
+    snprintf(mqttCfg.discoveryPrefix, sizeof(mqttCfg.discoveryPrefix), "%s", doc["mqttDiscoveryPrefix"] | mqttCfg.discoveryPrefix);
+    mqttCfg.tempDeadband = doc["mqttTempDeadband"] | mqttCfg.tempDeadband;
+    mqttCfg.setpointDeadband = doc["mqttSetpointDeadband"] | mqttCfg.setpointDeadband;
+    mqttCfg.minIntervalMs = doc["mqttMinIntervalMs"] | mqttCfg.minIntervalMs;
+    mqttConfigure(mqttCfg);
+  }
+  
   // Load PID parameters - backward compatibility
   if (doc.containsKey("pidKp")) {
     pid.Kp = doc["pidKp"] | 2.0;
@@ -2201,27 +2455,19 @@ void loadSettings() {
 }
 
 // Saves breadmaker settings (PID, temperature, program selection, etc.) to FFat.
-// Uses direct streaming to minimize memory usage under load.
+// The write is deferred to the persistence worker (see persistence_manager.h).
 void saveSettings() {
-  if (debugSerial) Serial.println("[saveSettings] Saving settings...");
-  
-  // Check if file system is available
-  if (!FFat.begin()) {
-    if (debugSerial) Serial.println("[saveSettings] FFat not available!");
-    return;
-  }
-  
-  File f = FFat.open(SETTINGS_FILE, "w");
-  if (!f) {
-    if (debugSerial) Serial.println("[saveSettings] Failed to open settings.json for writing!");
-    return;
-  }
-  
+  if (debugSerial) Serial.println("[saveSettings] Settings save queued");
+  persistMarkDirty(PERSIST_SETTINGS);
+}
+
+// Settings JSON, streamed by the persistence worker (control lock held)
+void serializeSettingsJson(Print& f) {
   // Use simple JSON construction to avoid memory issues
   f.print("{\n");
   f.print("  \"outputMode\":\"digital\",\n");
   f.print("  \"debugSerial\":");
-  f.print(debugSerial ? "true" : "false");
+  f.print(telemetryDebugSerialSetting() ? "true" : "false");  // Not the suspended value while streaming
   f.print(",\n");
   f.print("  \"safetyEnabled\":");
   f.print(safetySystem.safetyEnabled ? "true" : "false");
@@ -2261,9 +2507,94 @@ void saveSettings() {
   f.print(",\n");
   f.print("  \"pidWindowSize\":");
   f.print(windowSize);
+  f.print(",\n");
+  
+  // RTD oversampling pipeline
+  const RTDSamplerConfig& adcCfg = rtdSamplerGetConfig();
+  f.print("  \"adcBurstSamples\":");
+  f.print(adcCfg.burstSamples);
+  f.print(",\n");
+  f.print("  \"adcDecimation\":");
+  f.print(adcCfg.decimation);
+  f.print(",\n");
+  f.print("  \"adcBurstIntervalMs\":");
+  f.print(adcCfg.burstIntervalMs);
+  f.print(",\n");
+  f.print("  \"adcRejectFraction\":");
+  f.print(adcCfg.rejectFraction, 2);
+  f.print(",\n");
+  
+  // Temperature filter selection and Kalman model
+  f.print("  \"tempFilter\":\"");
+  f.print(tempKalman.enabled ? "kalman" : "ema");
+  f.print("\",\n");
+  f.print("  \"kalmanHeatRate\":");
+  f.print(tempKalman.heatRate, 4);
+  f.print(",\n");
+  f.print("  \"kalmanLossRate\":");
+  f.print(tempKalman.lossRate, 6);
+  f.print(",\n");
+  f.print("  \"kalmanAmbient\":");
+  f.print(tempKalman.ambient, 1);
+  f.print(",\n");
+  f.print("  \"kalmanProcessNoise\":");
+  f.print(tempKalman.processNoise, 6);
+  f.print(",\n");
+  f.print("  \"kalmanBiasNoise\":");
+  f.print(tempKalman.biasNoise, 6);
+  f.print(",\n");
+  f.print("  \"kalmanMeasurementNoise\":");
+  f.print(tempKalman.measurementNoise, 6);
+  f.print(",\n");
+  
+  // Predictive thermal monitor thresholds
+  f.print("  \"thermalMinHeaterGain\":");
+  f.print(thermalMonitor.config.minHeaterGain, 4);
+  f.print(",\n");
+  f.print("  \"thermalRunawaySlope\":");
+  f.print(thermalMonitor.config.runawaySlope, 4);
+  f.print(",\n");
+  f.print("  \"thermalPredictionHorizon\":");
+  f.print(thermalMonitor.config.predictionHorizon, 0);
+  f.print(",\n");
+  
+  // MQTT publisher
+  const MqttConfig& mqttCfg = mqttGetConfig();
+  f.print("  \"mqttEnabled\":");
+  f.print(mqttCfg.enabled ? "true" : "false");
+  f.print(",\n");
+  char escaped[2 * sizeof(mqttCfg.password)];   // Largest MQTT string, escaped
+  f.print("  \"mqttHost\":\"");
+  mqttJsonEscape(escaped, sizeof(escaped), mqttCfg.host);
+  f.print(escaped);
+  f.print("\",\n");
+  f.print("  \"mqttPort\":");
+  f.print(mqttCfg.port);
+  f.print(",\n");
+  f.print("  \"mqttUser\":\"");
+  mqttJsonEscape(escaped, sizeof(escaped), mqttCfg.user);
+  f.print(escaped);
+  f.print("\",\n");
+  f.print("  \"mqttPassword\":\"");
+  mqttJsonEscape(escaped, sizeof(escaped), mqttCfg.password);
+  f.print(escaped);
+  f.print("\",\n");
+  f.print("  \"mqttBaseTopic\":\"");
+  mqttJsonEscape(escaped, sizeof(escaped), mqttCfg.baseTopic);
+  f.print(escaped);
+  f.print("\",\n");
+  f.print("  \"mqttDiscoveryPrefix\":\"");
+  mqttJsonEscape(escaped, sizeof(escaped), mqttCfg.discoveryPrefix);
+  f.print(escaped);
+  f.print("\",\n");
+  f.print("  \"mqttTempDeadband\":");
+  f.print(mqttCfg.tempDeadband, 2);
+  f.print(",\n");
+  f.print("  \"mqttSetpointDeadband\":");
+  f.print(mqttCfg.setpointDeadband, 2);
+  f.print(",\n");
+  f.print("  \"mqttMinIntervalMs\":");
+  f.print(mqttCfg.minIntervalMs);
   f.print("\n");
   f.print("}\n");
-  
-  f.close();
-  if (debugSerial) Serial.println("[saveSettings] Settings saved.");
 }
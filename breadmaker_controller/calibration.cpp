@@ -1,20 +1,38 @@
 #include "calibration.h"
 #include "globals.h"  // For PIN_RTD definition
-#include <FFat.h>
+#include "sensor_service.h"
+#include "persistence_manager.h"
+#include "storage_backend.h"
 #include <ArduinoJson.h>
+#include <algorithm>
+
+extern bool debugSerial;
 
 const char* CALIB_FILE = "/calibration.json";
 std::vector<CalibPoint> rtdCalibTable;
 float calibrationSlope = 1.0f;
 float calibrationOffset = 0.0f;
+uint8_t calibFitMode = CALIB_FIT_PIECEWISE;
+
+// Dense lookup table in centi-degrees (8 KB) - tempFromRaw() is O(1)
+static int16_t calibLut[CALIB_LUT_SIZE];
+static bool calibLutValid = false;
+static double calibPoly[CALIB_FIT_MAX_DEGREE + 1];
+static uint8_t calibPolyDegree = 0;  // Degree actually fitted (0 = piecewise in use)
+static std::vector<float> calibResiduals;
+static std::vector<float> calibLooResiduals;
+static float calibRms = 0.0f;
 
+// Deferred to the persistence worker
 void saveCalibration() {
-  // MEMORY OPTIMIZATION: Use streaming to avoid large DynamicJsonDocument allocation
-  File f = FFat.open(CALIB_FILE, "w");
-  if (!f) return;
-  
-  // Stream JSON directly to file instead of building in memory
-  f.print("{\"table\":[");
+  persistMarkDirty(PERSIST_CALIBRATION);
+}
+
+// Streamed by the persistence worker (control lock held)
+void serializeCalibrationJson(Print& f) {
+  f.print("{\"fit\":\"");
+  f.print(calibFitModeName());
+  f.print("\",\"table\":[");
   for(size_t i = 0; i < rtdCalibTable.size(); i++) {
     if (i > 0) f.print(',');
     f.print("{\"raw\":");
@@ -24,13 +42,15 @@ void saveCalibration() {
     f.print('}');
   }
   f.print("]}");
-  f.close();
 }
 
 void loadCalibration() {
   rtdCalibTable.clear();
-  File f = FFat.open(CALIB_FILE, "r");
-  if (!f) return;
+  File f = storageFS().open(CALIB_FILE, "r");
+  if (!f) {
+    rebuildCalibrationLut();  // No file: drop the previous table's LUT too
+    return;
+  }
   
   // MEMORY OPTIMIZATION: Reduced from 4096 to 1024 bytes (75% reduction)
   DynamicJsonDocument doc(1024);
@@ -39,53 +59,178 @@ void loadCalibration() {
       CalibPoint pt = { o["raw"], o["temp"] };
       rtdCalibTable.push_back(pt);
     }
+    setCalibFitMode(doc["fit"] | "piecewise");
   }
   f.close();
+  
+  std::sort(rtdCalibTable.begin(), rtdCalibTable.end(),
+            [](const CalibPoint& a, const CalibPoint& b) { return a.raw < b.raw; });
+  rebuildCalibrationLut();
 }
 
-float tempFromRaw(int raw) {
-  if (rtdCalibTable.empty()) return 0;
-  if (raw <= rtdCalibTable.front().raw) return rtdCalibTable.front().temp;
-  if (raw >= rtdCalibTable.back().raw) return rtdCalibTable.back().temp;
-  for(size_t i=1; i<rtdCalibTable.size(); ++i) {
+// Piecewise-linear interpolation over the (sorted) table, optionally skipping one point.
+static float interpolateTable(float raw, int skip) {
+  int first = (skip == 0) ? 1 : 0;
+  int last = (int)rtdCalibTable.size() - 1;
+  if (skip == last) last--;
+  if (first > last) return rtdCalibTable[first].temp;
+  if (raw <= rtdCalibTable[first].raw) return rtdCalibTable[first].temp;
+  if (raw >= rtdCalibTable[last].raw) return rtdCalibTable[last].temp;
+  int prev = first;
+  for (int i = first + 1; i <= last; ++i) {
+    if (i == skip) continue;
     if (raw < rtdCalibTable[i].raw) {
-      auto &a = rtdCalibTable[i-1], &b = rtdCalibTable[i];
-      float t = a.temp + (raw - a.raw) * (b.temp - a.temp) / (b.raw - a.raw);
-      return t;
+      const CalibPoint &a = rtdCalibTable[prev], &b = rtdCalibTable[i];
+      return a.temp + (raw - a.raw) * (b.temp - a.temp) / (b.raw - a.raw);
     }
+    prev = i;
   }
-  return rtdCalibTable.back().temp;
+  return rtdCalibTable[last].temp;
 }
 
-float readTemperature() {
-  int raw = analogRead(PIN_RTD);  // RTD on ESP32 analog pin
-  
-  // CRITICAL SAFETY FIX: Raw reading of 0 means VERY HOT temperature, not sensor failure!
-  // RTD resistance drops as temperature increases, so raw=0 means maximum temperature
-  if (raw == 0) {
-    Serial.println("CRITICAL TEMPERATURE ALERT: Raw reading is 0 - EXTREMELY HOT TEMPERATURE DETECTED!");
-    Serial.println("Immediately shutting off heater for safety - temperature is at maximum scale!");
-    // Turn off heater immediately for safety
-    extern void setHeater(bool);  // Forward declaration
-    setHeater(false);
-    // Return the maximum temperature from our calibration table (highest temperature we can measure)
-    if (!rtdCalibTable.empty()) {
-      float maxTemp = rtdCalibTable.front().temp;  // First entry should be highest temp (raw=0)
-      Serial.printf("Returning maximum calibrated temperature: %.1f°C\n", maxTemp);
-      return maxTemp;
+// Least-squares polynomial fit of temp against normalised raw (raw / 4095).
+// Solves the normal equations with partial pivoting; returns false if singular.
+static bool fitPolynomial(uint8_t degree) {
+  const int n = degree + 1;
+  double a[CALIB_FIT_MAX_DEGREE + 1][CALIB_FIT_MAX_DEGREE + 2] = {};
+  for (const CalibPoint& p : rtdCalibTable) {
+    double x = p.raw / 4095.0;
+    double pw[2 * CALIB_FIT_MAX_DEGREE + 1];
+    pw[0] = 1.0;
+    for (int k = 1; k <= 2 * degree; k++) pw[k] = pw[k - 1] * x;
+    for (int r = 0; r < n; r++) {
+      for (int c = 0; c < n; c++) a[r][c] += pw[r + c];
+      a[r][n] += pw[r] * p.temp;
     }
-    // Fallback if no calibration table
-    return 250.0f;  // Return a high but realistic maximum temperature
   }
-  
-  float temp = tempFromRaw(raw);
-  
-  // Temperature sensor fault detection - only for unrealistic readings
-  if (temp > 300.0f || temp < -50.0f) {
-    Serial.println("WARNING: Temperature sensor fault detected - extreme reading: " + String(temp) + "°C");
-    Serial.println("Raw ADC value: " + String(raw));
-    return 25.0f;  // Return safe room temperature default
+  for (int col = 0; col < n; col++) {
+    int pivot = col;
+    for (int r = col + 1; r < n; r++) {
+      if (fabs(a[r][col]) > fabs(a[pivot][col])) pivot = r;
+    }
+    if (fabs(a[pivot][col]) < 1e-12) return false;
+    if (pivot != col) {
+      for (int c = 0; c <= n; c++) std::swap(a[col][c], a[pivot][c]);
+    }
+    for (int r = 0; r < n; r++) {
+      if (r == col) continue;
+      double f = a[r][col] / a[col][col];
+      for (int c = col; c <= n; c++) a[r][c] -= f * a[col][c];
+    }
   }
-  
-  return temp;
+  for (int k = 0; k < n; k++) calibPoly[k] = a[k][n] / a[k][k];
+  for (int k = n; k <= CALIB_FIT_MAX_DEGREE; k++) calibPoly[k] = 0.0;
+  return true;
+}
+
+static float evalPolynomial(float raw) {
+  // Clamp to the calibrated span - polynomials must not extrapolate
+  float lo = rtdCalibTable.front().raw, hi = rtdCalibTable.back().raw;
+  double x = constrain(raw, lo, hi) / 4095.0;
+  double t = 0.0;
+  for (int k = calibPolyDegree; k >= 0; k--) t = t * x + calibPoly[k];
+  return (float)t;
+}
+
+void rebuildCalibrationLut() {
+  unsigned long startUs = micros();
+  calibLutValid = false;
+  calibPolyDegree = 0;
+  calibResiduals.assign(rtdCalibTable.size(), 0.0f);
+  calibLooResiduals.assign(rtdCalibTable.size(), 0.0f);
+  calibRms = 0.0f;
+  if (rtdCalibTable.empty()) return;
+
+  // Fall back to piecewise when there are too few points for the requested degree
+  if (calibFitMode != CALIB_FIT_PIECEWISE && rtdCalibTable.size() > calibFitMode) {
+    if (fitPolynomial(calibFitMode)) {
+      calibPolyDegree = calibFitMode;
+    } else if (debugSerial) {
+      Serial.println("[CALIB] Polynomial fit is singular, using piecewise table");
+    }
+  }
+
+  size_t seg = 1;
+  for (int raw = 0; raw < CALIB_LUT_SIZE; raw++) {
+    float t;
+    if (calibPolyDegree > 0) {
+      t = evalPolynomial(raw);
+    } else if (raw <= rtdCalibTable.front().raw) {
+      t = rtdCalibTable.front().temp;
+    } else if (raw >= rtdCalibTable.back().raw) {
+      t = rtdCalibTable.back().temp;
+    } else {
+      // raw increases monotonically, so the active segment only moves forward
+      while (seg < rtdCalibTable.size() - 1 && raw >= rtdCalibTable[seg].raw) seg++;
+      const CalibPoint &a = rtdCalibTable[seg - 1], &b = rtdCalibTable[seg];
+      t = a.temp + (raw - a.raw) * (b.temp - a.temp) / (b.raw - a.raw);
+    }
+    calibLut[raw] = (int16_t)lroundf(constrain(t, -300.0f, 320.0f) * 100.0f);
+  }
+  calibLutValid = true;
+
+  // Residuals: fit error per point, plus leave-one-out error so an outlier stands
+  // out even in piecewise mode (where the fit passes through every point)
+  double sumSq = 0.0;
+  for (size_t i = 0; i < rtdCalibTable.size(); i++) {
+    const CalibPoint& p = rtdCalibTable[i];
+    float fitted = calibPolyDegree > 0 ? evalPolynomial(p.raw) : p.temp;
+    calibResiduals[i] = fitted - p.temp;
+    calibLooResiduals[i] = rtdCalibTable.size() > 2 ? interpolateTable(p.raw, (int)i) - p.temp : 0.0f;
+    sumSq += (double)calibResiduals[i] * calibResiduals[i];
+  }
+  calibRms = (float)sqrt(sumSq / rtdCalibTable.size());
+
+  if (debugSerial) {
+    Serial.printf("[CALIB] LUT rebuilt (%s, %u points) in %lu us, RMS residual %.3f°C\n",
+                  calibFitModeName(), (unsigned)rtdCalibTable.size(), micros() - startUs, calibRms);
+  }
+}
+
+const char* calibFitModeName() {
+  switch (calibFitMode) {
+    case 1: return "poly1";
+    case 2: return "poly2";
+    case 3: return "poly3";
+    default: return "piecewise";
+  }
+}
+
+bool setCalibFitMode(const String& name) {
+  if (name == "piecewise") calibFitMode = CALIB_FIT_PIECEWISE;
+  else if (name == "poly1") calibFitMode = 1;
+  else if (name == "poly2") calibFitMode = 2;
+  else if (name == "poly3") calibFitMode = 3;
+  else return false;
+  return true;
+}
+
+float calibResidual(size_t index) {
+  return index < calibResiduals.size() ? calibResiduals[index] : 0.0f;
+}
+
+float calibLooResidual(size_t index) {
+  return index < calibLooResiduals.size() ? calibLooResiduals[index] : 0.0f;
+}
+
+float calibRmsResidual() {
+  return calibRms;
+}
+
+float tempFromRaw(float raw) {
+  if (!calibLutValid) {
+    if (rtdCalibTable.empty()) return 0;
+    rebuildCalibrationLut();
+  }
+  if (raw <= 0.0f) return calibLut[0] * 0.01f;
+  if (raw >= CALIB_LUT_SIZE - 1) return calibLut[CALIB_LUT_SIZE - 1] * 0.01f;
+  int idx = (int)raw;
+  float frac = raw - idx;
+  return (calibLut[idx] + (calibLut[idx + 1] - calibLut[idx]) * frac) * 0.01f;
+}
+
+// Latest calibrated (unsmoothed) temperature published by the sensor service.
+// Never touches the ADC - check sensorGetHealth() where validity matters.
+float readTemperature() {
+  return sensorGetReading().temperature;
 }
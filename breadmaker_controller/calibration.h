@@ -7,7 +7,21 @@ extern std::vector<CalibPoint> rtdCalibTable;
 extern const char* CALIB_FILE;
 extern float calibrationSlope, calibrationOffset;
 
+// Calibration is compiled into a dense lookup table covering the 12-bit ADC range,
+// either from piecewise-linear segments or from a least-squares polynomial fit.
+constexpr int CALIB_LUT_SIZE = 4096;
+constexpr uint8_t CALIB_FIT_PIECEWISE = 0;  // 1..3 = polynomial degree
+constexpr uint8_t CALIB_FIT_MAX_DEGREE = 3;
+extern uint8_t calibFitMode;
+
 void saveCalibration();
+void serializeCalibrationJson(Print& f);
 void loadCalibration();
-float tempFromRaw(int raw);
+void rebuildCalibrationLut();               // Call after any change to rtdCalibTable or calibFitMode
+const char* calibFitModeName();
+bool setCalibFitMode(const String& name);  // "piecewise", "poly1", "poly2", "poly3"
+float calibResidual(size_t index);          // Fitted minus measured temp for point `index`
+float calibLooResidual(size_t index);       // Leave-one-out residual (neighbour interpolation)
+float calibRmsResidual();
+float tempFromRaw(float raw);  // raw may be fractional (oversampled ADC counts)
 float readTemperature();
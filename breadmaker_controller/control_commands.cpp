@@ -0,0 +1,261 @@
+#include "control_commands.h"
+#include "control_task.h"
+#include "debug_log.h"
+#include <atomic>
+#include <cstring>
+#ifndef NATIVE_SIMULATION
+#include <esp_timer.h>
+#endif
+
+static const uint32_t QUEUE_MASK = CONTROL_COMMAND_QUEUE_SIZE - 1;
+static_assert((CONTROL_COMMAND_QUEUE_SIZE & QUEUE_MASK) == 0, "queue size must be a power of two");
+
+// Ring slot: seq == position when free for that producer, position + 1 once filled
+struct CommandSlot {
+  std::atomic<uint32_t> seq{0};
+  ControlCommand cmd;
+  int64_t submittedUs = 0;
+  uint8_t batchFollowing = 0;  // Commands after this one in the same batch
+};
+
+// Completion: doneToken is cleared before result is rewritten and published after it,
+// so a reader that sees the same token before and after copying got a whole result
+struct CommandCompletion {
+  std::atomic<uint32_t> doneToken{0};
+  ControlCommandResult result;
+};
+
+static CommandSlot ring[CONTROL_COMMAND_QUEUE_SIZE];
+static CommandCompletion completions[CONTROL_COMMAND_QUEUE_SIZE];
+static std::atomic<uint32_t> enqueuePos{0};
+static uint32_t dequeuePos = 0;  // Consumer only
+static ControlCommandApplier applier = nullptr;
+static void (*stateChangedHook)() = nullptr;
+
+static std::atomic<uint32_t> submittedCount{0};
+static std::atomic<uint32_t> rejectedCount{0};
+static std::atomic<uint32_t> timeoutCount{0};
+static std::atomic<uint32_t> batchCount{0};
+static ControlCommandStats consumerStats;  // applied / depth / latency (consumer only)
+
+static const char* const COMMAND_NAMES[CMD_TYPE_COUNT] = {
+  "ping", "advance", "back", "start_at_stage", "pause", "resume", "add_prefermentation", "set_setpoint",
+  "select_program", "start", "stop", "set_output", "schedule_start"
+};
+
+void controlCommandsBegin(ControlCommandApplier apply, void (*onStateChanged)()) {
+  for (uint32_t i = 0; i < CONTROL_COMMAND_QUEUE_SIZE; i++) {
+    ring[i].seq.store(i, std::memory_order_relaxed);
+    completions[i].doneToken.store(0, std::memory_order_relaxed);
+  }
+  enqueuePos.store(0, std::memory_order_relaxed);
+  dequeuePos = 0;
+  applier = apply;
+  stateChangedHook = onStateChanged;
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+uint32_t controlCommandSubmit(const ControlCommand& cmd) {
+  uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+  CommandSlot* slot;
+  for (;;) {
+    slot = &ring[pos & QUEUE_MASK];
+    uint32_t seq = slot->seq.load(std::memory_order_acquire);
+    int32_t diff = (int32_t)(seq - pos);
+    if (diff == 0) {
+      if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+    } else if (diff < 0) {
+      rejectedCount.fetch_add(1, std::memory_order_relaxed);
+      return 0;  // Full: the consumer hasn't freed this slot yet
+    } else {
+      pos = enqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+  slot->cmd = cmd;
+  slot->submittedUs = esp_timer_get_time();
+  slot->batchFollowing = 0;
+  slot->seq.store(pos + 1, std::memory_order_release);
+  submittedCount.fetch_add(1, std::memory_order_relaxed);
+  return pos + 1;  // Token: never 0
+}
+
+uint32_t controlCommandSubmitBatch(const ControlCommand* cmds, uint8_t count) {
+  if (count == 0 || count > CONTROL_COMMAND_MAX_BATCH) return 0;
+  uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+  for (;;) {
+    uint32_t seq = ring[pos & QUEUE_MASK].seq.load(std::memory_order_acquire);
+    int32_t diff = (int32_t)(seq - pos);
+    if (diff == 0) {
+      // Slots are freed in order: if the last one is free, so are the ones before it
+      uint32_t last = pos + count - 1;
+      if ((int32_t)(ring[last & QUEUE_MASK].seq.load(std::memory_order_acquire) - last) < 0) {
+        rejectedCount.fetch_add(count, std::memory_order_relaxed);
+        return 0;
+      }
+      if (enqueuePos.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) break;
+    } else if (diff < 0) {
+      rejectedCount.fetch_add(count, std::memory_order_relaxed);
+      return 0;
+    } else {
+      pos = enqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+  // Publish back to front: the consumer stops at the first unfilled slot, so it can't
+  // start on the batch until all of it is there
+  int64_t now = esp_timer_get_time();
+  for (int i = count - 1; i >= 0; i--) {
+    CommandSlot& slot = ring[(pos + i) & QUEUE_MASK];
+    slot.cmd = cmds[i];
+    slot.submittedUs = now;
+    slot.batchFollowing = count - 1 - i;
+    slot.seq.store(pos + i + 1, std::memory_order_release);
+  }
+  submittedCount.fetch_add(count, std::memory_order_relaxed);
+  batchCount.fetch_add(1, std::memory_order_relaxed);
+  return pos + 1;
+}
+
+bool controlCommandsProcess() {
+  bool changed = false;
+  uint32_t drained = 0;
+  uint8_t skip = 0;  // Rest of a batch whose command failed
+  for (;;) {
+    CommandSlot& slot = ring[dequeuePos & QUEUE_MASK];
+    uint32_t seq = slot.seq.load(std::memory_order_acquire);
+    if ((int32_t)(seq - (dequeuePos + 1)) < 0) break;  // Empty (or producer still writing)
+
+    ControlCommand cmd = slot.cmd;
+    int64_t submittedUs = slot.submittedUs;
+    uint8_t following = slot.batchFollowing;
+    uint32_t token = dequeuePos + 1;
+    slot.seq.store(dequeuePos + CONTROL_COMMAND_QUEUE_SIZE, std::memory_order_release);
+    dequeuePos++;
+
+    CommandCompletion& done = completions[token & QUEUE_MASK];
+    done.doneToken.store(0, std::memory_order_relaxed);  // A reader still copying the old result retries
+    std::atomic_thread_fence(std::memory_order_release);
+    done.result = ControlCommandResult();
+    if (skip) {
+      skip--;
+      done.result.httpCode = 424;
+      snprintf(done.result.body, sizeof(done.result.body), "{\"status\":\"skipped\",\"message\":\"An earlier command in the batch failed\"}");
+      done.doneToken.store(token, std::memory_order_release);
+      consumerStats.skipped++;
+      drained++;
+      continue;
+    }
+    if (cmd.type == CMD_PING) {
+      done.result.value = cmd.intArg;
+    } else if (applier && cmd.type < CMD_TYPE_COUNT) {
+      applier(cmd, done.result);
+    } else {
+      done.result.httpCode = 400;
+      snprintf(done.result.body, sizeof(done.result.body), "{\"status\":\"error\",\"message\":\"Unknown command\"}");
+    }
+    changed |= done.result.stateChanged;
+    if (following && done.result.httpCode >= 400) skip = following;
+    done.doneToken.store(token, std::memory_order_release);
+
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - submittedUs);
+    consumerStats.applied++;
+    consumerStats.lastLatencyUs = latency;
+    if (latency > consumerStats.maxLatencyUs) consumerStats.maxLatencyUs = latency;
+    consumerStats.totalLatencyUs += latency;
+    drained++;
+    if (cmd.type != CMD_PING) {
+      LOG_DEBUG(LOG_SYSTEM, "[CMD] %s applied -> %d (%lu us after submit)\n", controlCommandName(cmd.type),
+                done.result.httpCode, (unsigned long)latency);
+    }
+  }
+  if (drained > consumerStats.maxDepth) consumerStats.maxDepth = drained;
+  if (changed && stateChangedHook) stateChangedHook();
+  return changed;
+}
+
+// Copies the result behind token if it is complete and still there
+static bool copyResult(uint32_t token, ControlCommandResult& out) {
+  CommandCompletion& done = completions[token & QUEUE_MASK];
+  if (done.doneToken.load(std::memory_order_acquire) != token) return false;
+  out = done.result;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return done.doneToken.load(std::memory_order_relaxed) == token;  // Not recycled during the copy
+}
+
+bool controlCommandWait(uint32_t token, ControlCommandResult& out, unsigned long timeoutMs) {
+  unsigned long start = millis();
+  for (;;) {
+    if (!controlTaskRunning() || onControlCore()) {
+      // Nobody else will drain the queue: apply inline, as the loop-driven firmware did
+      ControlLockGuard guard;
+      controlCommandsProcess();
+    }
+    if (copyResult(token, out)) return true;
+    if (millis() - start >= timeoutMs) {
+      timeoutCount.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    delay(1);
+  }
+}
+
+bool controlCommandWaitBatch(uint32_t token, uint8_t count, ControlCommandResult* out, unsigned long timeoutMs) {
+  // The batch is applied in one pass: once its last command is done, all of them are
+  if (!controlCommandWait(token + count - 1, out[count - 1], timeoutMs)) return false;
+  for (uint8_t i = 0; i + 1 < count; i++) {
+    if (!copyResult(token + i, out[i])) return false;  // Already recycled
+  }
+  return true;
+}
+
+bool controlCommandExecute(const ControlCommand& cmd, ControlCommandResult& out) {
+  uint32_t token = controlCommandSubmit(cmd);
+  if (token == 0) {
+    out = ControlCommandResult();
+    out.httpCode = 503;
+    snprintf(out.body, sizeof(out.body), "{\"status\":\"error\",\"message\":\"Command queue full\"}");
+    return false;
+  }
+  if (!controlCommandWait(token, out)) {
+    out = ControlCommandResult();
+    out.httpCode = 503;
+    snprintf(out.body, sizeof(out.body), "{\"status\":\"queued\",\"message\":\"Command will apply on the next control tick\"}");
+    return false;
+  }
+  return true;
+}
+
+const char* controlCommandName(ControlCommandType type) {
+  return type < CMD_TYPE_COUNT ? COMMAND_NAMES[type] : "unknown";
+}
+
+bool controlCommandFromName(const char* name, ControlCommandType& type) {
+  for (uint8_t i = 0; i < CMD_TYPE_COUNT; i++) {
+    if (strcmp(name, COMMAND_NAMES[i]) == 0) {
+      type = (ControlCommandType)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+ControlCommandStats controlCommandsGetStats() {
+  ControlCommandStats st;
+  {
+    ControlLockGuard guard;  // Consumer stats are written under the control lock
+    st = consumerStats;
+  }
+  st.submitted = submittedCount.load(std::memory_order_relaxed);
+  st.rejectedFull = rejectedCount.load(std::memory_order_relaxed);
+  st.timeouts = timeoutCount.load(std::memory_order_relaxed);
+  st.batches = batchCount.load(std::memory_order_relaxed);
+  return st;
+}
+
+void controlCommandsResetStats() {
+  ControlLockGuard guard;
+  consumerStats = ControlCommandStats();
+  submittedCount.store(0, std::memory_order_relaxed);
+  rejectedCount.store(0, std::memory_order_relaxed);
+  timeoutCount.store(0, std::memory_order_relaxed);
+  batchCount.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <Arduino.h>
+
+// Command queue from web handlers to the control tick.
+// Handlers that change program state (/advance, /back, /start_at_stage, /pause,
+// /resume, /api/add_prefermentation, /api/temperature) no longer touch programState,
+// fermentState or pid themselves: they submit a typed command and wait on its
+// completion token. The control task applies queued commands in submission order at
+// the start of its next tick and saves the resume file once for the whole batch.
+//
+// The queue is a bounded multi-producer / single-consumer ring (per-slot sequence
+// numbers, no locks): any task may submit, only the control tick drains it.
+//
+// Batches. /api/batch submits several commands with controlCommandSubmitBatch(): they
+// take consecutive slots and the first slot is published last, so the tick that sees
+// the batch drains all of it - no tick runs (and no status is rendered) between two
+// commands of a batch. If a command fails (HTTP status 400 or above) the rest of its
+// batch is skipped with 424; the commands before it stay applied, and the per-command
+// results say where the batch stopped.
+
+constexpr uint8_t CONTROL_COMMAND_QUEUE_SIZE = 16;          // Power of two
+constexpr unsigned long CONTROL_COMMAND_TIMEOUT_MS = 1000;  // Handler wait for completion
+constexpr uint8_t CONTROL_COMMAND_MAX_BATCH = 8;            // Commands per batch
+
+enum ControlCommandType : uint8_t {
+  CMD_PING = 0,             // No-op; result.value echoes intArg (health check / benchmark)
+  CMD_ADVANCE,              // Next stage
+  CMD_BACK,                 // Previous stage (wraps to last)
+  CMD_START_AT_STAGE,       // intArg = stage
+  CMD_PAUSE,
+  CMD_RESUME,
+  CMD_ADD_PREFERMENTATION,  // floatArg = seconds
+  CMD_SET_SETPOINT,         // floatArg = °C
+  CMD_SELECT_PROGRAM,       // intArg = program id (read from flash by the tick unless cached)
+  CMD_START,                // intArg = stage; starts a new run like /start
+  CMD_STOP,
+  CMD_SET_OUTPUT,           // intArg = output (0 heater, 1 motor, 2 light, 3 buzzer), auxArg = on
+  CMD_SCHEDULE_START,       // intArg = minutes after midnight (-1 cancels), auxArg = stage (-1 = from the start)
+  CMD_TYPE_COUNT
+};
+
+struct ControlCommand {
+  ControlCommandType type = CMD_PING;
+  int32_t intArg = 0;
+  float floatArg = 0.0f;
+  int32_t auxArg = 0;
+};
+
+struct ControlCommandResult {
+  int16_t httpCode = 200;
+  bool stateChanged = false;  // Applier sets this to have the resume file saved after the batch
+  int32_t value = 0;
+  char body[96] = "";         // JSON response; empty on success means "send the status JSON"
+};
+
+struct ControlCommandStats {
+  uint32_t submitted = 0;
+  uint32_t applied = 0;
+  uint32_t rejectedFull = 0;
+  uint32_t timeouts = 0;          // Handlers that gave up waiting (command still applies)
+  uint32_t batches = 0;
+  uint32_t skipped = 0;           // Batch commands not applied because an earlier one failed
+  uint32_t maxDepth = 0;          // Most commands drained in one tick
+  uint32_t lastLatencyUs = 0;     // Submit to applied
+  uint32_t maxLatencyUs = 0;
+  uint64_t totalLatencyUs = 0;
+};
+
+typedef void (*ControlCommandApplier)(const ControlCommand& cmd, ControlCommandResult& result);
+
+// Resets the ring and sets the function that applies commands (control tick context).
+// onStateChanged runs once after a batch in which any command set stateChanged.
+void controlCommandsBegin(ControlCommandApplier apply, void (*onStateChanged)() = nullptr);
+
+// Queues a command; returns its completion token, or 0 if the queue is full
+uint32_t controlCommandSubmit(const ControlCommand& cmd);
+
+// Queues count commands (1..CONTROL_COMMAND_MAX_BATCH) to be applied in one tick.
+// Returns the first token (the others follow it: token + i), or 0 if there isn't
+// room for all of them - then none is queued.
+uint32_t controlCommandSubmitBatch(const ControlCommand* cmds, uint8_t count);
+
+// Waits until the command behind token has been applied and copies its result.
+// Without the control task (or when called from it) pending commands are applied
+// inline, so callers behave the same in loop-driven mode.
+bool controlCommandWait(uint32_t token, ControlCommandResult& out, unsigned long timeoutMs = CONTROL_COMMAND_TIMEOUT_MS);
+
+// Waits for a whole batch (token from controlCommandSubmitBatch) and copies its
+// count results. Completions are recycled CONTROL_COMMAND_QUEUE_SIZE commands later,
+// so the results are collected together, as soon as the batch has been applied.
+bool controlCommandWaitBatch(uint32_t token, uint8_t count, ControlCommandResult* out,
+                             unsigned long timeoutMs = CONTROL_COMMAND_TIMEOUT_MS);
+
+// Submit + wait. On a full queue or timeout, out carries a 503 body.
+bool controlCommandExecute(const ControlCommand& cmd, ControlCommandResult& out);
+
+// Drains the queue in order (control tick only); returns true if any command changed state
+bool controlCommandsProcess();
+
+const char* controlCommandName(ControlCommandType type);
+bool controlCommandFromName(const char* name, ControlCommandType& type);
+ControlCommandStats controlCommandsGetStats();
+void controlCommandsResetStats();
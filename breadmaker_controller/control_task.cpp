@@ -0,0 +1,129 @@
+#include "control_task.h"
+#include "trace_recorder.h"
+#include <atomic>
+#ifndef NATIVE_SIMULATION
+#include <esp_timer.h>
+#endif
+
+extern bool debugSerial;
+
+static TaskHandle_t controlTaskHandle = nullptr;
+static SemaphoreHandle_t controlMutex = nullptr;
+static void (*controlTick)() = nullptr;
+
+// Sequence lock: odd while the control task is writing
+static std::atomic<uint32_t> snapshotSeq{0};
+static ControlSnapshot snapshot;
+
+static ControlTaskStats stats;
+
+static void controlTaskMain(void*) {
+  const TickType_t period = pdMS_TO_TICKS(CONTROL_TICK_MS);
+  const int64_t periodUs = (int64_t)CONTROL_TICK_MS * 1000;
+  TickType_t lastWake = xTaskGetTickCount();
+  int64_t dueUs = esp_timer_get_time() + periodUs;
+
+  for (;;) {
+    vTaskDelayUntil(&lastWake, period);
+    int64_t wakeUs = esp_timer_get_time();
+    uint32_t late = wakeUs > dueUs ? (uint32_t)(wakeUs - dueUs) : 0;
+
+    xSemaphoreTakeRecursive(controlMutex, portMAX_DELAY);
+    int64_t startUs = esp_timer_get_time();
+    controlTick();
+    int64_t endUs = esp_timer_get_time();
+
+    // Stats are updated under the lock so a reset from a handler can't interleave
+    uint32_t lockWait = (uint32_t)(startUs - wakeUs);
+    uint32_t tickUs = (uint32_t)(endUs - startUs);
+    stats.ticks++;
+    stats.lastTickUs = tickUs;
+    if (tickUs > stats.maxTickUs) stats.maxTickUs = tickUs;
+    stats.lastLatenessUs = late;
+    if (late > stats.maxLatenessUs) stats.maxLatenessUs = late;
+    stats.totalLatenessUs += late;
+    if (lockWait > stats.maxLockWaitUs) stats.maxLockWaitUs = lockWait;
+    // Spans under the recording threshold are skipped, so a normal tick costs no ring space
+    traceComplete(TRACE_CONTROL, "late wake", dueUs, late);
+    traceComplete(TRACE_CONTROL, "lock wait", wakeUs, lockWait);
+    traceComplete(TRACE_CONTROL, "control tick", startUs, tickUs);
+
+    dueUs += periodUs;
+    if (endUs > dueUs) {
+      // vTaskDelayUntil() returns immediately for missed periods; re-anchor so one
+      // long tick is counted once rather than as a burst of late ticks
+      stats.overruns++;
+      traceInstant(TRACE_CONTROL, "tick overrun");
+      lastWake = xTaskGetTickCount();
+      dueUs = endUs + periodUs;
+    }
+    if ((stats.ticks & 0xFF) == 0) {
+      stats.stackFreeBytes = uxTaskGetStackHighWaterMark(nullptr) * sizeof(StackType_t);
+    }
+    xSemaphoreGiveRecursive(controlMutex);
+  }
+}
+
+bool controlTaskBegin(void (*tick)()) {
+  if (controlTaskHandle) return true;
+  if (!controlMutex) controlMutex = xSemaphoreCreateRecursiveMutex();
+  if (!controlMutex || !tick) return false;
+  controlTick = tick;
+  BaseType_t ok = xTaskCreatePinnedToCore(controlTaskMain, "control", CONTROL_TASK_STACK, nullptr,
+                                          CONTROL_TASK_PRIORITY, &controlTaskHandle, CONTROL_TASK_CORE);
+  if (ok != pdPASS) {
+    controlTaskHandle = nullptr;
+    Serial.println("[CONTROL] Task creation failed - control stays in loop()");
+    return false;
+  }
+  if (debugSerial) {
+    Serial.printf("[CONTROL] Task started on core %d, %lu ms period (loop on core %d)\n",
+                  (int)CONTROL_TASK_CORE, CONTROL_TICK_MS, (int)xPortGetCoreID());
+  }
+  return true;
+}
+
+bool controlTaskRunning() {
+  return controlTaskHandle != nullptr;
+}
+
+bool onControlCore() {
+  return controlTaskHandle != nullptr && xTaskGetCurrentTaskHandle() == controlTaskHandle;
+}
+
+void controlLock() {
+  if (!controlMutex) controlMutex = xSemaphoreCreateRecursiveMutex();
+  xSemaphoreTakeRecursive(controlMutex, portMAX_DELAY);
+}
+
+void controlUnlock() {
+  xSemaphoreGiveRecursive(controlMutex);
+}
+
+void controlSnapshotPublish(const ControlSnapshot& snap) {
+  uint32_t seq = snapshotSeq.load(std::memory_order_relaxed);
+  snapshotSeq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  snapshot = snap;
+  snapshotSeq.store(seq + 2, std::memory_order_release);
+}
+
+bool controlSnapshotRead(ControlSnapshot& out) {
+  for (;;) {
+    uint32_t before = snapshotSeq.load(std::memory_order_acquire);
+    if (before == 0) return false;
+    if (before & 1) continue;  // Writer mid-copy; it finishes within microseconds
+    out = snapshot;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (snapshotSeq.load(std::memory_order_relaxed) == before) return true;
+  }
+}
+
+const ControlTaskStats& controlTaskGetStats() {
+  return stats;
+}
+
+void controlTaskResetStats() {
+  ControlLockGuard guard;
+  stats = ControlTaskStats();
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <Arduino.h>
+
+// Dedicated control task.
+// The control path (sensor sampling, safety checks, PID and heater window, mixing,
+// fermentation timing and stage advance) runs in its own FreeRTOS task pinned to
+// CONTROL_TASK_CORE and paced by vTaskDelayUntil(), so a slow HTTP client, a large
+// static file or an OTA chunk in loop() no longer delays it. loop() keeps the web
+// server, display, OTA and serial on the other core.
+//
+// Shared state:
+// - Each tick runs with the control lock held. Code on the loop core that changes
+//   control state (program, PID, outputs, calibration) takes the same lock through
+//   ControlLockGuard; the lock is only held for the length of a handler, never while
+//   streaming a file.
+// - Everything the loop core only needs to display is published once per tick as a
+//   ControlSnapshot through a sequence lock: the writer never blocks and readers
+//   retry until they get a consistent copy.
+
+constexpr unsigned long CONTROL_TICK_MS = 20;       // Control period (was 15-50 ms of loop rate limiting)
+constexpr BaseType_t CONTROL_TASK_CORE = 0;         // loop() runs on core 1
+constexpr UBaseType_t CONTROL_TASK_PRIORITY = 3;    // Above loop() (1), below the WiFi/lwIP tasks
+constexpr uint32_t CONTROL_TASK_STACK = 8192;       // Same as the Arduino loop task it replaces
+
+struct ControlSnapshot {
+  uint32_t tick = 0;
+  unsigned long atMs = 0;
+  float temperature = 0.0f;        // Averaged (EMA or Kalman), as shown in the web UI
+  float sensorTemperature = 0.0f;  // Latest calibrated reading
+  float setpoint = 0.0f;
+  float pidOutput = 0.0f;
+  bool running = false;
+  bool manualMode = false;
+  bool heater = false;
+  bool motor = false;
+  bool light = false;
+  bool buzzer = false;
+  uint8_t stageIdx = 0;
+  uint8_t mixIdx = 0;
+  unsigned long stageStart = 0;
+};
+
+struct ControlTaskStats {
+  uint32_t ticks = 0;
+  uint32_t overruns = 0;          // Ticks that ended after the next one was due
+  uint32_t lastTickUs = 0;        // Time spent in the tick (lock held)
+  uint32_t maxTickUs = 0;
+  uint32_t lastLatenessUs = 0;    // Wake-up time minus scheduled time
+  uint32_t maxLatenessUs = 0;
+  uint64_t totalLatenessUs = 0;
+  uint32_t maxLockWaitUs = 0;     // Time the tick waited for a handler holding the lock
+  uint32_t stackFreeBytes = 0;    // Stack high-water mark
+};
+
+// Starts the task running tick() every CONTROL_TICK_MS; returns false (loop-driven fallback) on failure
+bool controlTaskBegin(void (*tick)());
+bool controlTaskRunning();
+bool onControlCore();             // True when called from the control task
+
+// Control lock (recursive) - held by the control task for each tick
+void controlLock();
+void controlUnlock();
+
+class ControlLockGuard {
+public:
+  ControlLockGuard() { controlLock(); }
+  ~ControlLockGuard() { controlUnlock(); }
+  ControlLockGuard(const ControlLockGuard&) = delete;
+  ControlLockGuard& operator=(const ControlLockGuard&) = delete;
+};
+
+// Called by the control task at the end of each tick
+void controlSnapshotPublish(const ControlSnapshot& snap);
+// Lock-free consistent copy of the last published snapshot; false until the task has published one
+bool controlSnapshotRead(ControlSnapshot& out);
+
+const ControlTaskStats& controlTaskGetStats();
+void controlTaskResetStats();
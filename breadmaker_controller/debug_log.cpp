@@ -0,0 +1,185 @@
+#include "debug_log.h"
+#include "telemetry_stream.h"
+#include <cstdarg>
+#include <cstring>
+#include <cstdlib>
+
+static const char* const CATEGORY_NAMES[LOG_CATEGORY_COUNT] = {
+  "system", "ferment", "mix", "stage", "pid", "temp", "web", "storage"
+};
+static const char* const LEVEL_NAMES[] = { "none", "error", "warn", "info", "debug", "verbose" };
+
+uint8_t logCategoryLevels[LOG_CATEGORY_COUNT] = {
+  LOG_LEVEL_DEBUG, LOG_LEVEL_DEBUG, LOG_LEVEL_DEBUG, LOG_LEVEL_DEBUG,
+  LOG_LEVEL_DEBUG, LOG_LEVEL_DEBUG, LOG_LEVEL_DEBUG, LOG_LEVEL_DEBUG
+};
+
+struct RateBucket {
+  uint8_t tokens = LOG_RATE_BURST;
+  unsigned long refilledMs = 0;
+  uint32_t pending = 0;           // Suppressed since the last message that passed
+};
+
+// Byte ring of complete lines; head/tail only move under logMux
+static char ring[LOG_RING_SIZE];
+static uint32_t head = 0;         // Next write
+static uint32_t tail = 0;         // Next read
+static portMUX_TYPE logMux = portMUX_INITIALIZER_UNLOCKED;
+static RateBucket buckets[LOG_CATEGORY_COUNT];
+static LogStats stats;
+
+// Copies a whole line into the ring, or drops it (caller holds logMux)
+static bool ringPush(const char* line, size_t len) {
+  uint32_t used = head - tail;
+  if (len > LOG_RING_SIZE - used) {
+    stats.dropped++;
+    return false;
+  }
+  size_t at = head % LOG_RING_SIZE;
+  size_t first = len < LOG_RING_SIZE - at ? len : LOG_RING_SIZE - at;
+  memcpy(ring + at, line, first);
+  memcpy(ring, line + first, len - first);
+  head += len;
+  stats.messages++;
+  stats.bytes += len;
+  if (used + len > stats.highWater) stats.highWater = used + len;
+  return true;
+}
+
+// Token bucket; returns false when the message is over the category's rate (caller holds logMux)
+static bool takeToken(RateBucket& b, unsigned long now) {
+  unsigned long elapsed = now - b.refilledMs;
+  if (elapsed >= 1000UL / LOG_RATE_PER_SEC) {
+    uint32_t refill = elapsed * LOG_RATE_PER_SEC / 1000UL;
+    b.tokens = refill >= (uint32_t)(LOG_RATE_BURST - b.tokens) ? LOG_RATE_BURST : b.tokens + refill;
+    b.refilledMs = now;
+  }
+  if (b.tokens == 0) return false;
+  b.tokens--;
+  return true;
+}
+
+void logWrite(LogCategory category, uint8_t level, const char* format, ...) {
+  (void)level;
+  char line[LOG_LINE_MAX];
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+  if (n <= 0) return;
+  bool truncated = (size_t)n >= sizeof(line);
+  size_t len = truncated ? sizeof(line) - 1 : (size_t)n;
+  if (truncated) line[len - 1] = '\n';
+
+  RateBucket& bucket = buckets[category];
+  uint32_t missed = 0;
+  portENTER_CRITICAL(&logMux);
+  if (!takeToken(bucket, millis())) {
+    bucket.pending++;
+    stats.suppressed++;
+    stats.categorySuppressed[category]++;
+    portEXIT_CRITICAL(&logMux);
+    return;
+  }
+  missed = bucket.pending;
+  bucket.pending = 0;
+  if (truncated) stats.truncated++;
+  if (!missed) ringPush(line, len);
+  portEXIT_CRITICAL(&logMux);
+  if (!missed) return;
+
+  // Report the gap ahead of the message that ended it
+  char notice[64];
+  int m = snprintf(notice, sizeof(notice), "[LOG] %s: %lu messages suppressed\n",
+                   CATEGORY_NAMES[category], (unsigned long)missed);
+  portENTER_CRITICAL(&logMux);
+  ringPush(notice, m);
+  ringPush(line, len);
+  portEXIT_CRITICAL(&logMux);
+}
+
+// Moves up to `room` bytes from the ring to the UART; returns the bytes written
+static size_t drainOnce(size_t room) {
+  char chunk[128];
+  if (room > sizeof(chunk)) room = sizeof(chunk);
+  portENTER_CRITICAL(&logMux);
+  uint32_t used = head - tail;
+  size_t len = used < room ? used : room;
+  size_t at = tail % LOG_RING_SIZE;
+  size_t first = len < LOG_RING_SIZE - at ? len : LOG_RING_SIZE - at;
+  memcpy(chunk, ring + at, first);
+  memcpy(chunk + first, ring, len - first);
+  tail += len;
+  portEXIT_CRITICAL(&logMux);
+  if (len) Serial.write((const uint8_t*)chunk, len);
+  return len;
+}
+
+void logService() {
+  if (telemetryActive()) return;   // Text would cost telemetry frames
+  // Bounded: at most a FIFO's worth per pass, never waiting for the UART
+  for (uint8_t i = 0; i < 4; i++) {
+    int room = Serial.availableForWrite();
+    if (room <= 0 || !drainOnce(room)) break;
+  }
+}
+
+void logFlush() {
+  while (drainOnce(128)) {}
+  Serial.flush();
+}
+
+void logSetLevel(LogCategory category, uint8_t level) {
+  if (category >= LOG_CATEGORY_COUNT) return;
+  logCategoryLevels[category] = level > LOG_LEVEL_VERBOSE ? LOG_LEVEL_VERBOSE : level;
+}
+
+const char* logCategoryName(LogCategory category) {
+  return category < LOG_CATEGORY_COUNT ? CATEGORY_NAMES[category] : "unknown";
+}
+
+const char* logLevelName(uint8_t level) {
+  return level <= LOG_LEVEL_VERBOSE ? LEVEL_NAMES[level] : "unknown";
+}
+
+bool logCategoryFromName(const char* name, LogCategory& out) {
+  for (uint8_t i = 0; i < LOG_CATEGORY_COUNT; i++) {
+    if (strcmp(name, CATEGORY_NAMES[i]) == 0) {
+      out = (LogCategory)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool logLevelFromName(const char* name, uint8_t& out) {
+  if (name[0] >= '0' && name[0] <= '9' && name[1] == '\0') {
+    out = name[0] - '0';
+    return out <= LOG_LEVEL_VERBOSE;
+  }
+  for (uint8_t i = 0; i <= LOG_LEVEL_VERBOSE; i++) {
+    if (strcmp(name, LEVEL_NAMES[i]) == 0) {
+      out = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+uint32_t logPendingBytes() {
+  portENTER_CRITICAL(&logMux);
+  uint32_t used = head - tail;
+  portEXIT_CRITICAL(&logMux);
+  return used;
+}
+
+const LogStats& logGetStats() {
+  return stats;
+}
+
+void logResetStats() {
+  portENTER_CRITICAL(&logMux);
+  stats = LogStats();
+  stats.sinceMs = millis();
+  portEXIT_CRITICAL(&logMux);
+}
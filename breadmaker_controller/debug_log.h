@@ -0,0 +1,100 @@
+#pragma once
+#include <Arduino.h>
+
+// Serial debug log with levels, categories, rate limiting and an asynchronous drain.
+// `if (debugSerial) Serial.printf(...)` in the fermentation and mixing paths formatted
+// on the control tick and then waited for the UART: a 150-character line at 115200
+// baud holds the tick for ~13 ms once the 128-byte TX FIFO is full. LOG_*() instead
+// formats into a stack line and copies it into a RAM ring; logService() drains the
+// ring from loop() only as fast as the UART has room, so a caller never blocks on
+// Serial. If the ring is full the message is dropped and counted.
+//
+// Levels are filtered twice:
+//  - at compile time, messages above LOG_MIN_LEVEL (a build flag, e.g.
+//    -DLOG_MIN_LEVEL=LOG_LEVEL_WARN) compile to nothing - no call, no format string;
+//  - at run time, per category (logSetLevel(), /api/log), and DEBUG/INFO/VERBOSE only
+//    while debugSerial is on. ERROR and WARN are always logged.
+// Each category also has a token bucket (LOG_RATE_BURST messages, refilled at
+// LOG_RATE_PER_SEC): excess messages are counted, and the next message that passes
+// is preceded by a "[LOG] <category>: N messages suppressed" line.
+//
+// Message text is kept as it was ("[FERMENT] ..."): the analysis scripts parse it.
+// Formatting happens at the call, not in the drain, because arguments are often
+// temporaries (String::c_str()) that are gone by the time loop() runs.
+//
+// The drain pauses while binary telemetry is streaming; messages wait in the ring.
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+#define LOG_LEVEL_VERBOSE 5
+
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_LEVEL_VERBOSE   // Everything compiled in; categories default to DEBUG
+#endif
+
+enum LogCategory : uint8_t {
+  LOG_SYSTEM = 0,
+  LOG_FERMENT,
+  LOG_MIX,
+  LOG_STAGE,
+  LOG_PID,
+  LOG_TEMP,
+  LOG_WEB,
+  LOG_STORAGE,
+  LOG_CATEGORY_COUNT
+};
+
+constexpr size_t LOG_RING_SIZE = 4096;
+constexpr size_t LOG_LINE_MAX = 192;            // Longer messages are truncated
+constexpr uint8_t LOG_RATE_BURST = 20;
+constexpr uint8_t LOG_RATE_PER_SEC = 10;
+
+struct LogStats {
+  uint32_t messages = 0;          // Queued
+  uint64_t bytes = 0;             // Queued
+  uint32_t dropped = 0;           // Ring full
+  uint32_t truncated = 0;
+  uint32_t suppressed = 0;        // Over the category's rate
+  uint32_t highWater = 0;         // Most bytes waiting in the ring
+  uint32_t categorySuppressed[LOG_CATEGORY_COUNT] = {};
+  unsigned long sinceMs = 0;
+};
+
+extern bool debugSerial;
+extern uint8_t logCategoryLevels[LOG_CATEGORY_COUNT];
+
+inline bool logEnabled(LogCategory category, uint8_t level) {
+  return level <= logCategoryLevels[category] && (level <= LOG_LEVEL_WARN || debugSerial);
+}
+
+// Formats and queues one message (callers use the LOG_* macros)
+void logWrite(LogCategory category, uint8_t level, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+#define LOG_AT(level, category, format, ...) \
+  do { \
+    if ((level) <= LOG_MIN_LEVEL && logEnabled((category), (level))) logWrite((category), (level), format, ##__VA_ARGS__); \
+  } while (0)
+
+#define LOG_ERROR(category, format, ...) LOG_AT(LOG_LEVEL_ERROR, category, format, ##__VA_ARGS__)
+#define LOG_WARN(category, format, ...) LOG_AT(LOG_LEVEL_WARN, category, format, ##__VA_ARGS__)
+#define LOG_INFO(category, format, ...) LOG_AT(LOG_LEVEL_INFO, category, format, ##__VA_ARGS__)
+#define LOG_DEBUG(category, format, ...) LOG_AT(LOG_LEVEL_DEBUG, category, format, ##__VA_ARGS__)
+#define LOG_VERBOSE(category, format, ...) LOG_AT(LOG_LEVEL_VERBOSE, category, format, ##__VA_ARGS__)
+
+// Call once per loop() pass: writes what the UART TX buffer has room for
+void logService();
+// Drains the ring, waiting for the UART (before a restart)
+void logFlush();
+
+void logSetLevel(LogCategory category, uint8_t level);
+const char* logCategoryName(LogCategory category);
+const char* logLevelName(uint8_t level);
+bool logCategoryFromName(const char* name, LogCategory& out);
+bool logLevelFromName(const char* name, uint8_t& out);   // "warn" or "2"
+
+uint32_t logPendingBytes();
+const LogStats& logGetStats();
+void logResetStats();
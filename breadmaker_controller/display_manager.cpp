@@ -4,6 +4,8 @@
 #include "calibration.h"
 #include "outputs_manager.h"
 #include "missing_stubs.h"
+#include "control_task.h"
+#include "trace_recorder.h"
 #include <WiFi.h>
 
 #ifndef FIRMWARE_BUILD_DATE
@@ -81,6 +83,7 @@ void updateDisplay() {
   // Update display at regular intervals
   if (now - lastDisplayUpdate >= DISPLAY_UPDATE_INTERVAL) {
     lastDisplayUpdate = now;
+    TraceSpan span(TRACE_DISPLAY, "display redraw");
     
     // Check if we need a full redraw (state change)
     if (currentState != lastState) {
@@ -244,6 +247,23 @@ void drawTTGOProgramLayout() {
   // Y: 120–135 (Bottom row) - Metrics will be handled in displayStatus()
 }
 
+// Temperature and output states for drawing. With the control task running they come
+// from its lock-free snapshot, so a frame never mixes values from two control ticks.
+struct DisplayControlView {
+  float temperature;
+  bool heater;
+  bool motor;
+  bool light;
+};
+
+static DisplayControlView readControlView() {
+  ControlSnapshot snap;
+  if (controlSnapshotRead(snap)) {
+    return {snap.sensorTemperature, snap.heater, snap.motor, snap.light};
+  }
+  return {readTemperature(), outputStates.heater, outputStates.motor, outputStates.light};
+}
+
 void displayStatus() {
   // Only clear screen if we need a full redraw
   if (forceFullRedraw) {
@@ -284,7 +304,7 @@ void displayStatus() {
       display.println("Idle");
       
       // Y: 120-135 (Bottom row) - Show temperature only
-      float temp = readTemperature();
+      float temp = readControlView().temperature;
       display.setTextColor(COLOR_CYAN);
       display.setTextSize(1);
       display.setCursor(5, 123);
@@ -297,8 +317,9 @@ void displayStatus() {
   }
   
   // Always update temperature in bottom row if running
+  DisplayControlView view = readControlView();
   if (currentRunning) {
-    float temp = readTemperature();
+    float temp = view.temperature;
     if (forceFullRedraw || abs(temp - lastTemperature) > 0.5) {
       // Clear and update temperature in bottom row
       display.fillRect(5, 120, 80, 15, COLOR_BLACK);
@@ -312,9 +333,9 @@ void displayStatus() {
   
   // Update output states in bottom row if running
   if (currentRunning) {
-    bool heaterOn = outputStates.heater;
-    bool motorOn = outputStates.motor;
-    bool lightOn = outputStates.light;
+    bool heaterOn = view.heater;
+    bool motorOn = view.motor;
+    bool lightOn = view.light;
     
     if (forceFullRedraw || motorOn != lastMotorState) {
       // Clear and update motor status (center)
@@ -453,6 +474,7 @@ void displayWiFiSetup() {
 }
 
 void displayError(const String& message) {
+  TraceSpan span(TRACE_DISPLAY, "display error");
   // Error display should always update immediately
   display.fillScreen(COLOR_RED);
   display.setTextColor(COLOR_WHITE);
@@ -578,7 +600,8 @@ void drawProgressBar(int x, int y, int width, int height, float progress) {
 
 void drawProgramRunningLayout(int x, int y) {
   // Large centered temperature display at top
-  float temp = readTemperature();
+  DisplayControlView view = readControlView();
+  float temp = view.temperature;
   display.setTextColor(COLOR_YELLOW);
   display.setTextSize(3);  // Large font
   
@@ -592,10 +615,10 @@ void drawProgramRunningLayout(int x, int y) {
   display.print(tempStr);
   
   // Motor status in center area
-  display.setTextColor(outputStates.motor ? COLOR_GREEN : COLOR_GRAY);
+  display.setTextColor(view.motor ? COLOR_GREEN : COLOR_GRAY);
   display.setTextSize(2);  // Medium-large font
   
-  String motorText = outputStates.motor ? "Motor: ON" : "Motor: OFF";
+  String motorText = view.motor ? "Motor: ON" : "Motor: OFF";
   int motorWidth = motorText.length() * 12; // Approximate width for size 2 font
   int motorCenterX = (235 - motorWidth) / 2;
   
@@ -608,9 +631,9 @@ void drawProgramRunningLayout(int x, int y) {
   
   // Calculate approximate power based on active outputs
   int powerWatts = 0;
-  if (outputStates.heater) powerWatts += 40;  // Heater power
-  if (outputStates.motor) powerWatts += 5;    // Motor power
-  if (outputStates.light) powerWatts += 3;    // Light power
+  if (view.heater) powerWatts += 40;  // Heater power
+  if (view.motor) powerWatts += 5;    // Motor power
+  if (view.light) powerWatts += 3;    // Light power
   
   display.setCursor(170, y + 60);  // Right side
   display.printf("Power: %dW", powerWatts);
@@ -0,0 +1,220 @@
+#include "enhanced_motor_control.h"
+#include "debug_log.h"
+#ifndef NATIVE_SIMULATION
+#include <esp_timer.h>
+#endif
+
+extern bool debugSerial;
+
+static const uint8_t MOTOR_TIMER_NUM = 1;       // Hardware timer group 0, timer 1 (timer 0 drives the heater)
+static const uint16_t MOTOR_TIMER_DIVIDER = 80;  // 1 µs counter
+static const uint32_t MOTOR_TIMER_TICK_US = 1000;
+
+static hw_timer_t* motorHwTimer = nullptr;
+static portMUX_TYPE motorPulseMux = portMUX_INITIALIZER_UNLOCKED;
+static int motorPin = -1;
+
+// Pattern and position (guarded by motorPulseMux)
+static MotorPulseSegment pattern[MOTOR_PATTERN_MAX];
+static uint8_t patternCount = 0;
+static volatile bool running = false;
+static volatile bool level = false;
+static volatile uint8_t segmentIdx = 0;
+static int64_t segmentStartUs = 0;
+static int64_t leaseUntilUs = 0;
+static int64_t pulseStartUs = 0;
+static int64_t pulseScheduledStartUs = 0;
+static int64_t esptimerToMillisOffsetUs = 0;  // esp_timer µs minus millis() µs, captured at load
+static bool firstEdgeAfterLoad = false;        // A resume lands mid-schedule; its first edge is on time by definition
+
+// Edge log ring: head advances in the ISR, drainTail in the loop
+static MotorEdgeRecord edgeLog[MOTOR_EDGE_LOG_SIZE];
+static volatile uint32_t edgeHead = 0;
+static uint32_t drainTail = 0;
+
+static MotorPulseStats stats;
+
+static void IRAM_ATTR recordEdge(int64_t nowUs, int64_t scheduledUs, bool on) {
+  int32_t err = (int32_t)(nowUs - scheduledUs);
+  uint32_t absErr = err < 0 ? (uint32_t)-err : (uint32_t)err;
+  stats.lastEdgeErrorUs = absErr;
+  if (absErr > stats.maxEdgeErrorUs) stats.maxEdgeErrorUs = absErr;
+  stats.totalEdgeErrorUs += absErr;
+  stats.edges++;
+
+  MotorEdgeRecord& rec = edgeLog[edgeHead % MOTOR_EDGE_LOG_SIZE];
+  rec.atMs = (uint32_t)((nowUs - esptimerToMillisOffsetUs) / 1000);
+  rec.errorUs = err;
+  rec.segment = segmentIdx;
+  rec.on = on;
+  edgeHead = edgeHead + 1;
+}
+
+static void IRAM_ATTR driveMotor(bool on) {
+  level = on;
+  digitalWrite(motorPin, on ? HIGH : LOW);
+}
+
+static void IRAM_ATTR motorPulseIsr() {
+  int64_t nowUs = esp_timer_get_time();
+  portENTER_CRITICAL_ISR(&motorPulseMux);
+  if (running && nowUs > leaseUntilUs) {
+    // Tick stopped renewing the pattern - fail safe
+    running = false;
+    if (level) driveMotor(false);
+    stats.leaseExpiries++;
+  } else if (running && patternCount > 0) {
+    // Advance through completed segments on the exact schedule
+    const MotorPulseSegment* seg = &pattern[segmentIdx];
+    while (nowUs - segmentStartUs >= (int64_t)seg->durationMs * 1000) {
+      segmentStartUs += (int64_t)seg->durationMs * 1000;
+      segmentIdx = (segmentIdx + 1) % patternCount;
+      seg = &pattern[segmentIdx];
+      stats.segmentsCompleted++;
+    }
+
+    int64_t pos = nowUs - segmentStartUs;
+    int64_t cycleUs = (int64_t)(seg->mixMs + seg->waitMs) * 1000;
+    int64_t cycleStartUs = segmentStartUs;
+    if (cycleUs > 0 && seg->durationMs * 1000LL > cycleUs) {
+      cycleStartUs += (pos / cycleUs) * cycleUs;
+    }
+    int64_t cyclePos = nowUs - cycleStartUs;
+    bool want = cyclePos < (int64_t)seg->mixMs * 1000;
+
+    if (want != level) {
+      driveMotor(want);
+      if (want) {
+        pulseStartUs = nowUs;
+        pulseScheduledStartUs = firstEdgeAfterLoad ? nowUs : cycleStartUs;
+        recordEdge(nowUs, pulseScheduledStartUs, true);
+      } else {
+        int64_t scheduledEnd = firstEdgeAfterLoad ? nowUs : cycleStartUs + (int64_t)seg->mixMs * 1000;
+        recordEdge(nowUs, scheduledEnd, false);
+        int64_t width = nowUs - pulseStartUs;
+        int64_t expected = scheduledEnd - pulseScheduledStartUs;
+        uint32_t pulseErr = (uint32_t)(width > expected ? width - expected : expected - width);
+        stats.lastPulseUs = (uint32_t)width;
+        if (pulseErr > stats.maxPulseErrorUs) stats.maxPulseErrorUs = pulseErr;
+      }
+      firstEdgeAfterLoad = false;
+    }
+  }
+  portEXIT_CRITICAL_ISR(&motorPulseMux);
+}
+
+bool motorPulseBegin(int pin) {
+  if (motorHwTimer) return true;
+  motorPin = pin;
+  motorHwTimer = timerBegin(MOTOR_TIMER_NUM, MOTOR_TIMER_DIVIDER, true);
+  if (!motorHwTimer) {
+    Serial.println("[MOTOR-PULSE] timerBegin failed - falling back to loop-driven mixing");
+    return false;
+  }
+  timerAttachInterrupt(motorHwTimer, &motorPulseIsr, false);   // Level interrupt; edge mode is unsupported
+  timerAlarmWrite(motorHwTimer, MOTOR_TIMER_TICK_US, true);
+  timerAlarmEnable(motorHwTimer);
+  if (debugSerial) Serial.printf("[MOTOR-PULSE] Started on pin %d, %lu us tick\n", pin, (unsigned long)MOTOR_TIMER_TICK_US);
+  return true;
+}
+
+bool motorPulseActive() {
+  return motorHwTimer != nullptr;
+}
+
+void motorPulseLoad(const MotorPulseSegment* segments, uint8_t count, uint8_t startIndex, unsigned long elapsedMs) {
+  if (!motorHwTimer) return;
+  if (count > MOTOR_PATTERN_MAX) count = MOTOR_PATTERN_MAX;
+  if (startIndex >= count) startIndex = 0;
+  int64_t nowUs = esp_timer_get_time();
+  int64_t offset = nowUs - (int64_t)millis() * 1000;
+
+  portENTER_CRITICAL(&motorPulseMux);
+  for (uint8_t i = 0; i < count; i++) {
+    pattern[i] = segments[i];
+    if (pattern[i].durationMs == 0) pattern[i].durationMs = 1;  // A zero segment would stall the advance loop
+  }
+  patternCount = count;
+  segmentIdx = startIndex;
+  segmentStartUs = nowUs - (int64_t)elapsedMs * 1000;
+  esptimerToMillisOffsetUs = offset;
+  leaseUntilUs = nowUs + (int64_t)MOTOR_PULSE_LEASE_MS * 1000;
+  running = count > 0;
+  firstEdgeAfterLoad = true;
+  stats.patternsLoaded++;
+  portEXIT_CRITICAL(&motorPulseMux);
+
+  LOG_VERBOSE(LOG_MIX, "[MOTOR-PULSE] Loaded %u segments, starting at %u (+%lums)\n", count, startIndex, elapsedMs);
+}
+
+void motorPulseRenew() {
+  if (!motorHwTimer) return;
+  int64_t until = esp_timer_get_time() + (int64_t)MOTOR_PULSE_LEASE_MS * 1000;
+  portENTER_CRITICAL(&motorPulseMux);
+  leaseUntilUs = until;
+  portEXIT_CRITICAL(&motorPulseMux);
+}
+
+bool motorPulseStop() {
+  if (!motorHwTimer) return false;
+  portENTER_CRITICAL(&motorPulseMux);
+  bool wasRunning = running;
+  running = false;
+  if (level) driveMotor(false);
+  portEXIT_CRITICAL(&motorPulseMux);
+  return wasRunning;
+}
+
+bool motorPulseRunning() {
+  return running;
+}
+
+bool motorPulseOutput() {
+  return level;
+}
+
+uint8_t motorPulseSegment() {
+  return segmentIdx;
+}
+
+unsigned long motorPulseSegmentElapsedMs() {
+  portENTER_CRITICAL(&motorPulseMux);
+  int64_t elapsedUs = esp_timer_get_time() - segmentStartUs;
+  portEXIT_CRITICAL(&motorPulseMux);
+  return elapsedUs > 0 ? (unsigned long)(elapsedUs / 1000) : 0;
+}
+
+uint8_t motorPulseDrainEdges(MotorEdgeRecord* out, uint8_t max) {
+  portENTER_CRITICAL(&motorPulseMux);
+  uint32_t head = edgeHead;
+  if (head - drainTail > MOTOR_EDGE_LOG_SIZE) drainTail = head - MOTOR_EDGE_LOG_SIZE;  // Overrun: keep the newest
+  uint8_t n = 0;
+  while (drainTail != head && n < max) {
+    out[n++] = edgeLog[drainTail % MOTOR_EDGE_LOG_SIZE];
+    drainTail++;
+  }
+  portEXIT_CRITICAL(&motorPulseMux);
+  return n;
+}
+
+uint8_t motorPulseRecentEdges(MotorEdgeRecord* out, uint8_t max) {
+  portENTER_CRITICAL(&motorPulseMux);
+  uint32_t head = edgeHead;
+  uint32_t available = head < MOTOR_EDGE_LOG_SIZE ? head : MOTOR_EDGE_LOG_SIZE;
+  if (available > max) available = max;
+  for (uint32_t i = 0; i < available; i++) {
+    out[i] = edgeLog[(head - available + i) % MOTOR_EDGE_LOG_SIZE];
+  }
+  portEXIT_CRITICAL(&motorPulseMux);
+  return (uint8_t)available;
+}
+
+const MotorPulseStats& motorPulseGetStats() {
+  return stats;
+}
+
+void motorPulseResetStats() {
+  portENTER_CRITICAL(&motorPulseMux);
+  stats = MotorPulseStats();
+  portEXIT_CRITICAL(&motorPulseMux);
+}
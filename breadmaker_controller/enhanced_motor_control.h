@@ -0,0 +1,67 @@
+#pragma once
+#include <Arduino.h>
+
+// Hardware-timed motor pulse engine.
+// A stage's mix pattern is loaded once as a list of segments (mix on-time, wait
+// off-time, total duration); a 1 ms timer interrupt on hardware timer 1 then
+// switches the motor pin and advances through the segments on an exact schedule,
+// so 100 ms knockdown pulses stay 100 ms whatever the web server or display are
+// doing. handleCustomStages() only loads the pattern and mirrors the engine's
+// segment index and motor state back into programState / outputStates.
+//
+// Safety: loading a pattern and every motorPulseRenew() call renew a lease. If the
+// control tick stops renewing it for MOTOR_PULSE_LEASE_MS the interrupt switches the
+// motor off and stops the pattern, so a stalled tick can't leave the motor cycling.
+
+constexpr uint8_t MOTOR_PATTERN_MAX = 16;      // Segments per stage
+constexpr uint8_t MOTOR_EDGE_LOG_SIZE = 32;    // Recent edges kept for /api/motor_pulse
+constexpr unsigned long MOTOR_PULSE_LEASE_MS = 3000;  // Motor off if the tick stops renewing the pattern
+
+struct MotorPulseSegment {
+  uint32_t mixMs;       // Motor on per cycle
+  uint32_t waitMs;      // Motor off per cycle
+  uint32_t durationMs;  // Segment length; > mix + wait repeats the cycle
+};
+
+struct MotorEdgeRecord {
+  uint32_t atMs;        // millis() domain time of the edge
+  int32_t errorUs;      // Actual minus scheduled
+  uint8_t segment;
+  bool on;
+};
+
+struct MotorPulseStats {
+  uint32_t edges = 0;
+  uint32_t lastEdgeErrorUs = 0;
+  uint32_t maxEdgeErrorUs = 0;
+  uint64_t totalEdgeErrorUs = 0;
+  uint32_t lastPulseUs = 0;       // Width of the last completed on-pulse
+  uint32_t maxPulseErrorUs = 0;   // |measured - scheduled| on-pulse width
+  uint32_t segmentsCompleted = 0;
+  uint32_t patternsLoaded = 0;
+  uint32_t leaseExpiries = 0;     // Pattern stopped because the tick stopped renewing it
+};
+
+// Starts hardware timer 1 on the motor pin; returns false (loop-driven fallback) on failure
+bool motorPulseBegin(int pin);
+bool motorPulseActive();
+
+// Loads a pattern and starts it at segment startIndex, elapsedMs into that segment
+// (resume). The pattern loops after the last segment, like the loop-driven mixer.
+void motorPulseLoad(const MotorPulseSegment* segments, uint8_t count, uint8_t startIndex, unsigned long elapsedMs);
+// Called from the control tick while the pattern should keep running
+void motorPulseRenew();
+// Stops the pattern and switches the motor off immediately; returns true if it was running
+bool motorPulseStop();
+bool motorPulseRunning();
+bool motorPulseOutput();               // Level currently driven by the engine
+uint8_t motorPulseSegment();           // Current segment index
+unsigned long motorPulseSegmentElapsedMs();
+
+// Copies edges recorded by the interrupt since the last call (oldest first); returns the count
+uint8_t motorPulseDrainEdges(MotorEdgeRecord* out, uint8_t max);
+// Last MOTOR_EDGE_LOG_SIZE edges (oldest first), for status output
+uint8_t motorPulseRecentEdges(MotorEdgeRecord* out, uint8_t max);
+
+const MotorPulseStats& motorPulseGetStats();
+void motorPulseResetStats();
@@ -0,0 +1,178 @@
+#include "file_transfer.h"
+#include <errno.h>
+#ifdef NATIVE_SIMULATION
+#include <sys/socket.h>
+#else
+#include <lwip/sockets.h>
+#include <esp_timer.h>
+#endif
+
+extern bool debugSerial;
+
+struct FileTransfer {
+  bool active = false;
+  File file;
+  WiFiClient client;       // Copy keeps the socket open after the handler returns
+  size_t pendingLen = 0;   // Bytes in buffer not yet accepted by the socket
+  size_t pendingOff = 0;
+  uint32_t sent = 0;
+  unsigned long lastProgressMs = 0;
+};
+
+static FileTransfer transfers[MAX_FILE_TRANSFERS];
+static uint8_t buffers[MAX_FILE_TRANSFERS][FILE_TRANSFER_CHUNK];
+static uint8_t activeCount = 0;
+static uint8_t nextSlot = 0;   // Round-robin start, so no transfer always goes first
+static size_t budgetBytes = FILE_TRANSFER_BUDGET_BYTES;
+static uint32_t budgetUs = FILE_TRANSFER_BUDGET_US;
+static FileTransferStats stats;
+
+static void finishTransfer(uint8_t i, bool completed) {
+  FileTransfer& t = transfers[i];
+  t.file.close();
+  t.client.stop();
+  t.client = WiFiClient();
+  t.active = false;
+  activeCount--;
+  if (completed) stats.completed++;
+  else stats.aborted++;
+  if (debugSerial) {
+    Serial.printf("[FILE-XFER] Slot %u %s after %lu bytes\n", (unsigned)i,
+                  completed ? "complete" : "aborted", (unsigned long)t.sent);
+  }
+}
+
+// Sends the old way, inside the handler (all slots busy)
+static void sendInline(WebServer& server, File& file) {
+  uint8_t buffer[FILE_TRANSFER_CHUNK];
+  while (file.available()) {
+    size_t bytesRead = file.readBytes((char*)buffer, FILE_TRANSFER_CHUNK);
+    if (bytesRead == 0) break;
+    server.client().write(buffer, bytesRead);
+    stats.bytesSent += bytesRead;
+    yield();
+  }
+  file.close();
+}
+
+bool fileTransferBegin(WebServer& server, File& file, const String& contentType) {
+  server.setContentLength(file.size());
+  server.send(200, contentType, "");
+  stats.started++;
+
+  int slot = -1;
+  for (uint8_t i = 0; i < MAX_FILE_TRANSFERS; i++) {
+    if (!transfers[i].active) { slot = i; break; }
+  }
+  if (slot < 0 || !server.client().connected()) {
+    stats.fallbacks++;
+    sendInline(server, file);
+    stats.completed++;
+    return true;
+  }
+
+  FileTransfer& t = transfers[slot];
+  t.file = file;
+  t.client = server.client();
+  t.pendingLen = 0;
+  t.pendingOff = 0;
+  t.sent = 0;
+  t.lastProgressMs = millis();
+  t.active = true;
+  activeCount++;
+  if (activeCount > stats.maxActive) stats.maxActive = activeCount;
+  file = File();  // Ownership moved to the slot
+  return true;
+}
+
+// One chunk for one transfer; returns bytes sent (0 if the client's window is full)
+static size_t serviceTransfer(uint8_t i) {
+  FileTransfer& t = transfers[i];
+  uint8_t* buf = buffers[i];
+
+  if (t.pendingOff >= t.pendingLen) {
+    t.pendingLen = t.file.available() ? t.file.read(buf, FILE_TRANSFER_CHUNK) : 0;
+    t.pendingOff = 0;
+    if (t.pendingLen == 0) {
+      finishTransfer(i, true);
+      return 0;
+    }
+  }
+
+  if (!t.client.connected()) {
+    finishTransfer(i, false);
+    return 0;
+  }
+
+  ssize_t n = send(t.client.fd(), buf + t.pendingOff, t.pendingLen - t.pendingOff, MSG_DONTWAIT);
+  if (n < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      stats.wouldBlock++;
+      if (millis() - t.lastProgressMs > FILE_TRANSFER_STALL_MS) finishTransfer(i, false);
+      return 0;
+    }
+    finishTransfer(i, false);
+    return 0;
+  }
+  t.pendingOff += n;
+  t.sent += n;
+  t.lastProgressMs = millis();
+  return n;
+}
+
+void fileTransfersService() {
+  if (activeCount == 0) return;
+  int64_t startUs = esp_timer_get_time();
+  size_t passBytes = 0;
+
+  // Rounds of one chunk per transfer until the budget is spent or nobody can send
+  for (;;) {
+    bool progress = false;
+    for (uint8_t k = 0; k < MAX_FILE_TRANSFERS; k++) {
+      uint8_t i = (nextSlot + k) % MAX_FILE_TRANSFERS;
+      if (!transfers[i].active) continue;
+      size_t n = serviceTransfer(i);
+      if (n > 0) progress = true;
+      passBytes += n;
+    }
+    if (!progress || activeCount == 0) break;
+    if (passBytes >= budgetBytes) break;
+    if ((uint32_t)(esp_timer_get_time() - startUs) >= budgetUs) break;
+  }
+  nextSlot = (nextSlot + 1) % MAX_FILE_TRANSFERS;
+
+  uint32_t passUs = (uint32_t)(esp_timer_get_time() - startUs);
+  stats.passes++;
+  stats.lastPassUs = passUs;
+  if (passUs > stats.maxPassUs) stats.maxPassUs = passUs;
+  stats.totalPassUs += passUs;
+  stats.lastPassBytes = passBytes;
+  if (passBytes > stats.maxPassBytes) stats.maxPassBytes = passBytes;
+  stats.bytesSent += passBytes;
+}
+
+uint8_t fileTransfersActive() {
+  return activeCount;
+}
+
+void fileTransferSetBudget(size_t bytesPerPass, uint32_t usPerPass) {
+  budgetBytes = bytesPerPass < FILE_TRANSFER_CHUNK ? FILE_TRANSFER_CHUNK : bytesPerPass;
+  budgetUs = usPerPass < 500 ? 500 : usPerPass;
+}
+
+size_t fileTransferBudgetBytes() {
+  return budgetBytes;
+}
+
+uint32_t fileTransferBudgetUs() {
+  return budgetUs;
+}
+
+const FileTransferStats& fileTransferGetStats() {
+  return stats;
+}
+
+void fileTransferResetStats() {
+  stats = FileTransferStats();
+  stats.maxActive = activeCount;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <Arduino.h>
+#include <WebServer.h>
+#include "storage_backend.h"
+
+// Incremental file responses.
+// serveStaticFile() used to send the whole file inside the handler, 1 KB at a time,
+// so a large page or /activity.log held loop() until the last byte was out. Now the
+// handler sends the headers and hands the open file and the client socket to a
+// transfer slot. fileTransfersService(), called once per loop() pass, sends at most
+// a byte budget or a time budget across all active transfers, one chunk per
+// transfer per round so concurrent downloads share the budget fairly.
+//
+// Sends are non-blocking: a client whose TCP window is full is skipped until the
+// next pass instead of stalling the loop. A transfer that makes no progress for
+// FILE_TRANSFER_STALL_MS is dropped.
+
+constexpr uint8_t MAX_FILE_TRANSFERS = 4;
+constexpr size_t FILE_TRANSFER_CHUNK = 1024;                 // Read/send unit (same as the old loop)
+constexpr size_t FILE_TRANSFER_BUDGET_BYTES = 8192;          // Default per-pass byte budget
+constexpr uint32_t FILE_TRANSFER_BUDGET_US = 4000;           // Default per-pass time budget
+constexpr unsigned long FILE_TRANSFER_STALL_MS = 10000;      // Drop a client that stops reading
+
+struct FileTransferStats {
+  uint32_t started = 0;
+  uint32_t completed = 0;
+  uint32_t aborted = 0;           // Client gone, send error or stall timeout
+  uint32_t fallbacks = 0;         // All slots busy: file sent inline the old way
+  uint64_t bytesSent = 0;
+  uint32_t passes = 0;            // loop() passes with at least one active transfer
+  uint32_t lastPassUs = 0;        // Time spent in fileTransfersService() - the per-loop I/O cost
+  uint32_t maxPassUs = 0;
+  uint64_t totalPassUs = 0;
+  uint32_t lastPassBytes = 0;
+  uint32_t maxPassBytes = 0;
+  uint32_t wouldBlock = 0;        // Sends skipped because the client's window was full
+  uint8_t maxActive = 0;
+};
+
+// Sends the response headers and queues the body. Takes ownership of file.
+// Returns false only if the headers could not be sent (file is closed).
+bool fileTransferBegin(WebServer& server, File& file, const String& contentType);
+
+// Advances active transfers within the per-pass budget; call once per loop() pass
+void fileTransfersService();
+uint8_t fileTransfersActive();
+
+// Per-pass budget (bytes across all transfers, and microseconds); at least one chunk is always sent
+void fileTransferSetBudget(size_t bytesPerPass, uint32_t usPerPass);
+size_t fileTransferBudgetBytes();
+uint32_t fileTransferBudgetUs();
+
+const FileTransferStats& fileTransferGetStats();
+void fileTransferResetStats();
@@ -31,6 +31,9 @@ OutputStates outputStates;
 // --- Temperature averaging state instance ---
 TemperatureAveragingState tempAvg;
 
+// --- Kalman temperature estimator state instance ---
+TemperatureKalmanState tempKalman;
+
 // --- WiFi cache instance ---
 WiFiCache wifiCache;
 
@@ -54,6 +54,34 @@ struct TemperatureEMAState {
 };
 #endif
 
+// Model-based Kalman temperature estimator (temperature_estimator.cpp)
+// State: chamber temperature T and an unmodelled heating bias b (°C/s).
+// Model: dT/dt = heatRate * heater - lossRate * (T - ambient) + b
+#ifndef TEMP_KALMAN_STATE_STRUCT_DEFINED
+#define TEMP_KALMAN_STATE_STRUCT_DEFINED
+struct TemperatureKalmanState {
+    bool enabled = false;               // true = getAveragedTemperature() returns the Kalman estimate
+    bool initialized = false;
+    double temperature = 0.0;           // Estimated chamber temperature (°C)
+    double bias = 0.0;                  // Learned unmodelled heating rate (°C/s)
+    double rate = 0.0;                  // Estimated dT/dt (°C/s), model + bias
+    double P[2][2] = {{1.0, 0.0}, {0.0, 0.01}}; // Estimate covariance
+    // Model and noise parameters (settings.json: kalman*)
+    double heatRate = 0.25;             // °C/s contributed by the heater at full on
+    double lossRate = 0.003;            // 1/s heat loss towards ambient
+    double ambient = 22.0;              // °C
+    double processNoise = 0.01;         // Temperature process noise (°C²/s)
+    double biasNoise = 0.0005;          // Bias random walk ((°C/s)²/s)
+    double measurementNoise = 0.04;     // Measurement variance (°C²)
+    // Statistics
+    double lastInnovation = 0.0;        // Measurement minus prediction (°C)
+    double innovationVariance = 0.0;    // Running mean of innovation² (°C²)
+    uint32_t updateCount = 0;
+    uint32_t skippedMeasurements = 0;   // Predict-only steps (sensor not valid)
+    unsigned long lastUpdate = 0;
+};
+#endif
+
 // Legacy compatibility aliases (for existing code that expects old structure)
 #define TemperatureAveragingState TemperatureEMAState
 #define tempSampleCount alpha  // Map old tempSampleCount to alpha (will need conversion)
@@ -73,6 +101,7 @@ struct OutputStates {
 
 extern OutputStates outputStates;
 extern TemperatureAveragingState tempAvg;
+extern TemperatureKalmanState tempKalman;
 
 // WiFi status caching for performance optimization
 #ifndef WIFI_CACHE_STRUCT_DEFINED
@@ -180,6 +209,7 @@ struct SafetySystem {
     static constexpr unsigned long HEATING_CHECK_INTERVAL = 30000; // 30 seconds
     static constexpr float MIN_TEMP_RISE = 2.0;                    // Minimum rise in 30s
     static constexpr unsigned long MAX_HEATING_TIME = 180000;      // 3 minutes max heat time (reduced from 5 min)
+    float temperatureRate = 0.0;                                    // °C/s from the Kalman estimator, refreshed each check
     
     // Enhanced sensor failure detection
     static constexpr float MAX_TEMP_SPIKE = 50.0;                  // Max temp rise per check interval
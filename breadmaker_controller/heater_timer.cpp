@@ -0,0 +1,179 @@
+#include "heater_timer.h"
+#ifndef NATIVE_SIMULATION
+#include <esp_timer.h>
+#endif
+
+extern bool debugSerial;
+
+static const uint8_t HEATER_TIMER_NUM = 0;     // Hardware timer group 0, timer 0
+static const uint16_t HEATER_TIMER_DIVIDER = 80; // 80 MHz APB / 80 = 1 µs counter
+
+static hw_timer_t* heaterHwTimer = nullptr;
+static portMUX_TYPE heaterTimerMux = portMUX_INITIALIZER_UNLOCKED;
+static int heaterPin = -1;
+
+// Shared with the ISR (guarded by heaterTimerMux)
+static volatile bool armed = false;
+static volatile bool level = false;
+static volatile bool restartPending = false;
+static volatile uint32_t pendingWindowUs = 0;
+static volatile uint32_t pendingOnUs = 0;
+static int64_t leaseUntilUs = 0;
+static uint64_t onTotalUs = 0;     // Completed on-pulses
+static int64_t onSinceUs = 0;      // Start of the pulse in progress
+static uint32_t onPulses = 0;
+
+// ISR-only window state
+static uint32_t windowUs = 0;
+static uint32_t onUs = 0;
+static int64_t windowStartUs = 0;
+static int64_t pulseStartUs = 0;
+static int64_t pulseScheduledStartUs = 0;
+
+static unsigned long lastFeedMs = 0;
+static HeaterTimerStats stats;
+
+static void IRAM_ATTR recordEdge(int64_t nowUs, int64_t scheduledUs) {
+  uint32_t err = nowUs > scheduledUs ? (uint32_t)(nowUs - scheduledUs) : 0;
+  stats.lastEdgeErrorUs = err;
+  if (err > stats.maxEdgeErrorUs) stats.maxEdgeErrorUs = err;
+  stats.totalEdgeErrorUs += err;
+  stats.edges++;
+}
+
+// Caller holds heaterTimerMux
+static void IRAM_ATTR driveHeater(bool on, int64_t nowUs) {
+  if (on) {
+    onSinceUs = nowUs;
+    onPulses++;
+  } else if (level) {
+    onTotalUs += (uint64_t)(nowUs - onSinceUs);
+  }
+  level = on;
+  digitalWrite(heaterPin, on ? HIGH : LOW);
+}
+
+static void IRAM_ATTR heaterTimerIsr() {
+  int64_t nowUs = esp_timer_get_time();
+  portENTER_CRITICAL_ISR(&heaterTimerMux);
+  if (armed) {
+    if (nowUs > leaseUntilUs) {
+      // Loop stopped feeding the window - fail safe
+      armed = false;
+      if (level) driveHeater(false, nowUs);
+      stats.leaseExpiries++;
+    } else {
+      if (restartPending || nowUs - windowStartUs >= (int64_t)windowUs) {
+        // Natural rollover keeps the exact schedule; a restart (or falling a whole window behind) re-anchors
+        if (restartPending || nowUs - windowStartUs >= 2 * (int64_t)windowUs) {
+          windowStartUs = nowUs;
+        } else {
+          windowStartUs += windowUs;
+        }
+        windowUs = pendingWindowUs;
+        restartPending = false;
+        stats.windows++;
+      }
+      // Duty changes apply mid-window, as the loop-driven window did; edges they cause count as on time
+      bool dutyChanged = onUs != pendingOnUs;
+      onUs = pendingOnUs;
+
+      bool want = (nowUs - windowStartUs) < (int64_t)onUs;
+      if (want != level) {
+        driveHeater(want, nowUs);
+        if (want) {
+          pulseStartUs = nowUs;
+          pulseScheduledStartUs = dutyChanged ? nowUs : windowStartUs;
+          recordEdge(nowUs, pulseScheduledStartUs);
+        } else {
+          int64_t scheduledEnd = dutyChanged ? nowUs : windowStartUs + onUs;
+          recordEdge(nowUs, scheduledEnd);
+          int64_t width = nowUs - pulseStartUs;
+          int64_t expected = scheduledEnd - pulseScheduledStartUs;
+          uint32_t pulseErr = (uint32_t)(width > expected ? width - expected : expected - width);
+          stats.lastPulseUs = (uint32_t)width;
+          if (pulseErr > stats.maxPulseErrorUs) stats.maxPulseErrorUs = pulseErr;
+        }
+      }
+    }
+  }
+  portEXIT_CRITICAL_ISR(&heaterTimerMux);
+}
+
+bool heaterTimerBegin(int pin) {
+  if (heaterHwTimer) return true;
+  heaterPin = pin;
+  heaterHwTimer = timerBegin(HEATER_TIMER_NUM, HEATER_TIMER_DIVIDER, true);
+  if (!heaterHwTimer) {
+    Serial.println("[HEATER-TIMER] timerBegin failed - falling back to loop-driven heater window");
+    return false;
+  }
+  timerAttachInterrupt(heaterHwTimer, &heaterTimerIsr, false);   // Level interrupt; edge mode is unsupported
+  timerAlarmWrite(heaterHwTimer, HEATER_TIMER_TICK_US, true);
+  timerAlarmEnable(heaterHwTimer);
+  if (debugSerial) Serial.printf("[HEATER-TIMER] Started on pin %d, %lu us tick\n", pin, HEATER_TIMER_TICK_US);
+  return true;
+}
+
+bool heaterTimerActive() {
+  return heaterHwTimer != nullptr;
+}
+
+void heaterTimerSetWindow(unsigned long windowMs, unsigned long onMs, bool restart) {
+  if (!heaterHwTimer) return;
+  unsigned long nowMs = millis();
+  if (lastFeedMs != 0) {
+    uint32_t gap = nowMs - lastFeedMs;
+    stats.lastLoopGapMs = gap;
+    if (gap > stats.loopGapMaxMs) stats.loopGapMaxMs = gap;
+  }
+  lastFeedMs = nowMs;
+
+  if (windowMs == 0) windowMs = 1;
+  if (onMs > windowMs) onMs = windowMs;
+
+  portENTER_CRITICAL(&heaterTimerMux);
+  pendingWindowUs = windowMs * 1000UL;
+  pendingOnUs = onMs * 1000UL;
+  leaseUntilUs = esp_timer_get_time() + (int64_t)HEATER_TIMER_LEASE_MS * 1000;
+  if (!armed || restart) restartPending = true;
+  armed = true;
+  portEXIT_CRITICAL(&heaterTimerMux);
+}
+
+bool heaterTimerStop() {
+  if (!heaterHwTimer) return false;
+  portENTER_CRITICAL(&heaterTimerMux);
+  bool wasArmed = armed;
+  armed = false;
+  if (level) driveHeater(false, esp_timer_get_time());
+  portEXIT_CRITICAL(&heaterTimerMux);
+  lastFeedMs = 0;
+  return wasArmed;
+}
+
+bool heaterTimerOutput() {
+  return level;
+}
+
+uint64_t heaterTimerOnTimeUs() {
+  int64_t nowUs = esp_timer_get_time();
+  portENTER_CRITICAL(&heaterTimerMux);
+  uint64_t total = onTotalUs + (level ? (uint64_t)(nowUs - onSinceUs) : 0);
+  portEXIT_CRITICAL(&heaterTimerMux);
+  return total;
+}
+
+uint32_t heaterTimerPulses() {
+  return onPulses;
+}
+
+const HeaterTimerStats& heaterTimerGetStats() {
+  return stats;
+}
+
+void heaterTimerResetStats() {
+  portENTER_CRITICAL(&heaterTimerMux);
+  stats = HeaterTimerStats();
+  portEXIT_CRITICAL(&heaterTimerMux);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <Arduino.h>
+
+// Hardware-timer-driven time-proportional heater window.
+// A 1 ms timer interrupt owns the window position and switches the heater pin at
+// the scheduled edges, so loop latency (handleClient, file serving, FFat writes)
+// no longer stretches on-times. The control loop only updates the duty through
+// heaterTimerSetWindow(); a new on-time applies from the next tick, a new window
+// length from the next window start.
+//
+// Safety: every heaterTimerSetWindow() call renews a lease. If the loop stops
+// calling it for HEATER_TIMER_LEASE_MS the interrupt switches the heater off, so a
+// locked-up loop can't leave the heater cycling on the last duty.
+
+constexpr unsigned long HEATER_TIMER_TICK_US = 1000;   // Interrupt period (edge resolution)
+constexpr unsigned long HEATER_TIMER_LEASE_MS = 3000;  // Heater off if the loop stops feeding the window
+
+struct HeaterTimerStats {
+  uint32_t windows = 0;           // Windows started
+  uint32_t edges = 0;             // Pin transitions driven by the timer
+  uint32_t lastEdgeErrorUs = 0;   // Actual minus scheduled edge time
+  uint32_t maxEdgeErrorUs = 0;
+  uint64_t totalEdgeErrorUs = 0;
+  uint32_t lastPulseUs = 0;       // Measured width of the last completed on-pulse
+  uint32_t maxPulseErrorUs = 0;   // |measured - scheduled| pulse width
+  uint32_t leaseExpiries = 0;     // Heater forced off because the loop stopped feeding
+  uint32_t loopGapMaxMs = 0;      // Longest gap between heaterTimerSetWindow() calls
+  uint32_t lastLoopGapMs = 0;     // What a loop-driven window would have been late by
+};
+
+// Starts the timer on the heater pin; returns false (loop-driven fallback) on failure
+bool heaterTimerBegin(int pin);
+bool heaterTimerActive();
+
+// Called from the control loop. restart starts a new window on the next tick
+// (dynamic window restart); the first call after a stop always does.
+void heaterTimerSetWindow(unsigned long windowMs, unsigned long onMs, bool restart);
+
+// Disarms the window and drives the pin low immediately; returns true if it was armed
+bool heaterTimerStop();
+bool heaterTimerOutput();   // Level currently driven by the timer
+
+// Heater on-time and pulses driven by the timer, counted at each edge in the ISR (so
+// short pulses between loop passes are not missed). Monotonic; not cleared by a stats reset.
+uint64_t heaterTimerOnTimeUs();   // Includes the pulse in progress
+uint32_t heaterTimerPulses();
+
+const HeaterTimerStats& heaterTimerGetStats();
+void heaterTimerResetStats();
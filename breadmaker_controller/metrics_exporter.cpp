@@ -0,0 +1,307 @@
+#include "metrics_exporter.h"
+#include "globals.h"
+#include "missing_stubs.h"
+#include "outputs_manager.h"
+#include "sensor_service.h"
+#include "heater_timer.h"
+#include "enhanced_motor_control.h"
+#include "control_task.h"
+#include "control_commands.h"
+#include "storage_stats.h"
+#include "web_routes.h"
+#include "response_cache.h"
+#include "mqtt_publisher.h"
+#include <WiFi.h>
+#include <cmath>
+#include <cstdarg>
+
+static const char* const OUTPUT_LABELS[4] = {"heater", "motor", "light", "buzzer"};
+
+// Control-task state, copied under the lock before anything is written
+struct ControlValues {
+  double setpoint, input, output;
+  double kp, ki, kd;
+  double pidP, pidI, pidD;
+  float fermentationFactor;
+  float temperature;
+  unsigned int dynamicRestarts;
+  uint32_t heaterCycles;
+  bool running, emergencyShutdown;
+  int stageIdx;
+  bool outputs[4];
+  HeaterTimerStats heater;
+  MotorPulseStats motor;
+  ControlTaskStats task;
+  ControlCommandStats commands;
+  SensorReading sensor;
+};
+
+// Writes one exposition line at a time from a stack buffer
+class MetricsWriter {
+  public:
+    explicit MetricsWriter(Print& out) : out(out) {}
+
+    void family(const char* name, const char* type, const char* help) {
+      line("# HELP breadmaker_%s %s\n# TYPE breadmaker_%s %s\n", name, help, name, type);
+    }
+
+    void sample(const char* name, double value, const char* labels = nullptr) {
+      char v[24];
+      formatValue(v, sizeof(v), value);
+      if (labels && *labels) line("breadmaker_%s{%s} %s\n", name, labels, v);
+      else line("breadmaker_%s %s\n", name, v);
+    }
+
+    void count(const char* name, uint64_t value, const char* labels = nullptr) {
+      if (labels && *labels) line("breadmaker_%s{%s} %llu\n", name, labels, (unsigned long long)value);
+      else line("breadmaker_%s %llu\n", name, (unsigned long long)value);
+    }
+
+    // Family header plus one unlabelled sample
+    void gauge(const char* name, const char* help, double value) {
+      family(name, "gauge", help);
+      sample(name, value);
+    }
+
+    void counter(const char* name, const char* help, uint64_t value) {
+      family(name, "counter", help);
+      count(name, value);
+    }
+
+  private:
+    void line(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+      va_list args;
+      va_start(args, fmt);
+      int n = vsnprintf(buf, sizeof(buf), fmt, args);
+      va_end(args);
+      if (n <= 0) return;
+      if ((size_t)n >= sizeof(buf)) {
+        // Truncated (very long label): keep the line terminated
+        n = sizeof(buf) - 1;
+        buf[n - 1] = '\n';
+      }
+      out.write((const uint8_t*)buf, n);
+    }
+
+    static void formatValue(char* dst, size_t len, double value) {
+      if (std::isnan(value)) snprintf(dst, len, "NaN");
+      else if (std::isinf(value)) snprintf(dst, len, value > 0 ? "+Inf" : "-Inf");
+      else snprintf(dst, len, "%.6g", value);
+    }
+
+    Print& out;
+    char buf[256];
+};
+
+// Label values may not contain an unescaped quote, backslash or newline
+static void escapeLabel(char* dst, size_t len, const char* src) {
+  size_t o = 0;
+  for (; *src && o + 2 < len; src++) {
+    char c = *src;
+    if (c == '"' || c == '\\') { dst[o++] = '\\'; dst[o++] = c; }
+    else if (c == '\n') { dst[o++] = '\\'; dst[o++] = 'n'; }
+    else dst[o++] = c;
+  }
+  dst[o] = '\0';
+}
+
+static void readControlValues(ControlValues& v) {
+  ControlLockGuard lock;
+  v.setpoint = pid.Setpoint;
+  v.input = pid.Input;
+  v.output = pid.Output;
+  v.kp = pid.Kp;
+  v.ki = pid.Ki;
+  v.kd = pid.Kd;
+  v.pidP = pid.pidP;
+  v.pidI = pid.pidI;
+  v.pidD = pid.pidD;
+  v.fermentationFactor = fermentState.fermentationFactor;
+  v.temperature = getAveragedTemperature();
+  v.dynamicRestarts = dynamicRestart.dynamicRestartCount;
+  v.heaterCycles = getHeaterCycleCount();
+  v.running = programState.isRunning;
+  v.emergencyShutdown = safetySystem.emergencyShutdown;
+  v.stageIdx = programState.customStageIdx;
+  v.outputs[0] = outputStates.heater;
+  v.outputs[1] = outputStates.motor;
+  v.outputs[2] = outputStates.light;
+  v.outputs[3] = outputStates.buzzer;
+  v.heater = heaterTimerGetStats();
+  v.motor = motorPulseGetStats();
+  v.task = controlTaskGetStats();
+  v.commands = controlCommandsGetStats();
+  v.sensor = sensorGetReading();
+}
+
+static void renderSystem(MetricsWriter& m) {
+  m.gauge("uptime_seconds", "Time since boot", millis() / 1000.0);
+
+  m.counter("loop_iterations_total", "Passes through loop() on the web/network core", getLoopCount());
+  m.gauge("loop_time_avg_seconds", "Average loop() pass time", getAverageLoopTime() / 1e6);
+  m.gauge("loop_time_max_seconds", "Longest loop() pass time", getMaxLoopTime() / 1e6);
+
+  m.gauge("heap_free_bytes", "Free heap", ESP.getFreeHeap());
+  m.gauge("heap_min_free_bytes", "Lowest free heap seen", getMinFreeHeap());
+  m.gauge("heap_max_alloc_bytes", "Largest allocatable heap block", ESP.getMaxAllocHeap());
+  m.gauge("heap_fragmentation_ratio", "Share of free heap not in the largest block", getHeapFragmentation() / 100.0);
+
+  m.counter("wifi_reconnects_total", "WiFi reconnections", getWifiReconnectCount());
+  m.gauge("wifi_connected", "1 while associated", WiFi.status() == WL_CONNECTED ? 1 : 0);
+  m.gauge("wifi_rssi_dbm", "Signal strength", WiFi.status() == WL_CONNECTED ? WiFi.RSSI() : NAN);
+}
+
+static void renderControl(MetricsWriter& m, const ControlValues& v) {
+  char labels[32];
+
+  m.gauge("program_running", "1 while a program runs", v.running ? 1 : 0);
+  m.gauge("program_stage_index", "Current stage of the running program", v.running ? v.stageIdx : NAN);
+  m.gauge("emergency_shutdown", "1 after a safety shutdown", v.emergencyShutdown ? 1 : 0);
+  m.family("output_on", "gauge", "Output state");
+  for (uint8_t i = 0; i < 4; i++) {
+    snprintf(labels, sizeof(labels), "output=\"%s\"", OUTPUT_LABELS[i]);
+    m.sample("output_on", v.outputs[i] ? 1 : 0, labels);
+  }
+
+  m.gauge("temperature_celsius", "Averaged chamber temperature", v.temperature);
+  m.gauge("sensor_temperature_celsius", "Latest calibrated reading", v.sensor.temperature);
+  m.gauge("sensor_health", "0 valid, 1 stale, 2 fault", v.sensor.health);
+  m.counter("sensor_faults_total", "Faulty sensor readings", v.sensor.faultCount);
+
+  m.gauge("pid_setpoint_celsius", "PID setpoint", v.setpoint);
+  m.gauge("pid_input_celsius", "PID input", v.input);
+  m.gauge("pid_output", "PID output (heater duty, 0-1)", v.output);
+  m.family("pid_gain", "gauge", "Active PID gains");
+  m.sample("pid_gain", v.kp, "term=\"p\"");
+  m.sample("pid_gain", v.ki, "term=\"i\"");
+  m.sample("pid_gain", v.kd, "term=\"d\"");
+  m.family("pid_term", "gauge", "PID output contributions");
+  m.sample("pid_term", v.pidP, "term=\"p\"");
+  m.sample("pid_term", v.pidI, "term=\"i\"");
+  m.sample("pid_term", v.pidD, "term=\"d\"");
+
+  m.gauge("fermentation_factor", "Stage time multiplier from fermentation temperature", v.fermentationFactor);
+
+  m.counter("heater_dynamic_restarts_total", "Heater windows restarted early on a large output change", v.dynamicRestarts);
+  m.counter("heater_relay_cycles_total", "Heater relay off-to-on switches", v.heaterCycles);
+  m.counter("heater_windows_total", "Hardware-timed heater windows started", v.heater.windows);
+  m.counter("heater_edges_total", "Heater pin transitions driven by the timer", v.heater.edges);
+  m.counter("heater_lease_expiries_total", "Heater forced off because the control loop stopped feeding", v.heater.leaseExpiries);
+  m.gauge("heater_edge_error_max_seconds", "Largest heater edge timing error", v.heater.maxEdgeErrorUs / 1e6);
+  m.counter("motor_edges_total", "Motor pin transitions driven by the timer", v.motor.edges);
+  m.counter("motor_lease_expiries_total", "Motor pattern stopped because the control tick stopped renewing it", v.motor.leaseExpiries);
+  m.gauge("motor_edge_error_max_seconds", "Largest motor edge timing error", v.motor.maxEdgeErrorUs / 1e6);
+
+  m.counter("control_ticks_total", "Control task ticks", v.task.ticks);
+  m.counter("control_overruns_total", "Control ticks that ended after the next was due", v.task.overruns);
+  m.gauge("control_tick_max_seconds", "Longest control tick", v.task.maxTickUs / 1e6);
+  m.gauge("control_lateness_max_seconds", "Largest control tick wake-up lateness", v.task.maxLatenessUs / 1e6);
+  m.gauge("control_stack_free_bytes", "Control task stack high-water mark", v.task.stackFreeBytes);
+
+  m.counter("commands_submitted_total", "Commands queued for the control tick", v.commands.submitted);
+  m.counter("commands_applied_total", "Commands applied by the control tick", v.commands.applied);
+  m.counter("commands_rejected_total", "Commands refused with the queue full", v.commands.rejectedFull);
+  m.counter("commands_timeouts_total", "Handlers that stopped waiting for their command", v.commands.timeouts);
+}
+
+static void renderStorage(MetricsWriter& m) {
+  static const char* const NAMES[4] = {
+    "flash_write_opens_total", "flash_write_bytes_total", "flash_sector_erases_total", "flash_write_failures_total"
+  };
+  static const char* const HELP[4] = {
+    "Files opened for writing", "Bytes written", "Estimated sector erases", "Failed opens for writing"
+  };
+  uint8_t n = storageStatsCount();
+  char path[64], caller[24], labels[112];
+  for (uint8_t k = 0; k < 4; k++) {
+    m.family(NAMES[k], "counter", HELP[k]);
+    for (uint8_t i = 0; i < n; i++) {
+      const StorageEntry& e = storageStatsEntry(i);
+      escapeLabel(path, sizeof(path), e.path);
+      escapeLabel(caller, sizeof(caller), e.caller);
+      snprintf(labels, sizeof(labels), "path=\"%s\",caller=\"%s\"", path, caller);
+      const StorageCounters& c = e.total;
+      uint64_t value = k == 0 ? c.opens : k == 1 ? c.bytes : k == 2 ? c.erases : c.failures;
+      m.count(NAMES[k], value, labels);
+    }
+  }
+  m.counter("boots_total", "Boots since the flash counters were reset", storageStatsSummary().boots);
+}
+
+static void routeLabels(char* dst, size_t len, const WebRoute& r) {
+  char uri[64];
+  escapeLabel(uri, sizeof(uri), r.uri);
+  snprintf(dst, len, "route=\"%s\",method=\"%s\"", uri, routeMethodName(r.method));
+}
+
+static void renderHttp(MetricsWriter& m) {
+  static const char* const NAMES[3] = {"http_requests_total", "http_errors_total", "http_response_bytes_total"};
+  static const char* const HELP[3] = {
+    "Requests per route", "Responses with status 400 and above per route", "Response bytes per route, headers included"
+  };
+  uint8_t n = routeCount();
+  char labels[112], bucketLabels[128];
+
+  for (uint8_t k = 0; k < 3; k++) {
+    m.family(NAMES[k], "counter", HELP[k]);
+    for (uint8_t i = 0; i < n; i++) {
+      const WebRoute& r = routeGet(i);
+      if (!r.stats.requests) continue;
+      routeLabels(labels, sizeof(labels), r);
+      uint64_t value = k == 0 ? r.stats.requests : k == 1 ? r.stats.errors : r.stats.bytesOut;
+      m.count(NAMES[k], value, labels);
+    }
+  }
+
+  m.family("http_request_duration_seconds", "histogram", "Handler time per route");
+  for (uint8_t i = 0; i < n; i++) {
+    const WebRoute& r = routeGet(i);
+    if (!r.stats.requests) continue;
+    routeLabels(labels, sizeof(labels), r);
+    // Buckets are cumulative in the exposition format
+    uint64_t cumulative = 0;
+    for (uint8_t b = 0; b < ROUTE_LATENCY_BUCKETS; b++) {
+      cumulative += r.stats.histogram[b];
+      if (b < ROUTE_LATENCY_BUCKETS - 1) {
+        snprintf(bucketLabels, sizeof(bucketLabels), "%s,le=\"%g\"", labels, ROUTE_LATENCY_BOUNDS_US[b] / 1e6);
+      } else {
+        snprintf(bucketLabels, sizeof(bucketLabels), "%s,le=\"+Inf\"", labels);
+      }
+      m.count("http_request_duration_seconds_bucket", cumulative, bucketLabels);
+    }
+    m.sample("http_request_duration_seconds_sum", r.stats.totalUs / 1e6, labels);
+    m.count("http_request_duration_seconds_count", cumulative, labels);
+  }
+
+  const WebRouteTableStats& t = routeTableStats();
+  m.counter("http_unmatched_total", "Requests no route accepted", t.unmatched);
+  const WebConnectionStats& c = webConnectionStats();
+  m.counter("http_connections_total", "TCP connections accepted while keep-alive is on", c.accepted);
+  m.counter("http_connections_reused_total", "Requests served on an already used connection", c.reused);
+  m.gauge("http_connections_open", "Open keep-alive connections", c.open);
+
+  const ResponseCacheStats& rc = responseCacheGetStats();
+  m.counter("response_cache_hits_total", "Responses served from the cache", rc.hits);
+  m.counter("response_cache_misses_total", "Cacheable responses rendered", rc.misses);
+}
+
+static void renderMqtt(MetricsWriter& m) {
+  const MqttStats& s = mqttGetStats();
+  m.gauge("mqtt_connected", "1 while connected to the broker", s.connected ? 1 : 0);
+  m.counter("mqtt_connects_total", "Broker connections", s.connects);
+  m.counter("mqtt_connect_failures_total", "Failed broker connection attempts", s.connectFailures);
+  m.counter("mqtt_publishes_total", "Messages published", s.publishes);
+  m.counter("mqtt_suppressed_total", "Changes within their deadband, not published", s.suppressed);
+}
+
+void metricsRender(Print& out) {
+  ControlValues v;
+  readControlValues(v);
+
+  MetricsWriter m(out);
+  renderSystem(m);
+  renderControl(m, v);
+  renderStorage(m);
+  renderHttp(m);
+  renderMqtt(m);
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <Arduino.h>
+
+// Prometheus text exposition (format 0.0.4) for GET /metrics.
+// The diagnostics endpoints (/api/pid_debug, /api/ewma_status, /ha, /debug/fs,
+// /api/control_task, ...) each have their own JSON shape, which a TSDB can't scrape.
+// metricsRender() writes the same counters in one pass: loop timing, heap, WiFi,
+// heater windows and relay cycles, PID terms, fermentation, control task and command
+// queue, flash writes per (path, caller), and per-route HTTP counters with the route
+// latency histogram.
+//
+// Each line is formatted into a stack buffer and written to the Print, which for
+// /metrics is the response cache's uncached path (TTL 0): buffered and sent as one
+// response, or streamed in 1 KB chunks once it passes RESPONSE_CACHE_MAX_BODY. The
+// control-state values are copied under the control lock in one short section before
+// anything is written, so the tick never waits on the network. Routes that have not
+// served a request are left out to keep the scrape small.
+
+constexpr const char* METRICS_CONTENT_TYPE = "text/plain; version=0.0.4; charset=utf-8";
+
+void metricsRender(Print& out);
@@ -3,6 +3,15 @@
 #include "programs_manager.h"
 #include "calibration.h"
 #include "program_logger.h"
+#include "sensor_service.h"
+#include "temperature_estimator.h"
+#include "heater_timer.h"
+#include "outputs_manager.h"
+#include "persistence_manager.h"
+#include "storage_stats.h"
+#include "storage_backend.h"
+#include "debug_log.h"
+#include "trace_recorder.h"
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <WebServer.h>
@@ -11,7 +20,6 @@
 #ifdef ESP32
 #include <esp_system.h>
 #include <WiFi.h>
-#include <FFat.h>
 #endif
 
 // External function declarations
@@ -45,6 +53,7 @@ extern void setLight(bool on);
 extern void setBuzzer(bool on);
 extern void invalidateStatusCache();
 extern void clearResumeState();
+extern void saveResumeState();
 extern size_t getProgramCount();
 extern String getProgramName(int programId);
 extern bool isProgramValid(int programId);
@@ -52,6 +61,10 @@ extern bool ensureProgramLoaded(int programId);
 extern Program* getActiveProgramMutable();
 extern void switchToProfile(const String& profileName);
 extern void saveSettings();
+extern void resetFermentationTracking(float temp);
+extern time_t scheduledStart;
+extern int scheduledStartStage;
+extern unsigned long lightOnTime;
 
 // Performance tracking variables
 static unsigned long lastLoopTime = 0;
@@ -78,6 +91,8 @@ static FermentationCache fermentCache;
 
 // Temperature and performance functions
 double getAveragedTemperature() {
+    // Kalman estimate when selected in settings (tempFilter = "kalman"), otherwise the EMA
+    if (temperatureEstimatorActive()) return temperatureEstimatorGetTemperature();
     return tempAvg.smoothedTemperature;
 }
 
@@ -90,23 +105,23 @@ void updateTemperatureSampling() {
     if (nowMs - tempAvg.lastUpdate >= tempAvg.updateInterval) {
         tempAvg.lastUpdate = nowMs;
         
-        // Take a new temperature sample using the calibrated readTemperature function
+        // Only feed valid, fresh readings from the sensor service into the EMA
+        if (!sensorIsValid()) {
+            LOG_DEBUG(LOG_TEMP, "[TEMP-EMA] Skipping sample - sensor %s\n", sensorHealthName(sensorGetHealth()));
+            return;
+        }
         float calibratedTemp = readTemperature();
         
         // CRITICAL SAFETY FIX: Reject invalid temperature readings to prevent PID malfunction
         if (calibratedTemp <= -999.0f || calibratedTemp >= 999.0f) {
-            if (debugSerial) {
-                Serial.printf("[TEMP-EMA] SAFETY: Rejecting invalid temperature %.2f°C from sensor failure\n", calibratedTemp);
-            }
+            LOG_WARN(LOG_TEMP, "[TEMP-EMA] SAFETY: Rejecting invalid temperature %.2f°C from sensor failure\n", calibratedTemp);
             // Do not update EMA with invalid readings - keep last valid temperature
             return;
         }
         
         // Additional validation: Reject physically impossible temperatures
         if (calibratedTemp < -50.0f || calibratedTemp > 300.0f) {
-            if (debugSerial) {
-                Serial.printf("[TEMP-EMA] SAFETY: Rejecting out-of-range temperature %.2f°C\n", calibratedTemp);
-            }
+            LOG_WARN(LOG_TEMP, "[TEMP-EMA] SAFETY: Rejecting out-of-range temperature %.2f°C\n", calibratedTemp);
             return;
         }
         
@@ -149,9 +164,7 @@ void updateTemperatureSampling() {
         if (!tempAvg.initialized) {
             tempAvg.smoothedTemperature = calibratedTemp;
             tempAvg.initialized = true;
-            if (debugSerial) {
-                Serial.printf("[TEMP-EMA] Initialized with %.2f°C\n", calibratedTemp);
-            }
+            LOG_DEBUG(LOG_TEMP, "[TEMP-EMA] Initialized with %.2f°C\n", calibratedTemp);
         } else {
             // Apply Exponential Moving Average: new = α × current + (1-α) × previous
             // Using explicit double precision to prevent accumulation of rounding errors
@@ -164,10 +177,10 @@ void updateTemperatureSampling() {
         tempAvg.sampleCount++;
         
         // Optional: Log every 10th sample for debugging
-        if (debugSerial && (tempAvg.sampleCount % 10 == 0)) {
-            Serial.printf("[TEMP-EMA] Sample #%u: Raw=%.2f°C, Smoothed=%.2f°C, α=%.3f, Diff=%.2f°C\n", 
-                         tempAvg.sampleCount, calibratedTemp, tempAvg.smoothedTemperature, tempAvg.alpha,
-                         calibratedTemp - tempAvg.smoothedTemperature);
+        if (tempAvg.sampleCount % 10 == 0) {
+            LOG_VERBOSE(LOG_TEMP, "[TEMP-EMA] Sample #%u: Raw=%.2f°C, Smoothed=%.2f°C, α=%.3f, Diff=%.2f°C\n", 
+                        tempAvg.sampleCount, calibratedTemp, tempAvg.smoothedTemperature, tempAvg.alpha,
+                        calibratedTemp - tempAvg.smoothedTemperature);
         }
     }
 }
@@ -247,10 +260,8 @@ void checkAndSwitchPIDProfile() {
     if (pid.Setpoint >= profile.minTemp && pid.Setpoint < profile.maxTemp) {
       // Only switch if we're not already using the correct profile
       if (abs(pid.Kp - profile.kp) > 0.001 || abs(pid.Ki - profile.ki) > 0.0001 || abs(pid.Kd - profile.kd) > 0.01) {
-        if (debugSerial) {
-          Serial.printf("[PID-PROFILE] Setpoint %.1f°C requires '%s' profile (Kp=%.3f, Ki=%.6f, Kd=%.1f)\n",
-                        pid.Setpoint, profile.name.c_str(), profile.kp, profile.ki, profile.kd);
-        }
+        LOG_INFO(LOG_PID, "[PID-PROFILE] Setpoint %.1f°C requires '%s' profile (Kp=%.3f, Ki=%.6f, Kd=%.1f)\n",
+                 pid.Setpoint, profile.name.c_str(), profile.kp, profile.ki, profile.kd);
         switchToProfile(profile.name);
         saveSettings();
       }
@@ -274,14 +285,13 @@ String getCurrentActiveProfileName() {
   return "Unknown"; // Setpoint outside all profile ranges
 }
 
-// Save PID profiles to file
+// Save PID profiles to file (deferred to the persistence worker)
 void savePIDProfiles() {
-  File file = FFat.open("/pid-profiles.json", "w");
-  if (!file) {
-    if (debugSerial) Serial.println("[ERROR] Failed to open pid-profiles.json for writing");
-    return;
-  }
-  
+  persistMarkDirty(PERSIST_PID_PROFILES);
+}
+
+// PID profiles JSON, streamed by the persistence worker (control lock held)
+void serializePIDProfilesJson(Print& out) {
   // Create JSON document
   StaticJsonDocument<1024> doc;
   JsonArray profiles = doc.createNestedArray("pidProfiles");
@@ -302,19 +312,14 @@ void savePIDProfiles() {
   // Add metadata - but NOT activeProfile (it's determined automatically by setpoint)
   doc["autoSwitching"] = pid.autoSwitching;
   
-  // Write to file
-  if (serializeJson(doc, file) == 0) {
+  if (serializeJson(doc, out) == 0) {
     if (debugSerial) Serial.println("[ERROR] Failed to write PID profiles JSON");
-  } else {
-    if (debugSerial) Serial.println("[INFO] PID profiles saved successfully");
   }
-  
-  file.close();
 }
 
 // Load PID profiles from file
 void loadPIDProfiles() {
-  File file = FFat.open("/pid-profiles.json", "r");
+  File file = storageFS().open("/pid-profiles.json", "r");
   if (!file) {
     if (debugSerial) Serial.println("[WARN] pid-profiles.json not found, creating default profiles");
     createDefaultPIDProfiles();
@@ -399,7 +404,7 @@ void updateActiveProgramVars() {
   if (getProgramCount() > 0 && programState.activeProgramId < getProgramCount() && isProgramValid(programState.activeProgramId)) {
     // Ensure the program is loaded
     if (!ensureProgramLoaded(programState.activeProgramId)) {
-      if (debugSerial) Serial.printf("[ERROR] Failed to load program %d\n", programState.activeProgramId);
+      LOG_ERROR(LOG_STAGE, "[ERROR] Failed to load program %d\n", programState.activeProgramId);
       programState.customProgram = nullptr;
       programState.maxCustomStages = 0;
       return;
@@ -408,13 +413,13 @@ void updateActiveProgramVars() {
     programState.customProgram = getActiveProgramMutable();
     programState.maxCustomStages = programState.customProgram ? programState.customProgram->customStages.size() : 0;
     
-    if (debugSerial) Serial.printf("[INFO] updateActiveProgramVars: Program %d loaded, customProgram=%p, stages=%zu\n", 
-                                   programState.activeProgramId, (void*)programState.customProgram, programState.maxCustomStages);
+    LOG_VERBOSE(LOG_STAGE, "[INFO] updateActiveProgramVars: Program %d loaded, customProgram=%p, stages=%zu\n",
+                programState.activeProgramId, (void*)programState.customProgram, programState.maxCustomStages);
   } else {
     programState.customProgram = nullptr;
     programState.maxCustomStages = 0;
-    if (debugSerial) Serial.printf("[INFO] updateActiveProgramVars: No valid program (count=%zu, id=%d)\n", 
-                                   getProgramCount(), programState.activeProgramId);
+    LOG_VERBOSE(LOG_STAGE, "[INFO] updateActiveProgramVars: No valid program (count=%zu, id=%d)\n",
+                getProgramCount(), programState.activeProgramId);
   }
 }
 
@@ -446,6 +451,359 @@ void stopBreadmaker() {
     clearResumeState();
 }
 
+// Starts a new run of the active program at stageIdx (already validated against
+// maxCustomStages). Shared by /start and CMD_START; the caller saves the resume file.
+void beginProgramRun(int stageIdx) {
+    programState.customStageIdx = stageIdx;
+    programState.isRunning = true;
+    programState.customMixIdx = 0;
+    programState.customStageStart = millis();
+    programState.customMixStepStart = 0;
+    programState.programStartTime = time(nullptr);
+    
+    // Clear all timing arrays when starting/restarting
+    for (int i = 0; i < 20; i++) {
+        programState.actualStageStartTimes[i] = 0;
+        programState.actualStageEndTimes[i] = 0;
+    }
+    // Record the start time for the current stage
+    programState.actualStageStartTimes[programState.customStageIdx] = programState.programStartTime;
+    
+    // Initialize stage duration arrays with current fermentation conditions
+    initializeStageArrays();
+    
+    LOG_DEBUG(LOG_STAGE, "[TIMING] Program started at stage %d, time %lu\n", (int)programState.customStageIdx, (unsigned long)programState.programStartTime);
+    
+    // Log program start
+    String programName = getProgramName(programState.activeProgramId);
+    logProgramStart(programName, programState.activeProgramId);
+    storageStatsStartRun();
+    
+    resetFermentationTracking(getAveragedTemperature());
+    invalidateStatusCache();
+}
+
+// --- Web command appliers (control tick, control lock held) ---
+// Moved out of the /advance, /back, /start_at_stage, /pause, /resume,
+// /api/add_prefermentation and /api/temperature handlers. They report errors in
+// result.body with the same JSON the handlers used to send, and set stateChanged
+// instead of saving the resume file themselves.
+
+static void commandError(ControlCommandResult& result, int16_t code, const char* message) {
+  result.httpCode = code;
+  snprintf(result.body, sizeof(result.body), "{\"status\":\"error\",\"message\":\"%s\"}", message);
+}
+
+static void applyAdvance(ControlCommandResult& result) {
+  if (!programState.isRunning) return commandError(result, 400, "Program not running");
+  Program* p = getActiveProgramMutable();
+  if (!p || p->customStages.empty()) return commandError(result, 400, "No active program");
+  if (programState.customStageIdx >= p->customStages.size() - 1) return commandError(result, 400, "Already at last stage");
+  
+  // Record when current stage ended (BEFORE advancing)
+  time_t now = time(nullptr);
+  if (now > 1640995200 && programState.customStageIdx < 20) { // Valid NTP time and within bounds
+    programState.actualStageEndTimes[programState.customStageIdx] = now;
+    LOG_DEBUG(LOG_STAGE, "[TIMING] Manual advance - Stage %d ended at %lu\n", (int)programState.customStageIdx, (unsigned long)now);
+  }
+  
+  // Save resume state BEFORE advancing (FIX: prevents stage skipping during firmware uploads)
+  saveResumeState();
+  
+  // Manually advance to next stage
+  programState.customStageIdx++;
+  programState.customStageStart = millis();
+  traceInstant(TRACE_CONTROL, "manual advance");
+  
+  // Update actual stage start times array
+  if (programState.customStageIdx < 20) {
+    programState.actualStageStartTimes[programState.customStageIdx] = now;
+    LOG_DEBUG(LOG_STAGE, "[TIMING] Manual advance - Stage %d started at %lu\n", (int)programState.customStageIdx, (unsigned long)now);
+  }
+  
+  resetFermentationTracking(getAveragedTemperature());
+  invalidateStatusCache();
+  result.stateChanged = true;
+  LOG_DEBUG(LOG_STAGE, "[MANUAL ADVANCE] Advanced to stage %d\n", (int)programState.customStageIdx);
+}
+
+static void applyBack(ControlCommandResult& result) {
+  if (programState.activeProgramId >= getProgramCount()) {
+    stopBreadmaker();
+    return commandError(result, 200, "No valid program");
+  }
+  Program *p = getActiveProgramMutable();
+  if (!p) {
+    LOG_ERROR(LOG_STAGE, "[ERROR] /back: Unable to get active program\n");
+    stopBreadmaker();
+    return commandError(result, 200, "Cannot access active program");
+  }
+  size_t numStages = p->customStages.size();
+  if (numStages == 0) {
+    LOG_ERROR(LOG_STAGE, "[ERROR] /back: Program at id %u has zero stages\n", (unsigned)programState.activeProgramId);
+    stopBreadmaker();
+    return commandError(result, 200, "Program has no stages");
+  }
+  
+  // Go to previous stage (wrap to last stage if at beginning)
+  if (programState.customStageIdx > 0) {
+    programState.customStageIdx--;
+  } else {
+    programState.customStageIdx = numStages - 1;
+  }
+  
+  programState.customStageStart = millis();
+  programState.customMixStepStart = 0;
+  programState.isRunning = true;
+  if (programState.customStageIdx == 0) {
+    programState.programStartTime = time(nullptr);
+  }
+  invalidateStatusCache();
+  
+  // Record actual start time of this stage when going back
+  if (programState.customStageIdx < numStages && programState.customStageIdx < MAX_PROGRAM_STAGES) {
+    programState.actualStageStartTimes[programState.customStageIdx] = time(nullptr);
+    
+    // Clear any future stage timestamps to prevent timing corruption
+    for (size_t i = programState.customStageIdx + 1; i < MAX_PROGRAM_STAGES; i++) {
+      programState.actualStageStartTimes[i] = 0;
+    }
+  }
+  
+  result.stateChanged = true;
+  result.value = programState.customStageIdx;
+  snprintf(result.body, sizeof(result.body), "{\"status\":\"ok\",\"stage\":%d}", (int)programState.customStageIdx);
+}
+
+static void applyStartAtStage(int stage, ControlCommandResult& result) {
+  if (programState.activeProgramId >= getProgramCount()) {
+    stopBreadmaker();
+    result.httpCode = 400;
+    snprintf(result.body, sizeof(result.body), "{\"error\":\"No valid program selected\"}");
+    return;
+  }
+  Program *p = getActiveProgramMutable();
+  if (!p) {
+    LOG_ERROR(LOG_STAGE, "[ERROR] /start_at_stage: Unable to get active program\n");
+    stopBreadmaker();
+    result.httpCode = 400;
+    snprintf(result.body, sizeof(result.body), "{\"error\":\"Cannot access active program\"}");
+    return;
+  }
+  size_t numStages = p->customStages.size();
+  if (numStages == 0) {
+    LOG_ERROR(LOG_STAGE, "[ERROR] /start_at_stage: Program has zero stages\n");
+    stopBreadmaker();
+    result.httpCode = 400;
+    snprintf(result.body, sizeof(result.body), "{\"error\":\"Program has no stages\"}");
+    return;
+  }
+  if (stage < 0 || stage >= (int)numStages) {
+    result.httpCode = 400;
+    snprintf(result.body, sizeof(result.body), "{\"error\":\"Invalid stage number\"}");
+    return;
+  }
+  
+  // Set the starting stage
+  programState.customStageIdx = stage;
+  programState.customStageStart = millis();
+  programState.customMixStepStart = 0;
+  programState.isRunning = true;
+  if (stage == 0) {
+    programState.programStartTime = time(nullptr);
+    // Initialize stage arrays for new program
+    initializeStageArrays();
+    storageStatsStartRun();
+  } else {
+    // Ensure stage arrays are initialized for manual starts
+    if (!programState.adjustedStageDurations || programState.adjustedStageDurations[stage] == 0) {
+      initializeStageArrays();
+    }
+    
+    // If starting at a fermentation stage, reset fermentation timing
+    if (p->customStages[stage].isFermentation) {
+      // Force complete fermentation state reset for manual stage starts
+      fermentState.lastFermentStageIdx = -1;  // Force reset detection
+      fermentState.fermentLastUpdateMs = 0;
+      fermentState.scheduledElapsedSeconds = 0.0;
+      fermentState.realElapsedSeconds = 0.0;
+      fermentState.accumulatedFermentMinutes = 0.0;
+      fermentState.fermentationFactor = 0.0;
+      LOG_DEBUG(LOG_FERMENT, "[MANUAL-START] Reset fermentation timing for stage %d\n", stage);
+    }
+  }
+  invalidateStatusCache();
+  
+  // Record actual start time only for the current stage being entered
+  if (stage < MAX_PROGRAM_STAGES) {
+    programState.actualStageStartTimes[stage] = time(nullptr);
+    
+    // Clear any future stage timestamps to prevent timing corruption
+    for (int i = stage + 1; i < MAX_PROGRAM_STAGES; i++) {
+      programState.actualStageStartTimes[i] = 0;
+    }
+  }
+  
+  result.stateChanged = true;
+  result.value = stage;
+  snprintf(result.body, sizeof(result.body), "{\"status\":\"ok\",\"stage\":%d}", stage);
+}
+
+static void applySelectProgram(int programId, ControlCommandResult& result) {
+  if (!isProgramValid(programId)) return commandError(result, 400, "Invalid program ID");
+  // Reads the program file unless it is already in the cache
+  if (!ensureProgramLoaded(programId)) return commandError(result, 500, "Failed to load program");
+  programState.activeProgramId = programId;
+  updateActiveProgramVars();
+  invalidateStatusCache();
+  result.stateChanged = true;
+  result.value = programId;
+  snprintf(result.body, sizeof(result.body), "{\"status\":\"ok\",\"selected\":%d}", programId);
+}
+
+static void applyStart(int stage, ControlCommandResult& result) {
+  // Immediate start - clear any scheduled start
+  scheduledStart = 0;
+  scheduledStartStage = -1;
+  updateActiveProgramVars();
+  if (stage < 0 || stage >= (int)programState.maxCustomStages) return commandError(result, 400, "Invalid stage index");
+  beginProgramRun(stage);
+  result.stateChanged = true;
+  result.value = stage;
+  snprintf(result.body, sizeof(result.body), "{\"status\":\"started\",\"stage\":%d}", stage);
+}
+
+static const char* const OUTPUT_NAMES[] = { "heater", "motor", "light", "buzzer" };
+
+static void applySetOutput(int output, bool on, ControlCommandResult& result) {
+  switch (output) {
+    case 0: setHeater(on); break;
+    case 1: setMotor(on); break;
+    case 2:
+      setLight(on);
+      if (on) lightOnTime = millis();
+      break;
+    case 3: setBuzzer(on); break;
+    default: return commandError(result, 400, "Unknown output");
+  }
+  invalidateStatusCache();
+  snprintf(result.body, sizeof(result.body), "{\"%s\":%s}", OUTPUT_NAMES[output], on ? "true" : "false");
+}
+
+// Next occurrence of minutesOfDay (today, or tomorrow if already past)
+static void applyScheduleStart(int minutesOfDay, int stage, ControlCommandResult& result) {
+  if (minutesOfDay < 0) {
+    scheduledStart = 0;
+    scheduledStartStage = -1;
+    invalidateStatusCache();
+    snprintf(result.body, sizeof(result.body), "{\"status\":\"cancelled\"}");
+    return;
+  }
+  if (minutesOfDay >= 24 * 60) return commandError(result, 400, "Invalid time values");
+  if (stage >= 0) {
+    const Program* p = getActiveProgramMutable();
+    if (!p) return commandError(result, 400, "No active program selected");
+    if (stage >= (int)p->customStages.size()) return commandError(result, 400, "Invalid stage index");
+  }
+  
+  time_t now = time(nullptr);
+  struct tm timeinfo;
+  localtime_r(&now, &timeinfo);
+  timeinfo.tm_hour = minutesOfDay / 60;
+  timeinfo.tm_min = minutesOfDay % 60;
+  timeinfo.tm_sec = 0;
+  time_t targetTime = mktime(&timeinfo);
+  if (targetTime <= now) targetTime += 24 * 60 * 60;
+  
+  scheduledStart = targetTime;
+  scheduledStartStage = stage < 0 ? -1 : stage;
+  invalidateStatusCache();
+  snprintf(result.body, sizeof(result.body), "{\"status\":\"scheduled\",\"start\":%lu,\"stage\":%d}",
+           (unsigned long)targetTime, scheduledStartStage);
+}
+
+static void applyAddPrefermentation(float addSeconds, ControlCommandResult& result) {
+  if (!programState.isRunning) return commandError(result, 400, "Program not running");
+  Program* p = getActiveProgramMutable();
+  if (!p || p->customStages.empty()) return commandError(result, 400, "No active program");
+  if (programState.customStageIdx >= p->customStages.size()) return commandError(result, 400, "Invalid stage index");
+  // Only allow on fermentation stages
+  if (!p->customStages[programState.customStageIdx].isFermentation) {
+    return commandError(result, 400, "Current stage is not a fermentation stage");
+  }
+  
+  // Add the pre-fermentation time to scheduled elapsed seconds
+  fermentState.scheduledElapsedSeconds += addSeconds;
+  invalidateStatusCache();
+  result.stateChanged = true;
+  LOG_DEBUG(LOG_FERMENT, "[PRE-FERMENTATION] Added %.1f seconds to fermentation tracking (now %.1f total)\n", 
+            addSeconds, fermentState.scheduledElapsedSeconds);
+}
+
+void applyControlCommand(const ControlCommand& cmd, ControlCommandResult& result) {
+  switch (cmd.type) {
+    case CMD_ADVANCE:
+      applyAdvance(result);
+      break;
+    case CMD_BACK:
+      applyBack(result);
+      break;
+    case CMD_START_AT_STAGE:
+      applyStartAtStage(cmd.intArg, result);
+      break;
+    case CMD_PAUSE:
+      programState.isRunning = false;
+      invalidateStatusCache();
+      setMotor(false);
+      setHeater(false);
+      setLight(false);
+      result.stateChanged = true;
+      snprintf(result.body, sizeof(result.body), "{\"status\":\"paused\"}");
+      break;
+    case CMD_RESUME:
+      programState.isRunning = true;
+      invalidateStatusCache();
+      // Do NOT reset actualStageStartTimes[customStageIdx] on resume if it was already set.
+      // Only set it if it was never set (i.e., just started this stage for the first time).
+      if (programState.customStageIdx < MAX_PROGRAM_STAGES && 
+          programState.actualStageStartTimes[programState.customStageIdx] == 0) {
+        programState.actualStageStartTimes[programState.customStageIdx] = time(nullptr);
+      }
+      result.stateChanged = true;
+      snprintf(result.body, sizeof(result.body), "{\"status\":\"running\"}");
+      break;
+    case CMD_ADD_PREFERMENTATION:
+      applyAddPrefermentation(cmd.floatArg, result);
+      break;
+    case CMD_SET_SETPOINT:
+      // Set PID setpoint for manual temperature control
+      pid.Setpoint = cmd.floatArg;
+      checkAndSwitchPIDProfile(); // Auto-switch profile based on new setpoint
+      invalidateStatusCache();
+      snprintf(result.body, sizeof(result.body), "{\"status\":\"ok\",\"setpoint\":%.2f}", cmd.floatArg);
+      break;
+    case CMD_SELECT_PROGRAM:
+      applySelectProgram(cmd.intArg, result);
+      break;
+    case CMD_START:
+      applyStart(cmd.intArg, result);
+      break;
+    case CMD_STOP:
+      stopBreadmaker();
+      snprintf(result.body, sizeof(result.body), "{\"status\":\"stopped\"}");
+      break;
+    case CMD_SET_OUTPUT:
+      applySetOutput(cmd.intArg, cmd.auxArg != 0, result);
+      break;
+    case CMD_SCHEDULE_START:
+      applyScheduleStart(cmd.intArg, cmd.auxArg, result);
+      break;
+    default:
+      commandError(result, 400, "Unknown command");
+      break;
+  }
+}
+
 // Initialize stage timing arrays when program is loaded or started
 void initializeStageArrays() {
     // Clear all arrays first
@@ -471,17 +829,13 @@ void initializeStageArrays() {
                     programState.adjustedStageDurations[i] = baseDuration;
                 }
                 
-                if (debugSerial) {
-                    Serial.printf("[STAGE-INIT] Stage %zu '%s': base=%lus, adjusted=%lus, fermentation=%s\n", 
-                                  i, stage.label.c_str(), baseDuration, programState.adjustedStageDurations[i],
-                                  stage.isFermentation ? "yes" : "no");
-                }
+                LOG_VERBOSE(LOG_STAGE, "[STAGE-INIT] Stage %u '%s': base=%lus, adjusted=%lus, fermentation=%s\n", 
+                            (unsigned)i, stage.label.c_str(), baseDuration, programState.adjustedStageDurations[i],
+                            stage.isFermentation ? "yes" : "no");
             }
             
-            if (debugSerial) {
-                Serial.printf("[STAGE-INIT] Initialized arrays for program %d with %zu stages\n", 
-                              programState.activeProgramId, p->customStages.size());
-            }
+            LOG_DEBUG(LOG_STAGE, "[STAGE-INIT] Initialized arrays for program %d with %u stages\n", 
+                      programState.activeProgramId, (unsigned)p->customStages.size());
         }
     }
 }
@@ -571,10 +925,8 @@ void updateTimeProportionalHeater() {
           dynamicRestart.lastDynamicRestartReason = "Reduce heat (output decreased to " + String((pid.Output*100), 1) + "%)";
         }
         
-        if (debugSerial) {
-          Serial.printf("[PID-DYNAMIC] Restart #%u: %s (elapsed: %lums)\n", 
-                       dynamicRestart.dynamicRestartCount, dynamicRestart.lastDynamicRestartReason.c_str(), elapsed);
-        }
+        LOG_DEBUG(LOG_PID, "[PID-DYNAMIC] Restart #%u: %s (elapsed: %lums)\n", 
+                  dynamicRestart.dynamicRestartCount, dynamicRestart.lastDynamicRestartReason.c_str(), elapsed);
       }
     }
   }
@@ -602,14 +954,20 @@ void updateTimeProportionalHeater() {
       }
     }
     
-    if (debugSerial && millis() % 15000 < 50) {  // Debug every 15 seconds
-      Serial.printf("[PID-RELAY] Setpoint: %.1f°C, Input: %.1f°C, Output: %.2f, OnTime: %lums/%lums (%.1f%%), MinOn: %lums %s\n", 
-                   pid.Setpoint, pid.Input, pid.Output, onTime, windowSize, (onTime * 100.0 / windowSize), minOnTime,
-                   shouldRestartWindow ? "[DYNAMIC]" : "[NORMAL]");
+    if (millis() % 15000 < 50) {  // Debug every 15 seconds
+      LOG_DEBUG(LOG_PID, "[PID-RELAY] Setpoint: %.1f°C, Input: %.1f°C, Output: %.2f, OnTime: %lums/%lums (%.1f%%), MinOn: %lums %s\n", 
+                pid.Setpoint, pid.Input, pid.Output, onTime, windowSize, (onTime * 100.0 / windowSize), minOnTime,
+                shouldRestartWindow ? "[DYNAMIC]" : "[NORMAL]");
     }
   }
   
-  // Determine heater state based on position within current window
+  // Hardware timer owns the window edges; the loop only hands it the current duty
+  if (heaterTimerActive()) {
+    setHeaterWindow(windowSize, onTime, shouldRestartWindow);
+    return;
+  }
+  
+  // Fallback: determine heater state based on position within current window
   elapsed = nowMs - windowStartTime;
   bool heaterShouldBeOn = (elapsed < onTime);
   setHeater(heaterShouldBeOn);
@@ -631,14 +989,12 @@ void switchToProfile(const String& profileName) {
         pid.controller->SetTunings(pid.Kp, pid.Ki, pid.Kd);
       }
       
-      if (debugSerial) {
-        Serial.printf("[switchToProfile] Switched to '%s': Kp=%.6f, Ki=%.6f, Kd=%.6f\n",
-                      profileName.c_str(), pid.Kp, pid.Ki, pid.Kd);
-      }
+      LOG_DEBUG(LOG_PID, "[switchToProfile] Switched to '%s': Kp=%.6f, Ki=%.6f, Kd=%.6f\n",
+                profileName.c_str(), pid.Kp, pid.Ki, pid.Kd);
       return;
     }
   }
-  if (debugSerial) Serial.printf("[switchToProfile] Profile '%s' not found!\n", profileName.c_str());
+  LOG_WARN(LOG_PID, "[switchToProfile] Profile '%s' not found!\n", profileName.c_str());
 }
 
 // Calculate individual PID terms for monitoring
@@ -844,6 +1200,7 @@ void streamStatusJson(Print& out) {
   float rawTemp = readTemperature();
   out.printf("\"rawTemperature\":%.1f,", rawTemp);
   out.printf("\"tempRaw\":%.1f,", rawTemp);
+  out.printf("\"sensorHealth\":\"%s\",", sensorHealthName(sensorGetHealth()));
   
   out.printf("\"setpoint\":%.1f,", pid.Setpoint);
   
@@ -1195,7 +1552,7 @@ float calculateFermentationFactor(float actualTemp) {
     }
   }
   
-  if (debugSerial) Serial.printf("[FERMENT-CALC] Using program values: baseline=%.1f, Q10=%.1f\n", baselineTemp, q10);
+  LOG_DEBUG(LOG_FERMENT, "[FERMENT-CALC] Using program values: baseline=%.1f, Q10=%.1f\n", baselineTemp, q10);
   
   // Biologically realistic fermentation factor based on yeast activity
   float factor = 0.0;
@@ -1203,11 +1560,11 @@ float calculateFermentationFactor(float actualTemp) {
   if (actualTemp < 0.0) {
     // Below freezing: dough is frozen, no fermentation
     factor = 0.0;
-    if (debugSerial) Serial.printf("[FERMENT] FROZEN: temp=%.1f°C < 0°C, factor=0 (no fermentation)\n", actualTemp);
+    LOG_DEBUG(LOG_FERMENT, "[FERMENT] FROZEN: temp=%.1f°C < 0°C, factor=0 (no fermentation)\n", actualTemp);
   } else if (actualTemp > 59.0) {
     // Above 59°C: yeast cells are killed, no fermentation
     factor = 0.0;
-    if (debugSerial) Serial.printf("[FERMENT] TOO HOT: temp=%.1f°C > 59°C, factor=0 (yeast death)\n", actualTemp);
+    LOG_DEBUG(LOG_FERMENT, "[FERMENT] TOO HOT: temp=%.1f°C > 59°C, factor=0 (yeast death)\n", actualTemp);
     // TODO: Add warning flag for overheating
   } else if (actualTemp <= 36.0) {
     // 0°C to 36°C: Normal Q10 calculation, peak activity at 36°C
@@ -1222,10 +1579,8 @@ float calculateFermentationFactor(float actualTemp) {
       factor = pow(q10, exponentFrom36);
     }
     
-    if (debugSerial) {
-      Serial.printf("[FERMENT] NORMAL: temp=%.1f°C, baseline=%.1f°C, Q10=%.1f\n", actualTemp, baselineTemp, q10);
-      Serial.printf("[FERMENT] TempDiff=%.1f, Exponent=%.2f, Factor=%.3f\n", tempDiff, exponent, factor);
-    }
+    LOG_DEBUG(LOG_FERMENT, "[FERMENT] NORMAL: temp=%.1f°C, baseline=%.1f°C, Q10=%.1f\n", actualTemp, baselineTemp, q10);
+    LOG_DEBUG(LOG_FERMENT, "[FERMENT] TempDiff=%.1f, Exponent=%.2f, Factor=%.3f\n", tempDiff, exponent, factor);
   } else {
     // 36°C to 59°C: Linear interpolation from peak factor (at 36°C) down to 0 (at 59°C)
     // First calculate the peak factor at 36°C
@@ -1244,11 +1599,9 @@ float calculateFermentationFactor(float actualTemp) {
     float interpolationRatio = 1.0 - (tempAbove36 / tempRange); // 1.0 at 36°C, 0.0 at 59°C
     factor = peakFactor * interpolationRatio;
     
-    if (debugSerial) {
-      Serial.printf("[FERMENT] HIGH TEMP: temp=%.1f°C (36-59°C range)\n", actualTemp);
-      Serial.printf("[FERMENT] Peak factor at 36°C: %.3f, interpolation ratio: %.2f, final factor: %.3f\n", 
-                    peakFactor, interpolationRatio, factor);
-    }
+    LOG_DEBUG(LOG_FERMENT, "[FERMENT] HIGH TEMP: temp=%.1f°C (36-59°C range)\n", actualTemp);
+    LOG_DEBUG(LOG_FERMENT, "[FERMENT] Peak factor at 36°C: %.3f, interpolation ratio: %.2f, final factor: %.3f\n",
+              peakFactor, interpolationRatio, factor);
   }
   
   // Ensure factor is never negative
@@ -1,6 +1,7 @@
 #pragma once
 #include <Arduino.h>
 #include <WebServer.h>
+#include "control_commands.h"
 
 // Function declarations for missing implementations
 
@@ -22,7 +23,10 @@ float getHeapFragmentation();
 void updateActiveProgramVars();
 void stopBreadmaker();
 void initializeStageArrays();
+void beginProgramRun(int stageIdx);
 bool isStartupDelayComplete();
+// Applies a queued web command on the control tick (see control_commands.h)
+void applyControlCommand(const ControlCommand& cmd, ControlCommandResult& result);
 
 // PID and control functions
 void updateTimeProportionalHeater();
@@ -34,6 +38,7 @@ void loadSettings();
 void saveSettings();
 void switchToProfile(const String& profileName);
 void savePIDProfiles();
+void serializePIDProfilesJson(Print& out);
 void loadPIDProfiles();
 void createDefaultPIDProfiles();
 
@@ -0,0 +1,373 @@
+#include "mqtt_publisher.h"
+#include "globals.h"
+#include "programs_manager.h"
+#include "control_task.h"
+#include "control_commands.h"
+#include <algorithm>
+#include <cmath>
+#ifdef NATIVE_SIMULATION
+#include "simulation_compatibility.h"  // Simulated WiFi and broker
+#else
+#include <WiFi.h>
+#include <PubSubClient.h>
+#endif
+
+extern bool debugSerial;
+extern ProgramState programState;
+extern OutputStates outputStates;
+extern PIDControl pid;
+extern time_t scheduledStart;
+extern double getAveragedTemperature();
+extern unsigned long getAdjustedStageTimeMs(unsigned long baseTimeMs, bool hasFermentation);
+extern uint32_t responseCacheVersion();
+
+enum MqttTopic : uint8_t {
+  TOPIC_STATE = 0,
+  TOPIC_TEMPERATURE,
+  TOPIC_SETPOINT,
+  TOPIC_HEATER,
+  TOPIC_MOTOR,
+  TOPIC_LIGHT,
+  TOPIC_BUZZER,
+  TOPIC_PROGRAM,
+  TOPIC_STAGE,
+  TOPIC_READY_AT,
+  TOPIC_COUNT
+};
+
+static const char* const TOPIC_NAMES[TOPIC_COUNT] = {
+  "state", "temperature", "setpoint", "heater", "motor", "light", "buzzer", "program", "stage", "ready_at"
+};
+
+// What was last published on each state topic; invalid = publish on the next check
+struct PublishedValue {
+  bool valid = false;
+  double number = 0.0;   // Double: ready-at is an epoch
+  unsigned long atMs = 0;
+  char text[48] = "";
+};
+
+// HA discovery entities: state topics first, then the command buttons
+struct DiscoveryEntity {
+  const char* component;
+  const char* key;
+  const char* name;
+  const char* extra;   // Additional discovery fields, or nullptr
+};
+
+static const DiscoveryEntity ENTITIES[] = {
+  { "sensor", "temperature", "Temperature", "\"dev_cla\":\"temperature\",\"unit_of_meas\":\"°C\",\"stat_cla\":\"measurement\"" },
+  { "sensor", "setpoint", "Setpoint", "\"dev_cla\":\"temperature\",\"unit_of_meas\":\"°C\"" },
+  { "sensor", "state", "State", nullptr },
+  { "sensor", "program", "Program", nullptr },
+  { "sensor", "stage", "Stage", nullptr },
+  { "sensor", "ready_at", "Ready at", "\"dev_cla\":\"timestamp\"" },
+  { "binary_sensor", "heater", "Heater", "\"dev_cla\":\"heat\"" },
+  { "binary_sensor", "motor", "Motor", "\"dev_cla\":\"running\"" },
+  { "binary_sensor", "light", "Light", "\"dev_cla\":\"light\"" },
+  { "binary_sensor", "buzzer", "Buzzer", "\"dev_cla\":\"sound\"" },
+  { "button", "start", "Start", nullptr },
+  { "button", "stop", "Stop", nullptr },
+};
+
+static MqttConfig config;
+static MqttStats stats;
+static WiFiClient net;
+static PubSubClient mqtt(net);
+static PublishedValue published[TOPIC_COUNT];
+static char nodeId[24] = "";
+static bool attempted = false;
+static unsigned long lastAttemptMs = 0;
+static unsigned long retryDelayMs = MQTT_RETRY_MIN_MS;
+static unsigned long lastCheckMs = 0;
+
+// Program, stage and ready-at need the control lock; re-read only when they can have changed
+static uint32_t slowVersion = 0;
+static unsigned long slowReadMs = 0;
+static bool slowValid = false;
+static bool lastRunning = false;
+static uint8_t lastStageIdx = 0;
+
+static void topicFor(char* out, size_t size, const char* leaf) {
+  snprintf(out, size, "%s/%s", config.baseTopic, leaf);
+}
+
+static bool publishRaw(const char* topic, const char* payload, bool retained) {
+  size_t length = strlen(payload);
+  if (!mqtt.publish(topic, (const uint8_t*)payload, length, retained)) {
+    stats.publishFailures++;
+    return false;
+  }
+  stats.publishes++;
+  stats.bytesOut += strlen(topic) + length;
+  return true;
+}
+
+static void publishValue(MqttTopic t, const char* text, double number) {
+  char topic[64];
+  topicFor(topic, sizeof(topic), TOPIC_NAMES[t]);
+  if (!publishRaw(topic, text, true)) return;
+  PublishedValue& p = published[t];
+  p.valid = true;
+  p.number = number;
+  p.atMs = millis();
+  snprintf(p.text, sizeof(p.text), "%s", text);
+}
+
+// Text and on/off topics: published on any change
+static void publishText(MqttTopic t, const char* text) {
+  const PublishedValue& p = published[t];
+  if (p.valid && strcmp(p.text, text) == 0) return;
+  publishValue(t, text, 0.0);
+}
+
+// Numeric topics: published once they move by deadband, at most once per minIntervalMs
+static void publishNumber(MqttTopic t, float value, float deadband) {
+  const PublishedValue& p = published[t];
+  if (p.valid) {
+    if (value == p.number) return;
+    if (fabs(value - p.number) < deadband) {
+      stats.suppressed++;
+      return;
+    }
+    if (millis() - p.atMs < config.minIntervalMs) {
+      stats.deferred++;
+      return;
+    }
+  }
+  char text[16];
+  snprintf(text, sizeof(text), "%.1f", value);
+  publishValue(t, text, value);
+}
+
+// ISO 8601 for HA's timestamp sensor; "None" (unknown) when nothing is running
+static void publishReadyAt(time_t readyAt) {
+  const PublishedValue& p = published[TOPIC_READY_AT];
+  if (p.valid && (readyAt == 0) == (p.number == 0.0) && fabs((double)readyAt - p.number) < MQTT_READY_AT_DEADBAND_S) return;
+  char text[32] = "None";
+  if (readyAt > 0) {
+    struct tm utc;
+    gmtime_r(&readyAt, &utc);
+    strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", &utc);
+  }
+  publishValue(TOPIC_READY_AT, text, (double)readyAt);
+}
+
+static void publishDiscovery() {
+  char base[2 * sizeof(config.baseTopic)];
+  mqttJsonEscape(base, sizeof(base), config.baseTopic);
+  char device[192];
+  snprintf(device, sizeof(device),
+           "\"dev\":{\"ids\":[\"%s\"],\"name\":\"Breadmaker\",\"mf\":\"ESPBreadMaker\",\"mdl\":\"TTGO T-Display\"}", nodeId);
+  char topic[128];
+  char payload[640];
+  for (const DiscoveryEntity& e : ENTITIES) {
+    snprintf(topic, sizeof(topic), "%s/%s/%s/%s/config", config.discoveryPrefix, e.component, nodeId, e.key);
+    bool button = strcmp(e.component, "button") == 0;
+    snprintf(payload, sizeof(payload),
+             "{\"name\":\"%s\",\"uniq_id\":\"%s_%s\",\"avty_t\":\"%s/status\",\"%s\":\"%s/%s%s\",%s%s%s}",
+             e.name, nodeId, e.key, base,
+             button ? "cmd_t" : "stat_t", base, button ? "cmd/" : "", e.key,
+             e.extra ? e.extra : "", e.extra ? "," : "", device);
+    if (publishRaw(topic, payload, true)) stats.discoveryPublishes++;
+  }
+}
+
+// cmd/start and cmd/stop from HA's buttons; the payload is ignored
+static void onMessage(char* topic, uint8_t* /*payload*/, unsigned int /*length*/) {
+  const char* leaf = strrchr(topic, '/');
+  if (!leaf) return;
+  ControlCommand cmd;
+  if (strcmp(leaf, "/start") == 0) {
+    cmd.type = CMD_START;
+    cmd.intArg = 0;
+  } else if (strcmp(leaf, "/stop") == 0) {
+    cmd.type = CMD_STOP;
+  } else {
+    return;
+  }
+  stats.commands++;
+  ControlCommandResult result;
+  controlCommandExecute(cmd, result);
+  if (debugSerial) Serial.printf("[MQTT] %s -> %d %s\n", topic, result.httpCode, result.body);
+}
+
+static void connect() {
+  attempted = true;
+  lastAttemptMs = millis();
+  if (!nodeId[0]) {
+    String mac = WiFi.macAddress();
+    size_t n = snprintf(nodeId, sizeof(nodeId), "breadmaker_");
+    for (const char* c = mac.c_str(); *c && n + 1 < sizeof(nodeId); c++) {
+      if (*c != ':') nodeId[n++] = tolower(*c);
+    }
+    nodeId[n] = '\0';
+  }
+
+  char willTopic[64];
+  topicFor(willTopic, sizeof(willTopic), "status");
+  net.setTimeout(MQTT_CONNECT_TIMEOUT_S);
+  mqtt.setServer(config.host, config.port);
+  mqtt.setBufferSize(MQTT_BUFFER_SIZE);
+  mqtt.setSocketTimeout(MQTT_CONNECT_TIMEOUT_S);
+  mqtt.setCallback(onMessage);
+
+  unsigned long startMs = millis();
+  bool ok = config.user[0]
+    ? mqtt.connect(nodeId, config.user, config.password, willTopic, 0, true, "offline")
+    : mqtt.connect(nodeId, willTopic, 0, true, "offline");
+  uint32_t tookMs = millis() - startMs;
+  if (tookMs > stats.maxConnectMs) stats.maxConnectMs = tookMs;
+  stats.lastState = mqtt.state();
+  if (!ok) {
+    stats.connectFailures++;
+    if (debugSerial) Serial.printf("[MQTT] Connect to %s:%u failed (state %d), retry in %lu s\n",
+                                   config.host, config.port, stats.lastState, retryDelayMs / 1000);
+    retryDelayMs = std::min(retryDelayMs * 2, MQTT_RETRY_MAX_MS);
+    return;
+  }
+
+  stats.connects++;
+  stats.connected = true;
+  retryDelayMs = MQTT_RETRY_MIN_MS;
+  publishRaw(willTopic, "online", true);
+  char cmdTopic[64];
+  topicFor(cmdTopic, sizeof(cmdTopic), "cmd/+");
+  mqtt.subscribe(cmdTopic);
+  publishDiscovery();
+  // New session: publish every state topic on the next check
+  for (PublishedValue& p : published) p = PublishedValue();
+  slowValid = false;
+  lastCheckMs = 0;
+  if (debugSerial) Serial.printf("[MQTT] Connected to %s:%u as %s (%lu ms)\n", config.host, config.port, nodeId, (unsigned long)tookMs);
+}
+
+static void publishChanges() {
+  ControlSnapshot snap;
+  if (!controlSnapshotRead(snap)) {
+    // Loop-driven mode: nothing publishes a snapshot, read the state directly
+    ControlLockGuard guard;
+    snap.temperature = getAveragedTemperature();
+    snap.setpoint = pid.Setpoint;
+    snap.running = programState.isRunning;
+    snap.heater = outputStates.heater;
+    snap.motor = outputStates.motor;
+    snap.light = outputStates.light;
+    snap.buzzer = outputStates.buzzer;
+    snap.stageIdx = programState.customStageIdx;
+  }
+
+  publishNumber(TOPIC_TEMPERATURE, snap.temperature, config.tempDeadband);
+  publishNumber(TOPIC_SETPOINT, snap.setpoint, config.setpointDeadband);
+  publishText(TOPIC_HEATER, snap.heater ? "ON" : "OFF");
+  publishText(TOPIC_MOTOR, snap.motor ? "ON" : "OFF");
+  publishText(TOPIC_LIGHT, snap.light ? "ON" : "OFF");
+  publishText(TOPIC_BUZZER, snap.buzzer ? "ON" : "OFF");
+
+  // Any status change bumps the response cache version, so it doubles as a change flag
+  unsigned long now = millis();
+  uint32_t version = responseCacheVersion();
+  if (slowValid && version == slowVersion && snap.running == lastRunning && snap.stageIdx == lastStageIdx &&
+      now - slowReadMs < MQTT_SLOW_REFRESH_MS) {
+    return;
+  }
+  slowValid = true;
+  slowVersion = version;
+  slowReadMs = now;
+  lastRunning = snap.running;
+  lastStageIdx = snap.stageIdx;
+
+  char programName[48] = "";
+  char stageName[48] = "Idle";
+  const char* state;
+  time_t readyAt = 0;
+  {
+    ControlLockGuard guard;
+    state = programState.isRunning ? "running" : (scheduledStart ? "scheduled" : "idle");
+    const Program* p = programState.customProgram;
+    if (p) {
+      snprintf(programName, sizeof(programName), "%s", p->name.c_str());
+      size_t idx = programState.customStageIdx;
+      if (programState.isRunning && idx < p->customStages.size()) {
+        snprintf(stageName, sizeof(stageName), "%s", p->customStages[idx].label.c_str());
+        time_t nowSec = time(nullptr);
+        if (nowSec > 1640995200) {  // NTP time valid
+          unsigned long elapsed = programState.customStageStart ? (millis() - programState.customStageStart) / 1000 : 0;
+          long left = (long)(getAdjustedStageTimeMs(p->customStages[idx].min * 60 * 1000, p->customStages[idx].isFermentation) / 1000) - (long)elapsed;
+          readyAt = nowSec + std::max(left, 0L);
+          for (size_t i = idx + 1; i < p->customStages.size(); i++) {
+            readyAt += getAdjustedStageTimeMs(p->customStages[i].min * 60 * 1000, p->customStages[i].isFermentation) / 1000;
+          }
+        }
+      }
+    }
+  }
+  publishText(TOPIC_STATE, state);
+  publishText(TOPIC_PROGRAM, programName);
+  publishText(TOPIC_STAGE, stageName);
+  publishReadyAt(readyAt);
+}
+
+void mqttLoop() {
+  if (!config.enabled || !config.host[0]) return;
+  if (!mqtt.connected()) {
+    if (stats.connected) {
+      stats.connected = false;
+      stats.disconnects++;
+      stats.lastState = mqtt.state();
+      if (debugSerial) Serial.printf("[MQTT] Disconnected (state %d)\n", stats.lastState);
+    }
+    if (WiFi.status() != WL_CONNECTED) return;
+    if (attempted && millis() - lastAttemptMs < retryDelayMs) return;
+    connect();
+    return;
+  }
+
+  mqtt.loop();  // Keep-alive and command topics
+  unsigned long now = millis();
+  if (lastCheckMs && now - lastCheckMs < MQTT_CHECK_MS) return;
+  lastCheckMs = now;
+  publishChanges();
+}
+
+void mqttConfigure(const MqttConfig& newConfig) {
+  if (mqtt.connected()) {
+    // A clean disconnect doesn't trigger the will: mark the old base topic offline
+    char willTopic[64];
+    topicFor(willTopic, sizeof(willTopic), "status");
+    publishRaw(willTopic, "offline", true);
+    mqtt.disconnect();
+    stats.connected = false;
+  }
+  config = newConfig;
+  config.minIntervalMs = std::min(config.minIntervalMs, (uint32_t)3600000);
+  attempted = false;
+  retryDelayMs = MQTT_RETRY_MIN_MS;
+}
+
+const MqttConfig& mqttGetConfig() {
+  return config;
+}
+
+const MqttStats& mqttGetStats() {
+  return stats;
+}
+
+void mqttResetStats() {
+  bool connected = stats.connected;
+  stats = MqttStats();
+  stats.connected = connected;
+  stats.sinceMs = millis();
+}
+
+size_t mqttJsonEscape(char* dst, size_t size, const char* src) {
+  if (!size) return 0;
+  size_t n = 0;
+  for (const char* p = src; *p && n + 2 < size; p++) {
+    unsigned char c = (unsigned char)*p;
+    if (c == '"' || c == '\\') dst[n++] = '\\';
+    dst[n++] = c < 0x20 ? '?' : c;
+  }
+  dst[n] = '\0';
+  return n;
+}
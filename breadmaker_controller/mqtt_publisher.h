@@ -0,0 +1,71 @@
+#pragma once
+#include <Arduino.h>
+
+// MQTT publisher for Home Assistant.
+// /ha is polled, so HA pays for a render every scan interval whether or not anything
+// changed, and renderHaJson() rotates through four subsets (cycleCounter) to keep each
+// poll cheap. With a broker configured the device instead publishes retained state
+// topics under <baseTopic>/ only when a value changes: numbers when they move by their
+// deadband (and at most once per minIntervalMs), text and on/off topics on any change.
+// An idle breadmaker publishes nothing; HA reads the retained values from the broker.
+//
+// On connect it announces itself through HA MQTT discovery (<discoveryPrefix>/...),
+// sets the "online" availability topic (the broker's last will publishes "offline")
+// and subscribes to <baseTopic>/cmd/+; cmd/start and cmd/stop go through the control
+// command queue like the web handlers. mqttLoop() runs on the loop core and reads the
+// fast-changing values from the control snapshot, so it doesn't take the control lock
+// except to look up program and stage names after a state change.
+//
+// PubSubClient connects synchronously: an unreachable broker stalls loop() for up to
+// MQTT_CONNECT_TIMEOUT_S per attempt, so failed attempts back off exponentially.
+
+constexpr unsigned long MQTT_CHECK_MS = 500;              // How often values are compared
+constexpr unsigned long MQTT_SLOW_REFRESH_MS = 30000;     // Program/stage/ready-at re-read without a state change
+constexpr unsigned long MQTT_RETRY_MIN_MS = 5000;
+constexpr unsigned long MQTT_RETRY_MAX_MS = 300000;
+constexpr uint32_t MQTT_CONNECT_TIMEOUT_S = 2;
+constexpr uint16_t MQTT_BUFFER_SIZE = 768;                // Largest discovery message
+constexpr long MQTT_READY_AT_DEADBAND_S = 60;             // Ready-at drifts with fermentation
+
+struct MqttConfig {
+  bool enabled = false;
+  char host[64] = "";
+  uint16_t port = 1883;
+  char user[32] = "";
+  char password[64] = "";
+  char baseTopic[32] = "breadmaker";
+  char discoveryPrefix[32] = "homeassistant";
+  float tempDeadband = 0.2f;       // °C
+  float setpointDeadband = 0.1f;   // °C
+  uint32_t minIntervalMs = 2000;   // Per numeric topic
+};
+
+struct MqttStats {
+  bool connected = false;
+  uint32_t connects = 0;
+  uint32_t connectFailures = 0;
+  int lastState = 0;               // PubSubClient state() after the last attempt (0 = connected)
+  uint32_t maxConnectMs = 0;       // Longest blocking connect attempt
+  uint32_t disconnects = 0;
+  uint32_t publishes = 0;          // State topics, availability and discovery
+  uint32_t discoveryPublishes = 0;
+  uint32_t publishFailures = 0;
+  uint64_t bytesOut = 0;           // Topic + payload
+  uint32_t suppressed = 0;         // Changes within their deadband, not published
+  uint32_t deferred = 0;           // Changes held back by minIntervalMs
+  uint32_t commands = 0;
+  unsigned long sinceMs = 0;
+};
+
+// Call once per loop() pass: connects, serves keep-alive/commands and publishes changes
+void mqttLoop();
+
+// Applies a new configuration; the client reconnects on the next mqttLoop()
+void mqttConfigure(const MqttConfig& config);
+const MqttConfig& mqttGetConfig();
+const MqttStats& mqttGetStats();
+void mqttResetStats();
+
+// Copies a config string (host, user, topic, ...) into a JSON string body: quotes and
+// backslashes escaped, control characters replaced. 2 * strlen + 1 bytes always suffice.
+size_t mqttJsonEscape(char* dst, size_t size, const char* src);
@@ -2,6 +2,7 @@
 #include <ArduinoOTA.h>
 #include <WiFi.h>
 #include "globals.h"
+#include "persistence_manager.h"
 
 // OTA status
 OTAStatus otaStatus;
@@ -36,6 +37,7 @@ void otaManagerInit() {
     otaStatus.inProgress = true;
     otaStatus.progress = 0;
     otaStatus.error = "";
+    persistFlushAll();  // Pending saves go out before the update reboots us
     
     if (debugSerial) {
       Serial.println("[OTA] Start updating " + type);
@@ -1,6 +1,10 @@
 #include "outputs_manager.h"
 #include <Arduino.h>
 #include "globals.h"
+#include "sensor_service.h"
+#include "heater_timer.h"
+#include "enhanced_motor_control.h"
+#include "debug_log.h"
 
 // Output pins (define here for linker visibility)
 // ESP32 TTGO T-Display Pin Assignments
@@ -20,59 +24,123 @@ const unsigned long HEATER_WATCHDOG_TIMEOUT_MS = 15000; // 15 seconds max heater
 static unsigned long heaterWatchdogStart = 0;
 static bool heaterWatchdogActive = false;
 
+// Cumulative heater on-time (for the thermal monitor's heater-effect regression) while
+// the pin is written directly; pulses driven by the heater timer are counted in its ISR
+static unsigned long heaterOnAccumMs = 0;
+static unsigned long heaterOnSince = 0;
+static bool heaterDirectOn = false;   // A directly written on-pulse is open
+static uint32_t heaterCycleCount = 0;
+
 bool heaterState = false;
 bool motorState = false;
 bool lightState = false;
 bool buzzerState = false;
 
+// Bookkeeping for a heater level change (the pin itself is written by the caller or the heater timer).
+// timerDriven: the heater timer switched the pin and has already counted the edge.
+static void recordHeaterState(bool on, bool timerDriven) {
+  heaterState = on;
+  outputStates.heater = on;  // Keep struct in sync
+  
+  // On-time of direct writes (any level change closes an open direct pulse)
+  if (heaterDirectOn) {
+    heaterOnAccumMs += millis() - heaterOnSince;
+    heaterDirectOn = false;
+  }
+  if (on && !timerDriven) {
+    heaterOnSince = millis();
+    heaterCycleCount++;
+    heaterDirectOn = true;
+  }
+  
+  // HEATER SAFETY WATCHDOG: Start/stop watchdog timer
+  if (on) {
+    heaterWatchdogStart = millis();
+    heaterWatchdogActive = true;
+    LOG_VERBOSE(LOG_PID, "[WATCHDOG] Heater watchdog started - 15 second timeout\n");
+  } else {
+    heaterWatchdogActive = false;
+    if (heaterWatchdogActive) LOG_VERBOSE(LOG_PID, "[WATCHDOG] Heater watchdog stopped\n");
+  }
+}
+
 void setHeater(bool on) {
   // HEATER SAFETY WATCHDOG: Check if heater has been on too long
   if (heaterWatchdogActive && (millis() - heaterWatchdogStart > HEATER_WATCHDOG_TIMEOUT_MS)) {
-    if (debugSerial) Serial.println("[SAFETY] HEATER WATCHDOG TIMEOUT - forcing heater OFF after 15 seconds!");
+    LOG_ERROR(LOG_PID, "[SAFETY] HEATER WATCHDOG TIMEOUT - forcing heater OFF after 15 seconds!\n");
     on = false;  // Force heater off due to watchdog timeout
     heaterWatchdogActive = false;
   }
 
-  // CRITICAL SAFETY CHECK: Don't allow heater to turn on if temperature sensor is failed
-  if (on) {
-    extern float readTemperature();  // Forward declaration
-    float currentTemp = readTemperature();
-    if (currentTemp <= -999.0f || currentTemp >= 999.0f) {  // Error values indicating sensor failure
-      if (debugSerial) Serial.println("[SAFETY] Heater turn-on BLOCKED - temperature sensor failure detected!");
-      on = false;  // Force heater off for safety
+  // CRITICAL SAFETY CHECK: Don't allow heater to turn on unless the sensor service has a valid, fresh reading
+  if (on && !sensorIsValid()) {
+    if (!heaterState) {
+      LOG_DEBUG(LOG_PID, "[SAFETY] Heater turn-on BLOCKED - temperature sensor %s\n", sensorHealthName(sensorGetHealth()));
     }
+    on = false;  // Force heater off for safety
   }
   
+  // A direct set takes the pin back from the heater timer (the pin is low after the stop)
+  if (heaterTimerStop() && heaterState) recordHeaterState(false, true);
+  
   if (heaterState == on) return;
-  heaterState = on;
-  outputStates.heater = on;  // Keep struct in sync
-  if (debugSerial) Serial.printf("[setHeater] Setting heater to %s\n", on ? "ON" : "OFF");
+  LOG_VERBOSE(LOG_PID, "[setHeater] Setting heater to %s\n", on ? "ON" : "OFF");
   digitalWrite(PIN_HEATER, on ? HIGH : LOW);
+  recordHeaterState(on, false);
+}
+
+void setHeaterWindow(unsigned long windowMs, unsigned long onMs, bool restart) {
+  if (!heaterTimerActive()) return;
   
-  // HEATER SAFETY WATCHDOG: Start/stop watchdog timer
-  if (on) {
-    heaterWatchdogStart = millis();
-    heaterWatchdogActive = true;
-    if (debugSerial) Serial.println("[WATCHDOG] Heater watchdog started - 15 second timeout");
-  } else {
-    heaterWatchdogActive = false;
-    if (debugSerial && heaterWatchdogActive) Serial.println("[WATCHDOG] Heater watchdog stopped");
+  // Same turn-on gate as setHeater(): no heating without a valid, fresh sensor reading
+  if (onMs > 0 && !sensorIsValid()) {
+    if (heaterState) {
+      LOG_DEBUG(LOG_PID, "[SAFETY] Heater window BLOCKED - temperature sensor %s\n", sensorHealthName(sensorGetHealth()));
+    }
+    onMs = 0;
   }
+  heaterTimerSetWindow(windowMs, onMs, restart);
+  
+  // Mirror the level the timer is driving so status and logging stay correct
+  bool on = heaterTimerOutput();
+  if (heaterState != on) recordHeaterState(on, true);
+}
+
+unsigned long getHeaterOnTimeMs() {
+  return heaterOnAccumMs + (heaterDirectOn ? millis() - heaterOnSince : 0) + (unsigned long)(heaterTimerOnTimeUs() / 1000);
+}
+
+uint32_t getHeaterCycleCount() {
+  return heaterCycleCount + heaterTimerPulses();
 }
 
 void setMotor(bool on) {
+  // A direct set takes the pin back from the motor pulse engine (the pin is low after the stop)
+  if (motorPulseStop() && motorState) {
+    motorState = false;
+    outputStates.motor = false;
+  }
+  
   if (motorState == on) return;
   motorState = on;
   outputStates.motor = on;  // Keep struct in sync
-  if (debugSerial) Serial.printf("[setMotor] Setting motor to %s\n", on ? "ON" : "OFF");
+  LOG_VERBOSE(LOG_MIX, "[setMotor] Setting motor to %s\n", on ? "ON" : "OFF");
   digitalWrite(PIN_MOTOR, on ? HIGH : LOW);
 }
 
+bool syncMotorFromPulseEngine() {
+  bool on = motorPulseOutput();
+  if (motorState == on) return on;
+  motorState = on;
+  outputStates.motor = on;  // Keep struct in sync (pin is driven by the engine)
+  return on;
+}
+
 void setLight(bool on) {
   if (lightState == on) return;
   lightState = on;
   outputStates.light = on;  // Keep struct in sync
-  if (debugSerial) Serial.printf("[setLight] Setting light to %s\n", on ? "ON" : "OFF");
+  LOG_DEBUG(LOG_SYSTEM, "[setLight] Setting light to %s\n", on ? "ON" : "OFF");
   digitalWrite(PIN_LIGHT, on ? HIGH : LOW);
   if (on) {
     extern unsigned long lightOnTime;
@@ -84,7 +152,7 @@ void setBuzzer(bool on) {
   if (buzzerState == on) return;
   buzzerState = on;
   outputStates.buzzer = on;  // Keep struct in sync
-  if (debugSerial) Serial.printf("[setBuzzer] Setting buzzer to %s\n", on ? "ON" : "OFF");
+  LOG_DEBUG(LOG_SYSTEM, "[setBuzzer] Setting buzzer to %s\n", on ? "ON" : "OFF");
   digitalWrite(PIN_BUZZER, on ? HIGH : LOW);
   extern bool buzzActive;
   extern unsigned long buzzStart;
@@ -104,6 +172,11 @@ void outputsManagerInit() {
   gpio_set_drive_capability((gpio_num_t)PIN_LIGHT, GPIO_DRIVE_CAP_0);   // ~5mA
   gpio_set_drive_capability((gpio_num_t)PIN_BUZZER, GPIO_DRIVE_CAP_0);  // ~5mA
   
+  // Heater window runs from a hardware timer; updateTimeProportionalHeater() falls back to the loop if this fails
+  heaterTimerBegin(PIN_HEATER);
+  // Mix pattern edges run from a second hardware timer; handleCustomStages() falls back to the loop if this fails
+  motorPulseBegin(PIN_MOTOR);
+  
   if (debugSerial) {
     Serial.println(F("[outputs] All outputs configured with minimum drive strength (~5mA)"));
     Serial.println(F("[outputs] This provides ESP8266-like behavior for better motor compatibility"));
@@ -130,8 +203,8 @@ void startBuzzerTone(float frequency, float amplitude, unsigned long duration) {
   buzzerDuration = duration * 2; // Make tones 2x as long as requested
   buzzerStartTime = millis();
   buzzerToneActive = true;
-  if (debugSerial) Serial.printf("[Buzzer] Starting tone: %.1fHz, %.2f amplitude, %lums duration\n", 
-                                frequency, amplitude, buzzerDuration);
+  LOG_DEBUG(LOG_SYSTEM, "[Buzzer] Starting tone: %.1fHz, %.2f amplitude, %lums duration\n",
+            frequency, amplitude, buzzerDuration);
 }
 
 void shortBeep() {
@@ -167,7 +240,7 @@ void updateBuzzerTone() {
 // HEATER SAFETY WATCHDOG: Check if heater needs to be shut off (call from main loop)
 void checkHeaterWatchdog() {
   if (heaterWatchdogActive && (millis() - heaterWatchdogStart > HEATER_WATCHDOG_TIMEOUT_MS)) {
-    if (debugSerial) Serial.println("[SAFETY] HEATER WATCHDOG TIMEOUT - forcing heater OFF after 15 seconds!");
+    LOG_ERROR(LOG_PID, "[SAFETY] HEATER WATCHDOG TIMEOUT - forcing heater OFF after 15 seconds!\n");
     setHeater(false);  // This will also reset the watchdog
   }
 }
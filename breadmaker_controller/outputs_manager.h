@@ -7,11 +7,19 @@ extern bool lightState;
 extern bool buzzerState;
 
 void setHeater(bool on);
+// Time-proportional window for the hardware heater timer (see heater_timer.h); no-op without the timer
+void setHeaterWindow(unsigned long windowMs, unsigned long onMs, bool restart);
 void setMotor(bool on);
+// Mirrors the motor pulse engine's output into motorState/outputStates; returns the level
+bool syncMotorFromPulseEngine();
 void setLight(bool on);
 void setBuzzer(bool on);
 void outputsManagerInit();
 
+// Cumulative heater on-time since boot (includes the current on period) and on-transitions
+unsigned long getHeaterOnTimeMs();
+uint32_t getHeaterCycleCount();
+
 // Heater safety watchdog - call this from main loop
 void checkHeaterWatchdog();
 
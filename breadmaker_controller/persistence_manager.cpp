@@ -0,0 +1,201 @@
+#include "persistence_manager.h"
+#include "control_task.h"
+#include "storage_stats.h"
+#include "trace_recorder.h"
+#ifndef NATIVE_SIMULATION
+#include <esp_timer.h>
+#endif
+
+extern bool debugSerial;
+
+struct PersistEntry {
+  const char* path = nullptr;
+  PersistSerializer serialize = nullptr;
+  unsigned long coalesceMs = 0;
+  bool append = false;
+  bool dirty = false;
+  bool urgent = false;
+  unsigned long firstMarkMs = 0;
+  bool failed = false;          // Last write failed: retried after PERSIST_RETRY_MS
+  unsigned long failedMs = 0;
+  String unwritten;             // Append data a failed write didn't store, written first next time
+};
+
+// Dirty flags are only touched under the control lock (marks from the control task
+// already hold it; loop-core callers take it), so a mark can't slip between the
+// worker's serialize and its clearing of the flag.
+static PersistEntry entries[PERSIST_OBJECT_COUNT];
+static PersistObjectStats objectStats[PERSIST_OBJECT_COUNT];
+static PersistStats stats;
+static uint8_t nextObject = 0;  // Round-robin so one busy object can't starve the rest
+
+static const char* const OBJECT_NAMES[PERSIST_OBJECT_COUNT] = {
+  "resume", "settings", "pid_profiles", "calibration", "activity_log", "storage_stats"
+};
+
+// Print into a String (serializers run into RAM, the flash write happens later)
+class PersistBuffer : public Print {
+  String& str;
+  public:
+    PersistBuffer(String& s) : str(s) {}
+    size_t write(uint8_t c) override { str += (char)c; return 1; }
+    size_t write(const uint8_t* buffer, size_t size) override {
+      str.concat((const char*)buffer, size);
+      return size;
+    }
+};
+
+static uint8_t countDirty() {
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < PERSIST_OBJECT_COUNT; i++) {
+    if (entries[i].dirty) n++;
+  }
+  return n;
+}
+
+void persistRegister(PersistObject obj, const char* path, PersistSerializer serialize,
+                     unsigned long coalesceMs, bool append) {
+  if (obj >= PERSIST_OBJECT_COUNT) return;
+  ControlLockGuard guard;
+  PersistEntry& e = entries[obj];
+  e.path = path;
+  e.serialize = serialize;
+  e.coalesceMs = coalesceMs;
+  e.append = append;
+}
+
+void persistMarkDirty(PersistObject obj, bool urgent) {
+  if (obj >= PERSIST_OBJECT_COUNT) return;
+  ControlLockGuard guard;
+  PersistEntry& e = entries[obj];
+  if (!e.dirty) {
+    e.dirty = true;
+    e.firstMarkMs = millis();
+  }
+  if (urgent) e.urgent = true;
+  objectStats[obj].marks++;
+  uint8_t depth = countDirty();
+  stats.depth = depth;
+  if (depth > stats.maxDepth) stats.maxDepth = depth;
+}
+
+void persistExpedite() {
+  ControlLockGuard guard;
+  for (uint8_t i = 0; i < PERSIST_OBJECT_COUNT; i++) {
+    if (entries[i].dirty) entries[i].urgent = true;
+  }
+}
+
+// Serializes under the lock, writes without it
+static void writeObject(uint8_t i) {
+  PersistEntry& e = entries[i];
+  PersistObjectStats& st = objectStats[i];
+  String data;
+  unsigned long firstMarkMs;
+  bool urgent;
+  {
+    ControlLockGuard guard;
+    if (!e.dirty || !e.serialize) return;
+    int64_t startUs = esp_timer_get_time();
+    data = e.unwritten;
+    e.unwritten = "";
+    PersistBuffer out(data);
+    e.serialize(out);
+    st.lastSerializeUs = (uint32_t)(esp_timer_get_time() - startUs);
+    firstMarkMs = e.firstMarkMs;
+    urgent = e.urgent;
+    e.dirty = false;
+    e.urgent = false;
+    stats.depth = countDirty();
+  }
+  if (e.append && data.length() == 0) return;
+
+  TraceSpan span(TRACE_FLASH, e.path);
+  int64_t startUs = esp_timer_get_time();
+  StorageFile f = storageOpen(e.path, e.append ? "a" : "w", OBJECT_NAMES[i]);
+  size_t written = f ? f.write((const uint8_t*)data.c_str(), data.length()) : 0;
+  f.close();
+  uint32_t writeUs = (uint32_t)(esp_timer_get_time() - startUs);
+  if (written < data.length()) {
+    // Dirty again, still dated from its first mark; an append keeps the part not stored
+    st.failures++;
+    ControlLockGuard guard;
+    e.dirty = true;
+    e.firstMarkMs = firstMarkMs;
+    e.urgent |= urgent;
+    e.failed = true;
+    e.failedMs = millis();
+    if (e.append) {
+      e.unwritten = data.substring(written);
+      if (e.unwritten.length() > PERSIST_UNWRITTEN_MAX) e.unwritten = "";   // Flash is gone; don't grow without bound
+    }
+    stats.depth = countDirty();
+    if (debugSerial) Serial.printf("[PERSIST] Failed to write %s (%u of %u bytes), retrying\n", e.path,
+                                   (unsigned)written, (unsigned)data.length());
+    return;
+  }
+  e.failed = false;
+
+  st.writes++;
+  st.lastBytes = data.length();
+  st.lastWriteUs = writeUs;
+  if (writeUs > st.maxWriteUs) st.maxWriteUs = writeUs;
+  st.totalWriteUs += writeUs;
+  uint32_t delayMs = millis() - firstMarkMs;
+  if (delayMs > st.maxDelayMs) st.maxDelayMs = delayMs;
+  if (debugSerial && i != PERSIST_ACTIVITY_LOG) {
+    Serial.printf("[PERSIST] %s: %u bytes in %lu us (%lu marks, %lu writes)\n", OBJECT_NAMES[i],
+                  (unsigned)data.length(), (unsigned long)writeUs, (unsigned long)st.marks, (unsigned long)st.writes);
+  }
+}
+
+void persistService() {
+  unsigned long now = millis();
+  for (uint8_t k = 0; k < PERSIST_OBJECT_COUNT; k++) {
+    uint8_t i = (nextObject + k) % PERSIST_OBJECT_COUNT;
+    const PersistEntry& e = entries[i];
+    // Unlocked peek; writeObject() re-checks under the lock
+    if (!e.dirty || !e.serialize) continue;
+    if (!e.urgent && now - e.firstMarkMs < e.coalesceMs) continue;
+    if (e.failed && now - e.failedMs < PERSIST_RETRY_MS) continue;
+    writeObject(i);
+    nextObject = (i + 1) % PERSIST_OBJECT_COUNT;
+    return;  // One flash write per loop() pass
+  }
+}
+
+void persistFlush(PersistObject obj) {
+  if (obj < PERSIST_OBJECT_COUNT) writeObject(obj);
+}
+
+void persistFlushAll() {
+  stats.flushAlls++;
+  for (uint8_t i = 0; i < PERSIST_OBJECT_COUNT; i++) {
+    writeObject(i);
+  }
+}
+
+uint8_t persistQueueDepth() {
+  return stats.depth;
+}
+
+const char* persistObjectName(PersistObject obj) {
+  return obj < PERSIST_OBJECT_COUNT ? OBJECT_NAMES[obj] : "unknown";
+}
+
+const PersistObjectStats& persistGetObjectStats(PersistObject obj) {
+  return objectStats[obj < PERSIST_OBJECT_COUNT ? obj : 0];
+}
+
+const PersistStats& persistGetStats() {
+  return stats;
+}
+
+void persistResetStats() {
+  ControlLockGuard guard;
+  for (uint8_t i = 0; i < PERSIST_OBJECT_COUNT; i++) objectStats[i] = PersistObjectStats();
+  uint8_t depth = stats.depth;
+  stats = PersistStats();
+  stats.depth = depth;
+  stats.maxDepth = depth;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <Arduino.h>
+
+// Deferred flash writes.
+// saveResumeState(), saveSettings(), savePIDProfiles(), saveCalibration() and the
+// activity log no longer write FFat themselves: they mark their object dirty and
+// return. persistService(), called once per loop() pass, writes each dirty object
+// once its coalescing window has passed, so a burst of saves (a stage advance used
+// to save the resume file up to three times) becomes one write.
+//
+// Each object has a serializer. The worker runs it under the control lock into a RAM
+// buffer (a consistent copy, a few hundred microseconds) and writes the buffer to
+// flash after releasing the lock, so neither the control task nor a web handler
+// waits for the FFat write.
+//
+// Urgent marks (stage changes from web commands, emergency shutdown) skip the
+// window and go out on the next pass; persistFlushAll() writes everything pending
+// inside the caller and is called before every restart and OTA update.
+//
+// A write that can't open its file or stores fewer bytes than it serialized leaves
+// the object dirty (still dated from its first mark) and is retried after
+// PERSIST_RETRY_MS; an append object keeps the bytes it didn't store and writes them
+// ahead of the next batch.
+
+constexpr unsigned long PERSIST_RETRY_MS = 5000;    // Wait after a failed write
+constexpr size_t PERSIST_UNWRITTEN_MAX = 8192;      // Append data kept for a retry; more is dropped
+
+enum PersistObject : uint8_t {
+  PERSIST_RESUME = 0,       // /resume.json
+  PERSIST_SETTINGS,         // /settings.json
+  PERSIST_PID_PROFILES,     // /pid-profiles.json
+  PERSIST_CALIBRATION,      // /calibration.json
+  PERSIST_ACTIVITY_LOG,     // /activity.log (append: buffered lines)
+  PERSIST_STORAGE_STATS,    // /storage_stats.json (flash write accounting)
+  PERSIST_OBJECT_COUNT
+};
+
+struct PersistObjectStats {
+  uint32_t marks = 0;           // Save requests
+  uint32_t writes = 0;          // Actual flash writes (marks - writes were coalesced)
+  uint32_t failures = 0;        // Open or write failed (retried)
+  uint32_t lastBytes = 0;
+  uint32_t lastSerializeUs = 0; // Under the control lock
+  uint32_t lastWriteUs = 0;     // open + write + close, lock released
+  uint32_t maxWriteUs = 0;
+  uint64_t totalWriteUs = 0;
+  uint32_t maxDelayMs = 0;      // First mark to written
+};
+
+struct PersistStats {
+  uint8_t depth = 0;            // Objects currently dirty
+  uint8_t maxDepth = 0;
+  uint32_t flushAlls = 0;       // Shutdown / restart flushes
+};
+
+// Writes the object's current state to out (called with the control lock held)
+typedef void (*PersistSerializer)(Print& out);
+
+// Registers an object; append objects are opened with "a" instead of "w".
+// coalesceMs is how long a mark may wait for more marks before it is written.
+void persistRegister(PersistObject obj, const char* path, PersistSerializer serialize,
+                     unsigned long coalesceMs, bool append = false);
+
+// Marks an object dirty (any task). urgent skips the coalescing window.
+void persistMarkDirty(PersistObject obj, bool urgent = false);
+
+// Every dirty object skips its coalescing window (emergency paths)
+void persistExpedite();
+
+// Writes due objects; call once per loop() pass (at most one object per pass)
+void persistService();
+
+// Writes the object now, inside the caller, if it is dirty (e.g. before serving it)
+void persistFlush(PersistObject obj);
+
+// Writes every dirty object now, inside the caller (restart, OTA, emergency paths)
+void persistFlushAll();
+
+uint8_t persistQueueDepth();
+const char* persistObjectName(PersistObject obj);
+const PersistObjectStats& persistGetObjectStats(PersistObject obj);
+const PersistStats& persistGetStats();
+void persistResetStats();
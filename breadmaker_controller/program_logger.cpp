@@ -1,44 +1,105 @@
 #include "program_logger.h"
-#include <FFat.h>
+#include "storage_backend.h"
 #include <WiFi.h>
 #include <time.h>
+#include "background_jobs.h"
+#include "control_task.h"
+#include "persistence_manager.h"
+#include "storage_stats.h"
 
 // Activity log configuration
 const char* ACTIVITY_LOG_FILE = "/activity.log";
 const size_t MAX_LOG_SIZE = 32768; // 32KB max log size
 static bool activityLogEnabled = true;
+static String pendingLog;                        // Lines not yet appended (control lock)
+static const size_t LOG_BUFFER_URGENT = 2048;    // Append on the next pass past this
 extern bool debugSerial;
 
+// --- Truncation job ---
+// Copies the last MAX_LOG_SIZE/2 bytes to a temporary file 1 KB per step, then
+// swaps it in. The last step copies whatever was appended meanwhile (the persistence
+// worker appends from loop() between steps), so no entry is lost in the swap.
+static const char* ACTIVITY_LOG_TMP = "/activity.tmp";
+
+struct TruncateLogCtx {
+  File src;
+  StorageFile dst;
+  uint8_t buf[1024];
+};
+
+static JobStep truncateLogStep(BackgroundJob& job) {
+  TruncateLogCtx& c = *(TruncateLogCtx*)job.ctx;
+  JOB_BEGIN(job);
+  c.src = storageFS().open(ACTIVITY_LOG_FILE, "r");
+  if (!c.src) return JOB_FINISHED;  // Removed meanwhile
+  if (c.src.size() <= MAX_LOG_SIZE / 2) return JOB_FINISHED;
+  c.src.seek(c.src.size() - MAX_LOG_SIZE / 2);  // Keep last 16KB
+  job.total = MAX_LOG_SIZE / 2;
+  c.dst = storageOpen(ACTIVITY_LOG_TMP, "w", "log_truncate");
+  if (!c.dst) {
+    backgroundJobSetMessage(job, "Failed to open %s", ACTIVITY_LOG_TMP);
+    return JOB_ERROR;
+  }
+  c.dst.print("=== LOG TRUNCATED ===\n");
+  JOB_YIELD(job);
+  
+  while (c.src.available()) {
+    {
+      size_t n = c.src.read(c.buf, sizeof(c.buf));
+      if (n == 0) break;
+      c.dst.write(c.buf, n);
+      job.done += n;
+    }
+    JOB_YIELD(job);
+  }
+  
+  {
+    size_t n;
+    while ((n = c.src.read(c.buf, sizeof(c.buf))) > 0) {
+      c.dst.write(c.buf, n);
+      job.done += n;
+    }
+    c.src.close();
+    c.dst.close();
+    storageFS().remove(ACTIVITY_LOG_FILE);
+    if (!storageFS().rename(ACTIVITY_LOG_TMP, ACTIVITY_LOG_FILE)) {
+      backgroundJobSetMessage(job, "Rename failed");
+      return JOB_ERROR;
+    }
+  }
+  backgroundJobSetMessage(job, "Kept %lu bytes", (unsigned long)job.done);
+  JOB_END(job);
+}
+
+static void truncateLogCleanup(BackgroundJob& job) {
+  TruncateLogCtx* c = (TruncateLogCtx*)job.ctx;
+  if (c->src) c->src.close();
+  if (c->dst) {
+    c->dst.close();
+    storageFS().remove(ACTIVITY_LOG_TMP);  // Interrupted before the swap
+  }
+  delete c;
+}
+
+uint16_t startTruncateActivityLogJob() {
+  // Two jobs would race on the same temporary file; hand back the one already in flight
+  static uint16_t jobId = 0;
+  const BackgroundJob* running = backgroundJobGet(jobId);
+  if (running && (running->state == JOB_QUEUED || running->state == JOB_RUNNING)) return jobId;
+  jobId = backgroundJobStart("truncate_log", truncateLogStep, new TruncateLogCtx(), truncateLogCleanup);
+  return jobId;
+}
+
 // Initialize activity logging
 void initActivityLog() {
   if (!activityLogEnabled) return;
   
-  // Check if log file is too large and truncate if needed
-  File logFile = FFat.open(ACTIVITY_LOG_FILE, "r");
-  if (logFile && logFile.size() > MAX_LOG_SIZE) {
-    logFile.close();
-    
-    // Read last 16KB of log to preserve recent entries
-    logFile = FFat.open(ACTIVITY_LOG_FILE, "r");
-    if (logFile) {
-      String recentEntries = "";
-      size_t keepSize = MAX_LOG_SIZE / 2; // Keep last 16KB
-      if (logFile.size() > keepSize) {
-        logFile.seek(logFile.size() - keepSize);
-        recentEntries = logFile.readString();
-      }
-      logFile.close();
-      
-      // Rewrite file with recent entries
-      logFile = FFat.open(ACTIVITY_LOG_FILE, "w");
-      if (logFile) {
-        logFile.print("=== LOG TRUNCATED ===\n");
-        logFile.print(recentEntries);
-        logFile.close();
-      }
-    }
-  } else if (logFile) {
+  // Check if log file is too large and truncate if needed (in the background)
+  File logFile = storageFS().open(ACTIVITY_LOG_FILE, "r");
+  if (logFile) {
+    size_t size = logFile.size();
     logFile.close();
+    if (size > MAX_LOG_SIZE) startTruncateActivityLogJob();
   }
   
   // Log system startup
@@ -89,12 +150,16 @@ void writeLogEntry(const String& level, const String& category, const String& me
     Serial.print("[ACTIVITY] " + logLine);
   }
   
-  // Write to log file
-  File logFile = FFat.open(ACTIVITY_LOG_FILE, "a");
-  if (logFile) {
-    logFile.print(logLine);
-    logFile.close();
-  }
+  // Buffered; the persistence worker appends batches of lines in one write
+  ControlLockGuard guard;
+  pendingLog += logLine;
+  persistMarkDirty(PERSIST_ACTIVITY_LOG, pendingLog.length() >= LOG_BUFFER_URGENT);
+}
+
+// Hands buffered lines to the persistence worker (control lock held)
+void serializeActivityLogBuffer(Print& out) {
+  out.print(pendingLog);
+  pendingLog = "";
 }
 
 // Program lifecycle logging
@@ -145,6 +210,7 @@ void logTemperatureEvent(const String& event, float temperature) {
 void logEmergencyShutdown(const String& reason, float temperature) {
   String message = "EMERGENCY SHUTDOWN: " + reason + " (Temp: " + String(temperature, 1) + "°C)";
   writeLogEntry("ERROR", "SAFETY", message);
+  persistMarkDirty(PERSIST_ACTIVITY_LOG, true);   // On flash with the next loop() pass, not in 5 s
 }
 
 void logSystemEvent(const String& event) {
@@ -160,14 +226,18 @@ void logFermentationUpdate(float factor, float scheduledElapsed, float realElaps
 
 // Activity log management functions
 void clearActivityLog() {
-  if (FFat.exists(ACTIVITY_LOG_FILE)) {
-    FFat.remove(ACTIVITY_LOG_FILE);
+  {
+    ControlLockGuard guard;
+    pendingLog = "";
+  }
+  if (storageFS().exists(ACTIVITY_LOG_FILE)) {
+    storageFS().remove(ACTIVITY_LOG_FILE);
   }
   logSystemEvent("Activity log cleared by user");
 }
 
 String getActivityLogSize() {
-  File logFile = FFat.open(ACTIVITY_LOG_FILE, "r");
+  File logFile = storageFS().open(ACTIVITY_LOG_FILE, "r");
   if (logFile) {
     size_t size = logFile.size();
     logFile.close();
@@ -3,6 +3,9 @@
 
 // Activity logging for ESP32 breadmaker controller
 // Logs program events, stage changes, and system events to /activity.log
+// (buffered in RAM and appended by the persistence worker)
+
+extern const char* ACTIVITY_LOG_FILE;
 
 void initActivityLog();
 void logProgramStart(const String& programName, int programId);
@@ -26,11 +29,13 @@ void logFermentationProgress(double progressPercent, double factor, double tempe
 
 // Activity log management
 void clearActivityLog();
+uint16_t startTruncateActivityLogJob();  // Background job id (0 if no slot; the running job's id if one is active)
 String getActivityLogSize();
 bool isActivityLogEnabled();
 void setActivityLogEnabled(bool enabled);
 
 // Internal helper functions
 void writeLogEntry(const String& level, const String& category, const String& message);
+void serializeActivityLogBuffer(Print& out);
 String formatTimestamp();
 String formatDuration(unsigned long seconds);
\ No newline at end of file
@@ -1,7 +1,10 @@
-#include <FFat.h>
+#include "storage_backend.h"
 #include <ArduinoJson.h>
 #include "programs_manager.h"
 #include "globals.h"
+#include "background_jobs.h"
+#include "storage_stats.h"
+#include "debug_log.h"
 
 // External variable declarations
 extern bool debugSerial;
@@ -15,7 +18,7 @@ void loadProgramMetadata() {
   programMetadata.clear();
   
   // Use lightweight index file instead of full programs.json
-  File f = FFat.open("/programs_index.json", "r");
+  File f = storageFS().open("/programs_index.json", "r");
   if (!f || f.size() == 0) {
     if (f) f.close();
     Serial.println("[ERROR] programs_index.json not found or empty");
@@ -69,20 +72,20 @@ void loadProgramMetadata() {
 bool loadSpecificProgram(int programId) {
   // Check if already loaded
   if (programState.activeProgramId == programId && activeProgram.id == programId) {
-    Serial.printf("[INFO] Program %d already loaded\n", programId);
+    LOG_VERBOSE(LOG_STORAGE, "[INFO] Program %d already loaded\n", programId);
     return true;
   }
   
   // Load individual program file instead of entire programs.json
   String programFileName = "/program_" + String(programId) + ".json";
-  File f = FFat.open(programFileName, "r");
+  File f = storageFS().open(programFileName, "r");
   if (!f || f.size() == 0) {
     if (f) f.close();
-    Serial.printf("[ERROR] Program file %s not found or empty\n", programFileName.c_str());
+    LOG_ERROR(LOG_STORAGE, "[ERROR] Program file %s not found or empty\n", programFileName.c_str());
     return false;
   }
   
-  Serial.printf("[INFO] Loading program from %s (Free heap: %u bytes)\n", programFileName.c_str(), ESP.getFreeHeap());
+  LOG_INFO(LOG_STORAGE, "[INFO] Loading program from %s (Free heap: %u bytes)\n", programFileName.c_str(), (unsigned)ESP.getFreeHeap());
   
   // MEMORY OPTIMIZATION: Reduced from 3072 to 1536 bytes (50% reduction)
   // Individual program files should be smaller than the full index
@@ -91,8 +94,8 @@ bool loadSpecificProgram(int programId) {
   f.close();
   
   if (err) {
-    Serial.printf("[ERROR] Failed to parse %s: %s (Free heap: %u bytes)\n", programFileName.c_str(), err.c_str(), ESP.getFreeHeap());
-    Serial.println("[INFO] Consider simplifying program file or reducing stages/data");
+    LOG_ERROR(LOG_STORAGE, "[ERROR] Failed to parse %s: %s (Free heap: %u bytes)\n", programFileName.c_str(), err.c_str(), (unsigned)ESP.getFreeHeap());
+    LOG_ERROR(LOG_STORAGE, "[INFO] Consider simplifying program file or reducing stages/data\n");
     return false;
   }
   
@@ -147,8 +150,8 @@ bool loadSpecificProgram(int programId) {
   
   // Update the active program
   programState.activeProgramId = programId;
-  Serial.printf("[INFO] Loaded program '%s' with %zu stages (Free heap: %u bytes)\n", 
-                activeProgram.name.c_str(), activeProgram.customStages.size(), ESP.getFreeHeap());
+  LOG_INFO(LOG_STORAGE, "[INFO] Loaded program '%s' with %zu stages (Free heap: %u bytes)\n",
+           activeProgram.name.c_str(), activeProgram.customStages.size(), (unsigned)ESP.getFreeHeap());
   
   return true;
 }
@@ -195,14 +198,13 @@ const Program* getActiveProgram() {
 
 // API function to ensure a program is loaded
 bool ensureProgramLoaded(int programId) {
-  Serial.printf("[DEBUG] ensureProgramLoaded called with ID %d\n", programId);
   if (isProgramLoaded(programId)) {
-    Serial.printf("[DEBUG] Program ID %d already loaded\n", programId);
+    LOG_VERBOSE(LOG_STORAGE, "[DEBUG] Program ID %d already loaded\n", programId);
     return true;
   }
-  Serial.printf("[DEBUG] Program ID %d not loaded, attempting to load...\n", programId);
+  LOG_DEBUG(LOG_STORAGE, "[DEBUG] Program ID %d not loaded, attempting to load...\n", programId);
   bool result = loadSpecificProgram(programId);
-  Serial.printf("[DEBUG] loadSpecificProgram returned: %s\n", result ? "true" : "false");
+  if (!result) LOG_ERROR(LOG_STORAGE, "[ERROR] Failed to load program ID %d\n", programId);
   return result;
 }
 
@@ -251,192 +253,188 @@ int findProgramIdByName(const String& name) {
   return -1;
 }
 
-bool splitProgramsJson() {
-  // Split main programs.json into individual program files and metadata index
-  // MEMORY OPTIMIZED: Process programs one at a time instead of loading entire array
-  Serial.println("[INFO] Starting programs.json split operation (memory optimized)");
-  
-  // Read the main programs.json file
-  File mainFile = FFat.open("/programs.json", "r");
-  if (!mainFile || mainFile.size() == 0) {
-    if (mainFile) mainFile.close();
-    Serial.println("[ERROR] programs.json not found or empty");
-    return false;
+// --- programs.json split (background job) ---
+// Streams programs.json 512 bytes per step instead of reading it into one String,
+// cutting out each top-level program object by brace depth. Each complete object is
+// parsed and written to /programs/program_<id>.json in its own step.
+
+struct SplitProgramsCtx {
+  File mainFile;
+  String current;            // Text of the program object being collected
+  int braceDepth = 0;
+  bool inString = false;
+  bool escaped = false;
+  bool sawArray = false;
+  int successCount = 0;
+  DynamicJsonDocument metaDoc{1024};
+  char buf[512];
+  size_t bufLen = 0;
+  size_t bufPos = 0;
+};
+
+// Writes one program file and adds its index entry
+static void writeSplitProgram(BackgroundJob& job, SplitProgramsCtx& c) {
+  c.current.trim();
+  if (c.current.length() == 0) return;
+  
+  // Parse individual program with minimal memory
+  DynamicJsonDocument programDoc(1024); // Smaller buffer per program
+  DeserializationError err = deserializeJson(programDoc, c.current);
+  c.current = "";
+  if (err) {
+    Serial.printf("[WARNING] Failed to parse program: %s\n", err.c_str());
+    return;
   }
   
-  Serial.printf("[INFO] programs.json found, size: %zu bytes (Free heap: %u bytes)\n", 
-                mainFile.size(), ESP.getFreeHeap());
+  JsonObject program = programDoc.as<JsonObject>();
   
-  // Create programs directory if it doesn't exist
-  if (!FFat.exists("/programs")) {
-    FFat.mkdir("/programs");
-    Serial.println("[INFO] Created /programs directory");
+  if (!program.containsKey("id")) {
+    Serial.println("[WARNING] Skipping program without id");
+    return;
   }
   
-  // Use smaller buffer and parse the array manually
-  // Read just enough to get the array structure
-  String content;
-  content.reserve(mainFile.size() + 100); // Reserve space to avoid reallocations
+  int programId = program["id"];
+  String filename = "/programs/program_" + String(programId) + ".json";
   
-  while (mainFile.available()) {
-    content += mainFile.readString();
+  // Fix data types in the program object before saving
+  if (program.containsKey("fermentBaselineTemp") && program["fermentBaselineTemp"].is<String>()) {
+    program["fermentBaselineTemp"] = program["fermentBaselineTemp"].as<String>().toFloat();
   }
-  mainFile.close();
-  
-  Serial.printf("[INFO] File content loaded (Free heap: %u bytes)\n", ESP.getFreeHeap());
-  
-  // Quick validation
-  if (!content.startsWith("[") || !content.endsWith("]")) {
-    Serial.println("[ERROR] programs.json is not a valid array");
-    return false;
+  if (program.containsKey("fermentQ10") && program["fermentQ10"].is<String>()) {
+    program["fermentQ10"] = program["fermentQ10"].as<String>().toFloat();
   }
   
-  // Remove outer brackets and whitespace
-  content = content.substring(1, content.length() - 1);
-  content.trim();
-  
-  // Prepare metadata collection (smaller buffer)
-  DynamicJsonDocument metaDoc(1024);
-  JsonArray metaArray = metaDoc.to<JsonArray>();
+  // Write individual program file
+  StorageFile progFile = storageOpen(filename, "w", "program_split");
+  if (!progFile) {
+    Serial.printf("[ERROR] Failed to create %s\n", filename.c_str());
+    return;
+  }
   
-  int successCount = 0;
-  int startPos = 0;
-  
-  // Split on top-level commas (between program objects)
-  while (startPos < content.length()) {
-    int nextComma = -1;
-    int braceDepth = 0;
-    bool inString = false;
-    bool escaped = false;
-    
-    // Find the next top-level comma or end of content
-    for (int i = startPos; i < content.length(); i++) {
-      char c = content[i];
-      
-      if (escaped) {
-        escaped = false;
-        continue;
-      }
-      
-      if (c == '\\') {
-        escaped = true;
-        continue;
-      }
-      
-      if (c == '"') {
-        inString = !inString;
-        continue;
-      }
-      
-      if (!inString) {
-        if (c == '{') {
-          braceDepth++;
-        } else if (c == '}') {
-          braceDepth--;
-        } else if (c == ',' && braceDepth == 0) {
-          nextComma = i;
-          break;
-        }
-      }
-    }
-    
-    // Extract program JSON
-    String programJson;
-    if (nextComma != -1) {
-      programJson = content.substring(startPos, nextComma);
-      startPos = nextComma + 1;
-    } else {
-      programJson = content.substring(startPos);
-      startPos = content.length(); // End the loop
-    }
-    
-    programJson.trim();
-    if (programJson.length() == 0) continue;
-    
-    // Parse individual program with minimal memory
-    DynamicJsonDocument programDoc(1024); // Smaller buffer per program
-    DeserializationError err = deserializeJson(programDoc, programJson);
-    
-    if (err) {
-      Serial.printf("[WARNING] Failed to parse program: %s\n", err.c_str());
+  serializeJson(program, progFile);
+  progFile.close();
+  
+  Serial.printf("[INFO] Created %s (Free heap: %u bytes)\n", filename.c_str(), ESP.getFreeHeap());
+  c.successCount++;
+  
+  // Create metadata object for index (numbers already fixed above)
+  JsonObject meta = c.metaDoc.as<JsonArray>().createNestedObject();
+  meta["id"] = program["id"];
+  meta["name"] = program["name"];
+  if (program.containsKey("notes")) meta["notes"] = program["notes"];
+  if (program.containsKey("icon")) meta["icon"] = program["icon"];
+  if (program.containsKey("fermentBaselineTemp")) meta["fermentBaselineTemp"] = program["fermentBaselineTemp"];
+  if (program.containsKey("fermentQ10")) meta["fermentQ10"] = program["fermentQ10"];
+  backgroundJobSetMessage(job, "%d programs written", c.successCount);
+}
+
+// Scans buffered input; returns true when a complete program object is in c.current
+static bool scanSplitInput(BackgroundJob& job, SplitProgramsCtx& c) {
+  while (c.bufPos < c.bufLen) {
+    char ch = c.buf[c.bufPos++];
+    job.done++;
+    if (!c.sawArray) {
+      if (ch == '[') c.sawArray = true;
       continue;
     }
+    if (c.braceDepth > 0) c.current += ch;
     
-    JsonObject program = programDoc.as<JsonObject>();
-    
-    if (!program.containsKey("id")) {
-      Serial.println("[WARNING] Skipping program without id");
+    if (c.escaped) {
+      c.escaped = false;
       continue;
     }
-    
-    int programId = program["id"];
-    String filename = "/programs/program_" + String(programId) + ".json";
-    
-    // Fix data types in the program object before saving
-    if (program.containsKey("fermentBaselineTemp") && program["fermentBaselineTemp"].is<String>()) {
-      program["fermentBaselineTemp"] = program["fermentBaselineTemp"].as<String>().toFloat();
-    }
-    if (program.containsKey("fermentQ10") && program["fermentQ10"].is<String>()) {
-      program["fermentQ10"] = program["fermentQ10"].as<String>().toFloat();
-    }
-    
-    // Write individual program file
-    File progFile = FFat.open(filename, "w");
-    if (!progFile) {
-      Serial.printf("[ERROR] Failed to create %s\n", filename.c_str());
+    if (c.inString) {
+      if (ch == '\\') c.escaped = true;
+      else if (ch == '"') c.inString = false;
       continue;
     }
-    
-    serializeJson(program, progFile);
-    progFile.close();
-    
-    Serial.printf("[INFO] Created %s (Free heap: %u bytes)\n", filename.c_str(), ESP.getFreeHeap());
-    successCount++;
-    
-    // Create metadata object for index
-    JsonObject meta = metaArray.createNestedObject();
-    meta["id"] = program["id"];
-    meta["name"] = program["name"];
-    if (program.containsKey("notes")) meta["notes"] = program["notes"];
-    if (program.containsKey("icon")) meta["icon"] = program["icon"];
-    // Ensure fermentation parameters are stored as numbers, not strings
-    if (program.containsKey("fermentBaselineTemp")) {
-      if (program["fermentBaselineTemp"].is<String>()) {
-        meta["fermentBaselineTemp"] = program["fermentBaselineTemp"].as<String>().toFloat();
-      } else {
-        meta["fermentBaselineTemp"] = program["fermentBaselineTemp"];
-      }
+    if (ch == '"') {
+      c.inString = true;
+    } else if (ch == '{') {
+      if (c.braceDepth++ == 0) c.current = "{";
+    } else if (ch == '}') {
+      if (--c.braceDepth == 0) return true;
     }
-    if (program.containsKey("fermentQ10")) {
-      if (program["fermentQ10"].is<String>()) {
-        meta["fermentQ10"] = program["fermentQ10"].as<String>().toFloat();
-      } else {
-        meta["fermentQ10"] = program["fermentQ10"];
-      }
+  }
+  return false;
+}
+
+static JobStep splitProgramsStep(BackgroundJob& job) {
+  SplitProgramsCtx& c = *(SplitProgramsCtx*)job.ctx;
+  JOB_BEGIN(job);
+  Serial.println("[INFO] Starting programs.json split operation (streamed background job)");
+  
+  c.mainFile = storageFS().open("/programs.json", "r");
+  if (!c.mainFile || c.mainFile.size() == 0) {
+    Serial.println("[ERROR] programs.json not found or empty");
+    backgroundJobSetMessage(job, "programs.json not found or empty");
+    return JOB_ERROR;
+  }
+  job.total = c.mainFile.size();
+  Serial.printf("[INFO] programs.json found, size: %zu bytes (Free heap: %u bytes)\n", 
+                c.mainFile.size(), ESP.getFreeHeap());
+  
+  // Create programs directory if it doesn't exist
+  if (!storageFS().exists("/programs")) {
+    storageFS().mkdir("/programs");
+    Serial.println("[INFO] Created /programs directory");
+  }
+  c.metaDoc.to<JsonArray>();
+  JOB_YIELD(job);
+  
+  for (;;) {
+    if (c.bufPos >= c.bufLen) {
+      c.bufLen = c.mainFile.read((uint8_t*)c.buf, sizeof(c.buf));
+      c.bufPos = 0;
+      if (c.bufLen == 0) break;
     }
-    
-    // Force garbage collection between programs
-    programDoc.clear();
+    if (scanSplitInput(job, c)) writeSplitProgram(job, c);
+    JOB_YIELD(job);
   }
+  c.mainFile.close();
   
-  // Create programs_index.json with metadata
-  File indexFile = FFat.open("/programs_index.json", "w");
-  if (!indexFile) {
-    Serial.println("[ERROR] Failed to create programs_index.json");
-    return false;
+  if (!c.sawArray) {
+    Serial.println("[ERROR] programs.json is not a valid array");
+    backgroundJobSetMessage(job, "programs.json is not a valid array");
+    return JOB_ERROR;
   }
   
-  serializeJson(metaDoc, indexFile);
-  indexFile.close();
+  {
+    // Create programs_index.json with metadata
+    StorageFile indexFile = storageOpen("/programs_index.json", "w", "program_split");
+    if (!indexFile) {
+      Serial.println("[ERROR] Failed to create programs_index.json");
+      backgroundJobSetMessage(job, "Failed to create programs_index.json");
+      return JOB_ERROR;
+    }
+    serializeJson(c.metaDoc, indexFile);
+    indexFile.close();
+  }
   
-  Serial.printf("[INFO] Created programs_index.json with %d programs\n", metaArray.size());
+  Serial.printf("[INFO] Created programs_index.json with %d programs\n", c.metaDoc.as<JsonArray>().size());
   Serial.printf("[INFO] Split operation complete: %d programs processed successfully (Free heap: %u bytes)\n", 
-                successCount, ESP.getFreeHeap());
+                c.successCount, ESP.getFreeHeap());
   
   // Reload metadata to reflect changes
   loadProgramMetadata();
-  
-  return successCount > 0;
+  if (c.successCount == 0) return JOB_ERROR;
+  JOB_END(job);
+}
+
+static void splitProgramsCleanup(BackgroundJob& job) {
+  SplitProgramsCtx* c = (SplitProgramsCtx*)job.ctx;
+  if (c->mainFile) c->mainFile.close();
+  delete c;
+}
+
+uint16_t startSplitProgramsJsonJob() {
+  return backgroundJobStart("split_programs", splitProgramsStep, new SplitProgramsCtx(), splitProgramsCleanup);
+}
+
+bool splitProgramsJson() {
+  // Split main programs.json into individual program files and metadata index
+  uint16_t id = startSplitProgramsJsonJob();
+  return id != 0 && backgroundJobRunNow(id) == JOB_DONE;
 }
 
 // --- Cache invalidation functions ---
@@ -60,7 +60,8 @@ extern Program activeProgram; // Only the currently active program is fully load
 // --- Program management functions ---
 void loadProgramMetadata(); // Load only names and basic info
 bool loadSpecificProgram(int programId); // Load full program data for specific program
-bool splitProgramsJson(); // Split main programs.json into individual files and index
+bool splitProgramsJson(); // Split main programs.json into individual files and index (runs to completion)
+uint16_t startSplitProgramsJsonJob(); // Same, as a sliced background job; returns job id (0 if no slot)
 
 // --- Helper functions ---
 bool isProgramLoaded(int programId); // Check if a program is currently loaded
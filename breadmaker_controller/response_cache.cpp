@@ -0,0 +1,240 @@
+#include "response_cache.h"
+#include <atomic>
+#ifndef NATIVE_SIMULATION
+#include <esp_timer.h>
+#endif
+
+extern bool debugSerial;
+
+static ResponseCacheEntry entries[MAX_RESPONSE_CACHE_ENTRIES];
+static uint8_t entryCount = 0;
+static ResponseCacheStats stats;
+static std::atomic<uint32_t> stateVersion{1};
+static bool enabled = true;
+
+// Captures the body for the cache. If it outgrows RESPONSE_CACHE_MAX_BODY (or
+// capture is off) it switches to a chunked response and coalesces writes into 1 KB
+// chunks, so a serializer that prints field by field doesn't cost a chunk per field.
+class ResponseWriter : public Print {
+  public:
+    ResponseWriter(WebServer& server, const char* contentType, bool capture)
+      : server(server), contentType(contentType) {
+      if (!capture) startStreaming();
+    }
+    ~ResponseWriter() { free(body); }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t size) override {
+      if (!streaming) {
+        if (length + size <= RESPONSE_CACHE_MAX_BODY && reserve(length + size)) {
+          memcpy(body + length, data, size);
+          length += size;
+          return size;
+        }
+        startStreaming();
+      }
+      if (chunkLen + size > sizeof(chunk)) flushChunk();
+      if (size >= sizeof(chunk)) {
+        server.sendContent((const char*)data, size);
+      } else {
+        memcpy(chunk + chunkLen, data, size);
+        chunkLen += size;
+      }
+      return size;
+    }
+
+    // Ends a streamed response
+    void finish() {
+      if (!streaming) return;
+      flushChunk();
+      server.sendContent("");
+    }
+
+    bool streaming = false;
+    char* body = nullptr;
+    size_t length = 0;
+
+  private:
+    bool reserve(size_t needed) {
+      if (needed <= capacity) return true;
+      size_t grown = std::min(std::max(needed, std::max(capacity * 2, (size_t)512)), RESPONSE_CACHE_MAX_BODY);
+      char* p = (char*)realloc(body, grown);
+      if (!p) return false;
+      body = p;
+      capacity = grown;
+      return true;
+    }
+
+    void startStreaming() {
+      server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+      server.send(200, contentType, "");
+      streaming = true;
+      if (length) server.sendContent(body, length);
+      free(body);
+      body = nullptr;
+      length = capacity = 0;
+    }
+
+    void flushChunk() {
+      if (chunkLen) server.sendContent(chunk, chunkLen);
+      chunkLen = 0;
+    }
+
+    WebServer& server;
+    const char* contentType;
+    size_t capacity = 0;
+    char chunk[1024];
+    size_t chunkLen = 0;
+};
+
+static bool buildKey(WebServer& server, char* key, size_t size) {
+  int n = snprintf(key, size, "%s", server.uri().c_str());
+  for (int i = 0; i < server.args() && n < (int)size; i++) {
+    n += snprintf(key + n, size - n, "%c%s=%s", i ? '&' : '?', server.argName(i).c_str(), server.arg(i).c_str());
+  }
+  return n < (int)size;
+}
+
+static ResponseCacheEntry* findEntry(const char* key) {
+  for (uint8_t i = 0; i < entryCount; i++) {
+    if (strcmp(entries[i].key, key) == 0) return &entries[i];
+  }
+  return nullptr;
+}
+
+// A free slot, or the least recently used entry
+static ResponseCacheEntry& claimEntry(const char* key) {
+  ResponseCacheEntry* e;
+  if (entryCount < MAX_RESPONSE_CACHE_ENTRIES) {
+    e = &entries[entryCount++];
+  } else {
+    e = &entries[0];
+    for (uint8_t i = 1; i < entryCount; i++) {
+      if (entries[i].lastUsedMs - e->lastUsedMs > 0x80000000UL) e = &entries[i];  // Older, wrap-safe
+    }
+    free(e->body);
+    stats.evictions++;
+  }
+  *e = ResponseCacheEntry();
+  snprintf(e->key, sizeof(e->key), "%s", key);
+  return *e;
+}
+
+static void removeEntry(ResponseCacheEntry* e) {
+  free(e->body);
+  *e = entries[--entryCount];
+  entries[entryCount] = ResponseCacheEntry();
+}
+
+static void sendBody(WebServer& server, const char* contentType, const char* body, size_t length, const char* cache) {
+  server.sendHeader("X-Cache", cache);
+  server.setContentLength(length);
+  server.send(200, contentType, "");
+  if (length) server.sendContent(body, length);
+}
+
+void responseCacheServe(WebServer& server, const char* contentType, uint32_t ttlMs, ResponseRenderer render) {
+  char key[RESPONSE_CACHE_KEY_LEN];
+  if (!enabled || ttlMs == 0 || !buildKey(server, key, sizeof(key))) {
+    // Still rendered into a buffer and sent afterwards: a renderer that holds the
+    // control lock mustn't wait on the client's socket
+    stats.bypassed++;
+    ResponseWriter out(server, contentType, true);
+    render(out);
+    if (out.streaming) out.finish();
+    else sendBody(server, contentType, out.body, out.length, "BYPASS");
+    return;
+  }
+
+  unsigned long now = millis();
+  uint32_t version = stateVersion.load();
+  ResponseCacheEntry* e = findEntry(key);
+  if (!e) {
+    stats.cold++;
+  } else if (e->version != version) {
+    stats.invalidated++;
+  } else if (now - e->renderedMs >= ttlMs) {
+    stats.expired++;
+  } else {
+    e->hits++;
+    e->lastUsedMs = now;
+    stats.hits++;
+    stats.bytesFromCache += e->length;
+    sendBody(server, e->contentType, e->body, e->length, "HIT");
+    return;
+  }
+
+  // Miss: render once, keep the bytes. The version is read before rendering, so a
+  // state change during the render leaves the entry already stale.
+  stats.misses++;
+  ResponseWriter out(server, contentType, true);
+  int64_t startUs = esp_timer_get_time();
+  render(out);
+  stats.renderUs += esp_timer_get_time() - startUs;
+  if (out.streaming) {
+    out.finish();
+    stats.bypassed++;
+    if (e) removeEntry(e);
+    if (debugSerial) Serial.printf("[CACHE] %s is over %u bytes, streamed uncached\n", key, (unsigned)RESPONSE_CACHE_MAX_BODY);
+    return;
+  }
+
+  if (!e) e = &claimEntry(key);
+  free(e->body);
+  e->body = out.length ? (char*)realloc(out.body, out.length) : nullptr;
+  if (!e->body) free(out.body);
+  out.body = nullptr;
+  e->length = e->body ? out.length : 0;
+  e->capacity = e->length;
+  e->contentType = contentType;
+  e->version = version;
+  e->renderedMs = now;
+  e->lastUsedMs = now;
+  e->renders++;
+  sendBody(server, contentType, e->body, e->length, "MISS");
+}
+
+void responseCacheInvalidate() {
+  stateVersion++;
+}
+
+uint32_t responseCacheVersion() {
+  return stateVersion.load();
+}
+
+void responseCacheSetEnabled(bool on) {
+  enabled = on;
+  if (!on) responseCacheClear();
+}
+
+bool responseCacheEnabled() {
+  return enabled;
+}
+
+void responseCacheClear() {
+  for (uint8_t i = 0; i < entryCount; i++) {
+    free(entries[i].body);
+    entries[i] = ResponseCacheEntry();
+  }
+  entryCount = 0;
+}
+
+uint8_t responseCacheEntryCount() {
+  return entryCount;
+}
+
+const ResponseCacheEntry& responseCacheEntry(uint8_t i) {
+  return entries[i < MAX_RESPONSE_CACHE_ENTRIES ? i : 0];
+}
+
+const ResponseCacheStats& responseCacheGetStats() {
+  return stats;
+}
+
+void responseCacheResetStats() {
+  stats = ResponseCacheStats();
+  for (uint8_t i = 0; i < entryCount; i++) {
+    entries[i].hits = 0;
+    entries[i].renders = 0;
+  }
+}
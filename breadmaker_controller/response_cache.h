@@ -0,0 +1,73 @@
+#pragma once
+#include <Arduino.h>
+#include <WebServer.h>
+#include <functional>
+
+// Response cache for polled GETs.
+// The web UI, Home Assistant and a phone polling /status, /ha or /api/pid_status in
+// the same second used to run the full serializer once per request. A handler now
+// hands its serializer to responseCacheServe(): the body is rendered into an entry
+// keyed by URI and args, and any request for the same key within the TTL is answered
+// from those bytes with a Content-Length response instead of a run of small chunks.
+//
+// Entries also carry the state version. responseCacheInvalidate() (called through
+// invalidateStatusCache() wherever program/output state changes, from either core)
+// bumps it, so a cached body is never older than the last state change.
+//
+// Single flight: the WebServer serves one request at a time on the loop core, so
+// requests that arrive together wait in the TCP backlog while the first one renders
+// and are then served from its entry - a key is never rendered twice concurrently.
+// The renderer runs without any lock held; it takes the control lock itself, so a
+// cache hit doesn't contend with the control tick at all. Every render - cached or
+// not - goes to a RAM buffer first and is sent after the renderer returns, so the
+// lock is never held while writing to a client; only a body over
+// RESPONSE_CACHE_MAX_BODY (the trace dump) streams while it renders, and renderers
+// that take the lock stay well under it.
+
+constexpr uint8_t MAX_RESPONSE_CACHE_ENTRIES = 6;
+constexpr size_t RESPONSE_CACHE_MAX_BODY = 12288;   // Larger bodies are streamed uncached
+constexpr size_t RESPONSE_CACHE_KEY_LEN = 96;        // URI + args; longer keys bypass the cache
+
+typedef std::function<void(Print& out)> ResponseRenderer;
+
+struct ResponseCacheStats {
+  uint32_t hits = 0;
+  uint32_t misses = 0;            // Rendered: cold + expired + invalidated
+  uint32_t cold = 0;              // No entry for the key
+  uint32_t expired = 0;           // Entry older than its TTL
+  uint32_t invalidated = 0;       // State changed since the entry was rendered
+  uint32_t bypassed = 0;          // Not cacheable (disabled, TTL 0, key or body too large, no memory)
+  uint32_t evictions = 0;
+  uint64_t bytesFromCache = 0;    // Body bytes served without rendering
+  uint64_t renderUs = 0;          // Time spent rendering on misses
+};
+
+struct ResponseCacheEntry {
+  char key[RESPONSE_CACHE_KEY_LEN] = "";
+  char* body = nullptr;
+  size_t length = 0;
+  size_t capacity = 0;
+  const char* contentType = "";
+  uint32_t version = 0;
+  unsigned long renderedMs = 0;
+  unsigned long lastUsedMs = 0;
+  uint32_t hits = 0;
+  uint32_t renders = 0;
+};
+
+// Answers the current request from the cache, or renders, stores and sends it.
+// ttlMs = 0 always renders (and sends the body uncached).
+void responseCacheServe(WebServer& server, const char* contentType, uint32_t ttlMs, ResponseRenderer render);
+
+// State changed: every entry is stale. Safe from any task.
+void responseCacheInvalidate();
+uint32_t responseCacheVersion();
+
+void responseCacheSetEnabled(bool enabled);   // Disabled: every request renders (for A/B comparison)
+bool responseCacheEnabled();
+void responseCacheClear();                    // Frees all entries
+
+uint8_t responseCacheEntryCount();
+const ResponseCacheEntry& responseCacheEntry(uint8_t i);
+const ResponseCacheStats& responseCacheGetStats();
+void responseCacheResetStats();
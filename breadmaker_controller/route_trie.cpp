@@ -0,0 +1,64 @@
+#include "route_trie.h"
+#include <string.h>
+
+void RouteTrie::clear() {
+  count = 0;
+  newNode("", 0);
+}
+
+int16_t RouteTrie::newNode(const char* label, uint8_t len) {
+  if (count >= MAX_NODES) return -1;
+  RouteTrieNode& n = nodes[count];
+  n = RouteTrieNode();
+  n.label = label;
+  n.len = len;
+  return count++;
+}
+
+int16_t RouteTrie::insert(const char* path) {
+  if (!count) clear();
+  int16_t n = 0;
+  const char* p = path;
+  for (;;) {
+    if (!*p) return n;
+    int16_t* link = &nodes[n].child;
+    while (*link >= 0 && nodes[*link].label[0] != *p) link = &nodes[*link].sibling;
+    if (*link < 0) {
+      int16_t leaf = newNode(p, strlen(p));
+      if (leaf >= 0) *link = leaf;
+      return leaf;
+    }
+    RouteTrieNode& c = nodes[*link];
+    uint8_t common = 0;
+    while (common < c.len && c.label[common] == p[common]) common++;
+    if (common < c.len) {
+      // Split the edge: the shared prefix becomes a new node above c
+      int16_t mid = newNode(c.label, common);
+      if (mid < 0) return -1;
+      nodes[mid].child = *link;
+      nodes[mid].sibling = c.sibling;
+      c.sibling = -1;
+      c.label += common;
+      c.len -= common;
+      *link = mid;
+      n = mid;
+    } else {
+      n = *link;
+    }
+    p += common;
+  }
+}
+
+int16_t RouteTrie::find(const char* path) const {
+  if (!count) return -1;
+  int16_t n = 0;
+  const char* p = path;
+  while (*p) {
+    int16_t c = nodes[n].child;
+    while (c >= 0 && nodes[c].label[0] != *p) c = nodes[c].sibling;
+    if (c < 0 || strncmp(nodes[c].label, p, nodes[c].len) != 0) return -1;
+    p += nodes[c].len;
+    n = c;
+  }
+  return n;
+}
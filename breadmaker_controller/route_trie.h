@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+
+// Radix trie over the route paths of web_routes.cpp.
+// Each node holds a slice of one path (label/len point into the caller's copy of the
+// path, which must outlive the trie); children are a sibling list. Every insert adds at
+// most a split node and a leaf, so 2 * ROUTE_TRIE_MAX_PATHS + 1 nodes always suffice.
+// A node carries one int16_t of the caller's (web_routes.cpp keeps the first route
+// registered for that exact path there), -1 when unset.
+//
+// Pure C++ (no Arduino dependencies) so the host tests under test/ exercise the same
+// lookup the firmware runs.
+
+constexpr uint16_t ROUTE_TRIE_MAX_PATHS = 128;
+
+struct RouteTrieNode {
+  const char* label = "";
+  uint8_t len = 0;
+  int16_t child = -1;
+  int16_t sibling = -1;
+  int16_t value = -1;
+};
+
+class RouteTrie {
+  public:
+    static constexpr uint16_t MAX_NODES = 2 * ROUTE_TRIE_MAX_PATHS + 1;
+
+    void clear();                           // Root only
+    int16_t insert(const char* path);       // Node for exactly path, added if new; -1 if out of nodes
+    int16_t find(const char* path) const;   // Node for exactly path, or -1
+    int16_t& value(int16_t node) { return nodes[node].value; }
+    int16_t value(int16_t node) const { return nodes[node].value; }
+    uint16_t nodeCount() const { return count; }
+
+  private:
+    int16_t newNode(const char* label, uint8_t len);
+
+    RouteTrieNode nodes[MAX_NODES];
+    uint16_t count = 0;
+};
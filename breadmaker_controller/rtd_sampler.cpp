@@ -0,0 +1,161 @@
+#include "rtd_sampler.h"
+#include "globals.h"  // For PIN_RTD definition
+
+extern bool debugSerial;
+
+static RTDSamplerConfig samplerConfig;
+static RTDSamplerStats samplerStats;
+
+// Decimation accumulator (one entry per burst mean). Welford's running mean and sum of
+// squared deviations: with counts near 2000 a float sum of squares has no bits left for
+// the variance.
+static float decimationMean = 0.0f;
+static float decimationM2 = 0.0f;
+static uint8_t decimationCount = 0;
+static unsigned long lastBurstMs = 0;
+static bool haveReading = false;
+
+// Insertion sort - bursts are at most RTD_BURST_MAX_SAMPLES and usually nearly sorted
+static void sortSamples(uint16_t* s, uint8_t n) {
+  for (uint8_t i = 1; i < n; i++) {
+    uint16_t v = s[i];
+    int8_t j = i - 1;
+    while (j >= 0 && s[j] > v) {
+      s[j + 1] = s[j];
+      j--;
+    }
+    s[j + 1] = v;
+  }
+}
+
+static void sanitizeConfig(RTDSamplerConfig& c) {
+  c.burstSamples = constrain(c.burstSamples, (uint8_t)4, RTD_BURST_MAX_SAMPLES);
+  c.decimation = constrain(c.decimation, (uint8_t)1, (uint8_t)32);
+  c.burstIntervalMs = constrain(c.burstIntervalMs, (uint16_t)5, (uint16_t)1000);
+  c.rejectFraction = constrain(c.rejectFraction, 0.0f, 0.45f);
+}
+
+// Takes one burst and returns the trimmed mean in ADC counts. Updates burst statistics.
+static float runBurst() {
+  uint16_t samples[RTD_BURST_MAX_SAMPLES];
+  const uint8_t n = samplerConfig.burstSamples;
+
+  unsigned long startUs = micros();
+  for (uint8_t i = 0; i < n; i++) {
+    samples[i] = (uint16_t)analogRead(PIN_RTD);
+  }
+  sortSamples(samples, n);
+
+  uint8_t trim = (uint8_t)(n * samplerConfig.rejectFraction);
+  uint8_t kept = n - 2 * trim;
+
+  float sum = 0.0f;
+  for (uint8_t i = trim; i < n - trim; i++) sum += samples[i];
+  float mean = sum / kept;
+
+  float var = 0.0f;
+  for (uint8_t i = trim; i < n - trim; i++) {
+    float d = samples[i] - mean;
+    var += d * d;
+  }
+  uint32_t elapsedUs = micros() - startUs;
+
+  samplerStats.burstNoise = kept > 1 ? sqrtf(var / (kept - 1)) : 0.0f;
+  samplerStats.lastBurstMin = samples[0];
+  samplerStats.lastBurstMax = samples[n - 1];
+  samplerStats.burstCount++;
+  samplerStats.totalSamples += n;
+  samplerStats.rejectedSamples += 2 * trim;
+  samplerStats.lastBurstMicros = elapsedUs;
+  if (elapsedUs > samplerStats.maxBurstMicros) samplerStats.maxBurstMicros = elapsedUs;
+
+  return mean;
+}
+
+void rtdSamplerInit() {
+  sanitizeConfig(samplerConfig);
+  decimationMean = 0.0f;
+  decimationM2 = 0.0f;
+  decimationCount = 0;
+  haveReading = false;
+  lastBurstMs = millis();
+
+  // Prime the pipeline so the first consumers get an oversampled value
+  samplerStats.rawReading = runBurst();
+  samplerStats.lastOutputMs = millis();
+  haveReading = true;
+
+  if (debugSerial) {
+    Serial.printf("[RTD-SAMPLER] Init: %u samples/burst, decimation %u, %u ms/burst, reject %.2f, first raw %.1f\n",
+                  samplerConfig.burstSamples, samplerConfig.decimation, samplerConfig.burstIntervalMs,
+                  samplerConfig.rejectFraction, samplerStats.rawReading);
+  }
+}
+
+bool rtdSamplerUpdate() {
+  unsigned long nowMs = millis();
+  if (nowMs - lastBurstMs < samplerConfig.burstIntervalMs) return false;
+  lastBurstMs = nowMs;
+
+  float burstMean = runBurst();
+  decimationCount++;
+  float delta = burstMean - decimationMean;
+  decimationMean += delta / decimationCount;
+  decimationM2 += delta * (burstMean - decimationMean);
+
+  if (decimationCount < samplerConfig.decimation) return false;
+
+  float var = decimationCount > 1 ? decimationM2 / (decimationCount - 1) : 0.0f;
+  samplerStats.outputNoise = var > 0.0f ? sqrtf(var) : 0.0f;
+  samplerStats.rawReading = decimationMean;
+  samplerStats.lastOutputMs = nowMs;
+  samplerStats.outputCount++;
+  haveReading = true;
+
+  decimationMean = 0.0f;
+  decimationM2 = 0.0f;
+  decimationCount = 0;
+  return true;
+}
+
+float rtdSamplerAcquireBurst() {
+  return runBurst();
+}
+
+float rtdSamplerGetRaw() {
+  if (!haveReading) {
+    samplerStats.rawReading = runBurst();
+    samplerStats.lastOutputMs = millis();
+    haveReading = true;
+  }
+  return samplerStats.rawReading;
+}
+
+bool rtdSamplerHasReading() {
+  return haveReading;
+}
+
+const RTDSamplerConfig& rtdSamplerGetConfig() {
+  return samplerConfig;
+}
+
+void rtdSamplerConfigure(const RTDSamplerConfig& config) {
+  samplerConfig = config;
+  sanitizeConfig(samplerConfig);
+  // Restart the decimation window so one output never mixes two configurations
+  decimationMean = 0.0f;
+  decimationM2 = 0.0f;
+  decimationCount = 0;
+}
+
+const RTDSamplerStats& rtdSamplerGetStats() {
+  return samplerStats;
+}
+
+void rtdSamplerResetStats() {
+  float raw = samplerStats.rawReading;
+  unsigned long lastOutput = samplerStats.lastOutputMs;
+  samplerStats = RTDSamplerStats();
+  samplerStats.rawReading = raw;
+  samplerStats.lastOutputMs = lastOutput;
+}
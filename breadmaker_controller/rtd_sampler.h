@@ -0,0 +1,49 @@
+#pragma once
+#include <Arduino.h>
+
+// Oversampled RTD acquisition pipeline.
+// Each burst takes burstSamples back-to-back ADC reads, sorts them and discards
+// rejectFraction from each end (median/trimmed-mean rejection of ADC spikes).
+// `decimation` bursts are then averaged into one output reading, so a new
+// low-noise reading is produced every burstIntervalMs * decimation.
+
+constexpr uint8_t RTD_BURST_MAX_SAMPLES = 64;
+
+struct RTDSamplerConfig {
+  uint8_t burstSamples = 16;       // ADC reads per burst (4..RTD_BURST_MAX_SAMPLES)
+  uint8_t decimation = 4;          // Bursts averaged into one output reading (1..32)
+  uint16_t burstIntervalMs = 25;   // Spacing between bursts
+  float rejectFraction = 0.25f;    // Fraction trimmed from each end of a sorted burst (0..0.45)
+};
+
+struct RTDSamplerStats {
+  float rawReading = 0.0f;         // Latest decimated reading in ADC counts (fractional)
+  float burstNoise = 0.0f;         // Std dev of kept samples in the last burst (counts)
+  float outputNoise = 0.0f;        // Std dev of burst means within the last output (counts)
+  uint16_t lastBurstMin = 0;       // Raw min/max of the last burst, before rejection
+  uint16_t lastBurstMax = 0;
+  uint32_t burstCount = 0;
+  uint32_t outputCount = 0;
+  uint32_t totalSamples = 0;
+  uint32_t rejectedSamples = 0;
+  uint32_t lastBurstMicros = 0;    // CPU cost of the last burst
+  uint32_t maxBurstMicros = 0;
+  unsigned long lastOutputMs = 0;  // millis() of the latest decimated reading
+};
+
+void rtdSamplerInit();
+
+// Runs a burst when one is due. Returns true when a new decimated reading is ready.
+bool rtdSamplerUpdate();
+
+// Runs one burst immediately and returns its trimmed mean (used before the pipeline has output).
+float rtdSamplerAcquireBurst();
+
+// Latest decimated reading in ADC counts; falls back to a fresh burst if none exists yet.
+float rtdSamplerGetRaw();
+bool rtdSamplerHasReading();
+
+const RTDSamplerConfig& rtdSamplerGetConfig();
+void rtdSamplerConfigure(const RTDSamplerConfig& config);
+const RTDSamplerStats& rtdSamplerGetStats();
+void rtdSamplerResetStats();
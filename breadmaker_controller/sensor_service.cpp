@@ -0,0 +1,105 @@
+#include "sensor_service.h"
+#include "rtd_sampler.h"
+#include "calibration.h"
+#include "globals.h"
+#include "debug_log.h"
+
+extern bool debugSerial;
+extern void setHeater(bool on);
+
+static SensorReading currentReading;
+
+static unsigned long staleTimeoutMs() {
+  const RTDSamplerConfig& cfg = rtdSamplerGetConfig();
+  unsigned long outputInterval = (unsigned long)cfg.burstIntervalMs * cfg.decimation;
+  return max(SENSOR_STALE_MIN_MS, outputInterval * 3);
+}
+
+// Converts the sampler's latest raw reading and publishes it with a health state
+static void publishReading(float raw, unsigned long timestampMs) {
+  SensorReading next = currentReading;
+  next.rawAdc = raw;
+  next.timestampMs = timestampMs;
+  next.sequence++;
+  next.faultReason = "";
+
+  if (rtdCalibTable.empty()) {
+    next.health = SENSOR_FAULT;
+    next.faultReason = "no calibration";
+  } else if (raw < 0.5f) {
+    // Raw 0 means maximum temperature (RTD resistance drops as it heats), not a wiring fault
+    next.temperature = rtdCalibTable.front().temp;
+    next.health = SENSOR_VALID;
+    if (currentReading.rawAdc >= 0.5f || currentReading.sequence == 0) {
+      LOG_ERROR(LOG_TEMP, "CRITICAL TEMPERATURE ALERT: Raw reading is 0 - EXTREMELY HOT TEMPERATURE DETECTED!\n");
+      LOG_ERROR(LOG_TEMP, "Immediately shutting off heater - reporting maximum calibrated temperature %.1f°C\n", next.temperature);
+    }
+  } else {
+    float temp = tempFromRaw(raw);
+    if (safetySystem.isTemperatureValid(temp)) {
+      next.temperature = temp;
+      next.health = SENSOR_VALID;
+    } else {
+      // Keep the last valid temperature; consumers must check health
+      next.health = SENSOR_FAULT;
+      next.faultReason = "out of range";
+      if (next.consecutiveFaults == 0) {
+        LOG_WARN(LOG_TEMP, "[SENSOR] Fault: %.1f°C from raw %.1f is out of range\n", temp, raw);
+      }
+    }
+  }
+
+  if (next.health == SENSOR_FAULT) {
+    next.faultCount++;
+    if (next.consecutiveFaults < UINT16_MAX) next.consecutiveFaults++;
+  } else {
+    next.consecutiveFaults = 0;
+  }
+
+  currentReading = next;
+
+  // Heater off at the maximum of the scale, independently of the PID and safety loop
+  if (raw < 0.5f) setHeater(false);
+}
+
+void sensorServiceInit() {
+  rtdSamplerInit();
+  const RTDSamplerStats& st = rtdSamplerGetStats();
+  publishReading(st.rawReading, st.lastOutputMs);
+  if (debugSerial) {
+    Serial.printf("[SENSOR] Service initialized: %.2f°C (raw %.1f), health %s\n",
+                  currentReading.temperature, currentReading.rawAdc, sensorHealthName(currentReading.health));
+  }
+}
+
+bool sensorServiceUpdate() {
+  if (!rtdSamplerUpdate()) return false;
+  const RTDSamplerStats& st = rtdSamplerGetStats();
+  publishReading(st.rawReading, st.lastOutputMs);
+  return true;
+}
+
+const SensorReading& sensorGetReading() {
+  if (currentReading.health == SENSOR_VALID && millis() - currentReading.timestampMs > staleTimeoutMs()) {
+    currentReading.health = SENSOR_STALE;
+    LOG_WARN(LOG_TEMP, "[SENSOR] Reading is stale - no new RTD output\n");
+  }
+  return currentReading;
+}
+
+SensorHealth sensorGetHealth() {
+  return sensorGetReading().health;
+}
+
+bool sensorIsValid() {
+  return sensorGetHealth() == SENSOR_VALID;
+}
+
+const char* sensorHealthName(SensorHealth health) {
+  switch (health) {
+    case SENSOR_VALID: return "valid";
+    case SENSOR_STALE: return "stale";
+    case SENSOR_FAULT: return "fault";
+  }
+  return "unknown";
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <Arduino.h>
+
+// Central temperature sensor service.
+// Owns the RTD sampling cadence (drives rtd_sampler), converts each decimated
+// reading through the calibration LUT and classifies its health. Actuators,
+// safety checks and HTTP handlers read the shared reading in O(1) and never
+// touch the ADC themselves.
+
+enum SensorHealth : uint8_t {
+  SENSOR_VALID = 0,   // Fresh reading inside the valid temperature range
+  SENSOR_STALE = 1,   // No new reading within the stale timeout
+  SENSOR_FAULT = 2    // Reading out of range or no calibration loaded
+};
+
+struct SensorReading {
+  float temperature = 0.0f;        // Calibrated, unsmoothed °C (last valid value while faulted)
+  float rawAdc = 0.0f;             // Decimated ADC counts (fractional)
+  unsigned long timestampMs = 0;   // millis() when the reading was produced
+  uint32_t sequence = 0;           // Increments with every new reading
+  SensorHealth health = SENSOR_STALE;
+  const char* faultReason = "";    // Static string, empty unless health == SENSOR_FAULT
+  uint32_t faultCount = 0;         // Total faulty readings since boot
+  uint16_t consecutiveFaults = 0;
+};
+
+constexpr unsigned long SENSOR_STALE_MIN_MS = 2000;  // Stale timeout floor (3x output interval if longer)
+
+void sensorServiceInit();
+
+// Call every loop; returns true when a new reading was published.
+bool sensorServiceUpdate();
+
+// Latest reading. health is re-evaluated for staleness on every call.
+const SensorReading& sensorGetReading();
+SensorHealth sensorGetHealth();
+bool sensorIsValid();
+const char* sensorHealthName(SensorHealth health);
@@ -1,8 +1,34 @@
 #ifdef NATIVE_SIMULATION
 
 #include "arduino_simulation.h"
+#include "../rtd_sampler.h"
+#include "../heater_timer.h"
+#include "../enhanced_motor_control.h"
+#include "../control_task.h"
+#include "../control_commands.h"
+#include "../background_jobs.h"
+#include "../storage_backend.h"
+#include "../storage_bench.h"
+#include "../web_routes.h"
+#include "../web_endpoints.h"
+#include "../file_transfer.h"
+#include "../storage_stats.h"
+#include "http_load.h"
 #include <cstdarg>
 #include <cstring>
+#include <vector>
+#include <filesystem>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
 
 // Global simulation variables
 unsigned long simulated_millis = 0;
@@ -15,11 +41,876 @@ std::map<int, int> pin_modes;
 WiFiClass WiFi;
 FFatClass FFat;
 SerialClass Serial;
+SimulatedADCModel simulated_adc;
+SimulatedFlashModel simulated_flash;
+SimulatedNetworkModel simulated_network;
 
 // Temperature sensor statics
 double SimulatedTemperatureSensor::room_temperature = 20.0;
 double SimulatedTemperatureSensor::target_temperature = 20.0;
 
+// ===== Hardware Timer Model =====
+static void simTimerWorker(hw_timer_t* timer) {
+    using clock = std::chrono::steady_clock;
+    auto deadline = clock::now();
+    bool wasEnabled = false;
+    while (timer->running) {
+        if (!timer->enabled || timer->alarmTicks == 0 || !timer->isr) {
+            wasEnabled = false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        // Timer ticks at 80 MHz / divider; convert the alarm to real time under acceleration
+        double periodUs = timer->alarmTicks * (timer->divider / 80.0) / time_acceleration_factor;
+        auto period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double, std::micro>(periodUs));
+        if (!wasEnabled) deadline = clock::now();
+        wasEnabled = true;
+        deadline += period;
+        std::this_thread::sleep_until(deadline);
+        int64_t late = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - deadline).count();
+        if (late > timer->maxLatenessUs) timer->maxLatenessUs = late;
+        if (late > 10 * periodUs) deadline = clock::now();  // Host stalled; don't fire a burst to catch up
+        timer->isr();
+        timer->fired++;
+        if (!timer->autoreload) timer->enabled = false;
+    }
+}
+
+hw_timer_t* timerBegin(uint8_t num, uint16_t divider, bool countUp) {
+    hw_timer_t* timer = new hw_timer_t();
+    timer->num = num;
+    timer->divider = divider;
+    timer->worker = std::thread(simTimerWorker, timer);
+    std::cout << "[SIM] Hardware timer " << (int)num << " started (divider " << divider << ")" << std::endl;
+    return timer;
+}
+
+void timerAttachInterrupt(hw_timer_t* timer, void (*isr)(), bool edge) { timer->isr = isr; }
+void timerAlarmWrite(hw_timer_t* timer, uint64_t alarmValue, bool autoreload) {
+    timer->alarmTicks = alarmValue;
+    timer->autoreload = autoreload;
+}
+void timerAlarmEnable(hw_timer_t* timer) { timer->enabled = true; }
+void timerAlarmDisable(hw_timer_t* timer) { timer->enabled = false; }
+void timerEnd(hw_timer_t* timer) {
+    timer->running = false;
+    if (timer->worker.joinable()) timer->worker.join();
+    delete timer;
+}
+
+// ===== Socket WebServer =====
+SimSocket::~SimSocket() {
+    if (fd >= 0) ::close(fd);
+}
+
+uint8_t WiFiClient::connected() {
+    if (!sock_ || sock_->fd < 0) return 0;
+    char c;
+    ssize_t n = recv(sock_->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (n > 0) return 1;
+    if (n == 0) {
+        // Closed, but the FIN is still on its way back over the modelled link
+        auto rtt = std::chrono::microseconds(simulated_network.rttUs);
+        return std::chrono::steady_clock::now() - sock_->lastWrite < rtt ? 1 : 0;
+    }
+    return (errno == EAGAIN || errno == EWOULDBLOCK) ? 1 : 0;
+}
+
+size_t WiFiClient::write(const uint8_t* buf, size_t size) {
+    if (!sock_ || sock_->fd < 0) return 0;
+    size_t sent = 0;
+    while (sent < size) {
+        ssize_t n = send(sock_->fd, buf + sent, size - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;   // Peer gone or send timeout
+        sent += n;
+    }
+    sock_->lastWrite = std::chrono::steady_clock::now();
+    return sent;
+}
+
+int WiFiClient::available() {
+    if (!sock_ || sock_->fd < 0) return 0;
+    char buf[1024];
+    ssize_t n = recv(sock_->fd, buf, sizeof(buf), MSG_PEEK | MSG_DONTWAIT);
+    return n > 0 ? (int)n : 0;
+}
+
+int WiFiClient::read(uint8_t* buf, size_t size) {
+    if (!sock_ || sock_->fd < 0) return -1;
+    ssize_t n = recv(sock_->fd, buf, size, MSG_DONTWAIT);
+    return n < 0 ? -1 : (int)n;
+}
+
+int WiFiClient::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+static std::string urlDecode(const std::string& in) {
+    std::string out;
+    out.reserve(in.size());
+    for (size_t i = 0; i < in.size(); i++) {
+        if (in[i] == '+') {
+            out += ' ';
+        } else if (in[i] == '%' && i + 2 < in.size() && isxdigit((unsigned char)in[i + 1]) && isxdigit((unsigned char)in[i + 2])) {
+            out += (char)strtol(in.substr(i + 1, 2).c_str(), nullptr, 16);
+            i += 2;
+        } else {
+            out += in[i];
+        }
+    }
+    return out;
+}
+
+static bool equalsIgnoreCase(const std::string& a, const std::string& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(),
+        [](char x, char y) { return tolower((unsigned char)x) == tolower((unsigned char)y); });
+}
+
+static const char* statusText(int code) {
+    switch (code) {
+        case 200: return "OK";
+        case 201: return "Created";
+        case 204: return "No Content";
+        case 301: return "Moved Permanently";
+        case 302: return "Found";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 409: return "Conflict";
+        case 413: return "Payload Too Large";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default: return "";
+    }
+}
+
+static HTTPMethod parseMethod(const std::string& m) {
+    if (m == "GET") return HTTP_GET;
+    if (m == "HEAD") return HTTP_HEAD;
+    if (m == "POST") return HTTP_POST;
+    if (m == "PUT") return HTTP_PUT;
+    if (m == "PATCH") return HTTP_PATCH;
+    if (m == "DELETE") return HTTP_DELETE;
+    if (m == "OPTIONS") return HTTP_OPTIONS;
+    return HTTP_ANY;
+}
+
+void WiFiServer::begin() {
+    if (fd_ >= 0) return;
+    fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons((uint16_t)port_);
+    if (bind(fd_, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd_, 16) != 0) {
+        std::cout << "[SIM] Web server: cannot listen on port " << port_ << ": " << strerror(errno) << std::endl;
+        ::close(fd_);
+        fd_ = -1;
+        return;
+    }
+    fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_NONBLOCK);
+    std::cout << "[SIM] Web server listening on http://127.0.0.1:" << port_ << std::endl;
+}
+
+// Takes the connections the kernel has completed, up to the listen backlog; each
+// becomes available one modelled RTT later
+void WiFiServer::acceptPending() {
+    while (pending_.size() < 16) {
+        int fd = ::accept(fd_, nullptr, nullptr);
+        if (fd < 0) return;
+        timeval timeout = { HTTP_MAX_DATA_WAIT / 1000, 0 };
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        pending_.push_back({ fd, std::chrono::steady_clock::now() + std::chrono::microseconds(simulated_network.rttUs) });
+    }
+}
+
+WiFiClient WiFiServer::available() {
+    if (fd_ < 0) return WiFiClient();
+    acceptPending();
+    if (pending_.empty() || pending_.front().second > std::chrono::steady_clock::now()) return WiFiClient();
+    int fd = pending_.front().first;
+    pending_.pop_front();
+    return WiFiClient(fd);
+}
+
+bool WiFiServer::hasClient() {
+    if (fd_ < 0) return false;
+    acceptPending();
+    return !pending_.empty() && pending_.front().second <= std::chrono::steady_clock::now();
+}
+
+void WiFiServer::close() {
+    for (auto& p : pending_) ::close(p.first);
+    pending_.clear();
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+}
+
+static int simHttpPort(int port) {
+    const char* env = getenv("SIM_HTTP_PORT");
+    return env && env[0] ? atoi(env) : (port < 1024 ? port + 8000 : port);
+}
+
+WebServer::WebServer(int port) : _server(simHttpPort(port)) {}
+
+WebServer::~WebServer() {
+    close();
+}
+
+void WebServer::begin() {
+    _server.begin();
+}
+
+void WebServer::close() {
+    _server.close();
+}
+
+// What on() registers, as in the ESP32 core (detail/RequestHandlersImpl.h)
+class FunctionRequestHandler : public RequestHandler {
+public:
+    FunctionRequestHandler(const String& uri, HTTPMethod method, WebServer::THandlerFunction fn, WebServer::THandlerFunction ufn)
+        : uri_(uri.c_str()), method_(method), fn_(fn), ufn_(ufn) {}
+    bool canHandle(HTTPMethod method, String uri) override {
+        return (method_ == HTTP_ANY || method_ == method) && uri_ == uri.c_str();
+    }
+    bool canUpload(String uri) override { return ufn_ && uri_ == uri.c_str(); }
+    bool handle(WebServer& server, HTTPMethod requestMethod, String requestUri) override {
+        if (!canHandle(requestMethod, requestUri)) return false;
+        fn_();
+        return true;
+    }
+    void upload(WebServer& server, String requestUri, HTTPUpload& upload) override {
+        if (canUpload(requestUri)) ufn_();
+    }
+
+private:
+    std::string uri_;
+    HTTPMethod method_;
+    WebServer::THandlerFunction fn_;
+    WebServer::THandlerFunction ufn_;
+};
+
+void WebServer::on(const String& uri, HTTPMethod method, THandlerFunction handler, THandlerFunction uploadHandler) {
+    ownedHandlers_.emplace_back(new FunctionRequestHandler(uri, method, handler, uploadHandler));
+    handlers_.push_back(ownedHandlers_.back().get());
+}
+
+// Reads the head and a Content-Length body, waiting up to HTTP_MAX_DATA_WAIT. Only
+// this request's bytes are consumed (the head is peeked for its end), so the next
+// request of a keep-alive client stays queued in the socket, as with the core's
+// line-by-line reads.
+bool WebServer::readRequest(WiFiClient& client, std::string& head, std::string& body) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(HTTP_MAX_DATA_WAIT);
+    auto waitData = [&]() {
+        int remaining = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        pollfd pfd = { client.fd(), POLLIN, 0 };
+        return remaining > 0 && poll(&pfd, 1, remaining) > 0;
+    };
+    char buf[4096];
+    std::string data;
+    for (;;) {
+        if (!waitData()) return false;
+        ssize_t n = recv(client.fd(), buf, sizeof(buf), MSG_PEEK | MSG_DONTWAIT);
+        if (n <= 0) return false;
+        size_t from = data.size() > 3 ? data.size() - 3 : 0;
+        size_t consumed = data.size();
+        data.append(buf, n);
+        size_t headEnd = data.find("\r\n\r\n", from);
+        size_t take = headEnd == std::string::npos ? (size_t)n : headEnd + 4 - consumed;
+        if (recv(client.fd(), buf, take, 0) != (ssize_t)take) return false;
+        if (headEnd != std::string::npos) {
+            head = data.substr(0, headEnd);
+            break;
+        }
+        if (data.size() > 16384) return false;  // Runaway head
+    }
+    std::string lower = head;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    size_t cl = lower.find("\r\ncontent-length:");
+    size_t need = cl == std::string::npos ? 0 : strtoul(head.c_str() + cl + 17, nullptr, 10);
+    body.clear();
+    while (body.size() < need) {
+        if (!waitData()) return false;
+        ssize_t n = recv(client.fd(), buf, std::min(sizeof(buf), need - body.size()), 0);
+        if (n <= 0) return false;
+        body.append(buf, n);
+    }
+    return true;
+}
+
+void WebServer::parseArguments(const std::string& query) {
+    size_t pos = 0;
+    while (pos < query.size()) {
+        size_t amp = query.find('&', pos);
+        if (amp == std::string::npos) amp = query.size();
+        std::string pair = query.substr(pos, amp - pos);
+        if (!pair.empty()) {
+            size_t eq = pair.find('=');
+            if (eq == std::string::npos) args_.push_back({ urlDecode(pair), "" });
+            else args_.push_back({ urlDecode(pair.substr(0, eq)), urlDecode(pair.substr(eq + 1)) });
+        }
+        pos = amp + 1;
+    }
+}
+
+// File parts go to the upload handler in HTTP_UPLOAD_BUFLEN pieces, other fields become args
+void WebServer::parseMultipart(const std::string& body, const std::string& boundary, RequestHandler* handler) {
+    bool routeUpload = handler && handler->canUpload(uri());
+    auto uploadHandler = [&]() {
+        if (routeUpload) handler->upload(*this, uri(), upload_);
+        else fileUpload_();
+    };
+    std::string delimiter = "--" + boundary;
+    size_t pos = body.find(delimiter);
+    while (pos != std::string::npos) {
+        pos += delimiter.size();
+        if (body.compare(pos, 2, "--") == 0) break;
+        pos += 2;  // CRLF
+        size_t partHeadEnd = body.find("\r\n\r\n", pos);
+        if (partHeadEnd == std::string::npos) break;
+        std::string partHead = body.substr(pos, partHeadEnd - pos);
+        size_t dataStart = partHeadEnd + 4;
+        size_t next = body.find("\r\n" + delimiter, dataStart);
+        if (next == std::string::npos) break;
+        std::string name, filename, type;
+        size_t n = partHead.find("name=\"");
+        if (n != std::string::npos) name = partHead.substr(n + 6, partHead.find('"', n + 6) - n - 6);
+        size_t f = partHead.find("filename=\"");
+        if (f != std::string::npos) filename = partHead.substr(f + 10, partHead.find('"', f + 10) - f - 10);
+        size_t t = partHead.find("Content-Type:");
+        if (t != std::string::npos) {
+            size_t end = partHead.find("\r\n", t);
+            type = partHead.substr(t + 14, (end == std::string::npos ? partHead.size() : end) - t - 14);
+        }
+        if (f == std::string::npos) {
+            args_.push_back({ name, body.substr(dataStart, next - dataStart) });
+        } else if (routeUpload || fileUpload_) {
+            upload_.filename = String(filename.c_str());
+            upload_.name = String(name.c_str());
+            upload_.type = String(type.c_str());
+            upload_.totalSize = 0;
+            upload_.currentSize = 0;
+            upload_.status = UPLOAD_FILE_START;
+            uploadHandler();
+            for (size_t off = dataStart; off < next; off += HTTP_UPLOAD_BUFLEN) {
+                upload_.currentSize = std::min<size_t>(HTTP_UPLOAD_BUFLEN, next - off);
+                memcpy(upload_.buf, body.data() + off, upload_.currentSize);
+                upload_.totalSize += upload_.currentSize;
+                upload_.status = UPLOAD_FILE_WRITE;
+                uploadHandler();
+            }
+            upload_.currentSize = 0;
+            upload_.status = UPLOAD_FILE_END;
+            uploadHandler();
+        }
+        pos = next + 2;
+    }
+}
+
+// The core's loop: one connection at a time, at most one request per call
+void WebServer::handleClient() {
+    if (_currentStatus == HC_NONE) {
+        WiFiClient client = _server.available();
+        if (!client) return;
+        _currentClient = client;
+        _currentStatus = HC_WAIT_READ;
+        _statusChange = millis();
+    }
+    bool keepCurrentClient = false;
+    if (_currentClient.connected()) {
+        switch (_currentStatus) {
+            case HC_NONE:
+                break;
+            case HC_WAIT_READ:
+                if (_currentClient.available()) {
+                    if (_parseRequest(_currentClient)) {
+                        _contentLength = CONTENT_LENGTH_NOT_SET;
+                        _handleRequest();
+                        if (_currentClient.connected()) {
+                            _currentStatus = HC_WAIT_CLOSE;
+                            _statusChange = millis();
+                            keepCurrentClient = true;
+                        }
+                    }
+                } else if (millis() - _statusChange <= HTTP_MAX_DATA_WAIT) {
+                    keepCurrentClient = true;
+                }
+                break;
+            case HC_WAIT_CLOSE:
+                if (millis() - _statusChange <= HTTP_MAX_CLOSE_WAIT) keepCurrentClient = true;
+                break;
+        }
+    }
+    if (!keepCurrentClient) {
+        _currentClient = WiFiClient();  // A transfer slot may still hold a copy
+        _currentStatus = HC_NONE;
+    }
+}
+
+// Reads one request from the client: target, args, headers and body. Upload
+// handlers run from here, as in the core, before the route's handler.
+bool WebServer::_parseRequest(WiFiClient& client) {
+    args_.clear();
+    headers_.clear();
+    responseHeaders_.clear();
+    currentHandler_ = nullptr;
+    _chunked = false;
+
+    std::string head, body;
+    if (!readRequest(client, head, body)) return false;
+    size_t lineEnd = head.find("\r\n");
+    std::string requestLine = head.substr(0, lineEnd);
+    size_t sp1 = requestLine.find(' '), sp2 = requestLine.rfind(' ');
+    if (sp1 == std::string::npos || sp2 <= sp1) return false;
+    method_ = parseMethod(requestLine.substr(0, sp1));
+    std::string target = requestLine.substr(sp1 + 1, sp2 - sp1 - 1);
+    std::string version = requestLine.substr(sp2 + 1);
+    _currentVersion = version.compare(0, 7, "HTTP/1.") == 0 ? (uint8_t)atoi(version.c_str() + 7) : 0;
+    size_t q = target.find('?');
+    uri_ = urlDecode(target.substr(0, q));
+    if (q != std::string::npos) parseArguments(target.substr(q + 1));
+
+    size_t pos = lineEnd == std::string::npos ? head.size() : lineEnd + 2;
+    while (pos < head.size()) {
+        size_t end = head.find("\r\n", pos);
+        if (end == std::string::npos) end = head.size();
+        std::string line = head.substr(pos, end - pos);
+        size_t colon = line.find(':');
+        if (colon != std::string::npos) {
+            size_t v = line.find_first_not_of(' ', colon + 1);
+            headers_.push_back({ line.substr(0, colon), v == std::string::npos ? "" : line.substr(v) });
+        }
+        pos = end + 2;
+    }
+
+    for (RequestHandler* h : handlers_) {
+        if (h->canHandle(method_, uri())) { currentHandler_ = h; break; }
+    }
+
+    std::string contentType = header("Content-Type").c_str();
+    if (contentType.find("multipart/form-data") != std::string::npos) {
+        size_t b = contentType.find("boundary=");
+        if (b != std::string::npos) parseMultipart(body, contentType.substr(b + 9), currentHandler_);
+    } else if (!body.empty()) {
+        bool encoded = contentType.find("application/x-www-form-urlencoded") != std::string::npos;
+        parseArguments(encoded ? body : std::string());
+        if (!encoded) args_.push_back({ "plain", body });
+    }
+    return true;
+}
+
+void WebServer::_handleRequest() {
+    bool handled = currentHandler_ && currentHandler_->handle(*this, method_, uri());
+    if (!handled && notFound_) {
+        notFound_();
+        handled = true;
+    }
+    if (!handled) send(404, "text/plain", String(("Not found: " + uri_).c_str()));
+    _finalizeResponse();
+    uri_.clear();
+}
+
+// Terminates a chunked response the handler left open
+void WebServer::_finalizeResponse() {
+    if (_chunked) sendContent("", 0);
+}
+
+String WebServer::arg(const String& name) const {
+    for (const auto& a : args_) if (a.first == name.c_str()) return String(a.second.c_str());
+    return String("");
+}
+
+String WebServer::arg(int i) const {
+    return i >= 0 && i < (int)args_.size() ? String(args_[i].second.c_str()) : String("");
+}
+
+String WebServer::argName(int i) const {
+    return i >= 0 && i < (int)args_.size() ? String(args_[i].first.c_str()) : String("");
+}
+
+bool WebServer::hasArg(const String& name) const {
+    for (const auto& a : args_) if (a.first == name.c_str()) return true;
+    return false;
+}
+
+String WebServer::header(const String& name) const {
+    for (const auto& h : headers_) if (equalsIgnoreCase(h.first, name.c_str())) return String(h.second.c_str());
+    return String("");
+}
+
+bool WebServer::hasHeader(const String& name) const {
+    for (const auto& h : headers_) if (equalsIgnoreCase(h.first, name.c_str())) return true;
+    return false;
+}
+
+void WebServer::sendHeader(const String& name, const String& value, bool first) {
+    std::string line = std::string(name.c_str()) + ": " + value.c_str() + "\r\n";
+    responseHeaders_ = first ? line + responseHeaders_ : responseHeaders_ + line;
+}
+
+size_t WebServer::_currentClientWrite(const char* b, size_t l) {
+    return l ? _currentClient.write((const uint8_t*)b, l) : 0;
+}
+
+void WebServer::send(int code, const char* contentType, const char* content) {
+    size_t length = strlen(content);
+    std::string response = "HTTP/1." + std::to_string(_currentVersion) + " " + std::to_string(code) + " " + statusText(code) + "\r\n";
+    response += std::string("Content-Type: ") + (contentType ? contentType : "text/html") + "\r\n";
+    if (_contentLength != CONTENT_LENGTH_UNKNOWN) {
+        size_t declared = _contentLength == CONTENT_LENGTH_NOT_SET ? length : _contentLength;
+        response += "Content-Length: " + std::to_string(declared) + "\r\n";
+    } else if (_currentVersion) {
+        // HTTP/1.1: chunked. An HTTP/1.0 client reads until close instead.
+        _chunked = true;
+        response += "Accept-Ranges: none\r\nTransfer-Encoding: chunked\r\n";
+    }
+    response += responseHeaders_;
+    response += "Connection: close\r\n\r\n";
+    responseHeaders_.clear();
+    _contentLength = CONTENT_LENGTH_NOT_SET;
+    _currentClientWrite(response.data(), response.size());
+    if (length) sendContent(content, length);
+}
+
+void WebServer::send(int code, const char* contentType, const String& content) {
+    send(code, contentType, content.c_str());
+}
+
+void WebServer::sendContent(const char* content, size_t length) {
+    if (_chunked) {
+        char size[16];
+        snprintf(size, sizeof(size), "%zx\r\n", length);
+        std::string chunk = size;
+        chunk.append(content, length);
+        chunk += "\r\n";
+        _currentClientWrite(chunk.data(), chunk.size());
+        if (length == 0) _chunked = false;
+        return;
+    }
+    _currentClientWrite(content, length);
+}
+
+// ===== Host-Directory Filesystem =====
+namespace hostfs = std::filesystem;
+static constexpr size_t SIM_SECTOR_SIZE = 4096;
+
+struct SimFileImpl {
+    std::string path;             // Path on the simulated FS ("/programs/program_1.json")
+    std::string hostPath;
+    std::string name;             // Last path component
+    FILE* fp = nullptr;
+    bool open = false;
+    bool directory = false;
+    bool writable = false;
+    bool appendMode = false;
+    bool written = false;
+    bool truncated = false;       // "w" on an existing, non-empty file
+    size_t startSize = 0;
+    long bufferedSector = -1;     // Sector held in FatFs's per-file buffer
+    bool bufferDirty = false;
+    std::vector<std::string> entries;
+    size_t nextEntry = 0;
+
+    ~SimFileImpl() { close(); }
+
+    size_t fileSize() const {
+        if (!fp) return 0;
+        long cur = ftell(fp);
+        fseek(fp, 0, SEEK_END);
+        long end = ftell(fp);
+        fseek(fp, cur, SEEK_SET);
+        return end < 0 ? 0 : (size_t)end;
+    }
+
+    void flushBuffer() {
+        if (!bufferDirty) return;
+        simulated_flash.chargeSectorWrite();
+        bufferDirty = false;
+    }
+
+    // Moves the sector buffer across [pos, pos + len): a sector leaving the buffer is
+    // programmed if dirty, a sector entering it is read unless it is being written
+    void touch(size_t pos, size_t len, bool write) {
+        if (len == 0) return;
+        long first = (long)(pos / SIM_SECTOR_SIZE);
+        long last = (long)((pos + len - 1) / SIM_SECTOR_SIZE);
+        for (long sector = first; sector <= last; sector++) {
+            if (sector != bufferedSector) {
+                flushBuffer();
+                if (!write) simulated_flash.chargeRead(1);
+                bufferedSector = sector;
+            }
+            if (write) bufferDirty = true;
+        }
+    }
+
+    void close() {
+        if (!open) return;
+        open = false;
+        if (!fp) return;
+        flushBuffer();
+        if (written) {
+            size_t endSize = fileSize();
+            simulated_flash.chargeSectorWrite();  // Directory entry (size, timestamp)
+            size_t oldClusters = (startSize + SIM_SECTOR_SIZE - 1) / SIM_SECTOR_SIZE;
+            size_t newClusters = (endSize + SIM_SECTOR_SIZE - 1) / SIM_SECTOR_SIZE;
+            if (truncated || newClusters > oldClusters) simulated_flash.chargeSectorWrite();  // FAT
+        }
+        fclose(fp);
+        fp = nullptr;
+    }
+};
+
+File::operator bool() const { return impl_ && impl_->open; }
+
+size_t File::write(const uint8_t* buf, size_t size) {
+    if (!impl_ || !impl_->open || !impl_->fp || !impl_->writable || size == 0) return 0;
+    size_t pos = impl_->appendMode ? impl_->fileSize() : (size_t)ftell(impl_->fp);
+    impl_->touch(pos, size, true);
+    size_t n = fwrite(buf, 1, size, impl_->fp);
+    impl_->written = impl_->written || n > 0;
+    simulated_flash.bytesWritten += n;
+    return n;
+}
+
+size_t File::print(const String& str) { return write(str.c_str()); }
+
+int File::available() {
+    if (!impl_ || !impl_->open || !impl_->fp) return 0;
+    long pos = ftell(impl_->fp);
+    size_t size = impl_->fileSize();
+    return pos >= 0 && (size_t)pos < size ? (int)(size - pos) : 0;
+}
+
+size_t File::read(uint8_t* buf, size_t size) {
+    if (!impl_ || !impl_->open || !impl_->fp) return 0;
+    long pos = ftell(impl_->fp);
+    size_t n = fread(buf, 1, size, impl_->fp);
+    if (pos >= 0) impl_->touch((size_t)pos, n, false);
+    simulated_flash.bytesRead += n;
+    return n;
+}
+
+int File::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::peek() {
+    if (!impl_ || !impl_->open || !impl_->fp) return -1;
+    int c = fgetc(impl_->fp);
+    if (c != EOF) ungetc(c, impl_->fp);
+    return c == EOF ? -1 : c;
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+    if (!impl_ || !impl_->open || !impl_->fp) return false;
+    int whence = mode == SeekCur ? SEEK_CUR : (mode == SeekEnd ? SEEK_END : SEEK_SET);
+    return fseek(impl_->fp, (long)pos, whence) == 0;
+}
+
+size_t File::position() const {
+    if (!impl_ || !impl_->open || !impl_->fp) return 0;
+    long pos = ftell(impl_->fp);
+    return pos < 0 ? 0 : (size_t)pos;
+}
+
+size_t File::size() const {
+    if (!impl_ || !impl_->open) return 0;
+    return impl_->fileSize();
+}
+
+void File::flush() {
+    if (!impl_ || !impl_->open || !impl_->fp) return;
+    fflush(impl_->fp);
+    impl_->flushBuffer();
+}
+
+void File::close() {
+    if (impl_) impl_->close();
+}
+
+const char* File::name() const { return impl_ ? impl_->name.c_str() : ""; }
+const char* File::path() const { return impl_ ? impl_->path.c_str() : ""; }
+bool File::isDirectory() const { return impl_ && impl_->open && impl_->directory; }
+
+File File::openNextFile(const char* mode) {
+    if (!isDirectory()) return File();
+    while (impl_->nextEntry < impl_->entries.size()) {
+        const std::string& entry = impl_->entries[impl_->nextEntry++];
+        std::string child = impl_->path == "/" ? "/" + entry : impl_->path + "/" + entry;
+        File f = FFat.open(child.c_str(), mode);
+        if (f) return f;
+    }
+    return File();
+}
+
+void File::rewindDirectory() {
+    if (impl_) impl_->nextEntry = 0;
+}
+
+time_t File::getLastWrite() {
+    struct stat st;
+    if (!impl_ || stat(impl_->hostPath.c_str(), &st) != 0) return 0;
+    return st.st_mtime;
+}
+
+std::string FFatClass::hostPath(const char* path) const {
+    std::string p = path ? path : "";
+    while (p.size() > 1 && p.back() == '/') p.pop_back();
+    return p == "/" ? root_ : root_ + p;
+}
+
+bool FFatClass::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+    if (mounted_) return true;
+    const char* root = getenv("SIM_FS_ROOT");
+    const char* seed = getenv("SIM_FS_SEED");
+    root_ = root && root[0] ? root : "sim_fs";
+    std::string seedDir = seed && seed[0] ? seed : "data";
+    std::error_code ec;
+    if (!hostfs::exists(root_, ec)) {
+        hostfs::create_directories(root_, ec);
+        if (ec) {
+            std::cout << "[SIM] FFat: cannot create " << root_ << ": " << ec.message() << std::endl;
+            return false;
+        }
+        if (hostfs::is_directory(seedDir, ec)) {
+            hostfs::copy(seedDir, root_, hostfs::copy_options::recursive, ec);
+            std::cout << "[SIM] FFat: seeded " << root_ << " from " << seedDir
+                      << (ec ? " (" + ec.message() + ")" : std::string()) << std::endl;
+        }
+    }
+    mounted_ = true;
+    std::cout << "[SIM] FFat file system on host directory " << root_ << std::endl;
+    return true;
+}
+
+bool FFatClass::format() {
+    if (!mounted_) return false;
+    std::error_code ec;
+    for (const auto& entry : hostfs::directory_iterator(root_, ec)) hostfs::remove_all(entry.path(), ec);
+    return !ec;
+}
+
+File FFatClass::open(const char* path, const char* mode, bool create) {
+    if (!mounted_ || !path || path[0] != '/' || !mode || !mode[0]) return File();
+    simulated_flash.chargeOpen();
+    std::string host = hostPath(path);
+    std::error_code ec;
+    auto impl = std::make_shared<SimFileImpl>();
+    impl->path = path;
+    while (impl->path.size() > 1 && impl->path.back() == '/') impl->path.pop_back();
+    size_t slash = impl->path.find_last_of('/');
+    impl->name = impl->path == "/" ? "/" : impl->path.substr(slash + 1);
+    impl->hostPath = host;
+
+    if (hostfs::is_directory(host, ec)) {
+        if (mode[0] != 'r') return File();
+        impl->directory = true;
+        for (const auto& entry : hostfs::directory_iterator(host, ec)) {
+            impl->entries.push_back(entry.path().filename().string());
+        }
+        std::sort(impl->entries.begin(), impl->entries.end());  // Host order is arbitrary
+        impl->open = true;
+        return File(impl);
+    }
+
+    bool exists = hostfs::is_regular_file(host, ec);
+    if (mode[0] == 'r' && !exists) return File();
+    if (mode[0] != 'r') {
+        hostfs::path parent = hostfs::path(host).parent_path();
+        if (!hostfs::is_directory(parent, ec)) {
+            if (!create) return File();
+            hostfs::create_directories(parent, ec);
+        }
+        impl->startSize = exists ? (size_t)hostfs::file_size(host, ec) : 0;
+        impl->truncated = mode[0] == 'w' && impl->startSize > 0;
+        impl->written = !exists || impl->truncated;  // Creating or truncating rewrites the entry
+    }
+    std::string hostMode(1, mode[0]);
+    if (strchr(mode, '+')) hostMode += '+';
+    hostMode += 'b';
+    impl->fp = fopen(host.c_str(), hostMode.c_str());
+    if (!impl->fp) return File();
+    impl->writable = mode[0] != 'r' || strchr(mode, '+') != nullptr;
+    impl->appendMode = mode[0] == 'a';
+    impl->open = true;
+    return File(impl);
+}
+
+bool FFatClass::exists(const char* path) {
+    if (!mounted_ || !path) return false;
+    simulated_flash.chargeOpen();  // The device's exists() is an open + close
+    std::error_code ec;
+    return hostfs::exists(hostPath(path), ec);
+}
+
+bool FFatClass::remove(const char* path) {
+    if (!mounted_ || !path) return false;
+    std::string host = hostPath(path);
+    std::error_code ec;
+    if (!hostfs::is_regular_file(host, ec)) return false;
+    bool hadData = hostfs::file_size(host, ec) > 0;
+    if (!hostfs::remove(host, ec)) return false;
+    simulated_flash.chargeSectorWrite();                // Directory entry
+    if (hadData) simulated_flash.chargeSectorWrite();   // FAT chain freed
+    return true;
+}
+
+bool FFatClass::rename(const char* from, const char* to) {
+    if (!mounted_ || !from || !to) return false;
+    std::string src = hostPath(from), dst = hostPath(to);
+    std::error_code ec;
+    if (!hostfs::exists(src, ec) || hostfs::exists(dst, ec)) return false;
+    hostfs::rename(src, dst, ec);
+    if (ec) return false;
+    simulated_flash.chargeSectorWrite();
+    if (hostfs::path(src).parent_path() != hostfs::path(dst).parent_path()) simulated_flash.chargeSectorWrite();
+    return true;
+}
+
+bool FFatClass::mkdir(const char* path) {
+    if (!mounted_ || !path) return false;
+    std::error_code ec;
+    if (!hostfs::create_directory(hostPath(path), ec)) return false;
+    simulated_flash.chargeSectorWrite();  // Parent's directory entry
+    simulated_flash.chargeSectorWrite();  // New directory cluster
+    simulated_flash.chargeSectorWrite();  // FAT
+    return true;
+}
+
+bool FFatClass::rmdir(const char* path) {
+    if (!mounted_ || !path) return false;
+    std::string host = hostPath(path);
+    std::error_code ec;
+    if (host == root_ || !hostfs::is_directory(host, ec) || !hostfs::is_empty(host, ec)) return false;
+    if (!hostfs::remove(host, ec)) return false;
+    simulated_flash.chargeSectorWrite();
+    simulated_flash.chargeSectorWrite();
+    return true;
+}
+
+size_t FFatClass::usedBytes() {
+    if (!mounted_) return 0;
+    size_t used = 0;
+    std::error_code ec;
+    for (auto it = hostfs::recursive_directory_iterator(root_, ec); it != hostfs::recursive_directory_iterator(); it.increment(ec)) {
+        if (ec) break;
+        size_t size = it->is_regular_file(ec) ? (size_t)it->file_size(ec) : SIM_SECTOR_SIZE;
+        used += (size + SIM_SECTOR_SIZE - 1) / SIM_SECTOR_SIZE * SIM_SECTOR_SIZE;
+    }
+    return used;
+}
+
 // Simulation control functions
 namespace Simulation {
     void setTimeAcceleration(double factor) {
@@ -48,6 +939,478 @@ namespace Simulation {
                   << "Motor: " << (motor ? "ON" : "OFF") << std::endl;
     }
     
+    void setADCNoise(double stdDevCounts, double spikeProbability, double spikeAmplitude) {
+        simulated_adc.noiseStdDevCounts = stdDevCounts;
+        simulated_adc.spikeProbability = spikeProbability;
+        simulated_adc.spikeAmplitude = spikeAmplitude;
+        std::cout << "[SIM] ADC noise: sigma=" << stdDevCounts << " counts, spikes p=" << spikeProbability
+                  << " amp=" << spikeAmplitude << std::endl;
+    }
+    
+    void setFlashTiming(uint32_t openUs, uint32_t programUsPerSector, uint32_t eraseUs,
+                        uint32_t eraseStallEvery, uint32_t eraseStallUs) {
+        simulated_flash.openUs = openUs;
+        simulated_flash.programUsPerSector = programUsPerSector;
+        simulated_flash.eraseUs = eraseUs;
+        simulated_flash.eraseStallEvery = eraseStallEvery;
+        simulated_flash.eraseStallUs = eraseStallUs;
+        std::cout << "[SIM] Flash timing: open " << openUs << " us, program " << programUsPerSector
+                  << " us/sector, erase " << eraseUs << " us, stall " << eraseStallUs << " us every "
+                  << eraseStallEvery << " erases" << std::endl;
+    }
+    
+    void setNetworkRtt(uint32_t rttUs) {
+        simulated_network.rttUs = rttUs;
+        std::cout << "[SIM] Network RTT: " << rttUs << " us" << std::endl;
+    }
+    
+    // Compares single analogRead() samples with the oversampled pipeline at a fixed
+    // temperature: reports output std dev (counts), worst error and CPU time per output.
+    void benchmarkRtdSampler(int outputs) {
+        double savedAccel = time_acceleration_factor;
+        time_acceleration_factor = 1.0; // Bursts are paced in real time
+        
+        auto stddev = [](const std::vector<double>& v, double& mean, double& worst) {
+            mean = 0.0;
+            for (double x : v) mean += x;
+            mean /= v.size();
+            double var = 0.0;
+            worst = 0.0;
+            for (double x : v) {
+                var += (x - mean) * (x - mean);
+                worst = std::max(worst, std::fabs(x - mean));
+            }
+            return std::sqrt(var / (v.size() - 1));
+        };
+        
+        std::vector<double> single, filtered;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < outputs; i++) single.push_back(analogRead(A0));
+        double singleUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / outputs;
+        
+        rtdSamplerInit();
+        rtdSamplerResetStats();
+        while ((int)filtered.size() < outputs) {
+            if (rtdSamplerUpdate()) filtered.push_back(rtdSamplerGetStats().rawReading);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        const RTDSamplerStats& st = rtdSamplerGetStats();
+        const RTDSamplerConfig& cfg = rtdSamplerGetConfig();
+        double burstUs = st.burstCount ? (double)st.lastBurstMicros : 0.0;
+        
+        double mean, worst;
+        double singleSd = stddev(single, mean, worst);
+        std::cout << "[SIM BENCH] single read: sd=" << singleSd << " counts, worst=" << worst
+                  << " counts, " << singleUs << " us/read" << std::endl;
+        double filteredSd = stddev(filtered, mean, worst);
+        std::cout << "[SIM BENCH] pipeline " << (int)cfg.burstSamples << "x" << (int)cfg.decimation
+                  << " reject " << cfg.rejectFraction << ": sd=" << filteredSd << " counts, worst=" << worst
+                  << " counts, " << burstUs * cfg.decimation << " us CPU/output (max burst "
+                  << st.maxBurstMicros << " us), rejected " << st.rejectedSamples << "/" << st.totalSamples
+                  << ", spikes injected " << simulated_adc.spikes << std::endl;
+        
+        time_acceleration_factor = savedAccel;
+    }
+    
+    // Runs a 500 ms-in-2 s heater window (the shortest proofing pulse) from the hardware
+    // timer while the "loop" stalls for stallMs about once a second, and compares pulse accuracy
+    // with what the loop-driven window would have produced from the same loop.
+    void benchmarkHeaterTimer(int windows, unsigned long stallMs) {
+        double savedAccel = time_acceleration_factor;
+        time_acceleration_factor = 1.0; // Edge timing is measured in real time
+        const unsigned long windowMs = 2000, onMs = 500;
+        
+        if (!heaterTimerBegin(32)) return;
+        heaterTimerResetStats();
+        
+        unsigned long loopWindowStart = millis(), loopPulseStart = 0, lastStall = millis();
+        bool loopLevel = false;
+        unsigned long loopPulses = 0, loopMaxPulseErrorMs = 0, loopTotalPulseErrorMs = 0;
+        unsigned long end = millis() + windows * windowMs;
+        std::mt19937 rng(7);
+        std::uniform_int_distribution<unsigned long> stallGap(500, 1500);
+        unsigned long nextStallGap = stallGap(rng);
+        
+        while (millis() < end) {
+            unsigned long now = millis();
+            heaterTimerSetWindow(windowMs, onMs, false);
+            
+            // Loop-driven reference: the same decision, evaluated only when the loop runs
+            if (now - loopWindowStart >= windowMs) loopWindowStart = now;
+            bool want = (now - loopWindowStart) < onMs;
+            if (want && !loopLevel) loopPulseStart = now;
+            if (!want && loopLevel) {
+                unsigned long width = now - loopPulseStart;
+                unsigned long err = width > onMs ? width - onMs : onMs - width;
+                loopMaxPulseErrorMs = std::max(loopMaxPulseErrorMs, err);
+                loopTotalPulseErrorMs += err;
+                loopPulses++;
+            }
+            loopLevel = want;
+            
+            if (now - lastStall >= nextStallGap) {
+                lastStall = now;
+                nextStallGap = stallGap(rng);
+                std::this_thread::sleep_for(std::chrono::milliseconds(stallMs)); // Injected loop stall (FFat write, big response)
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));     // Normal loop cadence
+            }
+        }
+        heaterTimerStop();
+        
+        const HeaterTimerStats& st = heaterTimerGetStats();
+        std::cout << "[SIM BENCH] heater timer: " << st.windows << " windows, " << st.edges << " edges, edge error avg "
+                  << (st.edges ? (double)st.totalEdgeErrorUs / st.edges : 0.0) << " us max " << st.maxEdgeErrorUs
+                  << " us, pulse error max " << st.maxPulseErrorUs << " us, lease expiries " << st.leaseExpiries
+                  << ", loop gap max " << st.loopGapMaxMs << " ms" << std::endl;
+        std::cout << "[SIM BENCH] loop-driven window: " << loopPulses << " pulses, pulse error avg "
+                  << (loopPulses ? (double)loopTotalPulseErrorMs / loopPulses : 0.0) << " ms max "
+                  << loopMaxPulseErrorMs << " ms (" << onMs << " ms pulse, " << stallMs << " ms stalls)" << std::endl;
+        
+        time_acceleration_factor = savedAccel;
+    }
+    
+    // Runs a knockdown pattern (100 ms pulse every second) from the motor pulse engine while
+    // the "loop" stalls for stallMs about once a second, and compares pulse widths with the
+    // loop-driven mixer evaluating the same pattern from the same loop.
+    void benchmarkMotorPulse(int pulses, unsigned long stallMs) {
+        double savedAccel = time_acceleration_factor;
+        time_acceleration_factor = 1.0; // Edge timing is measured in real time
+        const unsigned long mixMs = 100, waitMs = 900, cycleMs = mixMs + waitMs;
+        
+        if (!motorPulseBegin(33)) return;
+        motorPulseResetStats();
+        MotorPulseSegment knockdown = {mixMs, waitMs, (uint32_t)(pulses * cycleMs)};
+        motorPulseLoad(&knockdown, 1, 0, 0);
+        
+        unsigned long start = millis(), loopPulseStart = 0, lastStall = millis();
+        bool loopLevel = false;
+        unsigned long loopPulses = 0, loopMaxPulseErrorMs = 0, loopTotalPulseErrorMs = 0;
+        unsigned long end = start + pulses * cycleMs;
+        std::mt19937 rng(11);
+        std::uniform_int_distribution<unsigned long> stallGap(500, 1500);
+        unsigned long nextStallGap = stallGap(rng);
+        
+        while (millis() < end) {
+            unsigned long now = millis();
+            
+            // Loop-driven reference: the same decision, evaluated only when the loop runs
+            bool want = ((now - start) % cycleMs) < mixMs;
+            if (want && !loopLevel) loopPulseStart = now;
+            if (!want && loopLevel) {
+                unsigned long width = now - loopPulseStart;
+                unsigned long err = width > mixMs ? width - mixMs : mixMs - width;
+                loopMaxPulseErrorMs = std::max(loopMaxPulseErrorMs, err);
+                loopTotalPulseErrorMs += err;
+                loopPulses++;
+            }
+            loopLevel = want;
+            motorPulseRenew();   // As the control tick does on each mix pass
+            
+            if (now - lastStall >= nextStallGap) {
+                lastStall = now;
+                nextStallGap = stallGap(rng);
+                std::this_thread::sleep_for(std::chrono::milliseconds(stallMs)); // Injected loop stall
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));     // Normal loop cadence
+            }
+        }
+        motorPulseStop();
+        
+        const MotorPulseStats& st = motorPulseGetStats();
+        std::cout << "[SIM BENCH] motor pulse engine: " << st.edges << " edges, edge error avg "
+                  << (st.edges ? (double)st.totalEdgeErrorUs / st.edges : 0.0) << " us max " << st.maxEdgeErrorUs
+                  << " us, pulse error max " << st.maxPulseErrorUs << " us" << std::endl;
+        std::cout << "[SIM BENCH] loop-driven mixer: " << loopPulses << "/" << pulses << " pulses, pulse error avg "
+                  << (loopPulses ? (double)loopTotalPulseErrorMs / loopPulses : 0.0) << " ms max "
+                  << loopMaxPulseErrorMs << " ms (" << mixMs << " ms pulse, " << stallMs << " ms stalls)" << std::endl;
+        
+        time_acceleration_factor = savedAccel;
+    }
+    
+    // Synthetic control tick for benchmarkControlTask(): ~1 ms of work, like sampling + PID
+    static std::atomic<bool> benchTickActive{false};
+    static std::atomic<bool> benchCommandsActive{false};
+    static void benchControlTick() {
+        if (benchCommandsActive) controlCommandsProcess();
+        if (!benchTickActive) return;
+        auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(1000);
+        while (std::chrono::steady_clock::now() < until) {}
+    }
+    
+    // Runs the control task against a loop() that serves synthetic HTTP load: short
+    // handlers that take the control lock, plus a large static file (handlerStallMs,
+    // no lock) about once a second. Reports the task's tick lateness next to what a
+    // control step inside the same loop would have seen.
+    void benchmarkControlTask(int seconds, unsigned long handlerStallMs) {
+        double savedAccel = time_acceleration_factor;
+        time_acceleration_factor = 1.0; // Deadlines are measured in real time
+        
+        benchTickActive = true;
+        if (!controlTaskBegin(benchControlTick)) return;
+        controlTaskResetStats();
+        
+        std::mt19937 rng(5);
+        std::uniform_int_distribution<unsigned long> stallGap(500, 1500);
+        unsigned long nextStallGap = stallGap(rng), lastStall = millis();
+        unsigned long lastLoopStep = millis(), loopSteps = 0, loopLateSteps = 0;
+        unsigned long loopMaxLateMs = 0, loopTotalLateMs = 0, lockedHandlers = 0;
+        unsigned long end = millis() + seconds * 1000UL;
+        
+        while (millis() < end) {
+            unsigned long now = millis();
+            
+            // Single-loop reference: a control step due every CONTROL_TICK_MS, run when the loop gets there
+            if (now - lastLoopStep >= CONTROL_TICK_MS) {
+                unsigned long late = now - lastLoopStep - CONTROL_TICK_MS;
+                loopMaxLateMs = std::max(loopMaxLateMs, late);
+                loopTotalLateMs += late;
+                if (late >= CONTROL_TICK_MS) loopLateSteps++;
+                loopSteps++;
+                lastLoopStep = now;
+            }
+            
+            if (now - lastStall >= nextStallGap) {
+                // Large static file to a slow client: streamed without the control lock
+                lastStall = now;
+                nextStallGap = stallGap(rng);
+                std::this_thread::sleep_for(std::chrono::milliseconds(handlerStallMs));
+            } else {
+                // Status poll / button press: short handler under the control lock
+                {
+                    ControlLockGuard guard;
+                    auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(500);
+                    while (std::chrono::steady_clock::now() < until) {}
+                    lockedHandlers++;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+        }
+        
+        const ControlTaskStats& st = controlTaskGetStats();
+        std::cout << "[SIM BENCH] control task: " << st.ticks << " ticks, lateness avg "
+                  << (st.ticks ? (double)st.totalLatenessUs / st.ticks : 0.0) << " us max " << st.maxLatenessUs
+                  << " us, lock wait max " << st.maxLockWaitUs << " us, tick max " << st.maxTickUs
+                  << " us, overruns " << st.overruns << " (" << lockedHandlers << " locked handlers)" << std::endl;
+        std::cout << "[SIM BENCH] single loop: " << loopSteps << " steps, lateness avg "
+                  << (loopSteps ? (double)loopTotalLateMs / loopSteps : 0.0) << " ms max " << loopMaxLateMs
+                  << " ms, " << loopLateSteps << " steps a period or more late (" << handlerStallMs
+                  << " ms file stalls)" << std::endl;
+        
+        benchTickActive = false;
+        time_acceleration_factor = savedAccel;
+    }
+    
+    // Applier for benchmarkCommandQueue(): checks per-producer FIFO order (intArg = producer << 16 | seq)
+    static std::atomic<uint32_t> benchOrderViolations{0};
+    static int32_t benchLastSeq[64];
+    static void benchCommandApplier(const ControlCommand& cmd, ControlCommandResult& result) {
+        int producer = (cmd.intArg >> 16) & 63;
+        int32_t seq = cmd.intArg & 0xFFFF;
+        if (seq <= benchLastSeq[producer]) benchOrderViolations++;
+        benchLastSeq[producer] = seq;
+        result.value = cmd.intArg;
+    }
+    
+    // Producer threads (web handlers) submit commands and wait for their completion
+    // while the control task drains the queue once per tick. Reports submit cost,
+    // submit-to-applied latency, ordering and misrouted results, then a fire-and-forget
+    // burst larger than the ring to show rejections when it is full.
+    void benchmarkCommandQueue(int commandsPerProducer, int producers) {
+        double savedAccel = time_acceleration_factor;
+        time_acceleration_factor = 1.0;
+        producers = std::max(1, std::min(producers, 63));
+        commandsPerProducer = std::max(1, std::min(commandsPerProducer, 0xFFFF));
+        
+        for (int i = 0; i < 64; i++) benchLastSeq[i] = -1;
+        benchOrderViolations = 0;
+        controlCommandsBegin(benchCommandApplier);
+        benchCommandsActive = true;
+        if (!controlTaskBegin(benchControlTick)) return;
+        controlCommandsResetStats();
+        
+        std::atomic<uint64_t> submitNs{0};
+        std::atomic<uint32_t> misrouted{0}, failed{0};
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; p++) {
+            threads.emplace_back([&, p]() {
+                std::mt19937 rng(p + 1);
+                std::uniform_int_distribution<int> gap(0, 10);
+                for (int i = 0; i < commandsPerProducer; i++) {
+                    ControlCommand cmd;
+                    cmd.type = CMD_SET_SETPOINT;
+                    cmd.intArg = (p << 16) | i;
+                    auto t0 = std::chrono::steady_clock::now();
+                    uint32_t token = controlCommandSubmit(cmd);
+                    submitNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+                    ControlCommandResult result;
+                    if (!token || !controlCommandWait(token, result)) { failed++; continue; }
+                    if (result.value != cmd.intArg) misrouted++;
+                    std::this_thread::sleep_for(std::chrono::milliseconds(gap(rng)));
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+        ControlCommandStats st = controlCommandsGetStats();
+        
+        // Burst: 2x the ring from one handler without waiting
+        int burst = CONTROL_COMMAND_QUEUE_SIZE * 2, accepted = 0;
+        for (int i = 0; i < burst; i++) {
+            ControlCommand cmd;
+            cmd.type = CMD_PING;
+            if (controlCommandSubmit(cmd)) accepted++;
+        }
+        delay(3 * CONTROL_TICK_MS);
+        ControlCommandStats after = controlCommandsGetStats();
+        
+        std::cout << "[SIM BENCH] command queue: " << st.applied << " applied from " << producers
+                  << " producers, submit avg " << (st.submitted ? (double)submitNs / st.submitted : 0.0)
+                  << " ns, latency avg " << (st.applied ? (double)st.totalLatencyUs / st.applied : 0.0)
+                  << " us max " << st.maxLatencyUs << " us, max batch " << st.maxDepth << std::endl;
+        std::cout << "[SIM BENCH] order violations " << benchOrderViolations << ", misrouted " << misrouted
+                  << ", failed " << failed << "; burst of " << burst << " accepted " << accepted
+                  << " rejected " << (after.rejectedFull - st.rejectedFull) << std::endl;
+        
+        benchCommandsActive = false;
+        time_acceleration_factor = savedAccel;
+    }
+    
+    // Runs the storage benchmark job to completion on the host backend and prints
+    // each phase the way /api/storage_bench reports it on the device. The flash
+    // timing model is charged in real time (no acceleration), so phase times read
+    // as device time; the model's own counters follow the phases.
+    void benchmarkStorage(int largeKb, int appends) {
+        double savedAccel = time_acceleration_factor;
+        time_acceleration_factor = 1.0;
+        if (!storageBegin(true)) return;
+        StorageBenchConfig cfg;
+        cfg.largeBytes = (uint32_t)std::max(largeKb, 4) * 1024;
+        cfg.appends = (uint16_t)std::max(appends, 1);
+        simulated_flash.resetStats();
+        uint16_t id = storageBenchStart(cfg);
+        if (!id) {
+            std::cout << "[SIM BENCH] storage: could not start" << std::endl;
+            time_acceleration_factor = savedAccel;
+            return;
+        }
+        JobState state = backgroundJobRunNow(id);
+        const StorageBenchResult& r = storageBenchResult();
+        std::cout << "[SIM BENCH] storage (" << storageBackendName() << "): " << backgroundJobStateName(state);
+        const BackgroundJob* job = backgroundJobGet(id);
+        if (job && job->message[0]) std::cout << ", " << job->message;
+        std::cout << std::endl;
+        for (uint8_t i = 0; i < BENCH_PHASE_COUNT; i++) {
+            const StorageBenchPhase& p = r.phases[i];
+            std::cout << "[SIM BENCH]   " << storageBenchPhaseName(i) << ": " << p.ops << " ops, avg "
+                      << (p.ops ? (double)p.totalUs / p.ops : 0.0) << " us, max " << p.maxUs << " us, "
+                      << (p.totalUs ? p.bytes * 1000000.0 / 1024 / p.totalUs : 0.0) << " KB/s" << std::endl;
+        }
+        std::cout << "[SIM BENCH]   flash model: " << simulated_flash.opens << " opens, "
+                  << simulated_flash.sectorsRead << " sectors read, " << simulated_flash.sectorsWritten
+                  << " written (" << simulated_flash.stalls << " stalls), " << simulated_flash.bytesWritten
+                  << " bytes written, " << simulated_flash.chargedUs / 1000.0 << " ms charged" << std::endl;
+        time_acceleration_factor = savedAccel;
+    }
+    
+    static void printControlTaskLine(const char* label, const ControlTaskStats& st) {
+        std::cout << "[SIM BENCH]   control task " << label << ": " << st.ticks << " ticks, lateness avg "
+                  << (st.ticks ? (double)st.totalLatenessUs / st.ticks : 0.0) << " us max " << st.maxLatenessUs
+                  << " us, lock wait max " << st.maxLockWaitUs << " us, overruns " << st.overruns << std::endl;
+    }
+    
+    // Serves the firmware's own endpoints (registerWebEndpoints()) from a real socket
+    // server while HttpLoad pollers hit it, with the control task ticking alongside:
+    // /api/status and /api/pid_status through the response cache and the control lock,
+    // and a 64 KB static file sent by the file transfer service. A quiet baseline
+    // period is measured first so the control task's lateness can be compared with
+    // and without HTTP load. The load then runs twice on the firmware's
+    // RoutedWebServer: with keep-alive off (the core's handleClient(), one connection
+    // per request) and on at both ends. Set a WiFi-like RTT with setNetworkRtt() first,
+    // or connection setup costs next to nothing on loopback. The route table is built
+    // once, so run it instead of setup(), not after it.
+    void benchmarkWebServer(int pollers, int seconds) {
+        if (routeCount() > 0) {
+            std::cout << "[SIM BENCH] web server: routes already registered by setup(), not benchmarking" << std::endl;
+            return;
+        }
+        double savedAccel = time_acceleration_factor;
+        time_acceleration_factor = 1.0;
+        seconds = std::max(seconds, 1);
+        
+        RoutedWebServer server(8081);
+        registerWebEndpoints(server);   // Mounts storage, registers every route, begin()
+        static const char BIG_FILE[] = "/bench_big.bin";
+        {
+            static char block[1024];
+            memset(block, 'x', sizeof(block));
+            StorageFile f = storageOpen(BIG_FILE, "w", "bench");
+            for (int i = 0; f && i < 64; i++) f.write((const uint8_t*)block, sizeof(block));
+        }
+        
+        // The loop thread owns the server; it is stopped to switch modes
+        std::atomic<bool> serving{false};
+        std::thread loopThread;
+        auto startServing = [&]() {
+            serving = true;
+            loopThread = std::thread([&]() {
+                while (serving) {
+                    server.handleClient();
+                    fileTransfersService();
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            });
+        };
+        auto stopServing = [&]() {
+            serving = false;
+            if (loopThread.joinable()) loopThread.join();
+        };
+        
+        benchTickActive = true;
+        if (!controlTaskBegin(benchControlTick)) {
+            time_acceleration_factor = savedAccel;
+            return;
+        }
+        controlTaskResetStats();
+        delay(seconds * 1000UL);
+        ControlTaskStats quiet = controlTaskGetStats();
+        printControlTaskLine("quiet", quiet);
+        
+        HttpLoad::Options opt;
+        opt.port = server.port();
+        opt.paths = { "/api/status", "/api/pid_status", "/api/status", BIG_FILE };
+        opt.pollers = std::max(pollers, 1);
+        opt.seconds = seconds;
+        for (int keepAlive = 0; keepAlive < 2; keepAlive++) {
+            server.setKeepAlive(keepAlive);
+            opt.keepAlive = keepAlive;
+            webConnectionResetStats();
+            controlTaskResetStats();
+            startServing();
+            HttpLoad::Result r = HttpLoad::run(opt);
+            stopServing();
+            ControlTaskStats loaded = controlTaskGetStats();
+            const WebConnectionStats& cs = webConnectionStats();
+            
+            std::cout << "[SIM BENCH] web server, " << (keepAlive ? "keep-alive" : "connection per request") << ": "
+                      << opt.pollers << " pollers, " << r.requests << " requests (" << r.requestsPerSecond() << "/s), "
+                      << r.errors << " errors, " << r.bytes / 1024 << " KB" << std::endl;
+            std::cout << "[SIM BENCH]   latency avg " << r.avgMs << " ms, p50 " << r.p50Ms << " p90 " << r.p90Ms
+                      << " p99 " << r.p99Ms << " max " << r.maxMs << " ms" << std::endl;
+            std::cout << "[SIM BENCH]   connections: " << r.connections << " opened (" << r.connections / r.seconds << "/s)";
+            if (keepAlive) {
+                std::cout << ", " << cs.reused << " of " << cs.requests << " requests reused one, " << cs.crowdedClose
+                          << " closed while crowded, " << cs.evictions << " evicted, max open " << (int)cs.maxOpen;
+            }
+            std::cout << std::endl;
+            printControlTaskLine("loaded", loaded);
+        }
+        
+        server.close();
+        storageFS().remove(BIG_FILE);
+        benchTickActive = false;
+        time_acceleration_factor = savedAccel;
+    }
+    
     void runTestSequence() {
         std::cout << "[SIM] Starting automated test sequence..." << std::endl;
         
@@ -0,0 +1,3 @@
+#pragma once
+// Host builds (pio test -e native_test) include <Arduino.h> as the firmware does
+#include "arduino_simulation.h"
@@ -0,0 +1,3 @@
+#pragma once
+// The simulated WebServer lives in the HAL header (see Arduino.h)
+#include "arduino_simulation.h"
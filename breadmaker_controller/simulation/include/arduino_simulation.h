@@ -10,6 +10,16 @@
 #include <thread>
 #include <iostream>
 #include <cmath>
+#include <random>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <cstring>
+#include <cstdarg>
+#include <cstdio>
 
 // ===== Arduino Core Simulation =====
 #define HIGH 1
@@ -32,165 +42,159 @@ inline unsigned long millis() {
     return (unsigned long)(millis_real * time_acceleration_factor);
 }
 
+inline unsigned long micros() {
+    auto now = std::chrono::steady_clock::now();
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+}
+
 inline void delay(unsigned long ms) {
     std::this_thread::sleep_for(std::chrono::milliseconds((long)(ms / time_acceleration_factor)));
 }
 
-// ===== WiFi Simulation =====
-class WiFiClass {
-public:
-    void begin(const char* ssid, const char* password) {
-        connected = true;
-        std::cout << "[SIM] WiFi connected to " << ssid << std::endl;
-    }
-    
-    bool isConnected() { return connected; }
-    
-    std::string localIP() { return "192.168.1.100"; }
-    
-    int status() { return connected ? 3 : 6; } // WL_CONNECTED : WL_DISCONNECTED
-    
-private:
-    bool connected = false;
+inline void yield() { std::this_thread::yield(); }
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// ===== Interrupt / Critical Section Simulation =====
+// ISRs run on a host thread, so critical sections need a real (spin) lock
+#define IRAM_ATTR
+#define ARDUINO_ISR_ATTR
+
+struct portMUX_TYPE {
+    std::atomic<int> locked{0};
 };
+#define portMUX_INITIALIZER_UNLOCKED {}
 
-extern WiFiClass WiFi;
+inline void portENTER_CRITICAL(portMUX_TYPE* mux) {
+    int expected = 0;
+    while (!mux->locked.compare_exchange_weak(expected, 1)) expected = 0;
+}
+inline void portEXIT_CRITICAL(portMUX_TYPE* mux) { mux->locked.store(0); }
+inline void portENTER_CRITICAL_ISR(portMUX_TYPE* mux) { portENTER_CRITICAL(mux); }
+inline void portEXIT_CRITICAL_ISR(portMUX_TYPE* mux) { portEXIT_CRITICAL(mux); }
 
-// ===== Web Server Simulation =====
-enum HTTPMethod { HTTP_GET, HTTP_POST, HTTP_PUT, HTTP_DELETE };
+// Accelerated like millis() so timer periods are in simulated time
+inline int64_t esp_timer_get_time() {
+    return (int64_t)(micros() * time_acceleration_factor);
+}
 
-class WebServer {
-public:
-    WebServer(int port) : port_(port) {}
-    
-    void begin() {
-        std::cout << "[SIM] Web server started on port " << port_ << std::endl;
-    }
-    
-    void handleClient() {
-        // Simulate periodic client requests for testing
-        static auto last_request = std::chrono::steady_clock::now();
-        auto now = std::chrono::steady_clock::now();
-        if (std::chrono::duration_cast<std::chrono::seconds>(now - last_request).count() > 10) {
-            // Simulate status request every 10 seconds
-            simulateRequest("/api/status", HTTP_GET);
-            last_request = now;
-        }
-    }
-    
-    void on(const char* path, HTTPMethod method, std::function<void()> handler) {
-        routes_[std::string(path)] = handler;
-        std::cout << "[SIM] Route registered: " << path << std::endl;
-    }
-    
-    void send(int code, const char* content_type, const char* content) {
-        std::cout << "[SIM] HTTP " << code << " " << content_type << ": " << content << std::endl;
-    }
-    
-    std::string arg(const char* name) {
-        return request_args_[std::string(name)];
-    }
-    
-    void setContentLength(size_t len) {}
-    void sendContent(const char* content) {}
-    
-private:
-    int port_;
-    std::map<std::string, std::function<void()>> routes_;
-    std::map<std::string, std::string> request_args_;
-    
-    void simulateRequest(const char* path, HTTPMethod method) {
-        auto it = routes_.find(std::string(path));
-        if (it != routes_.end()) {
-            std::cout << "[SIM] Simulating request: " << path << std::endl;
-            it->second();
-        }
-    }
+// ===== Hardware Timer Simulation =====
+// Each timer is a host thread firing its ISR at the alarm period (simulated time).
+// Host scheduling adds latency, which shows up in the callers' edge-error stats
+// just like interrupt latency on the device.
+struct hw_timer_t {
+    uint8_t num = 0;
+    uint16_t divider = 80;
+    void (*isr)() = nullptr;
+    uint64_t alarmTicks = 0;
+    bool autoreload = false;
+    std::atomic<bool> enabled{false};
+    std::atomic<bool> running{true};
+    std::atomic<uint32_t> fired{0};
+    std::atomic<int64_t> maxLatenessUs{0};  // Real-time lateness of the ISR versus its deadline
+    std::thread worker;
 };
 
-// ===== FFat File System Simulation =====
-class File {
-public:
-    File() : valid_(false) {}
-    File(const std::string& content) : content_(content), valid_(true), pos_(0) {}
-    
-    operator bool() const { return valid_; }
-    
-    size_t write(const char* data, size_t len) {
-        content_.append(data, len);
-        return len;
-    }
-    
-    size_t write(const char* str) {
-        content_ += str;
-        return strlen(str);
-    }
-    
-    int read() {
-        if (pos_ >= content_.size()) return -1;
-        return content_[pos_++];
+hw_timer_t* timerBegin(uint8_t num, uint16_t divider, bool countUp);
+void timerAttachInterrupt(hw_timer_t* timer, void (*isr)(), bool edge);
+void timerAlarmWrite(hw_timer_t* timer, uint64_t alarmValue, bool autoreload);
+void timerAlarmEnable(hw_timer_t* timer);
+void timerAlarmDisable(hw_timer_t* timer);
+void timerEnd(hw_timer_t* timer);
+
+// ===== FreeRTOS Task Simulation =====
+// Tasks are host threads and ticks are simulated milliseconds (like millis()), so a
+// task paced by vTaskDelayUntil() runs concurrently with loop() as on the two cores.
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint8_t StackType_t;
+#define pdPASS 1
+#define pdFAIL 0
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY 0xFFFFFFFFUL
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+struct SimTask {
+    std::thread worker;
+    BaseType_t core = 0;
+};
+typedef SimTask* TaskHandle_t;
+
+inline thread_local SimTask* simCurrentTask = nullptr;  // nullptr on the loop() thread
+
+inline TickType_t xTaskGetTickCount() { return (TickType_t)millis(); }
+
+inline void vTaskDelay(TickType_t ticks) { delay(ticks); }
+
+inline void vTaskDelayUntil(TickType_t* previousWake, TickType_t increment) {
+    TickType_t target = *previousWake + increment;
+    int32_t remaining = (int32_t)(target - xTaskGetTickCount());
+    if (remaining > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds((long)(remaining * 1000.0 / time_acceleration_factor)));
     }
-    
-    size_t readBytes(char* buffer, size_t length) {
-        size_t available = content_.size() - pos_;
-        size_t to_read = std::min(length, available);
-        memcpy(buffer, content_.data() + pos_, to_read);
-        pos_ += to_read;
-        return to_read;
+    *previousWake = target;
+}
+
+inline BaseType_t xTaskCreatePinnedToCore(void (*fn)(void*), const char* name, uint32_t stackDepth, void* param,
+                                          UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+    SimTask* task = new SimTask();
+    task->core = core;
+    if (handle) *handle = task;
+    task->worker = std::thread([task, fn, param]() {
+        simCurrentTask = task;
+        fn(param);
+    });
+    task->worker.detach();
+    std::cout << "[SIM] Task '" << name << "' started (core " << core << ", priority " << priority << ")" << std::endl;
+    return pdPASS;
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return simCurrentTask; }
+inline BaseType_t xPortGetCoreID() { return simCurrentTask ? simCurrentTask->core : 1; }
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) { return 0; }  // No stack model on the host
+
+typedef std::recursive_timed_mutex* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() { return new std::recursive_timed_mutex(); }
+inline BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t mutex, TickType_t ticks) {
+    if (ticks == portMAX_DELAY) {
+        mutex->lock();
+        return pdTRUE;
     }
-    
-    void close() { valid_ = false; }
-    size_t size() { return content_.size(); }
-    
-private:
-    std::string content_;
-    bool valid_;
-    size_t pos_;
-};
+    auto wait = std::chrono::microseconds((long)(ticks * 1000.0 / time_acceleration_factor));
+    return mutex->try_lock_for(wait) ? pdTRUE : pdFALSE;
+}
+inline BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t mutex) {
+    mutex->unlock();
+    return pdTRUE;
+}
 
-class FFatClass {
+// ===== WiFi Simulation =====
+enum wl_status_t { WL_CONNECTED = 3, WL_DISCONNECTED = 6 };
+
+class WiFiClass {
 public:
-    bool begin(bool format_if_failed = false) {
-        std::cout << "[SIM] FFat file system initialized" << std::endl;
-        return true;
+    void begin(const char* ssid, const char* password) {
+        connected = true;
+        std::cout << "[SIM] WiFi connected to " << ssid << std::endl;
     }
     
-    File open(const char* path, const char* mode = "r") {
-        std::cout << "[SIM] Opening file: " << path << " mode: " << mode << std::endl;
-        
-        // Return mock file content based on path
-        if (std::string(path).find("programs") != std::string::npos) {
-            return File(R"([{"name":"Test Program","customStages":[{"label":"Mix","min":2,"temp":25}]}])");
-        }
-        if (std::string(path).find("resume") != std::string::npos) {
-            return File(R"({"running":false,"stage":0})");
-        }
-        
-        return File("{}"); // Empty JSON for other files
-    }
+    bool isConnected() { return connected; }
     
-    bool exists(const char* path) {
-        std::cout << "[SIM] Checking if file exists: " << path << std::endl;
-        return true; // Assume files exist for simulation
-    }
+    std::string localIP() { return "192.168.1.100"; }
     
-    bool remove(const char* path) {
-        std::cout << "[SIM] Removing file: " << path << std::endl;
-        return true;
-    }
+    int status() { return connected ? WL_CONNECTED : WL_DISCONNECTED; }
     
-    bool mkdir(const char* path) {
-        std::cout << "[SIM] Creating directory: " << path << std::endl;
-        return true;
-    }
+    const char* macAddress() { return "02:00:00:00:00:01"; }
     
-    bool rmdir(const char* path) {
-        std::cout << "[SIM] Removing directory: " << path << std::endl;
-        return true;
-    }
+private:
+    bool connected = false;
 };
 
-extern FFatClass FFat;
+extern WiFiClass WiFi;
 
 // ===== Hardware Pin Simulation =====
 extern std::map<int, int> pin_values;
@@ -251,17 +255,73 @@ private:
     static double target_temperature;
 };
 
+// ===== Noisy ADC Model =====
+// Approximates the ESP32 SAR ADC on the RTD input: white noise, occasional
+// large spikes (WiFi TX bursts), 12-bit quantization and a per-conversion cost,
+// so the oversampling pipeline can be benchmarked for filter quality and CPU time.
+struct SimulatedADCModel {
+    double noiseStdDevCounts = 6.0;   // Gaussian noise in ADC counts
+    double spikeProbability = 0.01;   // Chance a conversion is a spike
+    double spikeAmplitude = 300.0;    // Max spike magnitude in counts
+    double offsetCounts = 0.0;        // Static offset error
+    unsigned conversionMicros = 10;   // Busy time per conversion (real time, not accelerated)
+    uint32_t conversions = 0;
+    uint32_t spikes = 0;
+
+    int convert(double idealCounts) {
+        static std::mt19937 rng(12345);
+        std::normal_distribution<double> noise(0.0, noiseStdDevCounts);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+        double value = idealCounts + offsetCounts + noise(rng);
+        if (unit(rng) < spikeProbability) {
+            value += (unit(rng) * 2.0 - 1.0) * spikeAmplitude;
+            spikes++;
+        }
+        conversions++;
+
+        if (conversionMicros > 0) {
+            auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(conversionMicros);
+            while (std::chrono::steady_clock::now() < until) {}
+        }
+        long q = std::lround(value);
+        return (int)std::max(0L, std::min(4095L, q));
+    }
+};
+
+extern SimulatedADCModel simulated_adc;
+
 // ===== Analog Read Simulation =====
 inline int analogRead(int pin) {
     if (pin == A0) {
         // Simulate temperature sensor reading
         double temp = SimulatedTemperatureSensor::getTemperature();
-        // Convert to ADC value (assuming thermistor)
-        return (int)((temp - 15.0) / 235.0 * 4095.0);
+        // Convert to ADC value (assuming thermistor) and pass through the noisy ADC model
+        return simulated_adc.convert((temp - 15.0) / 235.0 * 4095.0);
     }
     return 0;
 }
 
+// ===== Print (byte sinks for streamed bodies: /metrics, /api/trace, StorageFile) =====
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t n = 0;
+        while (size--) n += write(*buffer++);
+        return n;
+    }
+    size_t write(const char* str) { return str ? write((const uint8_t*)str, strlen(str)) : 0; }
+    size_t print(const char* str) { return write(str); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int n) { return print((long)n); }
+    size_t print(unsigned int n) { return print((unsigned long)n); }
+    size_t print(long n) { char buf[24]; snprintf(buf, sizeof(buf), "%ld", n); return write(buf); }
+    size_t print(unsigned long n) { char buf[24]; snprintf(buf, sizeof(buf), "%lu", n); return write(buf); }
+    size_t print(double n, int digits = 2) { char buf[48]; snprintf(buf, sizeof(buf), "%.*f", digits, n); return write(buf); }
+};
+
 // ===== Serial Simulation =====
 class SerialClass {
 public:
@@ -284,6 +344,19 @@ public:
         va_end(args);
     }
     
+    size_t write(uint8_t c) {
+        std::cout.put((char)c);
+        return 1;
+    }
+    
+    size_t write(const uint8_t* buffer, size_t size) {
+        std::cout.write((const char*)buffer, size);
+        return size;
+    }
+    
+    int availableForWrite() { return 128; }  // UART TX FIFO size; stdout never fills
+    void flush() { std::cout.flush(); }
+    
     bool available() { return false; }
     int read() { return -1; }
 };
@@ -335,6 +408,325 @@ private:
     std::string data_;
 };
 
+// ===== Web Server Simulation =====
+// A real HTTP/1.1 server on a localhost socket with the subset of the ESP32
+// WebServer API the firmware uses: routes by method, query/form/"plain" args,
+// request headers, multipart uploads, sendHeader(), Content-Length and chunked
+// responses (setContentLength(CONTENT_LENGTH_UNKNOWN) + sendContent(), terminated
+// after the handler if it didn't), onNotFound() and client() for streaming. The
+// internals follow the core's WebServer.cpp so a subclass can drive them the same
+// way on both builds: handleClient() is the core's state machine (accept from
+// _server, wait up to HTTP_MAX_DATA_WAIT for the request, _parseRequest(),
+// _handleRequest(), then wait up to HTTP_MAX_CLOSE_WAIT for the client to close)
+// and every response says "Connection: close". Routes from on() and addHandler()
+// share one handler list, tried in registration order, and every response byte
+// goes out through the virtual _currentClientWrite() as on the device. The port is
+// SIM_HTTP_PORT if set, otherwise the constructor's port, moved up by 8000 if it is
+// privileged (80 -> 8080).
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+enum HTTPUploadStatus { UPLOAD_FILE_START, UPLOAD_FILE_WRITE, UPLOAD_FILE_END, UPLOAD_FILE_ABORTED };
+enum HTTPClientStatus { HC_NONE, HC_WAIT_READ, HC_WAIT_CLOSE };
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t) -1)
+#define CONTENT_LENGTH_NOT_SET ((size_t) -2)
+#define HTTP_UPLOAD_BUFLEN 1436
+#define HTTP_MAX_DATA_WAIT 5000   // ms to receive a request
+#define HTTP_MAX_CLOSE_WAIT 2000  // ms to wait for the client to close after the response
+
+// Link latency for the socket server. Loopback has none, so connection setup and
+// teardown are free in the sim, where over WiFi each costs a round trip. With rttUs
+// set, an accepted connection is handed to the server one RTT after the client
+// connected (the handshake), and the server sees the client's close one RTT after
+// its last write to it (the FIN coming back) - the time the core's HC_WAIT_CLOSE
+// holds the loop. Data on an open connection isn't delayed: that cost is the same
+// with or without keep-alive. 0 = plain loopback.
+struct SimulatedNetworkModel {
+    uint32_t rttUs = 0;
+};
+
+extern SimulatedNetworkModel simulated_network;
+
+struct SimSocket {
+    int fd = -1;
+    std::chrono::steady_clock::time_point lastWrite;
+    explicit SimSocket(int f) : fd(f) {}
+    ~SimSocket();
+};
+
+// Shares the socket like the device's WiFiClient: it closes when the last copy goes
+class WiFiClient {
+public:
+    WiFiClient() {}
+    explicit WiFiClient(int fd) : sock_(std::make_shared<SimSocket>(fd)) {}
+    int fd() const { return sock_ ? sock_->fd : -1; }
+    uint8_t connected();
+    size_t write(const uint8_t* buf, size_t size);
+    size_t write(const char* buf, size_t size) { return write((const uint8_t*)buf, size); }
+    size_t write(uint8_t c) { return write(&c, 1); }
+    int available();
+    int read();
+    int read(uint8_t* buf, size_t size);
+    void stop() { sock_.reset(); }
+    int setTimeout(uint32_t seconds) { return 0; }
+    operator bool() const { return sock_ != nullptr; }
+
+private:
+    std::shared_ptr<SimSocket> sock_;
+};
+
+// Listening socket; available() accepts without blocking, as on the device
+class WiFiServer {
+public:
+    explicit WiFiServer(int port = 80) : port_(port) {}
+    WiFiServer(const WiFiServer&) = delete;
+    WiFiServer& operator=(const WiFiServer&) = delete;
+    ~WiFiServer() { close(); }
+    void begin();
+    WiFiClient available();
+    WiFiClient accept() { return available(); }
+    bool hasClient();             // A connection is waiting to be accepted
+    void close();
+    void end() { close(); }
+    int port() const { return port_; }
+    operator bool() const { return fd_ >= 0; }
+
+private:
+    int port_;
+    int fd_ = -1;
+    std::deque<std::pair<int, std::chrono::steady_clock::time_point>> pending_;  // Handshake in flight
+
+    void acceptPending();
+};
+
+struct HTTPUpload {
+    HTTPUploadStatus status = UPLOAD_FILE_START;
+    String filename;
+    String name;
+    String type;
+    size_t totalSize = 0;
+    size_t currentSize = 0;
+    uint8_t buf[HTTP_UPLOAD_BUFLEN];
+};
+
+class WebServer;
+
+// Same interface as the ESP32 core's RequestHandler (detail/RequestHandler.h)
+class RequestHandler {
+public:
+    virtual ~RequestHandler() {}
+    virtual bool canHandle(HTTPMethod method, String uri) { return false; }
+    virtual bool canUpload(String uri) { return false; }
+    virtual bool handle(WebServer& server, HTTPMethod requestMethod, String requestUri) { return false; }
+    virtual void upload(WebServer& server, String requestUri, HTTPUpload& upload) {}
+};
+
+class WebServer {
+public:
+    typedef std::function<void()> THandlerFunction;
+
+    WebServer(int port = 80);
+    virtual ~WebServer();
+
+    void begin();
+    void close();
+    void stop() { close(); }
+    void handleClient();
+
+    void on(const String& uri, THandlerFunction handler) { on(uri, HTTP_ANY, handler); }
+    void on(const String& uri, HTTPMethod method, THandlerFunction handler) { on(uri, method, handler, nullptr); }
+    void on(const String& uri, HTTPMethod method, THandlerFunction handler, THandlerFunction uploadHandler);
+    void addHandler(RequestHandler* handler) { handlers_.push_back(handler); }
+    void onNotFound(THandlerFunction handler) { notFound_ = handler; }
+    void onFileUpload(THandlerFunction handler) { fileUpload_ = handler; }
+
+    String uri() const { return String(uri_.c_str()); }
+    HTTPMethod method() const { return method_; }
+    WiFiClient& client() { return _currentClient; }
+    HTTPUpload& upload() { return upload_; }
+
+    String arg(const String& name) const;
+    String arg(int i) const;
+    String argName(int i) const;
+    int args() const { return (int)args_.size(); }
+    bool hasArg(const String& name) const;
+    String header(const String& name) const;
+    bool hasHeader(const String& name) const;
+    int headers() const { return (int)headers_.size(); }
+    void collectHeaders(const char* headerKeys[], size_t count) {}  // All headers are kept
+
+    void sendHeader(const String& name, const String& value, bool first = false);
+    void setContentLength(size_t length) { _contentLength = length; }
+    void send(int code, const char* contentType, const char* content);
+    void send(int code, const char* contentType = "text/plain", const String& content = String(""));
+    void send(int code, const String& contentType, const String& content) { send(code, contentType.c_str(), content); }
+    void send_P(int code, const char* contentType, const char* content) { send(code, contentType, content); }
+    void sendContent(const char* content, size_t length);
+    void sendContent(const char* content) { sendContent(content, strlen(content)); }
+    void sendContent(const String& content) { sendContent(content.c_str(), content.length()); }
+
+    int port() const { return _server.port(); }
+
+protected:
+    virtual size_t _currentClientWrite(const char* b, size_t l);
+    bool _parseRequest(WiFiClient& client);
+    void _handleRequest();
+    void _finalizeResponse();
+
+    WiFiServer _server;
+    WiFiClient _currentClient;
+    uint8_t _currentVersion = 1;          // HTTP/1.x minor version of the current request
+    HTTPClientStatus _currentStatus = HC_NONE;
+    unsigned long _statusChange = 0;
+    size_t _contentLength = CONTENT_LENGTH_NOT_SET;
+    bool _chunked = false;
+
+private:
+    std::vector<RequestHandler*> handlers_;
+    std::vector<std::unique_ptr<RequestHandler>> ownedHandlers_;   // Created by on()
+    THandlerFunction notFound_;
+    THandlerFunction fileUpload_;
+
+    // Current request
+    RequestHandler* currentHandler_ = nullptr;
+    std::string uri_;
+    HTTPMethod method_ = HTTP_GET;
+    std::vector<std::pair<std::string, std::string>> args_;
+    std::vector<std::pair<std::string, std::string>> headers_;
+    HTTPUpload upload_;
+    std::string responseHeaders_;
+
+    bool readRequest(WiFiClient& client, std::string& head, std::string& body);
+    void parseArguments(const std::string& query);
+    void parseMultipart(const std::string& body, const std::string& boundary, RequestHandler* handler);
+};
+
+// ===== Flash Timing Model =====
+// Charges the host-directory filesystem below with the time the same operation
+// would take on the ESP32's wear-levelled FAT partition, so flash-bound paths show
+// up in host benchmarks. Costs are device microseconds and are slept through
+// time_acceleration_factor like delay(), so esp_timer_get_time() deltas measured
+// around a file call read as device time. FatFs keeps one sector buffer per file:
+// a 4 KB sector is programmed (with its wear-levelling erase) when a write leaves
+// it, on flush() and on close(); close() of a written file also rewrites the
+// directory entry, and the FAT when the file grew into a new cluster or was
+// truncated. Every eraseStallEvery erases one takes eraseStallUs instead, like a
+// wear-levelling relocation or a worst-case erase. Zero all costs to disable.
+struct SimulatedFlashModel {
+    uint32_t openUs = 1200;           // Directory lookup and FAT walk per open
+    uint32_t readUsPerSector = 150;   // 4 KB read at 80 MHz QIO plus FatFs overhead
+    uint32_t programUsPerSector = 11000;  // 16 page programs of 0.7 ms
+    uint32_t eraseUs = 45000;         // Sector erase (typical)
+    uint32_t eraseStallEvery = 64;    // 0 = never
+    uint32_t eraseStallUs = 400000;   // Sector erase (worst case) / relocation
+    uint32_t opens = 0;
+    uint64_t bytesRead = 0;
+    uint64_t bytesWritten = 0;
+    uint32_t sectorsRead = 0;
+    uint32_t sectorsWritten = 0;      // Data, directory and FAT sectors
+    uint32_t erases = 0;
+    uint32_t stalls = 0;
+    uint64_t chargedUs = 0;           // Total device time charged
+
+    void charge(uint64_t us) {
+        chargedUs += us;
+        if (us > 0 && time_acceleration_factor > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds((long long)(us / time_acceleration_factor)));
+        }
+    }
+    void chargeOpen() { opens++; charge(openUs); }
+    void chargeRead(size_t sectors) { sectorsRead += sectors; charge((uint64_t)sectors * readUsPerSector); }
+    void chargeSectorWrite() {
+        sectorsWritten++;
+        erases++;
+        bool stall = eraseStallEvery && erases % eraseStallEvery == 0;
+        if (stall) stalls++;
+        charge(programUsPerSector + (stall ? eraseStallUs : eraseUs));
+    }
+    void resetStats() {
+        opens = 0; bytesRead = 0; bytesWritten = 0; sectorsRead = 0;
+        sectorsWritten = 0; erases = 0; stalls = 0; chargedUs = 0;
+    }
+};
+
+extern SimulatedFlashModel simulated_flash;
+
+// ===== FFat File System Simulation =====
+// Backed by a host directory: SIM_FS_ROOT (default ./sim_fs), created and seeded
+// from SIM_FS_SEED (default ./data) by the first begin() that finds it missing.
+// Delete the directory to reseed. Paths, modes ("r", "w", "a" and their "+" forms),
+// directory iteration (openNextFile), seek and append behave like the ESP32 FS API;
+// name() is the last path component, path() the full path.
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+struct SimFileImpl;
+
+class File {
+public:
+    File() {}
+    explicit File(std::shared_ptr<SimFileImpl> impl) : impl_(impl) {}
+
+    operator bool() const;
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t size);
+    size_t write(const char* data, size_t len) { return write((const uint8_t*)data, len); }
+    size_t write(const char* str) { return write((const uint8_t*)str, strlen(str)); }
+    size_t print(const char* str) { return write(str); }
+    size_t print(const String& str);
+    int available();
+    int read();
+    int peek();
+    size_t read(uint8_t* buf, size_t size);
+    size_t readBytes(char* buffer, size_t length) { return read((uint8_t*)buffer, length); }
+    bool seek(uint32_t pos, SeekMode mode = SeekSet);
+    size_t position() const;
+    size_t size() const;
+    void flush();
+    void close();
+    const char* name() const;
+    const char* path() const;
+    bool isDirectory() const;
+    File openNextFile(const char* mode = "r");
+    void rewindDirectory();
+    time_t getLastWrite();
+
+private:
+    std::shared_ptr<SimFileImpl> impl_;  // Shared like the device's File, closed once
+};
+
+class FFatClass {
+public:
+    bool begin(bool formatOnFail = false, const char* basePath = "/ffat", uint8_t maxOpenFiles = 10,
+               const char* partitionLabel = "ffat");
+    void end() { mounted_ = false; }
+    bool format();
+    File open(const char* path, const char* mode = "r", bool create = false);
+    File open(const String& path, const char* mode = "r", bool create = false) { return open(path.c_str(), mode, create); }
+    bool exists(const char* path);
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool remove(const char* path);
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rename(const char* from, const char* to);
+    bool rename(const String& from, const String& to) { return rename(from.c_str(), to.c_str()); }
+    bool mkdir(const char* path);
+    bool mkdir(const String& path) { return mkdir(path.c_str()); }
+    bool rmdir(const char* path);
+    bool rmdir(const String& path) { return rmdir(path.c_str()); }
+    size_t totalBytes() { return 9 * 1024 * 1024; }  // Same as the app3M_fat9M partition
+    size_t usedBytes();                             // Host files rounded up to 4 KB clusters
+    size_t freeBytes() { size_t used = usedBytes(); return used < totalBytes() ? totalBytes() - used : 0; }
+    const std::string& root() const { return root_; }
+
+private:
+    bool mounted_ = false;
+    std::string root_;
+    std::string hostPath(const char* path) const;
+};
+
+extern FFatClass FFat;
+
 // ===== Simulation Control Functions =====
 namespace Simulation {
     void setTimeAcceleration(double factor);
@@ -342,6 +734,17 @@ namespace Simulation {
     void setTargetTemperature(double temp);
     void logState();
     void runTestSequence();
+    void setADCNoise(double stdDevCounts, double spikeProbability, double spikeAmplitude);
+    void benchmarkRtdSampler(int outputs);
+    void benchmarkHeaterTimer(int windows, unsigned long stallMs);
+    void benchmarkMotorPulse(int pulses, unsigned long stallMs);
+    void benchmarkControlTask(int seconds, unsigned long handlerStallMs);
+    void benchmarkCommandQueue(int commandsPerProducer, int producers);
+    void setFlashTiming(uint32_t openUs, uint32_t programUsPerSector, uint32_t eraseUs,
+                        uint32_t eraseStallEvery, uint32_t eraseStallUs);
+    void setNetworkRtt(uint32_t rttUs);
+    void benchmarkStorage(int largeKb, int appends);
+    void benchmarkWebServer(int pollers, int seconds);
 }
 
 #endif // NATIVE_SIMULATION
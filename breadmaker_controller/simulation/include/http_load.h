@@ -0,0 +1,230 @@
+#pragma once
+// HTTP load generator for the native_sim web server (and, over the LAN, the device).
+// N poller threads each request the paths round robin and wait intervalMs between
+// requests (0 = back to back). Without keepAlive every request opens a connection
+// and sends "Connection: close"; with it each poller keeps one connection for as long
+// as the server does, and reconnects (retrying the GET once, as browsers do) when the
+// server has closed it. Responses are read in full (Content-Length, chunked or until
+// close) so the server's streaming time is part of the latency. Header-only so
+// Simulation::benchmarkWebServer() and the tools/http_load CLI share it; it uses
+// plain POSIX sockets, no Arduino types.
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace HttpLoad {
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int port = 8080;
+    std::vector<std::string> paths = { "/api/status" };
+    int pollers = 4;
+    int seconds = 10;
+    int intervalMs = 0;            // Per poller, between requests
+    int timeoutMs = 5000;          // Connect + full response
+    bool keepAlive = false;        // Reuse each poller's connection
+};
+
+struct Result {
+    uint64_t requests = 0;         // Completed with a 2xx status
+    uint64_t errors = 0;           // Connect/read failures, timeouts, non-2xx
+    uint64_t bytes = 0;            // Response bodies
+    uint64_t connections = 0;      // TCP connections opened
+    double seconds = 0;
+    double p50Ms = 0, p90Ms = 0, p99Ms = 0, maxMs = 0, avgMs = 0;
+    double requestsPerSecond() const { return seconds > 0 ? requests / seconds : 0; }
+};
+
+// Reads until the full response is in; returns the body size, or -1 on failure.
+// reusable is false when the server closes the connection after this response.
+inline long readResponse(int fd, int& status, bool& reusable, std::chrono::steady_clock::time_point deadline) {
+    std::string data;
+    char buf[8192];
+    size_t headEnd = std::string::npos;
+    long contentLength = -1;
+    bool chunked = false;
+    auto recvMore = [&]() -> int {
+        int remaining = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) return -1;
+        pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, remaining) <= 0) return -1;
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n > 0) data.append(buf, n);
+        return (int)n;
+    };
+    while (headEnd == std::string::npos) {
+        if (recvMore() <= 0) return -1;
+        headEnd = data.find("\r\n\r\n");
+    }
+    status = atoi(data.c_str() + data.find(' ') + 1);
+    std::string head = data.substr(0, headEnd);
+    std::transform(head.begin(), head.end(), head.begin(), ::tolower);
+    size_t cl = head.find("\r\ncontent-length:");
+    if (cl != std::string::npos) contentLength = strtol(head.c_str() + cl + 17, nullptr, 10);
+    chunked = head.find("transfer-encoding: chunked") != std::string::npos;
+    reusable = head.find("\r\nconnection: close") == std::string::npos && (chunked || contentLength >= 0);
+    size_t pos = headEnd + 4;
+
+    if (chunked) {
+        long body = 0;
+        for (;;) {
+            size_t lineEnd;
+            while ((lineEnd = data.find("\r\n", pos)) == std::string::npos) {
+                if (recvMore() <= 0) return -1;
+            }
+            long size = strtol(data.c_str() + pos, nullptr, 16);
+            size_t need = lineEnd + 2 + size + 2;
+            while (data.size() < need) {
+                if (recvMore() <= 0) return -1;
+            }
+            body += size;
+            pos = need;
+            if (size == 0) return body;
+        }
+    }
+    if (contentLength >= 0) {
+        while ((long)(data.size() - pos) < contentLength) {
+            if (recvMore() <= 0) return -1;
+        }
+        return contentLength;
+    }
+    for (;;) {
+        int n = recvMore();
+        if (n == 0) return (long)(data.size() - pos);
+        if (n < 0) return -1;
+    }
+}
+
+inline int connectTo(const Options& opt, const sockaddr_in& addr) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    timeval tv = { opt.timeoutMs / 1000, (opt.timeoutMs % 1000) * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    if (connect(fd, (const sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// One GET, on the poller's open connection (fd) if it has one, else on a new one
+// (counted in connections). Returns the latency in microseconds, or -1. fd is left
+// open for the next request only when both sides keep the connection.
+inline long request(const Options& opt, const sockaddr_in& addr, const std::string& path, uint64_t& bodyBytes,
+                    int& fd, uint64_t& connections) {
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::milliseconds(opt.timeoutMs);
+    std::string req = "GET " + path + " HTTP/1.1\r\nHost: " + opt.host +
+                      (opt.keepAlive ? "\r\n\r\n" : "\r\nConnection: close\r\n\r\n");
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = fd >= 0;
+        if (!reused) {
+            fd = connectTo(opt, addr);
+            if (fd < 0) return -1;
+            connections++;
+        }
+        int status = 0;
+        bool reusable = false;
+        long body = -1;
+        if (send(fd, req.data(), req.size(), MSG_NOSIGNAL) == (ssize_t)req.size()) {
+            body = readResponse(fd, status, reusable, deadline);
+        }
+        if (body < 0 || !opt.keepAlive || !reusable) {
+            close(fd);
+            fd = -1;
+        }
+        if (body < 0 && reused) continue;  // The server closed the idle connection first
+        if (body < 0 || status < 200 || status >= 300) return -1;
+        bodyBytes = body;
+        return (long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+    return -1;
+}
+
+inline bool resolve(const Options& opt, sockaddr_in& addr) {
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)opt.port);
+    if (inet_pton(AF_INET, opt.host.c_str(), &addr.sin_addr) == 1) return true;
+    addrinfo hints = {}, *info = nullptr;
+    hints.ai_family = AF_INET;
+    if (getaddrinfo(opt.host.c_str(), nullptr, &hints, &info) != 0 || !info) return false;
+    addr.sin_addr = ((sockaddr_in*)info->ai_addr)->sin_addr;
+    freeaddrinfo(info);
+    return true;
+}
+
+inline double percentileMs(const std::vector<long>& sortedUs, double p) {
+    if (sortedUs.empty()) return 0;
+    size_t i = std::min(sortedUs.size() - 1, (size_t)(p * sortedUs.size()));
+    return sortedUs[i] / 1000.0;
+}
+
+inline Result run(const Options& opt) {
+    Result r;
+    sockaddr_in addr;
+    if (!resolve(opt, addr) || opt.paths.empty()) return r;
+    std::mutex mutex;
+    std::vector<long> latencies;
+    std::atomic<uint64_t> errors{0}, bytes{0}, connections{0};
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + std::chrono::seconds(opt.seconds);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < std::max(opt.pollers, 1); p++) {
+        threads.emplace_back([&, p]() {
+            std::vector<long> local;
+            size_t next = p;  // Stagger the pollers across the paths
+            int fd = -1;
+            uint64_t opened = 0;
+            while (std::chrono::steady_clock::now() < end) {
+                uint64_t body = 0;
+                long us = request(opt, addr, opt.paths[next++ % opt.paths.size()], body, fd, opened);
+                if (us < 0) {
+                    errors++;
+                } else {
+                    local.push_back(us);
+                    bytes += body;
+                }
+                if (opt.intervalMs > 0) std::this_thread::sleep_for(std::chrono::milliseconds(opt.intervalMs));
+            }
+            if (fd >= 0) close(fd);
+            connections += opened;
+            std::lock_guard<std::mutex> lock(mutex);
+            latencies.insert(latencies.end(), local.begin(), local.end());
+        });
+    }
+    for (auto& t : threads) t.join();
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::sort(latencies.begin(), latencies.end());
+    r.requests = latencies.size();
+    r.errors = errors;
+    r.bytes = bytes;
+    r.connections = connections;
+    r.p50Ms = percentileMs(latencies, 0.50);
+    r.p90Ms = percentileMs(latencies, 0.90);
+    r.p99Ms = percentileMs(latencies, 0.99);
+    r.maxMs = latencies.empty() ? 0 : latencies.back() / 1000.0;
+    uint64_t total = 0;
+    for (long us : latencies) total += us;
+    r.avgMs = latencies.empty() ? 0 : total / 1000.0 / latencies.size();
+    return r;
+}
+
+}  // namespace HttpLoad
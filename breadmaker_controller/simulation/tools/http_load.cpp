@@ -0,0 +1,49 @@
+// HTTP load generator CLI (simulation/include/http_load.h).
+//
+// Points N concurrent pollers at a running server - the native_sim build on
+// localhost:8080, or the device on the LAN - and reports throughput and latency
+// percentiles. Control-loop impact is reported by the server itself
+// (/api/control_task on the device, Simulation::benchmarkWebServer() in the sim).
+//
+// Build from this directory:
+//   g++ -std=c++17 -O2 -I../include http_load.cpp -o http_load -lpthread
+//   ./http_load [--host H] [--port P] [--pollers N] [--seconds S] [--interval MS] [--keepalive] [path ...]
+//
+// Run once with and once without --keepalive to see what connection setup costs.
+
+#include "http_load.h"
+#include <cstdio>
+
+int main(int argc, char** argv) {
+  HttpLoad::Options opt;
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (a == "--host" && hasValue) opt.host = argv[++i];
+    else if (a == "--port" && hasValue) opt.port = atoi(argv[++i]);
+    else if (a == "--pollers" && hasValue) opt.pollers = atoi(argv[++i]);
+    else if (a == "--seconds" && hasValue) opt.seconds = atoi(argv[++i]);
+    else if (a == "--interval" && hasValue) opt.intervalMs = atoi(argv[++i]);
+    else if (a == "--timeout" && hasValue) opt.timeoutMs = atoi(argv[++i]);
+    else if (a == "--keepalive") opt.keepAlive = true;
+    else if (a[0] == '/') paths.push_back(a);
+    else {
+      fprintf(stderr, "usage: %s [--host H] [--port P] [--pollers N] [--seconds S] [--interval MS] [--timeout MS] [--keepalive] [path ...]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (!paths.empty()) opt.paths = paths;
+
+  printf("%d pollers for %d s against %s:%d (%zu paths, %d ms interval, %s)\n",
+         opt.pollers, opt.seconds, opt.host.c_str(), opt.port, opt.paths.size(), opt.intervalMs,
+         opt.keepAlive ? "keep-alive" : "connection per request");
+  HttpLoad::Result r = HttpLoad::run(opt);
+  printf("requests %llu (%.1f/s), errors %llu, %.1f KB received\n",
+         (unsigned long long)r.requests, r.requestsPerSecond(), (unsigned long long)r.errors, r.bytes / 1024.0);
+  printf("connections %llu (%.1f requests each)\n", (unsigned long long)r.connections,
+         r.connections ? (double)r.requests / r.connections : 0.0);
+  printf("latency ms: avg %.2f  p50 %.2f  p90 %.2f  p99 %.2f  max %.2f\n",
+         r.avgMs, r.p50Ms, r.p90Ms, r.p99Ms, r.maxMs);
+  return r.requests ? 0 : 1;
+}
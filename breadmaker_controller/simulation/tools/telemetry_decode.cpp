@@ -0,0 +1,272 @@
+// Host decoder for the binary telemetry stream (telemetry_stream.cpp, telemetry_format.h).
+//
+// Reads a raw capture (or the serial port itself), splits it on the 0x00 delimiters,
+// COBS-decodes and CRC-checks each frame and writes the samples as CSV, or as one
+// little-endian binary file per column for numpy/pandas (np.fromfile(dir + "/temperature.f32",
+// np.float32)). Text that was on the port before the stream started, or between frames,
+// lands in one rejected frame and is counted as noise. Sequence gaps are frames the
+// device dropped because the UART was full.
+//
+// Build from this directory:
+//   g++ -std=c++17 -O2 -I../.. telemetry_decode.cpp -o telemetry_decode
+//   ./telemetry_decode [--csv out.csv | --columns DIR] [--baud N] [--seconds S] <capture.bin | /dev/ttyUSB0 | ->
+//
+// Start the stream with "telemetry:on" on the serial console or /api/telemetry?enable=1.
+
+#include "telemetry_format.h"
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+
+struct DecodeStats {
+  uint64_t bytes = 0;
+  uint64_t frames = 0;        // Valid samples
+  uint64_t crcErrors = 0;
+  uint64_t badFrames = 0;     // Malformed COBS, wrong length, type or version (text lands here)
+  uint64_t noiseBytes = 0;    // Bytes in rejected frames
+  uint64_t gaps = 0;          // Sequence discontinuities
+  uint64_t missing = 0;       // Samples lost in those gaps
+};
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) { stopRequested = 1; }
+
+static speed_t baudConstant(int baud) {
+  switch (baud) {
+    case 9600: return B9600;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default: return 0;
+  }
+}
+
+static int openInput(const std::string& path, int baud) {
+  if (path == "-") return STDIN_FILENO;
+  int fd = open(path.c_str(), O_RDONLY | O_NOCTTY);
+  if (fd < 0) return -1;
+  if (isatty(fd)) {
+    termios tio{};
+    tcgetattr(fd, &tio);
+    cfmakeraw(&tio);
+    speed_t speed = baudConstant(baud);
+    if (!speed) {
+      fprintf(stderr, "unsupported baud rate %d\n", baud);
+      close(fd);
+      return -1;
+    }
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 2;   // Return every 200 ms so --seconds and Ctrl-C are noticed
+    tcsetattr(fd, TCSANOW, &tio);
+    tcflush(fd, TCIFLUSH);
+  }
+  return fd;
+}
+
+// Writes each column as a raw little-endian array plus columns.txt (name type count)
+class ColumnWriter {
+  public:
+    bool open(const std::string& dir) {
+      mkdir(dir.c_str(), 0755);
+      this->dir = dir;
+      for (const Column& c : COLUMNS) {
+        FILE* f = fopen((dir + "/" + c.name + (c.isFloat ? ".f32" : ".u32")).c_str(), "wb");
+        if (!f) return false;
+        files.push_back(f);
+      }
+      return true;
+    }
+
+    void write(const TelemetrySample& s) {
+      for (size_t i = 0; i < files.size(); i++) {
+        float f = 0.0f;
+        uint32_t u = 0;
+        switch (i) {
+          case 0: u = s.timeMs; break;
+          case 1: u = s.sequence; break;
+          case 2: f = s.rawAdc; break;
+          case 3: f = s.temperature; break;
+          case 4: f = s.setpoint; break;
+          case 5: f = s.pidP; break;
+          case 6: f = s.pidI; break;
+          case 7: f = s.pidD; break;
+          case 8: f = s.output; break;
+          case 9: u = s.flags; break;
+          case 10: u = s.stage; break;
+        }
+        if (COLUMNS[i].isFloat) fwrite(&f, sizeof(f), 1, files[i]);
+        else fwrite(&u, sizeof(u), 1, files[i]);
+      }
+      rows++;
+    }
+
+    void close() {
+      for (FILE* f : files) fclose(f);
+      files.clear();
+      FILE* index = fopen((dir + "/columns.txt").c_str(), "w");
+      if (!index) return;
+      for (const Column& c : COLUMNS) fprintf(index, "%s %s %llu\n", c.name, c.isFloat ? "float32" : "uint32", (unsigned long long)rows);
+      fclose(index);
+    }
+
+  private:
+    struct Column { const char* name; bool isFloat; };
+    // Order matches the switch in write()
+    static constexpr Column COLUMNS[] = {
+      {"time_ms", false}, {"sequence", false}, {"raw_adc", true}, {"temperature", true}, {"setpoint", true},
+      {"pid_p", true}, {"pid_i", true}, {"pid_d", true}, {"output", true}, {"flags", false}, {"stage", false}
+    };
+    std::string dir;
+    std::vector<FILE*> files;
+    uint64_t rows = 0;
+};
+constexpr ColumnWriter::Column ColumnWriter::COLUMNS[];
+
+static void writeCsvHeader(FILE* out) {
+  fprintf(out, "time_ms,sequence,raw_adc,temperature,setpoint,pid_p,pid_i,pid_d,output,heater,motor,light,buzzer,running,sensor_valid,stage\n");
+}
+
+static void writeCsvRow(FILE* out, const TelemetrySample& s) {
+  fprintf(out, "%u,%u,%.2f,%.3f,%.2f,%.5f,%.5f,%.5f,%.5f,%d,%d,%d,%d,%d,%d,%u\n",
+          s.timeMs, s.sequence, s.rawAdc, s.temperature, s.setpoint, s.pidP, s.pidI, s.pidD, s.output,
+          !!(s.flags & TELEMETRY_HEATER), !!(s.flags & TELEMETRY_MOTOR), !!(s.flags & TELEMETRY_LIGHT),
+          !!(s.flags & TELEMETRY_BUZZER), !!(s.flags & TELEMETRY_RUNNING), !!(s.flags & TELEMETRY_SENSOR_VALID), s.stage);
+}
+
+// Validates one delimited frame; fills sample when it is a good record
+static bool decodeFrame(const uint8_t* frame, size_t len, TelemetrySample& sample, DecodeStats& st) {
+  uint8_t payload[TELEMETRY_FRAME_MAX];
+  if (len == 0) return false;   // Back-to-back delimiters
+  size_t n = len <= TELEMETRY_FRAME_MAX ? cobsDecode(frame, len, payload) : 0;
+  if (n != TELEMETRY_PAYLOAD_SIZE) {
+    st.badFrames++;
+    st.noiseBytes += len;
+    return false;
+  }
+  uint16_t crc = payload[sizeof(TelemetrySample)] | (payload[sizeof(TelemetrySample) + 1] << 8);
+  if (telemetryCrc16(payload, sizeof(TelemetrySample)) != crc) {
+    st.crcErrors++;
+    st.noiseBytes += len;
+    return false;
+  }
+  memcpy(&sample, payload, sizeof(sample));
+  if (sample.type != TELEMETRY_RECORD_SAMPLE || sample.version != TELEMETRY_FORMAT_VERSION) {
+    st.badFrames++;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  std::string input, csvPath, columnsDir;
+  int baud = 115200, seconds = 0;
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (a == "--csv" && hasValue) csvPath = argv[++i];
+    else if (a == "--columns" && hasValue) columnsDir = argv[++i];
+    else if (a == "--baud" && hasValue) baud = atoi(argv[++i]);
+    else if (a == "--seconds" && hasValue) seconds = atoi(argv[++i]);
+    else if (input.empty() && (a == "-" || a[0] != '-')) input = a;
+    else input.clear(), i = argc;
+  }
+  if (input.empty()) {
+    fprintf(stderr, "usage: %s [--csv out.csv | --columns DIR] [--baud N] [--seconds S] <capture.bin | /dev/ttyUSB0 | ->\n", argv[0]);
+    return 2;
+  }
+
+  int fd = openInput(input, baud);
+  if (fd < 0) {
+    fprintf(stderr, "%s: %s\n", input.c_str(), strerror(errno));
+    return 1;
+  }
+  FILE* csv = nullptr;
+  ColumnWriter columns;
+  bool columnar = !columnsDir.empty();
+  if (columnar) {
+    if (!columns.open(columnsDir)) {
+      fprintf(stderr, "%s: cannot create column files\n", columnsDir.c_str());
+      return 1;
+    }
+  } else {
+    csv = csvPath.empty() ? stdout : fopen(csvPath.c_str(), "w");
+    if (!csv) {
+      fprintf(stderr, "%s: %s\n", csvPath.c_str(), strerror(errno));
+      return 1;
+    }
+    writeCsvHeader(csv);
+  }
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  DecodeStats st;
+  uint8_t buf[4096];
+  std::vector<uint8_t> frame;
+  frame.reserve(256);
+  bool haveLast = false;
+  uint16_t lastSequence = 0;
+  uint32_t firstMs = 0, lastMs = 0;
+  time_t deadline = seconds > 0 ? time(nullptr) + seconds : 0;
+
+  while (!stopRequested && (!deadline || time(nullptr) < deadline)) {
+    ssize_t got = read(fd, buf, sizeof(buf));
+    if (got < 0 && errno == EINTR) continue;
+    if (got < 0) break;
+    if (got == 0) {
+      if (isatty(fd)) continue;   // Serial read timeout
+      break;                      // End of file
+    }
+    st.bytes += got;
+    for (ssize_t i = 0; i < got; i++) {
+      if (buf[i] != 0) {
+        // Cap runaway frames (long text, or a lost delimiter); they are rejected anyway
+        if (frame.size() < 1024) frame.push_back(buf[i]);
+        else st.noiseBytes++;
+        continue;
+      }
+      TelemetrySample s;
+      bool ok = decodeFrame(frame.data(), frame.size(), s, st);
+      frame.clear();
+      if (!ok) continue;
+
+      if (haveLast && s.sequence != (uint16_t)(lastSequence + 1)) {
+        st.gaps++;
+        st.missing += (uint16_t)(s.sequence - lastSequence - 1);
+      }
+      if (!haveLast) firstMs = s.timeMs;
+      haveLast = true;
+      lastSequence = s.sequence;
+      lastMs = s.timeMs;
+      st.frames++;
+      if (columnar) columns.write(s);
+      else writeCsvRow(csv, s);
+    }
+  }
+
+  if (columnar) columns.close();
+  else if (csv != stdout) fclose(csv);
+  if (fd != STDIN_FILENO) close(fd);
+
+  double spanS = (lastMs - firstMs) / 1000.0;
+  fprintf(stderr, "%llu bytes, %llu samples over %.1f s (%.1f Hz)\n", (unsigned long long)st.bytes,
+          (unsigned long long)st.frames, spanS, spanS > 0 ? (st.frames - 1) / spanS : 0.0);
+  fprintf(stderr, "rejected: %llu malformed, %llu CRC errors, %llu noise bytes\n",
+          (unsigned long long)st.badFrames, (unsigned long long)st.crcErrors, (unsigned long long)st.noiseBytes);
+  fprintf(stderr, "sequence gaps: %llu (%llu samples missing: dropped by the device or rejected above)\n",
+          (unsigned long long)st.gaps, (unsigned long long)st.missing);
+  return st.frames ? 0 : 1;
+}
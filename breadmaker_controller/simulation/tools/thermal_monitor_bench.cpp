@@ -0,0 +1,214 @@
+// Host benchmark for the predictive thermal monitor (thermal_monitor.cpp).
+//
+// Runs simulated proof/bake profiles through the same ThermalMonitor the firmware
+// uses and reports false positives per hour on healthy runs and decision latency
+// for injected faults (dead element, welded relay, stuck sensor). Recorded runs
+// can be replayed from CSV (t_ms,temp,heater,raw - one row per second is enough).
+//
+// Build from this directory:
+//   g++ -std=c++17 -O2 -I../.. thermal_monitor_bench.cpp ../../thermal_monitor.cpp -o thermal_monitor_bench
+//   ./thermal_monitor_bench [--hours N] [--seeds N] [--power C_PER_S] [--replay run.csv]
+//
+// --power sets the element's full-power heating rate; a faster element ramps steeply
+// towards the 180/230°C setpoints, which the overtemperature prediction must not
+// mistake for a fault.
+
+#include "thermal_monitor.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+enum Injection { INJECT_NONE, INJECT_DEAD_ELEMENT, INJECT_WELDED_RELAY, INJECT_STUCK_SENSOR };
+
+static double elementPower = 6.0;
+
+// Two-node plant: the element heats the chamber through a lag, the chamber loses to ambient
+struct OvenPlant {
+  double element = 22.0;
+  double chamber = 22.0;
+  double ambient = 22.0;
+  double power = elementPower; // Element °C/s at full power when cold
+  double coupling = 0.08;    // Element -> chamber (1/s)
+  double chamberShare = 0.1; // Chamber heat capacity relative to element coupling
+  double loss = 0.0025;      // Chamber -> ambient (1/s)
+
+  void step(bool heaterOn, double dt) {
+    double flow = coupling * (element - chamber);
+    element += dt * ((heaterOn ? power : 0.0) - flow);
+    chamber += dt * (chamberShare * flow - loss * (chamber - ambient));
+  }
+};
+
+struct RunResult {
+  uint32_t alarms = 0;
+  uint32_t byType[5] = {0, 0, 0, 0, 0};
+  ThermalFault firstFault = THERMAL_OK;
+  double firstFaultTime = -1;
+  double decisionLatency = 0;
+  double maxTemp = 0;
+};
+
+static RunResult runProfile(double setpoint, double seconds, Injection inject, double injectAt,
+                            unsigned seed, const ThermalMonitorConfig& cfg) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<double> noise(0.0, 0.05);   // °C after oversampling
+  std::normal_distribution<double> rawNoise(0.0, 0.3); // ADC counts after decimation
+
+  OvenPlant plant;
+  plant.ambient = plant.chamber = plant.element = 18.0 + (seed % 8);
+  ThermalMonitor mon;
+  mon.config = cfg;
+  mon.reset();
+
+  const double dt = 0.1;
+  const double windowSec = 30.0;  // Time-proportional window like the firmware's pidWindowSize
+  double onTime = 0.0, duty = 0.0, windowStart = 0.0, heaterOnSeconds = 0.0;
+  double stuckRaw = -1.0;
+  RunResult res;
+
+  for (int tick = 0; tick * dt < seconds; tick++) {
+    double t = tick * dt;
+    double measured = plant.chamber + noise(rng);
+
+    // Proportional + loss feed-forward controller, recomputed each window
+    if (t - windowStart >= windowSec || tick == 0) {
+      windowStart = t;
+      double ff = plant.loss * (setpoint - plant.ambient) / (plant.chamberShare * plant.power);
+      duty = std::min(1.0, std::max(0.0, 0.15 * (setpoint - measured) + ff));
+      onTime = duty * windowSec;
+    }
+    bool commanded = (t - windowStart) < onTime;
+    bool actual = commanded;
+    bool injected = inject != INJECT_NONE && t >= injectAt;
+    if (injected && inject == INJECT_DEAD_ELEMENT) actual = false;
+    if (injected && inject == INJECT_WELDED_RELAY) actual = true;
+
+    plant.step(actual, dt);
+    if (commanded) heaterOnSeconds += dt;  // Firmware only knows what it commanded
+    res.maxTemp = std::max(res.maxTemp, plant.chamber);
+
+    if (tick % 10 == 9) {
+      double raw = 3200.0 - 10.0 * measured + rawNoise(rng);
+      if (injected && inject == INJECT_STUCK_SENSOR) {
+        if (stuckRaw < 0) stuckRaw = raw;
+        raw = stuckRaw;
+        measured = (3200.0 - raw) / 10.0;
+      }
+      ThermalSample s{(float)t, (float)measured, (float)heaterOnSeconds, (float)raw, (uint32_t)(tick / 10 + 1), (float)setpoint};
+      ThermalFault f = mon.update(s);
+      if (f != THERMAL_OK) {
+        res.alarms++;
+        res.byType[f]++;
+        if (res.firstFault == THERMAL_OK) {
+          res.firstFault = f;
+          res.firstFaultTime = t;
+          res.decisionLatency = mon.stats.lastDecisionLatency;
+        }
+        mon.clearFault();  // Keep counting on healthy runs
+        if (inject != INJECT_NONE) break;
+      }
+    }
+  }
+  return res;
+}
+
+static int replay(const char* path, const ThermalMonitorConfig& cfg) {
+  FILE* f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "Cannot open %s\n", path);
+    return 1;
+  }
+  ThermalMonitor mon;
+  mon.config = cfg;
+  mon.reset();
+  char line[256];
+  double lastMs = -1, onSeconds = 0;
+  int lastHeater = 0;
+  unsigned rows = 0, alarms = 0;
+  double firstMs = -1;
+  while (fgets(line, sizeof(line), f)) {
+    double ms, temp, raw;
+    int heater;
+    if (sscanf(line, "%lf,%lf,%d,%lf", &ms, &temp, &heater, &raw) != 4) continue;  // Header or junk
+    if (firstMs < 0) firstMs = ms;
+    if (lastMs >= 0 && lastHeater) onSeconds += (ms - lastMs) / 1000.0;
+    lastMs = ms;
+    lastHeater = heater;
+    rows++;
+    ThermalSample s{(float)((ms - firstMs) / 1000.0), (float)temp, (float)onSeconds, (float)raw, rows};
+    ThermalFault fault = mon.update(s);
+    if (fault != THERMAL_OK) {
+      alarms++;
+      printf("  t=%8.0fs %-20s gain=%.4f slope=%.4f duty=%.2f latency=%.0fs\n", s.timeSec,
+             thermalFaultName(fault), mon.stats.heaterGain, mon.stats.slope, mon.stats.dutyMean,
+             mon.stats.lastDecisionLatency);
+      mon.clearFault();
+    }
+  }
+  fclose(f);
+  double hours = rows > 1 ? (lastMs - firstMs) / 3600000.0 : 0.0;
+  printf("Replay %s: %u samples, %.2f h, %u alarms (%.2f/h)\n", path, rows, hours, alarms,
+         hours > 0 ? alarms / hours : 0.0);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  double hours = 2.0;
+  unsigned seeds = 20;
+  ThermalMonitorConfig cfg;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--hours") && i + 1 < argc) hours = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--seeds") && i + 1 < argc) seeds = (unsigned)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--power") && i + 1 < argc) elementPower = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--replay") && i + 1 < argc) return replay(argv[++i], cfg);
+    else {
+      fprintf(stderr, "usage: %s [--hours N] [--seeds N] [--power C_PER_S] [--replay file.csv]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  const double setpoints[] = {28.0, 35.0, 180.0, 230.0};
+  const char* names[] = {"proof 28C", "rise 35C", "bake 180C", "bake 230C"};
+  const int profiles = sizeof(setpoints) / sizeof(setpoints[0]);
+
+  printf("Healthy runs (%u seeds x %.1f h per profile)\n", seeds, hours);
+  for (int p = 0; p < profiles; p++) {
+    uint32_t alarms = 0, byType[5] = {0, 0, 0, 0, 0};
+    double maxT = 0;
+    for (unsigned s = 0; s < seeds; s++) {
+      RunResult r = runProfile(setpoints[p], hours * 3600.0, INJECT_NONE, 0, s, cfg);
+      alarms += r.alarms;
+      for (int k = 0; k < 5; k++) byType[k] += r.byType[k];
+      maxT = std::max(maxT, r.maxTemp);
+    }
+    printf("  %-10s false positives: %u (%.3f/h) [no_rise %u, runaway %u, predicted %u, stuck %u], max %.1fC\n",
+           names[p], alarms, alarms / (hours * seeds), byType[1], byType[2], byType[3], byType[4], maxT);
+  }
+
+  const Injection faults[] = {INJECT_DEAD_ELEMENT, INJECT_WELDED_RELAY, INJECT_STUCK_SENSOR};
+  const char* faultNames[] = {"dead element", "welded relay", "stuck sensor"};
+  printf("\nInjected faults at t=1200s (mean over %u seeds)\n", seeds);
+  for (int fi = 0; fi < 3; fi++) {
+    for (int p = 0; p < profiles; p++) {
+      unsigned detected = 0;
+      double detectSum = 0, latencySum = 0, overshootMax = 0;
+      ThermalFault kind = THERMAL_OK;
+      for (unsigned s = 0; s < seeds; s++) {
+        RunResult r = runProfile(setpoints[p], 3600.0, faults[fi], 1200.0, s, cfg);
+        overshootMax = std::max(overshootMax, r.maxTemp - setpoints[p]);
+        if (r.firstFault != THERMAL_OK && r.firstFaultTime >= 1200.0) {
+          detected++;
+          detectSum += r.firstFaultTime - 1200.0;
+          latencySum += r.decisionLatency;
+          kind = r.firstFault;
+        }
+      }
+      printf("  %-13s %-10s detected %2u/%u as %-18s after %6.1fs (CUSUM latency %5.1fs), max overshoot %.1fC\n",
+             faultNames[fi], names[p], detected, seeds, thermalFaultName(kind),
+             detected ? detectSum / detected : 0.0, detected ? latencySum / detected : 0.0, overshootMax);
+    }
+  }
+  return 0;
+}
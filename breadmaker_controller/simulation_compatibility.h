@@ -4,8 +4,8 @@
 #ifdef NATIVE_SIMULATION
     #include "simulation/include/arduino_simulation.h"
     
-    // Mock ESP32-specific libraries for simulation
-    #define CONTENT_LENGTH_UNKNOWN SIZE_MAX
+    // Mock ESP32-specific libraries for simulation (WebServer, CONTENT_LENGTH_UNKNOWN
+    // and WiFiClient come from arduino_simulation.h)
     
     // TFT Display simulation
     class TFT_eSPI {
@@ -46,6 +46,56 @@
     };
     extern SPIFFSClass SPIFFS;
     
+    // MQTT client simulation: a broker that accepts every connection and keeps the
+    // last retained payload per topic, so mqtt_publisher.cpp runs without one.
+    // simulatedMqttClient() is the last client created, for injecting commands.
+    class PubSubClient;
+    inline PubSubClient*& simulatedMqttClient() { static PubSubClient* client = nullptr; return client; }
+    
+    class PubSubClient {
+    public:
+        typedef std::function<void(char*, uint8_t*, unsigned int)> Callback;
+        explicit PubSubClient(WiFiClient&) { simulatedMqttClient() = this; }
+        PubSubClient& setServer(const char* host, uint16_t port) { return *this; }
+        PubSubClient& setCallback(Callback cb) { callback_ = cb; return *this; }
+        PubSubClient& setSocketTimeout(uint16_t seconds) { return *this; }
+        bool setBufferSize(uint16_t size) { bufferSize_ = size; return true; }
+        bool connect(const char* id, const char* willTopic, uint8_t willQos, bool willRetain, const char* willMessage) {
+            connected_ = true;
+            will_ = willTopic;
+            Serial.printf("[SIM] MQTT %s connected\n", id);
+            return true;
+        }
+        bool connect(const char* id, const char* user, const char* pass, const char* willTopic, uint8_t willQos,
+                     bool willRetain, const char* willMessage) {
+            return connect(id, willTopic, willQos, willRetain, willMessage);
+        }
+        void disconnect() { connected_ = false; }
+        bool connected() { return connected_; }
+        int state() { return connected_ ? 0 : -1; }
+        bool loop() { return connected_; }
+        bool subscribe(const char* topic) { return connected_; }
+        bool publish(const char* topic, const uint8_t* payload, unsigned int length, bool retained) {
+            if (!connected_ || strlen(topic) + length + 7 > bufferSize_) return false;
+            if (retained) retained_[topic] = std::string((const char*)payload, length);
+            published++;
+            return true;
+        }
+        // Delivers a message to the client, as the broker does for a subscribed topic
+        void inject(const char* topic, const char* payload) {
+            std::string t = topic;
+            if (callback_) callback_(&t[0], (uint8_t*)payload, strlen(payload));
+        }
+        const std::map<std::string, std::string>& retained() const { return retained_; }
+        uint32_t published = 0;
+    private:
+        Callback callback_;
+        bool connected_ = false;
+        uint16_t bufferSize_ = 256;
+        std::string will_;
+        std::map<std::string, std::string> retained_;
+    };
+    
     // ESP32Servo simulation
     class Servo {
     public:
@@ -71,6 +121,7 @@
     #include <NTPClient.h>
     #include <WiFiUdp.h>
     #include <ESP32Servo.h>
+    #include <PubSubClient.h>
     #include <SPIFFS.h>
     #include <ArduinoJson.h>
 #endif
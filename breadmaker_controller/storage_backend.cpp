@@ -0,0 +1,82 @@
+#include "storage_backend.h"
+#if defined(NATIVE_SIMULATION)
+// FFat is the host-directory filesystem from arduino_simulation.h
+#elif defined(STORAGE_BACKEND_LITTLEFS)
+#include <LittleFS.h>
+#else
+#include <FFat.h>
+#endif
+
+#if defined(NATIVE_SIMULATION)
+
+bool storageBegin(bool formatOnFail) {
+  return FFat.begin(formatOnFail);
+}
+
+StorageFS& storageFS() {
+  return FFat;
+}
+
+const char* storageBackendName() {
+  return "host";
+}
+
+size_t storageTotalBytes() {
+  return FFat.totalBytes();
+}
+
+size_t storageUsedBytes() {
+  return FFat.usedBytes();
+}
+
+#elif defined(STORAGE_BACKEND_LITTLEFS)
+
+bool storageBegin(bool formatOnFail) {
+  return LittleFS.begin(formatOnFail, "/littlefs", 10, STORAGE_PARTITION_LABEL);
+}
+
+StorageFS& storageFS() {
+  return LittleFS;
+}
+
+const char* storageBackendName() {
+  return "littlefs";
+}
+
+size_t storageTotalBytes() {
+  return LittleFS.totalBytes();
+}
+
+size_t storageUsedBytes() {
+  return LittleFS.usedBytes();
+}
+
+#else
+
+bool storageBegin(bool formatOnFail) {
+  return FFat.begin(formatOnFail, "/ffat", 10, STORAGE_PARTITION_LABEL);
+}
+
+StorageFS& storageFS() {
+  return FFat;
+}
+
+const char* storageBackendName() {
+  return "ffat";
+}
+
+size_t storageTotalBytes() {
+  return FFat.totalBytes();
+}
+
+size_t storageUsedBytes() {
+  return FFat.usedBytes();
+}
+
+#endif
+
+size_t storageFreeBytes() {
+  size_t total = storageTotalBytes();
+  size_t used = storageUsedBytes();
+  return total > used ? total - used : 0;
+}
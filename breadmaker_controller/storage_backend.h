@@ -0,0 +1,34 @@
+#pragma once
+#include <Arduino.h>
+#ifndef NATIVE_SIMULATION
+#include <FS.h>
+#endif
+
+// Filesystem backend.
+// Modules reach flash through storageFS() instead of naming FFat, so the filesystem
+// is a build choice rather than something hard-wired into every file:
+//   FFat      default
+//   LittleFS  -DSTORAGE_BACKEND_LITTLEFS; mounts the same "ffat" data partition and
+//             formats it on first boot, so files must be uploaded again
+//   host      native_sim; FFat emulated on a host directory with a flash timing
+//             model (simulation/arduino_simulation.h)
+// Writes still go through storageOpen() (storage_stats.h) so they are accounted;
+// storageFS() is for reads, directory listing, remove/rename/mkdir and the storage
+// benchmark.
+
+#ifdef NATIVE_SIMULATION
+typedef FFatClass StorageFS;
+#else
+typedef fs::FS StorageFS;
+#endif
+
+#define STORAGE_PARTITION_LABEL "ffat"
+
+// Mounts the backend; formatOnFail formats the partition if it can't be mounted
+bool storageBegin(bool formatOnFail);
+
+StorageFS& storageFS();
+const char* storageBackendName();   // "ffat", "littlefs" or "host"
+size_t storageTotalBytes();
+size_t storageUsedBytes();
+size_t storageFreeBytes();
@@ -0,0 +1,239 @@
+#include "storage_bench.h"
+#include "storage_backend.h"
+#include "storage_stats.h"
+#include "background_jobs.h"
+#ifndef NATIVE_SIMULATION
+#include <esp_timer.h>
+#endif
+
+extern bool debugSerial;
+
+static const char* BENCH_DIR = "/bench";
+static const char* BENCH_SEED = "/bench/seed.txt";
+static const char* BENCH_APPEND_FILE = "/bench/append.log";
+static const char* BENCH_LARGE = "/bench/large.bin";
+
+static StorageBenchResult result;
+
+struct StorageBenchCtx {
+  uint32_t i = 0;
+  uint32_t offset = 0;
+  StorageFile out;      // Large write
+  File file;            // Read back
+  uint8_t* buf = nullptr;
+};
+
+static const char* const PHASE_NAMES[BENCH_PHASE_COUNT] = {
+  "open_read", "open_create", "append", "seq_write", "seq_read"
+};
+
+static void record(uint8_t phase, uint32_t bytes, int64_t us) {
+  StorageBenchPhase& p = result.phases[phase];
+  p.ops++;
+  p.bytes += bytes;
+  p.totalUs += us;
+  if ((uint32_t)us > p.maxUs) p.maxUs = (uint32_t)us;
+}
+
+static void createdPath(char* path, size_t size, uint32_t i) {
+  snprintf(path, size, "%s/c%lu.tmp", BENCH_DIR, (unsigned long)i);
+}
+
+static JobStep storageBenchStep(BackgroundJob& job) {
+  StorageBenchCtx& c = *(StorageBenchCtx*)job.ctx;
+  const StorageBenchConfig& cfg = result.config;
+  JOB_BEGIN(job);
+  if (!storageFS().exists(BENCH_DIR)) storageFS().mkdir(BENCH_DIR);
+  {
+    StorageFile f = storageOpen(BENCH_SEED, "w", "bench");
+    if (!f) {
+      backgroundJobSetMessage(job, "Cannot create %s", BENCH_SEED);
+      return JOB_ERROR;
+    }
+    f.write(c.buf, cfg.appendBytes);
+    f.close();
+  }
+  job.total = cfg.opens * 2 + cfg.appends + 2 * ((cfg.largeBytes + cfg.chunkBytes - 1) / cfg.chunkBytes);
+  JOB_YIELD(job);
+
+  // Open latency: existing file, then new files
+  for (c.i = 0; c.i < cfg.opens; c.i++) {
+    {
+      int64_t startUs = esp_timer_get_time();
+      File f = storageFS().open(BENCH_SEED, "r");
+      bool ok = (bool)f;
+      f.close();
+      if (!ok) {
+        backgroundJobSetMessage(job, "Cannot open %s", BENCH_SEED);
+        return JOB_ERROR;
+      }
+      record(BENCH_OPEN_READ, 0, esp_timer_get_time() - startUs);
+      job.done++;
+    }
+    JOB_YIELD(job);
+  }
+  for (c.i = 0; c.i < cfg.opens; c.i++) {
+    {
+      char path[32];
+      createdPath(path, sizeof(path), c.i);
+      int64_t startUs = esp_timer_get_time();
+      StorageFile f = storageOpen(path, "w", "bench");
+      bool ok = (bool)f;
+      f.close();
+      if (!ok) {
+        backgroundJobSetMessage(job, "Cannot create %s", path);
+        return JOB_ERROR;
+      }
+      record(BENCH_OPEN_CREATE, 0, esp_timer_get_time() - startUs);
+      job.done++;
+    }
+    JOB_YIELD(job);
+  }
+  for (c.i = 0; c.i < cfg.opens; c.i++) {
+    {
+      char path[32];
+      createdPath(path, sizeof(path), c.i);
+      storageFS().remove(path);  // Untimed
+    }
+    JOB_YIELD(job);
+  }
+
+  // Small appends: open, one line, close
+  for (c.i = 0; c.i < cfg.appends; c.i++) {
+    {
+      int64_t startUs = esp_timer_get_time();
+      StorageFile f = storageOpen(BENCH_APPEND_FILE, "a", "bench");
+      if (!f) {
+        backgroundJobSetMessage(job, "Cannot open %s", BENCH_APPEND_FILE);
+        return JOB_ERROR;
+      }
+      size_t n = f.write(c.buf, cfg.appendBytes);
+      f.close();
+      record(BENCH_APPEND, n, esp_timer_get_time() - startUs);
+      job.done++;
+    }
+    JOB_YIELD(job);
+  }
+
+  // Large sequential write; open and close are charged to the phase but not counted as ops
+  {
+    int64_t startUs = esp_timer_get_time();
+    c.out = storageOpen(BENCH_LARGE, "w", "bench");
+    result.phases[BENCH_SEQ_WRITE].totalUs += esp_timer_get_time() - startUs;
+    if (!c.out) {
+      backgroundJobSetMessage(job, "Cannot create %s", BENCH_LARGE);
+      return JOB_ERROR;
+    }
+  }
+  for (c.offset = 0; c.offset < cfg.largeBytes; c.offset += cfg.chunkBytes) {
+    {
+      size_t len = std::min<uint32_t>(cfg.chunkBytes, cfg.largeBytes - c.offset);
+      int64_t startUs = esp_timer_get_time();
+      size_t n = c.out.write(c.buf, len);
+      record(BENCH_SEQ_WRITE, n, esp_timer_get_time() - startUs);
+      job.done++;
+      if (n != len) {
+        backgroundJobSetMessage(job, "Short write at %lu", (unsigned long)c.offset);
+        return JOB_ERROR;
+      }
+    }
+    JOB_YIELD(job);
+  }
+  {
+    int64_t startUs = esp_timer_get_time();
+    c.out.close();
+    result.phases[BENCH_SEQ_WRITE].totalUs += esp_timer_get_time() - startUs;
+  }
+  JOB_YIELD(job);
+
+  // Read it back
+  {
+    int64_t startUs = esp_timer_get_time();
+    c.file = storageFS().open(BENCH_LARGE, "r");
+    result.phases[BENCH_SEQ_READ].totalUs += esp_timer_get_time() - startUs;
+    if (!c.file) {
+      backgroundJobSetMessage(job, "Cannot open %s", BENCH_LARGE);
+      return JOB_ERROR;
+    }
+  }
+  for (;;) {
+    {
+      int64_t startUs = esp_timer_get_time();
+      size_t n = c.file.read(c.buf, cfg.chunkBytes);
+      if (n == 0) break;
+      record(BENCH_SEQ_READ, n, esp_timer_get_time() - startUs);
+      job.done++;
+    }
+    JOB_YIELD(job);
+  }
+  c.file.close();
+
+  {
+    const StorageBenchPhase& w = result.phases[BENCH_SEQ_WRITE];
+    const StorageBenchPhase& r = result.phases[BENCH_SEQ_READ];
+    backgroundJobSetMessage(job, "%s: write %.0f KB/s, read %.0f KB/s", storageBackendName(),
+                            w.totalUs ? w.bytes * 1000000.0 / 1024 / w.totalUs : 0.0,
+                            r.totalUs ? r.bytes * 1000000.0 / 1024 / r.totalUs : 0.0);
+  }
+  JOB_END(job);
+}
+
+static void storageBenchCleanup(BackgroundJob& job) {
+  StorageBenchCtx* c = (StorageBenchCtx*)job.ctx;
+  c->out.close();
+  if (c->file) c->file.close();
+  // Created files are only left behind if the job stopped during the open phases
+  for (uint32_t i = 0; i < result.config.opens; i++) {
+    char path[32];
+    createdPath(path, sizeof(path), i);
+    if (storageFS().exists(path)) storageFS().remove(path);
+  }
+  storageFS().remove(BENCH_SEED);
+  storageFS().remove(BENCH_APPEND_FILE);
+  storageFS().remove(BENCH_LARGE);
+  storageFS().rmdir(BENCH_DIR);
+  free(c->buf);
+  delete c;
+}
+
+uint16_t storageBenchStart(const StorageBenchConfig& config) {
+  const BackgroundJob* running = backgroundJobGet(result.jobId);
+  if (running && (running->state == JOB_QUEUED || running->state == JOB_RUNNING)) return 0;
+
+  StorageBenchConfig cfg = config;
+  cfg.opens = constrain(cfg.opens, 1, 1000);
+  cfg.appends = constrain(cfg.appends, 1, 5000);
+  cfg.appendBytes = constrain(cfg.appendBytes, 1, 1024);
+  cfg.chunkBytes = constrain(cfg.chunkBytes, 256, 16384);
+  // Leave at least half the free space alone
+  uint32_t maxLarge = std::max<uint32_t>(storageFreeBytes() / 2, cfg.chunkBytes);
+  cfg.largeBytes = constrain(cfg.largeBytes, (uint32_t)cfg.chunkBytes, std::min<uint32_t>(maxLarge, 4 * 1024 * 1024));
+
+  StorageBenchCtx* ctx = new StorageBenchCtx();
+  ctx->buf = (uint8_t*)malloc(std::max(cfg.chunkBytes, cfg.appendBytes));
+  if (!ctx->buf) {
+    delete ctx;
+    return 0;
+  }
+  for (uint32_t i = 0; i < std::max(cfg.chunkBytes, cfg.appendBytes); i++) {
+    ctx->buf[i] = (i % 64 == 63) ? '\n' : 'a' + i % 26;
+  }
+
+  result = StorageBenchResult();
+  result.config = cfg;
+  result.jobId = backgroundJobStart("storage_bench", storageBenchStep, ctx, storageBenchCleanup);
+  if (debugSerial && result.jobId) {
+    Serial.printf("[BENCH] Storage benchmark on %s: %u opens, %u x %u B appends, %lu B in %u B chunks\n",
+                  storageBackendName(), cfg.opens, cfg.appends, cfg.appendBytes,
+                  (unsigned long)cfg.largeBytes, cfg.chunkBytes);
+  }
+  return result.jobId;
+}
+
+const StorageBenchResult& storageBenchResult() {
+  return result;
+}
+
+const char* storageBenchPhaseName(uint8_t phase) {
+  return phase < BENCH_PHASE_COUNT ? PHASE_NAMES[phase] : "unknown";
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <Arduino.h>
+
+// Storage benchmark for the active filesystem backend (storage_backend.h).
+// Runs as a background job in a scratch folder (/bench) and times each operation:
+//   open_read    open + close of an existing file
+//   open_create  create + close of a new, empty file
+//   append       open("a") + one small write + close, the activity-log/persist pattern
+//   seq_write    large sequential write in chunks (close included)
+//   seq_read     reading the same file back in chunks
+// One operation per job step, so on the device it shares loop() like any other job;
+// native_sim runs it to completion with Simulation::benchmarkStorage(). The scratch
+// files are removed when the job ends, finished or not. Writes go through
+// storageOpen() as caller "bench", so the write accounting shows what a run cost.
+
+struct StorageBenchConfig {
+  uint16_t opens = 50;            // Per open phase
+  uint16_t appends = 200;
+  uint16_t appendBytes = 64;
+  uint32_t largeBytes = 256 * 1024;
+  uint16_t chunkBytes = 4096;
+};
+
+struct StorageBenchPhase {
+  uint32_t ops = 0;
+  uint64_t bytes = 0;
+  uint64_t totalUs = 0;
+  uint32_t maxUs = 0;
+};
+
+enum StorageBenchPhaseId : uint8_t {
+  BENCH_OPEN_READ = 0,
+  BENCH_OPEN_CREATE,
+  BENCH_APPEND,
+  BENCH_SEQ_WRITE,
+  BENCH_SEQ_READ,
+  BENCH_PHASE_COUNT
+};
+
+struct StorageBenchResult {
+  uint16_t jobId = 0;             // 0 = never run
+  StorageBenchConfig config;
+  StorageBenchPhase phases[BENCH_PHASE_COUNT];
+};
+
+// Queues a run; returns the job id, or 0 if one is already running or no job slot is free
+uint16_t storageBenchStart(const StorageBenchConfig& config);
+
+const StorageBenchResult& storageBenchResult();
+const char* storageBenchPhaseName(uint8_t phase);
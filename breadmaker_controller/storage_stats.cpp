@@ -0,0 +1,229 @@
+#include "storage_stats.h"
+#include "control_task.h"
+#include "persistence_manager.h"
+#include "trace_recorder.h"
+#include <ArduinoJson.h>
+#include <time.h>
+
+extern bool debugSerial;
+
+const char* STORAGE_STATS_FILE = "/storage_stats.json";
+
+// Updated from the loop core (writers) and the control task (run start), so every
+// change is made under the control lock.
+static StorageEntry entries[MAX_STORAGE_ENTRIES];
+static uint8_t entryCount = 0;
+static StorageSummary summary;
+
+static void copyString(char* dst, size_t size, const char* src) {
+  snprintf(dst, size, "%s", src ? src : "");
+}
+
+static StorageEntry& findEntry(const char* path, const char* caller) {
+  for (uint8_t i = 0; i < entryCount; i++) {
+    if (strcmp(entries[i].path, path) == 0 && strcmp(entries[i].caller, caller) == 0) return entries[i];
+  }
+  if (entryCount < MAX_STORAGE_ENTRIES - 1) {
+    StorageEntry& e = entries[entryCount++];
+    e = StorageEntry();
+    copyString(e.path, sizeof(e.path), path);
+    copyString(e.caller, sizeof(e.caller), caller);
+    return e;
+  }
+  // Table full: the last slot collects everything else
+  StorageEntry& other = entries[MAX_STORAGE_ENTRIES - 1];
+  if (entryCount < MAX_STORAGE_ENTRIES) {
+    entryCount = MAX_STORAGE_ENTRIES;
+    other = StorageEntry();
+    copyString(other.path, sizeof(other.path), "(other)");
+    copyString(other.caller, sizeof(other.caller), "(other)");
+  }
+  return other;
+}
+
+static uint32_t estimateErases(uint32_t startSize, uint32_t bytes, bool append) {
+  uint32_t erases = 1;  // Directory entry
+  if (bytes > 0) {
+    erases += (startSize + bytes - 1) / STORAGE_SECTOR_SIZE - startSize / STORAGE_SECTOR_SIZE + 1;
+  }
+  uint32_t oldClusters = (startSize + STORAGE_SECTOR_SIZE - 1) / STORAGE_SECTOR_SIZE;
+  uint32_t newClusters = (startSize + bytes + STORAGE_SECTOR_SIZE - 1) / STORAGE_SECTOR_SIZE;
+  if (!append || newClusters > oldClusters) erases++;  // FAT
+  return erases;
+}
+
+static void account(const char* path, const char* caller, bool opened, uint32_t bytes, uint32_t erases) {
+  {
+    ControlLockGuard guard;
+    StorageEntry& e = findEntry(path, caller);
+    StorageCounters* counters[2] = { &e.total, &e.run };
+    for (StorageCounters* c : counters) {
+      if (opened) {
+        c->opens++;
+        c->bytes += bytes;
+        c->erases += erases;
+      } else {
+        c->failures++;
+      }
+    }
+  }
+  // Saving the table is itself a write; don't let it keep re-arming itself
+  if (strcmp(path, STORAGE_STATS_FILE) != 0) persistMarkDirty(PERSIST_STORAGE_STATS);
+}
+
+StorageFile& StorageFile::operator=(StorageFile&& other) {
+  if (this == &other) return *this;
+  close();
+  file = other.file;
+  caller = other.caller;
+  copyString(path, sizeof(path), other.path);
+  startSize = other.startSize;
+  written = other.written;
+  append = other.append;
+  other.file = File();
+  other.written = 0;
+  return *this;
+}
+
+size_t StorageFile::write(uint8_t c) {
+  size_t n = file.write(c);
+  written += n;
+  return n;
+}
+
+size_t StorageFile::write(const uint8_t* buffer, size_t size) {
+  size_t n = file.write(buffer, size);
+  written += n;
+  return n;
+}
+
+void StorageFile::close() {
+  if (!file) return;
+  {
+    TraceSpan span(TRACE_FLASH, "flash close");   // FatFs flushes the sector buffer and directory entry here
+    file.close();
+  }
+  file = File();
+  account(path, caller, true, written, estimateErases(startSize, written, append));
+  written = 0;
+}
+
+StorageFile storageOpen(const char* path, const char* mode, const char* caller) {
+  StorageFile sf;
+  {
+    TraceSpan span(TRACE_FLASH, "flash open");
+    sf.file = storageFS().open(path, mode);
+  }
+  if (!sf.file) {
+    account(path, caller, false, 0, 0);
+    return sf;
+  }
+  sf.caller = caller;
+  copyString(sf.path, sizeof(sf.path), path);
+  sf.append = mode[0] == 'a';
+  sf.startSize = sf.append ? sf.file.size() : 0;
+  return sf;
+}
+
+void storageStatsLoad() {
+  File f = storageFS().open(STORAGE_STATS_FILE, "r");
+  if (f) {
+    DynamicJsonDocument doc(6144);
+    DeserializationError err = deserializeJson(doc, f);
+    f.close();
+    if (err) {
+      if (debugSerial) Serial.printf("[STORAGE] %s unreadable (%s), starting fresh\n", STORAGE_STATS_FILE, err.c_str());
+    } else {
+      ControlLockGuard guard;
+      summary.boots = doc["boots"] | 0;
+      summary.runs = doc["runs"] | 0;
+      summary.runStarted = doc["run_started"] | 0;
+      entryCount = 0;
+      for (JsonObject o : doc["entries"].as<JsonArray>()) {
+        if (entryCount >= MAX_STORAGE_ENTRIES) break;
+        StorageEntry& e = entries[entryCount++];
+        e = StorageEntry();
+        copyString(e.path, sizeof(e.path), o["p"] | "");
+        copyString(e.caller, sizeof(e.caller), o["c"] | "");
+        e.total.opens = o["o"] | 0;
+        e.total.bytes = o["b"] | 0ULL;
+        e.total.erases = o["e"] | 0;
+        e.total.failures = o["f"] | 0;
+        e.run.opens = o["ro"] | 0;
+        e.run.bytes = o["rb"] | 0ULL;
+        e.run.erases = o["re"] | 0;
+        e.run.failures = o["rf"] | 0;
+      }
+    }
+  }
+  summary.boots++;
+  if (debugSerial) {
+    Serial.printf("[STORAGE] Boot %lu, %u accounting entries loaded\n", (unsigned long)summary.boots, (unsigned)entryCount);
+  }
+}
+
+void storageStatsStartRun() {
+  {
+    ControlLockGuard guard;
+    for (uint8_t i = 0; i < entryCount; i++) entries[i].run = StorageCounters();
+    summary.runs++;
+    summary.runStarted = time(nullptr);
+  }
+  persistMarkDirty(PERSIST_STORAGE_STATS);
+}
+
+void serializeStorageStatsJson(Print& out) {
+  out.printf("{\"boots\":%lu,\"runs\":%lu,\"run_started\":%lu,\"entries\":[",
+             (unsigned long)summary.boots, (unsigned long)summary.runs, (unsigned long)summary.runStarted);
+  for (uint8_t i = 0; i < entryCount; i++) {
+    const StorageEntry& e = entries[i];
+    out.printf("%s{\"p\":\"%s\",\"c\":\"%s\",\"o\":%lu,\"b\":%llu,\"e\":%lu,\"f\":%lu,"
+               "\"ro\":%lu,\"rb\":%llu,\"re\":%lu,\"rf\":%lu}",
+               i ? "," : "", e.path, e.caller,
+               (unsigned long)e.total.opens, (unsigned long long)e.total.bytes,
+               (unsigned long)e.total.erases, (unsigned long)e.total.failures,
+               (unsigned long)e.run.opens, (unsigned long long)e.run.bytes,
+               (unsigned long)e.run.erases, (unsigned long)e.run.failures);
+  }
+  out.print("]}");
+}
+
+uint8_t storageStatsCount() {
+  return entryCount;
+}
+
+const StorageEntry& storageStatsEntry(uint8_t i) {
+  return entries[i < MAX_STORAGE_ENTRIES ? i : 0];
+}
+
+const StorageSummary& storageStatsSummary() {
+  return summary;
+}
+
+void storageStatsTotals(StorageCounters& total, StorageCounters& run) {
+  total = StorageCounters();
+  run = StorageCounters();
+  ControlLockGuard guard;
+  for (uint8_t i = 0; i < entryCount; i++) {
+    const StorageEntry& e = entries[i];
+    total.opens += e.total.opens;
+    total.bytes += e.total.bytes;
+    total.erases += e.total.erases;
+    total.failures += e.total.failures;
+    run.opens += e.run.opens;
+    run.bytes += e.run.bytes;
+    run.erases += e.run.erases;
+    run.failures += e.run.failures;
+  }
+}
+
+void storageStatsReset() {
+  {
+    ControlLockGuard guard;
+    entryCount = 0;
+    uint32_t boots = summary.boots;
+    summary = StorageSummary();
+    summary.boots = boots;
+  }
+  persistMarkDirty(PERSIST_STORAGE_STATS, true);
+}
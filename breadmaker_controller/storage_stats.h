@@ -0,0 +1,90 @@
+#pragma once
+#include <Arduino.h>
+#include "storage_backend.h"
+
+// Flash write accounting.
+// Every flash write goes through storageOpen(), which returns a StorageFile: a File
+// wrapper that counts the bytes written and, on close(), charges the write to its
+// (path, caller) entry together with an estimate of the 4 KB sector erases it cost.
+// The table is saved to /storage_stats.json through the persistence worker, so the
+// counters survive reboots and a multi-day run can be measured end to end.
+//
+// Erase estimate (FFat on the wear-levelled partition, 4 KB sectors and clusters):
+//   data sectors spanned by the bytes written
+//   + 1 for the directory entry (size/timestamp rewritten on close)
+//   + 1 for the FAT when a rewrite frees and reallocates the chain, or an append
+//     grows into a new cluster
+// FatFs keeps one sector buffer per file, so small writes to the same sector count
+// once. Wear-levelling bookkeeping is not included.
+
+constexpr uint32_t STORAGE_SECTOR_SIZE = 4096;
+constexpr uint32_t STORAGE_SECTOR_ENDURANCE = 100000;  // Erase cycles per sector (datasheet minimum)
+constexpr uint8_t MAX_STORAGE_ENTRIES = 24;            // (path, caller) pairs; later ones share "(other)"
+extern const char* STORAGE_STATS_FILE;
+
+struct StorageCounters {
+  uint32_t opens = 0;       // Opens for writing
+  uint64_t bytes = 0;
+  uint32_t erases = 0;      // Estimated sector erases
+  uint32_t failures = 0;    // Open failed
+};
+
+struct StorageEntry {
+  char path[48] = "";
+  char caller[16] = "";
+  StorageCounters total;    // Since the counters were last reset (survives reboots)
+  StorageCounters run;      // Since the current program was started
+};
+
+struct StorageSummary {
+  uint32_t boots = 0;
+  uint32_t runs = 0;
+  time_t runStarted = 0;    // Epoch seconds; 0 if no program started since reset
+};
+
+class StorageFile : public Print {
+  public:
+    StorageFile() {}
+    StorageFile(StorageFile&& other) { *this = static_cast<StorageFile&&>(other); }
+    StorageFile& operator=(StorageFile&& other);
+    StorageFile(const StorageFile&) = delete;
+    StorageFile& operator=(const StorageFile&) = delete;
+    ~StorageFile() { close(); }
+
+    explicit operator bool() const { return (bool)file; }
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    size_t size() { return file ? file.size() : 0; }
+    void close();   // Accounts the write
+
+  private:
+    friend StorageFile storageOpen(const char* path, const char* mode, const char* caller);
+    File file;
+    const char* caller = "";
+    char path[48] = "";
+    uint32_t startSize = 0;
+    uint32_t written = 0;
+    bool append = false;
+};
+
+// Opens path for writing ("w" or "a") and charges it to caller
+StorageFile storageOpen(const char* path, const char* mode, const char* caller);
+inline StorageFile storageOpen(const String& path, const char* mode, const char* caller) {
+  return storageOpen(path.c_str(), mode, caller);
+}
+
+// Loads the saved counters (call once after FFat is mounted, before any writes)
+void storageStatsLoad();
+
+// Starts a new per-run window (program start)
+void storageStatsStartRun();
+
+// Persistence serializer for STORAGE_STATS_FILE
+void serializeStorageStatsJson(Print& out);
+
+uint8_t storageStatsCount();
+const StorageEntry& storageStatsEntry(uint8_t i);
+const StorageSummary& storageStatsSummary();
+void storageStatsTotals(StorageCounters& total, StorageCounters& run);
+void storageStatsReset();
@@ -0,0 +1,107 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Wire format of the binary telemetry stream (telemetry_stream.cpp).
+// A frame is one fixed-layout record followed by its CRC-16/CCITT-FALSE (little
+// endian), COBS encoded so the frame holds no zero byte, then a 0x00 delimiter. A
+// receiver that starts mid-stream, or sees text or a corrupted byte, loses at most the
+// frame in progress: it resynchronises on the next delimiter and the CRC rejects the
+// damaged one. Gaps in `sequence` count frames the device dropped.
+//
+// Records are packed little-endian (ESP32 and the usual hosts). A layout change bumps
+// TELEMETRY_FORMAT_VERSION.
+//
+// Pure C++ (no Arduino dependencies) so simulation/tools/telemetry_decode.cpp decodes
+// with the same layout and codecs.
+
+constexpr uint8_t TELEMETRY_RECORD_SAMPLE = 1;
+constexpr uint8_t TELEMETRY_FORMAT_VERSION = 1;
+
+enum TelemetryFlag : uint8_t {
+  TELEMETRY_HEATER = 0x01,
+  TELEMETRY_MOTOR = 0x02,
+  TELEMETRY_LIGHT = 0x04,
+  TELEMETRY_BUZZER = 0x08,
+  TELEMETRY_RUNNING = 0x10,
+  TELEMETRY_SENSOR_VALID = 0x20
+};
+
+struct __attribute__((packed)) TelemetrySample {
+  uint8_t type = TELEMETRY_RECORD_SAMPLE;
+  uint8_t version = TELEMETRY_FORMAT_VERSION;
+  uint16_t sequence = 0;       // Increments per sample, including dropped ones
+  uint32_t timeMs = 0;         // millis() at the control tick
+  float rawAdc = 0.0f;         // Decimated ADC counts behind the latest reading
+  float temperature = 0.0f;    // Filtered (EMA or Kalman) °C, the PID input
+  float setpoint = 0.0f;
+  float pidP = 0.0f;
+  float pidI = 0.0f;
+  float pidD = 0.0f;
+  float output = 0.0f;         // Heater duty 0-1
+  uint8_t flags = 0;           // TelemetryFlag bits
+  uint8_t stage = 0;           // Custom stage index (0 when idle)
+};
+static_assert(sizeof(TelemetrySample) == 38, "telemetry record layout changed; bump TELEMETRY_FORMAT_VERSION");
+
+constexpr size_t TELEMETRY_PAYLOAD_SIZE = sizeof(TelemetrySample) + 2;                      // Record + CRC
+constexpr size_t TELEMETRY_FRAME_MAX = TELEMETRY_PAYLOAD_SIZE + TELEMETRY_PAYLOAD_SIZE / 254 + 2;  // COBS + delimiter
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF); bitwise, 40 bytes per frame
+inline uint16_t telemetryCrc16(const uint8_t* data, size_t len) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (uint8_t b = 0; b < 8; b++) crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+  }
+  return crc;
+}
+
+// COBS encodes len bytes into out (room for len + len/254 + 1); returns the encoded
+// length, without the 0x00 delimiter
+inline size_t cobsEncode(const uint8_t* in, size_t len, uint8_t* out) {
+  size_t codeAt = 0, o = 1;
+  uint8_t code = 1;
+  for (size_t i = 0; i < len; i++) {
+    if (in[i] == 0) {
+      out[codeAt] = code;
+      codeAt = o++;
+      code = 1;
+    } else {
+      out[o++] = in[i];
+      if (++code == 0xFF) {
+        out[codeAt] = code;
+        codeAt = o++;
+        code = 1;
+      }
+    }
+  }
+  out[codeAt] = code;
+  return o;
+}
+
+// Decodes one COBS frame (delimiter stripped) into out (room for len bytes); returns the
+// decoded length, or 0 if the frame is malformed
+inline size_t cobsDecode(const uint8_t* in, size_t len, uint8_t* out) {
+  size_t i = 0, o = 0;
+  while (i < len) {
+    uint8_t code = in[i++];
+    if (code == 0 || i + code - 1 > len) return 0;
+    for (uint8_t k = 1; k < code; k++) out[o++] = in[i++];
+    if (code < 0xFF && i < len) out[o++] = 0;
+  }
+  return o;
+}
+
+// Record + CRC -> COBS frame with delimiter; returns the bytes to send
+inline size_t telemetryEncodeFrame(const TelemetrySample& sample, uint8_t* frame) {
+  uint8_t payload[TELEMETRY_PAYLOAD_SIZE];
+  const uint8_t* raw = reinterpret_cast<const uint8_t*>(&sample);
+  for (size_t i = 0; i < sizeof(sample); i++) payload[i] = raw[i];
+  uint16_t crc = telemetryCrc16(payload, sizeof(sample));
+  payload[sizeof(sample)] = crc & 0xFF;
+  payload[sizeof(sample) + 1] = crc >> 8;
+  size_t n = cobsEncode(payload, sizeof(payload), frame);
+  frame[n++] = 0;
+  return n;
+}
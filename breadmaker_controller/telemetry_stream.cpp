@@ -0,0 +1,101 @@
+#include "telemetry_stream.h"
+#include "globals.h"
+#include "sensor_service.h"
+#include "control_task.h"
+#include <atomic>
+
+extern bool debugSerial;
+extern ProgramState programState;
+extern OutputStates outputStates;
+extern PIDControl pid;
+extern double getAveragedTemperature();
+
+static std::atomic<bool> active{false};
+static std::atomic<uint16_t> intervalMs{TELEMETRY_DEFAULT_INTERVAL_MS};
+static bool savedDebugSerial = false;
+static uint16_t sequence = 0;
+static unsigned long lastSampleMs = 0;
+static TelemetryStats stats;
+
+void telemetrySample() {
+  if (!active.load()) return;
+  unsigned long now = millis();
+  // Half a tick of slack so jitter doesn't make a 20 ms interval skip every other tick
+  if (now - lastSampleMs + CONTROL_TICK_MS / 2 < intervalMs.load()) return;
+  lastSampleMs = now;
+
+  TelemetrySample s;
+  s.sequence = sequence++;
+  s.timeMs = now;
+  const SensorReading& reading = sensorGetReading();
+  s.rawAdc = reading.rawAdc;
+  s.temperature = (float)getAveragedTemperature();
+  s.setpoint = (float)pid.Setpoint;
+  s.pidP = (float)pid.pidP;
+  s.pidI = (float)pid.pidI;
+  s.pidD = (float)pid.pidD;
+  s.output = (float)pid.Output;
+  if (outputStates.heater) s.flags |= TELEMETRY_HEATER;
+  if (outputStates.motor) s.flags |= TELEMETRY_MOTOR;
+  if (outputStates.light) s.flags |= TELEMETRY_LIGHT;
+  if (outputStates.buzzer) s.flags |= TELEMETRY_BUZZER;
+  if (programState.isRunning) s.flags |= TELEMETRY_RUNNING;
+  if (reading.health == SENSOR_VALID) s.flags |= TELEMETRY_SENSOR_VALID;
+  s.stage = programState.isRunning ? (uint8_t)programState.customStageIdx : 0;
+
+  uint8_t frame[TELEMETRY_FRAME_MAX];
+  size_t n = telemetryEncodeFrame(s, frame);
+  // Serial.write() would wait for the UART to drain; drop the frame instead
+  if ((size_t)Serial.availableForWrite() < n) {
+    stats.dropped++;
+    return;
+  }
+  Serial.write(frame, n);
+  stats.frames++;
+  stats.bytes += n;
+}
+
+void telemetryStart(uint16_t interval) {
+  if (interval == 0) interval = TELEMETRY_DEFAULT_INTERVAL_MS;
+  if (interval > TELEMETRY_MAX_INTERVAL_MS) interval = TELEMETRY_MAX_INTERVAL_MS;
+  ControlLockGuard lock;   // Not between a tick's sample and its write
+  intervalMs.store(interval);
+  if (active.load()) return;
+  Serial.printf("[TELEMETRY] Binary stream on, every %u ms; text debug output suspended\n", interval);
+  Serial.write((uint8_t)0);   // Delimiter: the text above doesn't cost the first frame
+  Serial.flush();
+  savedDebugSerial = debugSerial;
+  debugSerial = false;
+  lastSampleMs = millis() - interval;
+  active.store(true);
+}
+
+void telemetryStop() {
+  ControlLockGuard lock;
+  if (!active.exchange(false)) return;
+  debugSerial = savedDebugSerial;
+  Serial.write((uint8_t)0);   // Terminate any partial frame before text resumes
+  Serial.printf("\n[TELEMETRY] Binary stream off: %lu frames, %lu dropped\n",
+                (unsigned long)stats.frames, (unsigned long)stats.dropped);
+}
+
+bool telemetryActive() {
+  return active.load();
+}
+
+uint16_t telemetryIntervalMs() {
+  return intervalMs.load();
+}
+
+bool telemetryDebugSerialSetting() {
+  return active.load() ? savedDebugSerial : debugSerial;
+}
+
+const TelemetryStats& telemetryGetStats() {
+  return stats;
+}
+
+void telemetryResetStats() {
+  stats = TelemetryStats();
+  stats.sinceMs = millis();
+}
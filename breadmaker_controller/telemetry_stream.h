@@ -0,0 +1,44 @@
+#pragma once
+#include <Arduino.h>
+#include "telemetry_format.h"
+
+// Binary telemetry over Serial.
+// Debug output is free text at 115200 baud: a PID trace costs ~120 characters per
+// line, so it can't keep up with the control tick, and parsing it back out of
+// debug_log.txt breaks whenever a message changes. While telemetry is on, the control
+// tick emits one TelemetrySample per interval (default every tick, 50 Hz) as a 42-byte
+// COBS frame with CRC (see telemetry_format.h) - about 2.1 KB/s, a fifth of the link.
+// simulation/tools/telemetry_decode.cpp turns a capture into CSV or column files.
+//
+// The tick never blocks on the UART: a frame that doesn't fit in the free TX space is
+// dropped and counted, and its sequence number is skipped so the decoder sees the gap.
+// Text debug output is suspended while streaming (it would cost frames) and restored
+// when the stream stops; the saved debugSerial setting is unaffected.
+//
+// Started and stopped over Serial ("telemetry:on[,interval_ms]", "telemetry:off") or
+// /api/telemetry. Not persisted: every boot starts in text mode.
+
+constexpr uint16_t TELEMETRY_DEFAULT_INTERVAL_MS = 20;   // Every control tick
+constexpr uint16_t TELEMETRY_MAX_INTERVAL_MS = 60000;
+
+struct TelemetryStats {
+  uint32_t frames = 0;            // Frames written
+  uint32_t dropped = 0;           // Samples not sent: UART TX space full
+  uint64_t bytes = 0;             // Frame bytes written, delimiters included
+  unsigned long sinceMs = 0;
+};
+
+// Called from the control tick (control lock held)
+void telemetrySample();
+
+// intervalMs is rounded up to the control tick by the sampling itself
+void telemetryStart(uint16_t intervalMs = TELEMETRY_DEFAULT_INTERVAL_MS);
+void telemetryStop();
+bool telemetryActive();
+uint16_t telemetryIntervalMs();
+
+// debugSerial as the user set it, for settings persistence while text output is suspended
+bool telemetryDebugSerialSetting();
+
+const TelemetryStats& telemetryGetStats();
+void telemetryResetStats();
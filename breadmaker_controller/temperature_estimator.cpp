@@ -0,0 +1,93 @@
+#include "temperature_estimator.h"
+#include "globals.h"
+#include "debug_log.h"
+
+void temperatureEstimatorReset(float temp) {
+  tempKalman.temperature = temp;
+  tempKalman.bias = 0.0;
+  tempKalman.rate = 0.0;
+  tempKalman.P[0][0] = tempKalman.measurementNoise;
+  tempKalman.P[0][1] = 0.0;
+  tempKalman.P[1][0] = 0.0;
+  tempKalman.P[1][1] = 0.01;
+  tempKalman.lastInnovation = 0.0;
+  tempKalman.innovationVariance = 0.0;
+  tempKalman.initialized = true;
+}
+
+void temperatureEstimatorUpdate(float measuredTemp, bool measurementValid, bool heaterOn, unsigned long nowMs) {
+  TemperatureKalmanState& k = tempKalman;
+
+  if (!k.initialized) {
+    if (!measurementValid) return;
+    temperatureEstimatorReset(measuredTemp);
+    k.lastUpdate = nowMs;
+    LOG_DEBUG(LOG_TEMP, "[KALMAN] Seeded with %.2f°C\n", measuredTemp);
+    return;
+  }
+
+  // Clamp dt so a long stall can't blow up the prediction
+  double dt = (nowMs - k.lastUpdate) / 1000.0;
+  k.lastUpdate = nowMs;
+  if (dt <= 0.0) return;
+  if (dt > 5.0) dt = 5.0;
+
+  // --- Predict ---
+  double u = heaterOn ? 1.0 : 0.0;
+  double modelRate = k.heatRate * u - k.lossRate * (k.temperature - k.ambient);
+  k.temperature += dt * (modelRate + k.bias);
+
+  // P = F P F' + Q with F = [[1 - loss*dt, dt], [0, 1]]
+  double f00 = 1.0 - k.lossRate * dt;
+  double p00 = k.P[0][0], p01 = k.P[0][1], p10 = k.P[1][0], p11 = k.P[1][1];
+  double fp00 = f00 * p00 + dt * p10;
+  double fp01 = f00 * p01 + dt * p11;
+  k.P[0][0] = fp00 * f00 + fp01 * dt + k.processNoise * dt;
+  k.P[0][1] = fp01;
+  k.P[1][0] = p10 * f00 + p11 * dt;
+  k.P[1][1] = p11 + k.biasNoise * dt;
+
+  // --- Update ---
+  if (measurementValid) {
+    double innovation = measuredTemp - k.temperature;
+    double s = k.P[0][0] + k.measurementNoise;
+    double k0 = k.P[0][0] / s;
+    double k1 = k.P[1][0] / s;
+
+    k.temperature += k0 * innovation;
+    k.bias += k1 * innovation;
+
+    p00 = k.P[0][0]; p01 = k.P[0][1];
+    k.P[0][0] = (1.0 - k0) * p00;
+    k.P[0][1] = (1.0 - k0) * p01;
+    k.P[1][0] -= k1 * p00;
+    k.P[1][1] -= k1 * p01;
+
+    k.lastInnovation = innovation;
+    k.innovationVariance = 0.98 * k.innovationVariance + 0.02 * innovation * innovation;
+    k.updateCount++;
+  } else {
+    k.skippedMeasurements++;
+  }
+
+  // Bias is a slow correction; bound it to the heater's authority so a bad fit can't run away
+  k.bias = constrain(k.bias, -k.heatRate, k.heatRate);
+  k.rate = k.heatRate * u - k.lossRate * (k.temperature - k.ambient) + k.bias;
+
+  if ((k.updateCount % 100 == 0) && measurementValid) {
+    LOG_DEBUG(LOG_TEMP, "[KALMAN] T=%.2f°C meas=%.2f rate=%.3f°C/s bias=%.4f innov=%.3f\n",
+              k.temperature, measuredTemp, k.rate, k.bias, k.lastInnovation);
+  }
+}
+
+bool temperatureEstimatorActive() {
+  return tempKalman.enabled && tempKalman.initialized;
+}
+
+double temperatureEstimatorGetTemperature() {
+  return tempKalman.temperature;
+}
+
+double getTemperatureRate() {
+  return tempKalman.initialized ? tempKalman.rate : 0.0;
+}
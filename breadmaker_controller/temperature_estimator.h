@@ -0,0 +1,17 @@
+#pragma once
+#include <Arduino.h>
+
+// Kalman temperature estimator fusing sensor readings with a first-order thermal
+// model driven by the heater output. Runs alongside the EMA on every new sensor
+// reading; getAveragedTemperature() returns its estimate when tempKalman.enabled.
+
+// Call once per published sensor reading (see sensorServiceUpdate()).
+// Invalid readings only advance the model (predict-only step).
+void temperatureEstimatorUpdate(float measuredTemp, bool measurementValid, bool heaterOn, unsigned long nowMs);
+
+// Re-seeds the estimate from a temperature, clearing bias and covariance.
+void temperatureEstimatorReset(float temp);
+
+bool temperatureEstimatorActive();          // Enabled and seeded
+double temperatureEstimatorGetTemperature();
+double getTemperatureRate();                // °C/s from the estimator (available even when EMA is selected)
@@ -0,0 +1,183 @@
+// RTD calibration lookup table and fits (calibration.cpp)
+#include <unity.h>
+#include <string>
+#include "../native_stubs.h"
+#include "calibration.cpp"
+
+// No filesystem on the host: every open fails, so loadCalibration() finds no file
+File FFatClass::open(const char*, const char*, bool) { return File(); }
+File::operator bool() const { return false; }
+int File::read() { return -1; }
+size_t File::read(uint8_t*, size_t) { return 0; }
+int File::peek() { return -1; }
+int File::available() { return 0; }
+void File::close() {}
+StorageFS& storageFS() {
+  static StorageFS fs;
+  return fs;
+}
+
+static int persistMarks = 0;
+void persistMarkDirty(PersistObject obj, bool) {
+  if (obj == PERSIST_CALIBRATION) persistMarks++;
+}
+
+const SensorReading& sensorGetReading() {
+  static SensorReading reading;
+  return reading;
+}
+
+struct StringPrint : Print {
+  std::string out;
+  size_t write(uint8_t c) override {
+    out += (char)c;
+    return 1;
+  }
+};
+
+static void setTable(std::initializer_list<CalibPoint> points, uint8_t fit) {
+  rtdCalibTable.assign(points);
+  calibFitMode = fit;
+  rebuildCalibrationLut();
+}
+
+void setUp() {
+  rtdCalibTable.clear();
+  calibFitMode = CALIB_FIT_PIECEWISE;
+  rebuildCalibrationLut();
+  persistMarks = 0;
+}
+void tearDown() {}
+
+static void test_empty_table_reads_zero() {
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0f, tempFromRaw(2000.0f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0f, calibRmsResidual());
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0f, calibResidual(0));
+}
+
+static void test_piecewise_interpolates_and_clamps() {
+  setTable({ { 1000, 20.0f }, { 2000, 60.0f }, { 3000, 120.0f } }, CALIB_FIT_PIECEWISE);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 20.0f, tempFromRaw(1000.0f));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 40.0f, tempFromRaw(1500.0f));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 60.0f, tempFromRaw(2000.0f));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 90.0f, tempFromRaw(2500.0f));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 20.02f, tempFromRaw(1000.5f));   // Fractional (oversampled) counts
+  // Flat outside the calibrated span, and at the ends of the ADC range
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 20.0f, tempFromRaw(10.0f));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 20.0f, tempFromRaw(-5.0f));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 120.0f, tempFromRaw(3500.0f));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 120.0f, tempFromRaw(5000.0f));
+
+  // The piecewise fit passes through every point; leave-one-out shows the line through
+  // the middle one's neighbours passes 10 °C above it
+  for (size_t i = 0; i < 3; i++) TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0f, calibResidual(i));
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0f, calibRmsResidual());
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 10.0f, calibLooResidual(1));
+}
+
+static void test_lut_matches_direct_interpolation() {
+  setTable({ { 500, 5.0f }, { 900, 18.5f }, { 1700, 47.0f }, { 2600, 101.0f }, { 3900, 230.0f } }, CALIB_FIT_PIECEWISE);
+  for (int raw = 500; raw <= 3900; raw += 7) {
+    TEST_ASSERT_FLOAT_WITHIN(0.006f, interpolateTable((float)raw, -1), tempFromRaw((float)raw));
+  }
+}
+
+static void test_linear_fit_recovers_a_line() {
+  // T = 0.05 * raw - 30
+  setTable({ { 800, 10.0f }, { 1400, 40.0f }, { 2000, 70.0f }, { 3000, 120.0f } }, 1);
+  TEST_ASSERT_EQUAL_STRING("poly1", calibFitModeName());
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 31.725f, tempFromRaw(1234.5f));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 95.0f, tempFromRaw(2500.0f));
+  for (size_t i = 0; i < 4; i++) TEST_ASSERT_FLOAT_WITHIN(1e-3, 0.0f, calibResidual(i));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3, 0.0f, calibRmsResidual());
+  // No extrapolation past the calibrated span
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 10.0f, tempFromRaw(100.0f));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 120.0f, tempFromRaw(4000.0f));
+}
+
+static void test_quadratic_fit_recovers_a_parabola() {
+  auto f = [](int raw) {
+    double x = raw / 4095.0;
+    return (float)(5.0 + 120.0 * x + 90.0 * x * x);
+  };
+  setTable({ { 400, f(400) }, { 1200, f(1200) }, { 2100, f(2100) }, { 2900, f(2900) }, { 3700, f(3700) } }, 2);
+  for (int raw = 400; raw <= 3700; raw += 150) TEST_ASSERT_FLOAT_WITHIN(0.01f, f(raw), tempFromRaw((float)raw));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3, 0.0f, calibRmsResidual());
+}
+
+static void test_least_squares_residuals() {
+  // Noisy line: residuals are fitted minus measured, sum to zero with an intercept,
+  // and the RMS is taken over them
+  setTable({ { 1000, 20.3f }, { 1500, 44.6f }, { 2000, 70.2f }, { 2500, 94.5f }, { 3000, 120.4f } }, 1);
+  double sum = 0.0, sumSq = 0.0;
+  for (size_t i = 0; i < rtdCalibTable.size(); i++) {
+    float r = calibResidual(i);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, tempFromRaw((float)rtdCalibTable[i].raw) - rtdCalibTable[i].temp, r);
+    sum += r;
+    sumSq += (double)r * r;
+  }
+  TEST_ASSERT_FLOAT_WITHIN(1e-3, 0.0f, (float)sum);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, (float)sqrt(sumSq / 5), calibRmsResidual());
+  TEST_ASSERT_TRUE(calibRmsResidual() > 0.05f);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0f, calibResidual(99));   // Out of range
+}
+
+static void test_falls_back_to_piecewise() {
+  // Two points can't take a cubic
+  setTable({ { 1000, 20.0f }, { 3000, 120.0f } }, 3);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 70.0f, tempFromRaw(2000.0f));
+  // Singular normal equations (one distinct raw value)
+  setTable({ { 1500, 30.0f }, { 1500, 32.0f } }, 1);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 30.0f, tempFromRaw(1000.0f));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 32.0f, tempFromRaw(2000.0f));
+}
+
+static void test_lut_is_clamped() {
+  setTable({ { 100, -400.0f }, { 4000, 400.0f } }, CALIB_FIT_PIECEWISE);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, -300.0f, tempFromRaw(100.0f));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 320.0f, tempFromRaw(4000.0f));
+}
+
+static void test_fit_mode_names() {
+  const char* names[] = { "piecewise", "poly1", "poly2", "poly3" };
+  for (uint8_t i = 0; i < 4; i++) {
+    TEST_ASSERT_TRUE(setCalibFitMode(names[i]));
+    TEST_ASSERT_EQUAL(i, calibFitMode);
+    TEST_ASSERT_EQUAL_STRING(names[i], calibFitModeName());
+  }
+  TEST_ASSERT_FALSE(setCalibFitMode("poly4"));
+  TEST_ASSERT_EQUAL(3, calibFitMode);
+}
+
+static void test_serialize_and_save() {
+  setTable({ { 1000, 20.0f }, { 2000, 60.25f } }, 1);
+  StringPrint out;
+  serializeCalibrationJson(out);
+  TEST_ASSERT_EQUAL_STRING("{\"fit\":\"poly1\",\"table\":[{\"raw\":1000,\"temp\":20.00},{\"raw\":2000,\"temp\":60.25}]}",
+                           out.out.c_str());
+  saveCalibration();
+  TEST_ASSERT_EQUAL(1, persistMarks);
+}
+
+static void test_load_without_file_clears_table() {
+  setTable({ { 1000, 20.0f }, { 2000, 60.0f } }, CALIB_FIT_PIECEWISE);
+  loadCalibration();
+  TEST_ASSERT_EQUAL(0, rtdCalibTable.size());
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0f, tempFromRaw(1500.0f));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_empty_table_reads_zero);
+  RUN_TEST(test_piecewise_interpolates_and_clamps);
+  RUN_TEST(test_lut_matches_direct_interpolation);
+  RUN_TEST(test_linear_fit_recovers_a_line);
+  RUN_TEST(test_quadratic_fit_recovers_a_parabola);
+  RUN_TEST(test_least_squares_residuals);
+  RUN_TEST(test_falls_back_to_piecewise);
+  RUN_TEST(test_lut_is_clamped);
+  RUN_TEST(test_fit_mode_names);
+  RUN_TEST(test_serialize_and_save);
+  RUN_TEST(test_load_without_file_clears_table);
+  return UNITY_END();
+}
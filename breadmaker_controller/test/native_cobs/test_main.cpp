@@ -0,0 +1,108 @@
+// Telemetry framing (telemetry_format.h): CRC-16, COBS and whole frames
+#include <unity.h>
+#include <random>
+#include <vector>
+#include "telemetry_format.h"
+
+void setUp() {}
+void tearDown() {}
+
+static std::vector<uint8_t> encode(const std::vector<uint8_t>& in) {
+  std::vector<uint8_t> out(in.size() + in.size() / 254 + 1);
+  out.resize(cobsEncode(in.data(), in.size(), out.data()));
+  return out;
+}
+
+static void assertEncodes(const std::vector<uint8_t>& in, const std::vector<uint8_t>& expected) {
+  std::vector<uint8_t> out = encode(in);
+  TEST_ASSERT_EQUAL(expected.size(), out.size());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expected.data(), out.data(), expected.size());
+}
+
+static void test_crc16_check_value() {
+  const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+  TEST_ASSERT_EQUAL_HEX16(0x29B1, telemetryCrc16(check, sizeof(check)));
+  TEST_ASSERT_EQUAL_HEX16(0xFFFF, telemetryCrc16(check, 0));
+}
+
+static void test_cobs_known_vectors() {
+  assertEncodes({}, { 0x01 });
+  assertEncodes({ 0x00 }, { 0x01, 0x01 });
+  assertEncodes({ 0x00, 0x00 }, { 0x01, 0x01, 0x01 });
+  assertEncodes({ 0x11, 0x22, 0x00, 0x33 }, { 0x03, 0x11, 0x22, 0x02, 0x33 });
+  assertEncodes({ 0x11, 0x22, 0x33, 0x44 }, { 0x05, 0x11, 0x22, 0x33, 0x44 });
+  assertEncodes({ 0x11, 0x00, 0x00, 0x00 }, { 0x02, 0x11, 0x01, 0x01, 0x01 });
+}
+
+static void test_cobs_long_run_splits_at_254() {
+  std::vector<uint8_t> in(254);
+  for (size_t i = 0; i < in.size(); i++) in[i] = (uint8_t)(i % 255 + 1);
+  std::vector<uint8_t> out = encode(in);
+  TEST_ASSERT_EQUAL(256, out.size());
+  TEST_ASSERT_EQUAL_HEX8(0xFF, out[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x01, out[255]);
+
+  std::vector<uint8_t> back(out.size());
+  TEST_ASSERT_EQUAL(in.size(), cobsDecode(out.data(), out.size(), back.data()));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(in.data(), back.data(), in.size());
+}
+
+static void test_cobs_round_trip_random() {
+  std::mt19937 rng(12345);
+  for (size_t len = 1; len <= 600; len++) {
+    std::vector<uint8_t> in(len);
+    // Mostly non-zero bytes so runs past 254 occur, with some zeros and zero runs
+    for (uint8_t& b : in) b = (rng() % 8 == 0) ? 0 : (uint8_t)rng();
+    std::vector<uint8_t> out = encode(in);
+    TEST_ASSERT_LESS_OR_EQUAL(len + len / 254 + 1, out.size());
+    for (uint8_t b : out) TEST_ASSERT_NOT_EQUAL(0, b);
+
+    std::vector<uint8_t> back(out.size());
+    TEST_ASSERT_EQUAL(len, cobsDecode(out.data(), out.size(), back.data()));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(in.data(), back.data(), len);
+  }
+}
+
+static void test_cobs_rejects_malformed() {
+  uint8_t out[8];
+  const uint8_t zeroCode[] = { 0x02, 0x11, 0x00, 0x22 };
+  TEST_ASSERT_EQUAL(0, cobsDecode(zeroCode, sizeof(zeroCode), out));
+  const uint8_t overrun[] = { 0x05, 0x11, 0x22 };
+  TEST_ASSERT_EQUAL(0, cobsDecode(overrun, sizeof(overrun), out));
+}
+
+static void test_frame_round_trip() {
+  TelemetrySample sample;
+  sample.sequence = 0x0100;        // A zero byte in the record
+  sample.timeMs = 123456;
+  sample.temperature = 28.5f;
+  sample.setpoint = 0.0f;
+  sample.flags = TELEMETRY_HEATER | TELEMETRY_RUNNING;
+
+  uint8_t frame[TELEMETRY_FRAME_MAX];
+  size_t n = telemetryEncodeFrame(sample, frame);
+  TEST_ASSERT_LESS_OR_EQUAL(TELEMETRY_FRAME_MAX, n);
+  TEST_ASSERT_EQUAL_HEX8(0x00, frame[n - 1]);
+  for (size_t i = 0; i + 1 < n; i++) TEST_ASSERT_NOT_EQUAL(0, frame[i]);
+
+  uint8_t payload[TELEMETRY_FRAME_MAX];
+  TEST_ASSERT_EQUAL(TELEMETRY_PAYLOAD_SIZE, cobsDecode(frame, n - 1, payload));
+  uint16_t crc = payload[sizeof(TelemetrySample)] | (uint16_t)payload[sizeof(TelemetrySample) + 1] << 8;
+  TEST_ASSERT_EQUAL_HEX16(telemetryCrc16(payload, sizeof(TelemetrySample)), crc);
+  TEST_ASSERT_EQUAL_MEMORY(&sample, payload, sizeof(TelemetrySample));
+
+  // A flipped bit fails the CRC
+  payload[6] ^= 0x04;
+  TEST_ASSERT_NOT_EQUAL(crc, telemetryCrc16(payload, sizeof(TelemetrySample)));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_crc16_check_value);
+  RUN_TEST(test_cobs_known_vectors);
+  RUN_TEST(test_cobs_long_run_splits_at_254);
+  RUN_TEST(test_cobs_round_trip_random);
+  RUN_TEST(test_cobs_rejects_malformed);
+  RUN_TEST(test_frame_round_trip);
+  return UNITY_END();
+}
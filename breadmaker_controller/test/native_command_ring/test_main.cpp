@@ -0,0 +1,201 @@
+// Web-to-control command ring (control_commands.cpp)
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "../native_stubs.h"
+#include "control_commands.cpp"
+
+static std::vector<ControlCommand> applied;
+static int stateChangedCalls = 0;
+
+// Fails CMD_BACK with 400; CMD_ADVANCE reports a state change
+static void apply(const ControlCommand& cmd, ControlCommandResult& result) {
+  applied.push_back(cmd);
+  if (cmd.type == CMD_BACK) result.httpCode = 400;
+  if (cmd.type == CMD_ADVANCE) result.stateChanged = true;
+  result.value = cmd.intArg;
+}
+
+static void onStateChanged() {
+  stateChangedCalls++;
+}
+
+static ControlCommand command(ControlCommandType type, int32_t intArg = 0) {
+  ControlCommand cmd;
+  cmd.type = type;
+  cmd.intArg = intArg;
+  return cmd;
+}
+
+void setUp() {
+  applied.clear();
+  stateChangedCalls = 0;
+  testControlTaskRunning = false;
+  controlCommandsBegin(apply, onStateChanged);
+  controlCommandsResetStats();
+}
+void tearDown() {}
+
+static void test_applies_in_submission_order() {
+  uint32_t a = controlCommandSubmit(command(CMD_START_AT_STAGE, 1));
+  uint32_t b = controlCommandSubmit(command(CMD_START_AT_STAGE, 2));
+  uint32_t c = controlCommandSubmit(command(CMD_START_AT_STAGE, 3));
+  TEST_ASSERT_NOT_EQUAL(0, a);
+  TEST_ASSERT_EQUAL(a + 1, b);
+  TEST_ASSERT_EQUAL(a + 2, c);
+  TEST_ASSERT_EQUAL(0, applied.size());
+
+  controlCommandsProcess();
+  TEST_ASSERT_EQUAL(3, applied.size());
+  for (int i = 0; i < 3; i++) TEST_ASSERT_EQUAL(i + 1, applied[i].intArg);
+
+  ControlCommandResult result;
+  TEST_ASSERT_TRUE(controlCommandWait(b, result, 0));
+  TEST_ASSERT_EQUAL(200, result.httpCode);
+  TEST_ASSERT_EQUAL(2, result.value);
+  TEST_ASSERT_EQUAL(3, controlCommandsGetStats().applied);
+}
+
+static void test_full_queue_rejects() {
+  for (uint8_t i = 0; i < CONTROL_COMMAND_QUEUE_SIZE; i++) {
+    TEST_ASSERT_NOT_EQUAL(0, controlCommandSubmit(command(CMD_PAUSE)));
+  }
+  TEST_ASSERT_EQUAL(0, controlCommandSubmit(command(CMD_PAUSE)));
+  TEST_ASSERT_EQUAL(1, controlCommandsGetStats().rejectedFull);
+
+  ControlCommandResult result;
+  TEST_ASSERT_FALSE(controlCommandExecute(command(CMD_RESUME), result));
+  TEST_ASSERT_EQUAL(503, result.httpCode);
+
+  controlCommandsProcess();
+  TEST_ASSERT_EQUAL(CONTROL_COMMAND_QUEUE_SIZE, applied.size());
+  TEST_ASSERT_NOT_EQUAL(0, controlCommandSubmit(command(CMD_PAUSE)));
+}
+
+static void test_ring_wraps() {
+  // Several laps of the ring, one command at a time
+  for (int i = 0; i < 5 * CONTROL_COMMAND_QUEUE_SIZE; i++) {
+    ControlCommandResult result;
+    TEST_ASSERT_TRUE(controlCommandExecute(command(CMD_START_AT_STAGE, i), result));
+    TEST_ASSERT_EQUAL(i, result.value);
+  }
+  TEST_ASSERT_EQUAL(5 * CONTROL_COMMAND_QUEUE_SIZE, applied.size());
+}
+
+static void test_ping_echoes_without_applier() {
+  ControlCommandResult result;
+  TEST_ASSERT_TRUE(controlCommandExecute(command(CMD_PING, 42), result));
+  TEST_ASSERT_EQUAL(200, result.httpCode);
+  TEST_ASSERT_EQUAL(42, result.value);
+  TEST_ASSERT_EQUAL(0, applied.size());
+}
+
+static void test_unknown_command_is_400() {
+  ControlCommandResult result;
+  TEST_ASSERT_TRUE(controlCommandExecute(command((ControlCommandType)CMD_TYPE_COUNT), result));
+  TEST_ASSERT_EQUAL(400, result.httpCode);
+  TEST_ASSERT_EQUAL(0, applied.size());
+}
+
+static void test_batch_stops_at_failure() {
+  ControlCommand cmds[] = { command(CMD_ADVANCE), command(CMD_BACK), command(CMD_PAUSE), command(CMD_RESUME) };
+  uint32_t token = controlCommandSubmitBatch(cmds, 4);
+  TEST_ASSERT_NOT_EQUAL(0, token);
+
+  ControlCommandResult results[4];
+  TEST_ASSERT_TRUE(controlCommandWaitBatch(token, 4, results, 0));
+  TEST_ASSERT_EQUAL(200, results[0].httpCode);
+  TEST_ASSERT_EQUAL(400, results[1].httpCode);
+  TEST_ASSERT_EQUAL(424, results[2].httpCode);
+  TEST_ASSERT_EQUAL(424, results[3].httpCode);
+  TEST_ASSERT_EQUAL(2, applied.size());
+
+  ControlCommandStats st = controlCommandsGetStats();
+  TEST_ASSERT_EQUAL(2, st.skipped);
+  TEST_ASSERT_EQUAL(1, st.batches);
+  TEST_ASSERT_EQUAL(1, stateChangedCalls);   // Once per drain, for the advance
+
+  // The next command is unaffected by the failed batch
+  ControlCommandResult result;
+  TEST_ASSERT_TRUE(controlCommandExecute(command(CMD_PAUSE), result));
+  TEST_ASSERT_EQUAL(200, result.httpCode);
+}
+
+static void test_batch_that_does_not_fit_is_not_queued() {
+  for (int i = 0; i < 12; i++) TEST_ASSERT_NOT_EQUAL(0, controlCommandSubmit(command(CMD_PAUSE)));
+  ControlCommand cmds[CONTROL_COMMAND_MAX_BATCH];
+  for (ControlCommand& c : cmds) c = command(CMD_RESUME);
+  TEST_ASSERT_EQUAL(0, controlCommandSubmitBatch(cmds, CONTROL_COMMAND_MAX_BATCH));
+  TEST_ASSERT_EQUAL(0, controlCommandSubmitBatch(cmds, 0));
+  TEST_ASSERT_EQUAL(0, controlCommandSubmitBatch(cmds, CONTROL_COMMAND_MAX_BATCH + 1));
+
+  // Nothing of the batch took a slot: four singles still fit
+  for (int i = 0; i < 4; i++) TEST_ASSERT_NOT_EQUAL(0, controlCommandSubmit(command(CMD_PAUSE)));
+  controlCommandsProcess();
+  TEST_ASSERT_EQUAL(16, applied.size());
+  for (const ControlCommand& c : applied) TEST_ASSERT_EQUAL(CMD_PAUSE, c.type);
+}
+
+static void test_concurrent_producers() {
+  // Producers on their own threads, the queue drained by a stand-in control task
+  testControlTaskRunning = true;
+  std::atomic<bool> stop{false};
+  std::thread consumer([&stop] {
+    while (!stop.load()) {
+      {
+        ControlLockGuard guard;
+        controlCommandsProcess();
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+  });
+
+  const int producers = 4, perProducer = 200;
+  std::atomic<int> mismatches{0};
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; p++) {
+    threads.emplace_back([p, &mismatches] {
+      for (int i = 0; i < perProducer; i++) {
+        ControlCommandResult result;
+        int32_t arg = p * 100000 + i;
+        if (!controlCommandExecute(command(CMD_PING, arg), result) || result.value != arg) mismatches++;
+      }
+    });
+  }
+  for (std::thread& t : threads) t.join();
+  stop.store(true);
+  consumer.join();
+  testControlTaskRunning = false;
+
+  TEST_ASSERT_EQUAL(0, mismatches.load());
+  ControlCommandStats st = controlCommandsGetStats();
+  TEST_ASSERT_EQUAL(producers * perProducer, st.submitted);
+  TEST_ASSERT_EQUAL(0, st.rejectedFull);
+  TEST_ASSERT_EQUAL(0, st.timeouts);
+}
+
+static void test_names_round_trip() {
+  for (uint8_t i = 0; i < CMD_TYPE_COUNT; i++) {
+    ControlCommandType type;
+    TEST_ASSERT_TRUE(controlCommandFromName(controlCommandName((ControlCommandType)i), type));
+    TEST_ASSERT_EQUAL(i, type);
+  }
+  ControlCommandType type;
+  TEST_ASSERT_FALSE(controlCommandFromName("reboot", type));
+  TEST_ASSERT_EQUAL_STRING("unknown", controlCommandName(CMD_TYPE_COUNT));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_applies_in_submission_order);
+  RUN_TEST(test_full_queue_rejects);
+  RUN_TEST(test_ring_wraps);
+  RUN_TEST(test_ping_echoes_without_applier);
+  RUN_TEST(test_unknown_command_is_400);
+  RUN_TEST(test_batch_stops_at_failure);
+  RUN_TEST(test_batch_that_does_not_fit_is_not_queued);
+  RUN_TEST(test_concurrent_producers);
+  RUN_TEST(test_names_round_trip);
+  return UNITY_END();
+}
@@ -0,0 +1,121 @@
+// Kalman temperature estimator (temperature_estimator.cpp)
+#include <unity.h>
+#include <random>
+#include "../native_stubs.h"
+#include "temperature_estimator.cpp"
+
+TemperatureKalmanState tempKalman;
+
+void setUp() {
+  tempKalman = TemperatureKalmanState();
+}
+void tearDown() {}
+
+static void test_seeds_on_first_valid_measurement() {
+  temperatureEstimatorUpdate(99.0f, false, false, 0);
+  TEST_ASSERT_FALSE(tempKalman.initialized);
+  TEST_ASSERT_FLOAT_WITHIN(1e-9, 0.0, getTemperatureRate());
+
+  temperatureEstimatorUpdate(25.0f, true, false, 1000);
+  TEST_ASSERT_TRUE(tempKalman.initialized);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5, 25.0, temperatureEstimatorGetTemperature());
+  TEST_ASSERT_EQUAL(0, tempKalman.updateCount);
+
+  TEST_ASSERT_FALSE(temperatureEstimatorActive());
+  tempKalman.enabled = true;
+  TEST_ASSERT_TRUE(temperatureEstimatorActive());
+}
+
+static void test_holds_a_steady_temperature() {
+  // Heater off above ambient: the bias learns the heat the model doesn't know about
+  std::mt19937 rng(1);
+  std::normal_distribution<double> noise(0.0, 0.2);
+  unsigned long t = 0;
+  double sumSq = 0.0;
+  int n = 0;
+  for (int i = 0; i < 1200; i++, t += 1000) {
+    temperatureEstimatorUpdate((float)(50.0 + noise(rng)), true, false, t);
+    if (i >= 600) {
+      double err = temperatureEstimatorGetTemperature() - 50.0;
+      sumSq += err * err;
+      n++;
+    }
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.15, 50.0, temperatureEstimatorGetTemperature());
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 0.0, getTemperatureRate());
+  TEST_ASSERT_FLOAT_WITHIN(0.02, tempKalman.lossRate * (50.0 - tempKalman.ambient), tempKalman.bias);
+  // Smoother than the raw sensor
+  TEST_ASSERT_TRUE(sqrt(sumSq / n) < 0.15);
+  TEST_ASSERT_EQUAL(1199, tempKalman.updateCount);
+}
+
+static void test_tracks_a_heating_ramp() {
+  // The element heats slower than the model assumes; the bias takes up the difference
+  std::mt19937 rng(2);
+  std::normal_distribution<double> noise(0.0, 0.2);
+  const double slope = 0.1;   // °C/s
+  unsigned long t = 0;
+  double truth = 30.0;
+  for (int i = 0; i < 400; i++, t += 1000, truth += slope) {
+    temperatureEstimatorUpdate((float)(truth + noise(rng)), true, true, t);
+  }
+  truth -= slope;
+  TEST_ASSERT_FLOAT_WITHIN(0.5, truth, temperatureEstimatorGetTemperature());
+  TEST_ASSERT_FLOAT_WITHIN(0.02, slope, getTemperatureRate());
+}
+
+static void test_predicts_through_invalid_readings() {
+  temperatureEstimatorUpdate(30.0f, true, true, 0);
+  double before = temperatureEstimatorGetTemperature();
+  temperatureEstimatorUpdate(0.0f, false, true, 1000);
+  TEST_ASSERT_EQUAL(1, tempKalman.skippedMeasurements);
+  TEST_ASSERT_EQUAL(0, tempKalman.updateCount);
+  // Heater on: the model alone moves the estimate up, the bad reading is ignored
+  double expected = before + tempKalman.heatRate - tempKalman.lossRate * (before - tempKalman.ambient);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, expected, temperatureEstimatorGetTemperature());
+}
+
+static void test_clamps_the_time_step() {
+  temperatureEstimatorUpdate(30.0f, true, true, 0);
+  temperatureEstimatorUpdate(0.0f, false, true, 60000);   // A 60 s stall predicts as 5 s
+  double fiveSeconds = 30.0 + 5.0 * (tempKalman.heatRate - tempKalman.lossRate * (30.0 - tempKalman.ambient));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, fiveSeconds, temperatureEstimatorGetTemperature());
+
+  double now = temperatureEstimatorGetTemperature();
+  temperatureEstimatorUpdate(80.0f, true, true, 60000);   // Same timestamp: nothing happens
+  TEST_ASSERT_FLOAT_WITHIN(1e-5, now, temperatureEstimatorGetTemperature());
+  TEST_ASSERT_EQUAL(0, tempKalman.updateCount);
+}
+
+static void test_bias_is_bounded() {
+  unsigned long t = 0;
+  temperatureEstimatorUpdate(20.0f, true, false, t);
+  for (int i = 0; i < 200; i++) {
+    t += 1000;
+    temperatureEstimatorUpdate(i % 2 ? 300.0f : -100.0f, true, false, t);
+    TEST_ASSERT_TRUE(tempKalman.bias <= tempKalman.heatRate && tempKalman.bias >= -tempKalman.heatRate);
+  }
+  TEST_ASSERT_TRUE(tempKalman.P[0][0] > 0.0 && tempKalman.P[1][1] > 0.0);
+}
+
+static void test_reset_reseeds() {
+  temperatureEstimatorUpdate(30.0f, true, true, 0);
+  temperatureEstimatorUpdate(35.0f, true, true, 1000);
+  temperatureEstimatorReset(60.0f);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5, 60.0, temperatureEstimatorGetTemperature());
+  TEST_ASSERT_FLOAT_WITHIN(1e-9, 0.0, tempKalman.bias);
+  TEST_ASSERT_FLOAT_WITHIN(1e-9, 0.0, tempKalman.lastInnovation);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5, tempKalman.measurementNoise, tempKalman.P[0][0]);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_seeds_on_first_valid_measurement);
+  RUN_TEST(test_holds_a_steady_temperature);
+  RUN_TEST(test_tracks_a_heating_ramp);
+  RUN_TEST(test_predicts_through_invalid_readings);
+  RUN_TEST(test_clamps_the_time_step);
+  RUN_TEST(test_bias_is_bounded);
+  RUN_TEST(test_reset_reseeds);
+  return UNITY_END();
+}
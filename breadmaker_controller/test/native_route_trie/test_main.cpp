@@ -0,0 +1,115 @@
+// Route path trie (route_trie.cpp), as web_routes.cpp builds it
+#include <unity.h>
+#include <string>
+#include <vector>
+#include "route_trie.cpp"
+
+static RouteTrie trie;
+
+void setUp() {
+  trie.clear();
+}
+void tearDown() {}
+
+// Inserts path and marks its node with value, as web_routes.cpp marks the first route
+static void add(const char* path, int16_t value) {
+  int16_t n = trie.insert(path);
+  TEST_ASSERT_TRUE(n >= 0);
+  if (trie.value(n) < 0) trie.value(n) = value;
+}
+
+static int16_t valueOf(const char* path) {
+  int16_t n = trie.find(path);
+  return n < 0 ? -1 : trie.value(n);
+}
+
+static void test_empty_trie_finds_nothing() {
+  TEST_ASSERT_EQUAL(1, trie.nodeCount());
+  TEST_ASSERT_EQUAL(-1, valueOf("/status"));
+  TEST_ASSERT_EQUAL(-1, valueOf("/"));
+  TEST_ASSERT_EQUAL(0, trie.find(""));   // The root
+}
+
+static void test_shared_prefixes() {
+  add("/api/status", 0);
+  add("/api/stats", 1);
+  add("/api/state", 2);
+  add("/api", 3);
+  add("/", 4);
+  add("/status", 5);
+
+  TEST_ASSERT_EQUAL(0, valueOf("/api/status"));
+  TEST_ASSERT_EQUAL(1, valueOf("/api/stats"));
+  TEST_ASSERT_EQUAL(2, valueOf("/api/state"));
+  TEST_ASSERT_EQUAL(3, valueOf("/api"));
+  TEST_ASSERT_EQUAL(4, valueOf("/"));
+  TEST_ASSERT_EQUAL(5, valueOf("/status"));
+
+  // Split nodes ("/api/stat") exist but carry no route
+  TEST_ASSERT_EQUAL(-1, valueOf("/api/stat"));
+  TEST_ASSERT_EQUAL(-1, valueOf("/api/"));
+  // Longer than any path, a different branch, or diverging inside a label
+  TEST_ASSERT_EQUAL(-1, valueOf("/api/status/x"));
+  TEST_ASSERT_EQUAL(-1, valueOf("/apx"));
+  TEST_ASSERT_EQUAL(-1, valueOf("/api/statuz"));
+  TEST_ASSERT_EQUAL(-1, valueOf("status"));
+}
+
+static void test_insert_returns_same_node_for_same_path() {
+  int16_t a = trie.insert("/api/routes");
+  uint16_t nodes = trie.nodeCount();
+  TEST_ASSERT_EQUAL(a, trie.insert("/api/routes"));
+  TEST_ASSERT_EQUAL(nodes, trie.nodeCount());
+  TEST_ASSERT_EQUAL(a, trie.find("/api/routes"));
+}
+
+static void test_node_bound_holds_for_full_table() {
+  // Every insert adds at most a split node and a leaf
+  std::vector<std::string> paths;
+  for (uint16_t i = 0; i < ROUTE_TRIE_MAX_PATHS; i++) {
+    paths.push_back("/api/" + std::to_string(i * 7919 % 1000) + "/x" + std::to_string(i));
+  }
+  for (uint16_t i = 0; i < paths.size(); i++) add(paths[i].c_str(), i);
+  TEST_ASSERT_LESS_OR_EQUAL(RouteTrie::MAX_NODES, trie.nodeCount());
+  for (uint16_t i = 0; i < paths.size(); i++) TEST_ASSERT_EQUAL(i, valueOf(paths[i].c_str()));
+}
+
+static void test_clear_rebuilds() {
+  add("/a", 0);
+  add("/b", 1);
+  trie.clear();
+  TEST_ASSERT_EQUAL(1, trie.nodeCount());
+  TEST_ASSERT_EQUAL(-1, valueOf("/a"));
+  add("/b", 7);
+  TEST_ASSERT_EQUAL(7, valueOf("/b"));
+}
+
+static void test_matches_linear_scan() {
+  // The lookup must agree with comparing against every path, as the core's list did
+  const char* paths[] = { "/", "/status", "/start", "/stop", "/api/programs", "/api/program", "/api/pid",
+                          "/api/pid_status", "/api/pid_profile", "/ha", "/home", "/metrics", "/api/motor_pulse" };
+  const size_t count = sizeof(paths) / sizeof(paths[0]);
+  for (size_t i = 0; i < count; i++) add(paths[i], (int16_t)i);
+
+  const char* probes[] = { "", "/", "/s", "/sta", "/status", "/statusx", "/start", "/stop", "/api", "/api/pid",
+                           "/api/pid_", "/api/pid_status", "/api/pid_profiles", "/api/program", "/api/programs",
+                           "/h", "/ha", "/hom", "/home", "/metrics", "/api/motor_pulse", "/API/pid" };
+  for (const char* probe : probes) {
+    int16_t expected = -1;
+    for (size_t i = 0; i < count; i++) {
+      if (strcmp(paths[i], probe) == 0) expected = (int16_t)i;
+    }
+    TEST_ASSERT_EQUAL(expected, valueOf(probe));
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_empty_trie_finds_nothing);
+  RUN_TEST(test_shared_prefixes);
+  RUN_TEST(test_insert_returns_same_node_for_same_path);
+  RUN_TEST(test_node_bound_holds_for_full_table);
+  RUN_TEST(test_clear_rebuilds);
+  RUN_TEST(test_matches_linear_scan);
+  return UNITY_END();
+}
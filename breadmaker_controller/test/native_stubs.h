@@ -0,0 +1,27 @@
+#pragma once
+// Link-time stand-ins for the host tests (pio test -e native_test).
+// Each test includes this once, from its test_main.cpp, next to the module source it
+// checks. It defines the simulation HAL's globals and the debug_log / control_task
+// entry points modules call, so a test links only the code under test.
+#include <Arduino.h>
+#include <mutex>
+#include "../debug_log.h"
+#include "../control_task.h"
+
+unsigned long simulated_millis = 0;
+double time_acceleration_factor = 1.0;
+SerialClass Serial;
+
+bool debugSerial = false;
+uint8_t logCategoryLevels[LOG_CATEGORY_COUNT] = {};
+void logWrite(LogCategory, uint8_t, const char*, ...) {}
+
+// No control task: controlCommandWait() applies commands inline unless a test
+// drains the queue from its own thread and sets this
+bool testControlTaskRunning = false;
+static std::recursive_mutex testControlMutex;
+
+bool controlTaskRunning() { return testControlTaskRunning; }
+bool onControlCore() { return false; }
+void controlLock() { testControlMutex.lock(); }
+void controlUnlock() { testControlMutex.unlock(); }
@@ -1,6 +1,7 @@
 # run_all_tests.py
 """
-Script to run all breadmaker controller tests against the device at 192.168.250.125.
+Script to run all breadmaker controller tests: the host unit tests (pio test -e native_test)
+and the tests against the device at 192.168.250.125.
 Captures output for Copilot agent review.
 Run this script from the root breadmaker_controller directory.
 """
@@ -43,8 +44,21 @@ def run_js_tests():
         if result.stderr:
             print(result.stderr)
 
+def run_native_tests():
+    import shutil
+    if not shutil.which('pio'):
+        print("PlatformIO is not installed. Skipping host unit tests.")
+        return
+    print("\n=== Running pio test -e native_test ===")
+    result = subprocess.run(['pio', 'test', '-e', 'native_test'], capture_output=True, text=True)
+    print(result.stdout)
+    if result.stderr:
+        print(result.stderr)
+
 def main():
-    print("Running Python tests...")
+    print("Running host unit tests...")
+    run_native_tests()
+    print("\nRunning Python tests...")
     run_python_tests()
     print("\nRunning JavaScript tests...")
     run_js_tests()
@@ -0,0 +1,223 @@
+#include "thermal_monitor.h"
+#include <math.h>
+
+ThermalMonitor thermalMonitor;
+
+static float clampf(float v, float lo, float hi) {
+  return v < lo ? lo : (v > hi ? hi : v);
+}
+
+void ThermalMonitor::reset() {
+  count = 0;
+  head = 0;
+  heatFiltered = 0.0f;
+  lastHeaterOnSeconds = -1.0f;
+  heaterOffSinceSec = -1.0f;
+  lastRaw = -1.0f;
+  lastSequence = 0;
+  lastNewSampleSec = -1.0f;
+  stuckSinceSec = -1.0f;
+  stuckRepeats = 0;
+  noRiseOnsetSec = -1.0f;
+  runawayOnsetSec = -1.0f;
+  ThermalMonitorStats fresh;
+  for (int i = 0; i < 5; i++) fresh.alarms[i] = stats.alarms[i];
+  fresh.lastDecisionLatency = stats.lastDecisionLatency;
+  stats = fresh;
+}
+
+void ThermalMonitor::clearFault() {
+  reset();
+}
+
+// Least-squares fit of T = a + c*t + g*E over the window (centred sums for stability).
+// When the heater duty barely varied, t and E are collinear and g cannot be separated
+// from c; the overall slope is then attributed to the heater (or to drift if it was off),
+// which is a lower bound on g while the oven is above ambient.
+void ThermalMonitor::fit() {
+  const uint8_t n = count;
+  const uint8_t len = config.windowSamples;
+  float mt = 0, mE = 0, mT = 0;
+  for (uint8_t i = 0; i < n; i++) {
+    uint8_t idx = (head + len - n + i) % len;
+    mt += window[idx].timeSec; mE += heatDelivered[idx]; mT += window[idx].temperature;
+  }
+  mt /= n; mE /= n; mT /= n;
+
+  double Stt = 0, StE = 0, SEE = 0, StT = 0, SET = 0;
+  for (uint8_t i = 0; i < n; i++) {
+    uint8_t idx = (head + len - n + i) % len;
+    double dt = window[idx].timeSec - mt, dE = heatDelivered[idx] - mE, dT = window[idx].temperature - mT;
+    Stt += dt * dt; StE += dt * dE; SEE += dE * dE; StT += dt * dT; SET += dE * dT;
+  }
+  if (Stt <= 0) return;
+
+  const ThermalSample& oldest = window[(head + len - n) % len];
+  const ThermalSample& newest = window[(head + len - 1) % len];
+  float span = newest.timeSec - oldest.timeSec;
+  stats.dutyMean = span > 0 ? clampf((newest.heaterOnSeconds - oldest.heaterOnSeconds) / span, 0.0f, 1.0f) : 0.0f;
+  stats.slope = (float)(StT / Stt);
+
+  double det = Stt * SEE - StE * StE;
+  double collinearity = (SEE > 1e-6) ? (StE * StE) / (Stt * SEE) : 1.0;
+  double c, g, a;
+  if (SEE > 1e-6 && collinearity < 0.95 && det > 1e-9) {
+    c = (StT * SEE - SET * StE) / det;
+    g = (SET * Stt - StT * StE) / det;
+    stats.gainIdentifiable = true;
+  } else if (stats.dutyMean > 0.05f) {
+    g = stats.slope / stats.dutyMean;
+    c = 0.0;
+    stats.gainIdentifiable = false;
+  } else {
+    g = 0.0;
+    c = stats.slope;
+    stats.gainIdentifiable = false;
+  }
+  a = mT - c * mt - g * mE;
+  stats.heaterGain = (float)g;
+  stats.driftSlope = (float)c;
+
+  double sse = 0;
+  for (uint8_t i = 0; i < n; i++) {
+    uint8_t idx = (head + len - n + i) % len;
+    double r = window[idx].temperature - (a + c * window[idx].timeSec + g * heatDelivered[idx]);
+    sse += r * r;
+  }
+  stats.residualStd = n > 3 ? (float)sqrt(sse / (n - 3)) : 0.0f;
+}
+
+ThermalFault ThermalMonitor::raise(ThermalFault fault, float nowSec, float onsetSec) {
+  if (stats.fault != THERMAL_OK) return THERMAL_OK;  // Latched until clearFault()
+  stats.fault = fault;
+  stats.faultTimeSec = nowSec;
+  stats.lastDecisionLatency = onsetSec >= 0 ? nowSec - onsetSec : 0.0f;
+  stats.alarms[fault]++;
+  return fault;
+}
+
+ThermalFault ThermalMonitor::update(const ThermalSample& sample) {
+  if (config.windowSamples < 8) config.windowSamples = 8;
+  if (config.windowSamples > THERMAL_WINDOW_MAX) config.windowSamples = THERMAL_WINDOW_MAX;
+  const uint8_t len = config.windowSamples;
+  const float now = sample.timeSec;
+  stats.updates++;
+
+  // Heater-off tracking (cumulative on-time did not advance since the last sample)
+  if (lastHeaterOnSeconds >= 0 && sample.heaterOnSeconds > lastHeaterOnSeconds + 0.001f) {
+    heaterOffSinceSec = -1.0f;
+  } else if (heaterOffSinceSec < 0) {
+    heaterOffSinceSec = now;
+  }
+
+  // Heat reaches the chamber through the element: first-order lag on cumulative on-time
+  if (count == 0 || config.elementLagSeconds <= 0) {
+    heatFiltered = sample.heaterOnSeconds;
+  } else {
+    const ThermalSample& prev = window[(head + len - 1) % len];
+    float dt = sample.timeSec - prev.timeSec;
+    float alpha = dt > 0 ? 1.0f - expf(-dt / config.elementLagSeconds) : 0.0f;
+    heatFiltered += alpha * (sample.heaterOnSeconds - heatFiltered);
+  }
+  lastHeaterOnSeconds = sample.heaterOnSeconds;
+
+  // Stuck sensor: decimated readings of a live sensor always move by a fraction of a count.
+  // The safety check runs faster than a slow sensor produces outputs, so only a new output
+  // (sequence changed) is compared, and stuck time runs between new outputs: re-reading
+  // the same output is not evidence of a frozen ADC.
+  if (lastNewSampleSec < 0 || sample.sequence != lastSequence) {
+    if (lastRaw >= 0 && fabsf(sample.rawAdc - lastRaw) <= config.stuckEpsilon) {
+      if (stuckSinceSec < 0) stuckSinceSec = lastNewSampleSec;
+      if (stuckRepeats < 255) stuckRepeats++;
+    } else {
+      stuckSinceSec = -1.0f;
+      stuckRepeats = 0;
+    }
+    lastRaw = sample.rawAdc;
+    lastSequence = sample.sequence;
+    lastNewSampleSec = now;
+  }
+  stats.stuckForSeconds = stuckSinceSec >= 0 ? lastNewSampleSec - stuckSinceSec : 0.0f;
+
+  window[head] = sample;
+  heatDelivered[head] = heatFiltered;
+  head = (head + 1) % len;
+  if (count < len) count++;
+
+  if (stats.stuckForSeconds >= config.stuckSeconds && stuckRepeats >= config.stuckMinRepeats) {
+    return raise(THERMAL_STUCK_SENSOR, now, stuckSinceSec);
+  }
+
+  // Need at least half a window before judging slopes
+  if (count < len / 2 + 1) return THERMAL_OK;
+  fit();
+
+  const ThermalSample& oldest = window[(head + len - count) % len];
+  float heaterOnInWindow = sample.heaterOnSeconds - oldest.heaterOnSeconds;
+  const float k = config.cusumSlack;
+
+  // --- Heater on, no rise: CUSUM on normalised shortfall of the heater gain ---
+  // At constant duty g and drift are confounded (a controller holding setpoint shows slope ~0
+  // at any healthy gain), so without duty variation only a saturated heater is judged.
+  bool judgeElement = heaterOnInWindow >= config.minHeaterOnSeconds &&
+                      sample.temperature < config.maxJudgeTemperature &&
+                      (stats.gainIdentifiable || stats.dutyMean >= config.saturatedDuty);
+  if (judgeElement) {
+    // Above ambient drift is <= 0 and duty <= 1, so a rising oven has g >= slope; this keeps
+    // heat from an uncommanded source (negative fitted g) from reading as a dead element
+    float gain = fmaxf(stats.heaterGain, stats.slope);
+    float z = clampf((config.minHeaterGain - gain) / config.minHeaterGain, -2.0f, 2.0f);
+    float prev = stats.cusumNoRise;
+    stats.cusumNoRise = fmaxf(0.0f, stats.cusumNoRise + z - k);
+    if (prev == 0.0f && stats.cusumNoRise > 0.0f) noRiseOnsetSec = now;
+  } else {
+    stats.cusumNoRise = fmaxf(0.0f, stats.cusumNoRise - k);
+  }
+  if (stats.cusumNoRise == 0.0f) noRiseOnsetSec = -1.0f;
+  if (stats.cusumNoRise >= config.noRiseThreshold) {
+    return raise(THERMAL_HEATER_NO_RISE, now, noRiseOnsetSec);
+  }
+
+  // --- Heater off, rising: CUSUM on slope relative to the runaway slope ---
+  bool heaterSettledOff = heaterOffSinceSec >= 0 && (now - heaterOffSinceSec) >= config.heaterOffSettleSeconds;
+  if (heaterSettledOff && heaterOnInWindow < 0.5f) {
+    float z = clampf(stats.slope / config.runawaySlope - 1.0f, -2.0f, 2.0f);
+    float prev = stats.cusumRunaway;
+    stats.cusumRunaway = fmaxf(0.0f, stats.cusumRunaway + z - k);
+    if (prev == 0.0f && stats.cusumRunaway > 0.0f) runawayOnsetSec = now;
+  } else {
+    stats.cusumRunaway = fmaxf(0.0f, stats.cusumRunaway - k);
+  }
+  if (stats.cusumRunaway == 0.0f) runawayOnsetSec = -1.0f;
+  if (stats.cusumRunaway >= config.runawayThreshold) {
+    return raise(THERMAL_RUNAWAY, now, runawayOnsetSec);
+  }
+
+  // --- Predicted overtemperature: extrapolate the window slope ---
+  // A full-power ramp towards a high setpoint is steep by design, so the prediction only
+  // judges a rise the controller is not asking for: the heater off for longer than the
+  // element lag, or the temperature past the setpoint by more than the overshoot band.
+  bool heaterOff = heaterOffSinceSec >= 0 && (now - heaterOffSinceSec) >= config.elementLagSeconds;
+  bool pastSetpoint = sample.setpoint < 0 || sample.temperature > sample.setpoint + config.overshootBand;
+  if (stats.slope > 0.001f && sample.temperature < config.emergencyTemperature) {
+    stats.secondsToEmergency = (config.emergencyTemperature - sample.temperature) / stats.slope;
+    if (stats.secondsToEmergency < config.predictionHorizon && (heaterOff || pastSetpoint)) {
+      return raise(THERMAL_PREDICTED_OVERTEMP, now, now);
+    }
+  } else {
+    stats.secondsToEmergency = -1.0f;
+  }
+
+  return THERMAL_OK;
+}
+
+const char* thermalFaultName(ThermalFault fault) {
+  switch (fault) {
+    case THERMAL_OK: return "ok";
+    case THERMAL_HEATER_NO_RISE: return "heater_no_rise";
+    case THERMAL_RUNAWAY: return "runaway";
+    case THERMAL_PREDICTED_OVERTEMP: return "predicted_overtemp";
+    case THERMAL_STUCK_SENSOR: return "stuck_sensor";
+  }
+  return "unknown";
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <stdint.h>
+
+// Predictive thermal fault detection.
+// Fed once per second with temperature, cumulative heater on-time and the raw ADC
+// reading. Over a sliding window it fits temperature = a + c*t + g*E by least
+// squares (E = heater on-seconds passed through the element lag), i.e. the regression
+// of temperature slope against heater duty in integral form: g is the heater's effect
+// (°C per heater-second) and c the drift with the heater off. CUSUM statistics on g and c separate a slow oven
+// (small but positive g) from a dead element (g ~ 0) and catch runaway with the
+// heater off long before the 240°C limit.
+//
+// Pure C++ (no Arduino dependencies) so simulation/tools/thermal_monitor_bench.cpp
+// can replay simulated and recorded runs through the same code.
+
+enum ThermalFault : uint8_t {
+  THERMAL_OK = 0,
+  THERMAL_HEATER_NO_RISE = 1,     // Heater on, no temperature response (dead element, open relay)
+  THERMAL_RUNAWAY = 2,            // Rising with the heater off (welded relay, external heat)
+  THERMAL_PREDICTED_OVERTEMP = 3, // Heater off or above setpoint, and the slope reaches the emergency limit within the horizon
+  THERMAL_STUCK_SENSOR = 4        // Raw ADC reading frozen
+};
+
+constexpr uint8_t THERMAL_WINDOW_MAX = 60;
+
+struct ThermalMonitorConfig {
+  uint8_t windowSamples = 60;          // Regression window (samples at 1 Hz), >= 2 heater windows
+  float elementLagSeconds = 15.0f;     // Element-to-chamber lag applied to heater on-time before the fit
+  float minHeaterGain = 0.005f;        // °C per heater-second below which the element is considered dead
+  float minHeaterOnSeconds = 10.0f;    // Heater on-time required in the window before judging the element
+  float saturatedDuty = 0.9f;          // Without duty variation, only judge the element at this duty or above
+  float runawaySlope = 0.03f;          // °C/s rise with heater off that counts as runaway
+  float heaterOffSettleSeconds = 60.0f;// Ignore residual element heat for this long after turn-off
+  float cusumSlack = 0.5f;             // CUSUM reference value k (normalised units)
+  float noRiseThreshold = 6.0f;        // CUSUM decision threshold h for HEATER_NO_RISE
+  float runawayThreshold = 4.0f;       // CUSUM decision threshold h for RUNAWAY
+  float emergencyTemperature = 240.0f; // Limit used for the overtemperature prediction
+  float predictionHorizon = 60.0f;     // Seconds ahead for THERMAL_PREDICTED_OVERTEMP
+  float overshootBand = 5.0f;          // °C above the setpoint before a rise with the heater on is judged
+  float maxJudgeTemperature = 195.0f;  // Above this a flat curve at full duty may be equilibrium, skip no-rise
+  float stuckSeconds = 15.0f;          // Identical raw readings for this long = stuck sensor
+  uint8_t stuckMinRepeats = 2;         // ...and repeated by at least this many new sensor outputs
+  float stuckEpsilon = 0.01f;          // Raw counts; decimated readings always move more than this
+};
+
+struct ThermalSample {
+  float timeSec;          // Monotonic seconds
+  float temperature;      // °C (unsmoothed sensor reading)
+  float heaterOnSeconds;  // Cumulative heater on-time (monotonic)
+  float rawAdc;           // Decimated ADC counts
+  uint32_t sequence = 0;  // Sensor output number; the stuck check only compares new outputs
+  float setpoint = -1.0f; // °C the controller is heating towards; < 0 when unknown
+};
+
+struct ThermalMonitorStats {
+  float heaterGain = 0.0f;        // g: °C per heater-second (NAN-free; 0 when not identifiable)
+  float driftSlope = 0.0f;        // c: °C/s with heater off
+  float slope = 0.0f;             // Overall dT/dt over the window (°C/s)
+  float dutyMean = 0.0f;          // Heater duty over the window (0..1)
+  float residualStd = 0.0f;       // Fit residual std dev (°C)
+  bool gainIdentifiable = false;  // Duty varied enough in the window to separate g from c
+  float cusumNoRise = 0.0f;
+  float cusumRunaway = 0.0f;
+  float secondsToEmergency = -1.0f; // -1 when not rising
+  float stuckForSeconds = 0.0f;
+  ThermalFault fault = THERMAL_OK;
+  float faultTimeSec = 0.0f;
+  float lastDecisionLatency = 0.0f; // Seconds from CUSUM onset (or stuck start) to alarm
+  uint32_t alarms[5] = {0, 0, 0, 0, 0};
+  uint32_t updates = 0;
+};
+
+struct ThermalMonitor {
+  ThermalMonitorConfig config;
+  ThermalMonitorStats stats;
+
+  void reset();
+  // Returns a fault the first time it is raised; THERMAL_OK otherwise (stats.fault latches)
+  ThermalFault update(const ThermalSample& sample);
+  void clearFault();
+
+private:
+  ThermalSample window[THERMAL_WINDOW_MAX];
+  float heatDelivered[THERMAL_WINDOW_MAX];  // Lag-filtered heater on-seconds per window slot
+  float heatFiltered = 0.0f;
+  uint8_t count = 0;
+  uint8_t head = 0;
+  float lastHeaterOnSeconds = -1.0f;
+  float heaterOffSinceSec = -1.0f;
+  float lastRaw = -1.0f;
+  uint32_t lastSequence = 0;
+  float lastNewSampleSec = -1.0f;
+  float stuckSinceSec = -1.0f;
+  uint8_t stuckRepeats = 0;
+  float noRiseOnsetSec = -1.0f;
+  float runawayOnsetSec = -1.0f;
+
+  void fit();
+  ThermalFault raise(ThermalFault fault, float nowSec, float onsetSec);
+};
+
+const char* thermalFaultName(ThermalFault fault);
+
+extern ThermalMonitor thermalMonitor;
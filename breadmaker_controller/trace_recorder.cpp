@@ -0,0 +1,169 @@
+#include "trace_recorder.h"
+#include "control_task.h"
+#include <atomic>
+#include <cstdarg>
+#ifndef NATIVE_SIMULATION
+#include <esp_timer.h>
+#endif
+
+static const char* const CATEGORY_NAMES[TRACE_CATEGORY_COUNT] = {
+  "loop", "control", "http", "flash", "display"
+};
+
+constexpr uint32_t TRACE_INSTANT_DURATION = 0xFFFFFFFF;
+
+// One span or instant; the start is split so the event packs into 16 bytes on the ESP32
+struct TraceEvent {
+  const char* name;
+  uint32_t startLow;
+  uint32_t durationUs;            // TRACE_INSTANT_DURATION for an instant
+  uint16_t startHigh;
+  uint8_t category;
+  uint8_t thread;                 // 1 = loop(), 2 = control task
+};
+
+static TraceEvent ring[TRACE_RING_EVENTS];
+static uint32_t written = 0;      // Events ever recorded; the newest is at written - 1
+static portMUX_TYPE traceMux = portMUX_INITIALIZER_UNLOCKED;
+static std::atomic<bool> enabled{true};
+static std::atomic<uint32_t> minUs{TRACE_DEFAULT_MIN_US};
+static TraceStats stats;
+
+static void record(TraceCategory category, const char* name, int64_t startUs, uint32_t durationUs) {
+  TraceEvent e;
+  e.name = name;
+  e.startLow = (uint32_t)startUs;
+  e.startHigh = (uint16_t)((uint64_t)startUs >> 32);
+  e.durationUs = durationUs;
+  e.category = category;
+  e.thread = onControlCore() ? 2 : 1;
+  portENTER_CRITICAL(&traceMux);
+  if (written >= TRACE_RING_EVENTS) stats.overwritten++;
+  ring[written % TRACE_RING_EVENTS] = e;
+  written++;
+  if (durationUs == TRACE_INSTANT_DURATION) stats.instants++;
+  else stats.spans++;
+  portEXIT_CRITICAL(&traceMux);
+}
+
+void traceComplete(TraceCategory category, const char* name, int64_t startUs, uint32_t durationUs) {
+  if (!enabled.load(std::memory_order_relaxed)) return;
+  if (durationUs < minUs.load(std::memory_order_relaxed)) {
+    stats.skipped++;   // Approximate across cores; only a rate indicator
+    return;
+  }
+  if (durationUs == TRACE_INSTANT_DURATION) durationUs--;
+  record(category, name, startUs, durationUs);
+}
+
+void traceInstant(TraceCategory category, const char* name) {
+  if (!enabled.load(std::memory_order_relaxed)) return;
+  record(category, name, esp_timer_get_time(), TRACE_INSTANT_DURATION);
+}
+
+TraceSpan::TraceSpan(TraceCategory category, const char* name)
+  : name(name), startUs(enabled.load(std::memory_order_relaxed) ? esp_timer_get_time() : 0), category(category) {}
+
+TraceSpan::~TraceSpan() {
+  if (!startUs) return;   // Recorder was off when the span started
+  traceComplete(category, name, startUs, (uint32_t)(esp_timer_get_time() - startUs));
+}
+
+void traceSetEnabled(bool on) {
+  enabled.store(on);
+}
+
+bool traceEnabled() {
+  return enabled.load();
+}
+
+void traceSetMinUs(uint32_t us) {
+  minUs.store(us);
+}
+
+uint32_t traceMinUs() {
+  return minUs.load();
+}
+
+// JSON string body; names are URIs and labels, so only quotes, backslashes and control characters matter
+static size_t escapeName(char* dst, size_t size, const char* name) {
+  size_t n = 0;
+  for (const char* p = name; *p && n + 3 < size; p++) {
+    unsigned char c = (unsigned char)*p;
+    if (c == '"' || c == '\\') dst[n++] = '\\';
+    dst[n++] = c < 0x20 ? '?' : c;
+  }
+  dst[n] = '\0';
+  return n;
+}
+
+static void emit(Print& out, const char* format, ...) __attribute__((format(printf, 2, 3)));
+static void emit(Print& out, const char* format, ...) {
+  char line[192];
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+  if (n <= 0) return;
+  out.write((const uint8_t*)line, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1);
+}
+
+void traceRender(Print& out) {
+  portENTER_CRITICAL(&traceMux);
+  uint32_t end = written;
+  TraceStats snap = stats;
+  portEXIT_CRITICAL(&traceMux);
+  uint32_t begin = end > TRACE_RING_EVENTS ? end - TRACE_RING_EVENTS : 0;
+
+  emit(out, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"enabled\":%s,\"min_us\":%lu,\"spans\":%lu,"
+            "\"instants\":%lu,\"skipped\":%lu,\"overwritten\":%lu,\"ring_events\":%u,\"elapsed_ms\":%lu},"
+            "\"traceEvents\":[",
+       traceEnabled() ? "true" : "false", (unsigned long)traceMinUs(), (unsigned long)snap.spans,
+       (unsigned long)snap.instants, (unsigned long)snap.skipped, (unsigned long)snap.overwritten,
+       (unsigned)TRACE_RING_EVENTS, millis() - snap.sinceMs);
+  emit(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"breadmaker\"}}");
+  emit(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"loop\"}}");
+  emit(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"control\"}}");
+
+  for (uint32_t i = begin; i < end; i++) {
+    TraceEvent e;
+    bool current;
+    portENTER_CRITICAL(&traceMux);
+    current = written - i <= TRACE_RING_EVENTS;
+    if (current) e = ring[i % TRACE_RING_EVENTS];
+    portEXIT_CRITICAL(&traceMux);
+    if (!current) continue;   // Overwritten while this dump was being sent
+
+    char name[64];
+    escapeName(name, sizeof(name), e.name ? e.name : "?");
+    unsigned long long ts = ((unsigned long long)e.startHigh << 32) | e.startLow;
+    const char* cat = e.category < TRACE_CATEGORY_COUNT ? CATEGORY_NAMES[e.category] : "other";
+    if (e.durationUs == TRACE_INSTANT_DURATION) {
+      emit(out, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%llu,\"pid\":1,\"tid\":%u}",
+           name, cat, ts, (unsigned)e.thread);
+    } else {
+      emit(out, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%lu,\"pid\":1,\"tid\":%u}",
+           name, cat, ts, (unsigned long)e.durationUs, (unsigned)e.thread);
+    }
+  }
+  emit(out, "]}\n");
+}
+
+void traceClear() {
+  portENTER_CRITICAL(&traceMux);
+  written = 0;
+  stats = TraceStats();
+  stats.sinceMs = millis();
+  portEXIT_CRITICAL(&traceMux);
+}
+
+uint16_t traceEventCount() {
+  portENTER_CRITICAL(&traceMux);
+  uint32_t n = written < TRACE_RING_EVENTS ? written : TRACE_RING_EVENTS;
+  portEXIT_CRITICAL(&traceMux);
+  return (uint16_t)n;
+}
+
+const TraceStats& traceGetStats() {
+  return stats;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <Arduino.h>
+
+// Span recorder for the main loop, the control task and the web handlers.
+// When the oven misses a PID sample or a stage advance stalls, the stats endpoints
+// say that something was slow but not what ran around it. TraceSpan marks a piece of
+// work (a loop() phase, a route handler, a flash open/close, a display redraw, the
+// control tick); when it ends, a span that took at least the recording threshold
+// (TRACE_DEFAULT_MIN_US, /api/trace?min_us=) is written to a fixed RAM ring as one
+// 16-byte event: static name, category, thread, start and duration in microseconds.
+// Short spans - an idle handleClient(), a tick with nothing to do - cost two
+// esp_timer_get_time() reads and a compare, so the recorder stays on in production
+// and the ring holds the last few minutes of slow work rather than the last second.
+//
+// Each span is stored once, at its end, as a Chrome "complete" event (ph "X") rather
+// than as separate begin and end records: half the ring per span, and the oldest
+// entries never leave a begin without its end when the ring wraps. /api/trace
+// streams the ring as Chrome trace-event JSON for chrome://tracing or
+// ui.perfetto.dev; loop() is thread 1, the control task thread 2.
+//
+// Names must outlive the ring: string literals, route URIs, persistence paths.
+
+constexpr uint16_t TRACE_RING_EVENTS = 512;           // 8 KB
+constexpr uint32_t TRACE_DEFAULT_MIN_US = 200;
+
+enum TraceCategory : uint8_t {
+  TRACE_LOOP = 0,
+  TRACE_CONTROL,
+  TRACE_HTTP,
+  TRACE_FLASH,
+  TRACE_DISPLAY,
+  TRACE_CATEGORY_COUNT
+};
+
+struct TraceStats {
+  uint32_t spans = 0;             // Recorded (at or above the threshold)
+  uint32_t instants = 0;
+  uint32_t skipped = 0;           // Under the threshold
+  uint32_t overwritten = 0;       // Recorded events pushed out of the ring
+  unsigned long sinceMs = 0;
+};
+
+// Records a span measured by the caller (esp_timer_get_time() microseconds)
+void traceComplete(TraceCategory category, const char* name, int64_t startUs, uint32_t durationUs);
+// Records a point in time (always kept, regardless of the threshold)
+void traceInstant(TraceCategory category, const char* name);
+
+class TraceSpan {
+  public:
+    TraceSpan(TraceCategory category, const char* name);
+    ~TraceSpan();
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+  private:
+    const char* name;
+    int64_t startUs;
+    TraceCategory category;
+};
+
+void traceSetEnabled(bool enabled);
+bool traceEnabled();
+void traceSetMinUs(uint32_t minUs);
+uint32_t traceMinUs();
+
+// Streams the ring, oldest first, as a Chrome trace-event JSON object. Recording
+// continues meanwhile; events overwritten during the dump are left out.
+void traceRender(Print& out);
+// Empties the ring and resets the counters
+void traceClear();
+
+uint16_t traceEventCount();
+const TraceStats& traceGetStats();
@@ -7,13 +7,33 @@
 #include <PID_v1.h>
 #include <WiFi.h>
 #include "calibration.h"
-#include <FFat.h>
+#include "storage_backend.h"  // Filesystem backend (FFat/LittleFS/host)
 #include "ota_manager.h"
 #include <Update.h>  // For web-based firmware updates
 #include <algorithm>  // For std::sort
 #include "missing_stubs.h"  // For getAdjustedStageTimeMs and other functions
 #include "display_manager.h"  // For screensaver control
 #include "program_logger.h"  // For activity logging
+#include "rtd_sampler.h"  // For oversampled RTD acquisition stats
+#include "sensor_service.h"  // Shared sensor reading (no ADC access from handlers)
+#include "temperature_estimator.h"  // Kalman estimator status
+#include "thermal_monitor.h"  // Predictive thermal fault detection
+#include "heater_timer.h"  // Hardware-timed heater window stats
+#include "enhanced_motor_control.h"  // Hardware-timed motor pulse stats
+#include "control_task.h"  // Control lock and snapshot
+#include "control_commands.h"  // Command queue into the control tick
+#include "file_transfer.h"  // Incremental file responses
+#include "background_jobs.h"  // Sliced maintenance jobs
+#include "persistence_manager.h"  // Deferred flash writes
+#include "storage_stats.h"  // Flash write accounting
+#include "storage_bench.h"  // Filesystem backend benchmark
+#include "web_routes.h"  // Route table and per-route metrics
+#include "response_cache.h"  // Cached bodies for polled GETs
+#include "mqtt_publisher.h"  // Change-driven MQTT state for Home Assistant
+#include "metrics_exporter.h"  // Prometheus /metrics
+#include "telemetry_stream.h"  // Binary telemetry over Serial
+#include "debug_log.h"  // Levelled debug log
+#include "trace_recorder.h"  // Span ring for /api/trace
 
 // External OTA status for web integration
 extern OTAStatus otaStatus;
@@ -52,6 +72,21 @@ class WebServerPrint : public Print {
     }
 };
 
+// Registers a handler that reads or changes control state. It runs with the control
+// lock held, so it never interleaves with a control tick on the other core; its
+// response is held in RAM and sent once the lock is released, so a slow client
+// doesn't hold up the tick. File transfers and OTA stay on routeOn() and never hold the lock.
+static void onControl(WebServer& server, const char* uri, HTTPMethod method, std::function<void()> handler) {
+    routeOn(server, uri, method, [handler]() {
+        webResponseDefer();
+        {
+            ControlLockGuard guard;
+            handler();
+        }
+        webResponseSend();
+    });
+}
+
 // Performance tracking variables
 static unsigned long loopCount = 0;
 static unsigned long lastLoopTime = 0;
@@ -61,16 +96,16 @@ static unsigned long minFreeHeap = 0xFFFFFFFF;
 static unsigned long wifiReconnectCount = 0;
 static unsigned long lastWifiStatus = WL_CONNECTED;
 
-// Caching variables for frequently accessed endpoints
-static unsigned long lastStatusUpdate = 0;
-static unsigned long lastHaUpdate = 0;
-static const unsigned long STATUS_CACHE_MS = 1000;  // Cache for 1 second
-static const unsigned long HA_CACHE_MS = 3000;      // Cache HA for 3 seconds
+// Response cache TTLs for frequently polled endpoints (response_cache.h);
+// adjustable through /api/response_cache, 0 = always render
+static const unsigned long STATUS_CACHE_MS = 1000;  // /status, /api/status, /api/pid_status
+static const unsigned long HA_CACHE_MS = 3000;      // /ha
+static unsigned long statusCacheMs = STATUS_CACHE_MS;
+static unsigned long haCacheMs = HA_CACHE_MS;
 
 // Cache invalidation function - call this when state changes
 void invalidateStatusCache() {
-  lastStatusUpdate = 0;
-  lastHaUpdate = 0;
+  responseCacheInvalidate();
 }
 
 // Helper to track web activity for screensaver
@@ -101,7 +136,78 @@ extern void startBuzzerTone(float, float, unsigned long);
 extern float readTemperature();
 extern void loadPIDProfiles();
 extern void savePIDProfiles();
-extern WebServer server; // Global server reference
+extern RoutedWebServer server; // Global server reference
+
+// Queues a state-changing command for the control tick and sends its result.
+// Handlers using this are registered with routeOn(): waiting while holding the
+// control lock would stall the tick that applies the command.
+static void sendCommandResult(WebServer& server, const ControlCommand& cmd) {
+    ControlCommandResult result;
+    controlCommandExecute(cmd, result);
+    if (result.httpCode == 200 && result.body[0] == '\0') {
+        // Snapshot the status under the lock, send it after releasing it
+        String json;
+        json.reserve(4096);
+        {
+            ControlLockGuard guard;
+            StringPrint jsonPrint(json);
+            streamStatusJson(jsonPrint);
+        }
+        server.send(200, "application/json", json);
+        return;
+    }
+    server.send(result.httpCode, "application/json", result.body);
+}
+
+// Reads one /api/batch entry: {"cmd":"<command name>", ...args}. Returns an error
+// message, or nullptr when cmd is filled in.
+static const char* parseBatchCommand(JsonVariant v, ControlCommand& cmd) {
+    ControlCommandType type;
+    if (!controlCommandFromName(v["cmd"] | "", type)) return "Unknown command";
+    cmd.type = type;
+    switch (type) {
+        case CMD_START:
+        case CMD_START_AT_STAGE:
+            cmd.intArg = v["stage"] | 0;
+            break;
+        case CMD_ADD_PREFERMENTATION:
+        case CMD_SET_SETPOINT:
+            if (!v.containsKey("value")) return "Missing value";
+            cmd.floatArg = v["value"] | 0.0f;
+            break;
+        case CMD_SELECT_PROGRAM:
+            if (!v.containsKey("program")) return "Missing program";
+            cmd.intArg = v["program"] | -1;
+            break;
+        case CMD_SET_OUTPUT: {
+            const char* output = v["output"] | "";
+            if (strcmp(output, "heater") == 0) cmd.intArg = 0;
+            else if (strcmp(output, "motor") == 0) cmd.intArg = 1;
+            else if (strcmp(output, "light") == 0) cmd.intArg = 2;
+            else if (strcmp(output, "buzzer") == 0) cmd.intArg = 3;
+            else return "Unknown output";
+            cmd.auxArg = (v["on"] | false) ? 1 : 0;
+            break;
+        }
+        case CMD_SCHEDULE_START: {
+            // "time":"HH:MM", or no time to cancel
+            const char* t = v["time"] | "";
+            int hh, mm;
+            if (t[0] == '\0') {
+                cmd.intArg = -1;
+            } else if (sscanf(t, "%d:%d", &hh, &mm) != 2 || hh < 0 || hh > 23 || mm < 0 || mm > 59) {
+                return "Invalid time format. Use HH:MM";
+            } else {
+                cmd.intArg = hh * 60 + mm;
+            }
+            cmd.auxArg = v["stage"] | -1;
+            break;
+        }
+        default:
+            break;
+    }
+    return nullptr;
+}
 
 extern void sendJsonError(WebServer& server, const String&, const String&, int);
 void deleteFolderRecursive(const String& path);
@@ -140,10 +246,10 @@ bool serveStaticFile(WebServer& server, const String& path) {
   }
   
   // Check if file exists
-  if (!FFat.exists(fullPath)) {
+  if (!storageFS().exists(fullPath)) {
     // Try without leading slash in case FATFS doesn't like it
     String altPath = fullPath.substring(1);
-    if (!FFat.exists(altPath)) {
+    if (!storageFS().exists(altPath)) {
       if (debugSerial) {
         Serial.printf("[DEBUG] File not found: %s (also tried: %s)\n", fullPath.c_str(), altPath.c_str());
       }
@@ -163,7 +269,7 @@ bool serveStaticFile(WebServer& server, const String& path) {
   else if (fullPath.endsWith(".svg")) contentType = "image/svg+xml";
   else if (fullPath.endsWith(".ico")) contentType = "image/x-icon";
   
-  File file = FFat.open(fullPath, "r");
+  File file = storageFS().open(fullPath, "r");
   if (!file) {
     if (debugSerial) {
       Serial.printf("[DEBUG] Failed to open file: %s\n", fullPath.c_str());
@@ -175,26 +281,8 @@ bool serveStaticFile(WebServer& server, const String& path) {
     Serial.printf("[DEBUG] Serving file: %s (%d bytes)\n", fullPath.c_str(), file.size());
   }
   
-  // Use chunked streaming to handle large files without memory issues
-  server.setContentLength(file.size());
-  server.send(200, contentType, "");
-  
-  // Stream file in chunks to avoid memory limitations
-  const size_t CHUNK_SIZE = 1024; // 1KB chunks
-  uint8_t buffer[CHUNK_SIZE];
-  
-  while (file.available()) {
-    size_t bytesRead = file.readBytes((char*)buffer, CHUNK_SIZE);
-    if (bytesRead > 0) {
-      server.client().write(buffer, bytesRead);
-      yield(); // Allow other tasks to run and prevent watchdog timeout
-    } else {
-      break; // End of file or error
-    }
-  }
-  
-  file.close();
-  return true;
+  // Headers now; the body is sent from loop() a budgeted slice at a time
+  return fileTransferBegin(server, file, contentType);
 }
 
 // Performance metrics tracking function is defined in missing_stubs.cpp
@@ -202,7 +290,7 @@ bool serveStaticFile(WebServer& server, const String& path) {
 // Core endpoints
 void coreEndpoints(WebServer& server) {
     // Streaming file upload endpoint for large files
-    static File uploadFile;
+    static StorageFile uploadFile;
     static bool uploadError = false;
     
     // Configure longer timeout for file uploads (60 seconds)
@@ -222,7 +310,7 @@ void coreEndpoints(WebServer& server) {
             if (!filename.startsWith("/")) filename = "/" + filename;
             
             // Try to open the file
-            uploadFile = FFat.open(filename, "w");
+            uploadFile = storageOpen(filename, "w", "upload");
             if (!uploadFile) {
                 if (debugSerial) Serial.printf("[UPLOAD] ERROR: Failed to create file: %s\n", filename.c_str());
                 uploadError = true;
@@ -251,6 +339,7 @@ void coreEndpoints(WebServer& server) {
             yield();
             
         } else if (upload.status == UPLOAD_FILE_END) {
+            ControlLockGuard guard;  // Program cache invalidation below
             if (uploadFile) {
                 uploadFile.close();
                 if (debugSerial) {
@@ -302,11 +391,15 @@ void coreEndpoints(WebServer& server) {
             uploadError = true;
         }
     });
-    server.on("/", HTTP_GET, [&](){
+    routeOn(server, "/", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[DEBUG] Root path '/' requested"));
         
-        // Ensure the active program is loaded when serving the index page
-        updateActiveProgramVars();
+        // Ensure the active program is loaded when serving the index page; the load
+        // rewrites activeProgram, which the control task reads under the lock
+        {
+            ControlLockGuard guard;
+            updateActiveProgramVars();
+        }
         
         if (!serveStaticFile(server, "/")) {
             // If index.html not found, provide helpful debug info
@@ -329,32 +422,30 @@ void coreEndpoints(WebServer& server) {
         }
     });
     
-    server.on("/status", HTTP_GET, [&](){
+    routeOn(server, "/status", HTTP_GET, [&](){
         trackWebActivity(); // Track web activity for screensaver
         if (debugSerial) Serial.println(F("[DEBUG] /status requested"));
         
-        // Stream directly to client - no buffer needed, unlimited size, better memory usage
-        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
-        server.send(200, "application/json", "");
-        WebServerPrint webPrint(server);
-        streamStatusJson(webPrint);
-        server.sendContent(""); // End chunked response
+        // Served from the response cache within STATUS_CACHE_MS; only a render takes the lock
+        responseCacheServe(server, "application/json", statusCacheMs, [](Print& out) {
+            ControlLockGuard guard;
+            streamStatusJson(out);
+        });
     });
     
     // Add missing /api/status endpoint for frontend compatibility
-    server.on("/api/status", HTTP_GET, [&](){
+    routeOn(server, "/api/status", HTTP_GET, [&](){
         trackWebActivity(); // Track web activity for screensaver
         if (debugSerial) Serial.println(F("[DEBUG] /api/status requested"));
         
-        // Stream directly to client - no buffer needed, unlimited size, better memory usage
-        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
-        server.send(200, "application/json", "");
-        WebServerPrint webPrint(server);
-        streamStatusJson(webPrint);
-        server.sendContent(""); // End chunked response
+        // Served from the response cache within STATUS_CACHE_MS; only a render takes the lock
+        responseCacheServe(server, "application/json", statusCacheMs, [](Print& out) {
+            ControlLockGuard guard;
+            streamStatusJson(out);
+        });
     });
     
-    server.on("/api/firmware_info", HTTP_GET, [&](){
+    routeOn(server, "/api/firmware_info", HTTP_GET, [&](){
         // Use efficient streaming for consistency
         server.setContentLength(CONTENT_LENGTH_UNKNOWN);
         server.send(200, "application/json", "");
@@ -366,7 +457,7 @@ void coreEndpoints(WebServer& server) {
     });
     
     // Debug endpoint to check filesystem - OPTIMIZED FOR STREAMING
-    server.on("/debug/fs", HTTP_GET, [&](){
+    routeOn(server, "/debug/fs", HTTP_GET, [&](){
         // Use streaming to avoid large string buffer
         server.setContentLength(CONTENT_LENGTH_UNKNOWN);
         server.send(200, "text/plain", "");
@@ -377,23 +468,25 @@ void coreEndpoints(WebServer& server) {
         server.sendContent("FATFS Debug:\n\n");
         
         // Check if FATFS is mounted
-        if (!FFat.begin()) {
+        if (!storageBegin(false)) {
             server.sendContent("ERROR: FATFS not mounted!\n");
         } else {
-            server.sendContent("✓ FFat mounted successfully\n");
+            server.sendContent("✓ Filesystem mounted successfully (");
+            server.sendContent(storageBackendName());
+            server.sendContent(")\n");
             server.sendContent("Total: ");
-            server.sendContent(String(FFat.totalBytes()));
+            server.sendContent(String(storageTotalBytes()));
             server.sendContent(" bytes\n");
             server.sendContent("Used: ");
-            server.sendContent(String(FFat.usedBytes()));
+            server.sendContent(String(storageUsedBytes()));
             server.sendContent(" bytes\n");
             server.sendContent("Free: ");
-            server.sendContent(String(FFat.totalBytes() - FFat.usedBytes()));
+            server.sendContent(String(storageFreeBytes()));
             server.sendContent(" bytes\n\n");
             
             // List files in root
             server.sendContent("Root directory contents:\n");
-            File root = FFat.open("/");
+            File root = storageFS().open("/");
             if (root) {
                 File file = root.openNextFile();
                 while (file) {
@@ -415,16 +508,16 @@ void coreEndpoints(WebServer& server) {
             // Test specific files
             server.sendContent("\nFile existence tests:\n");
             server.sendContent("/index.html: ");
-            server.sendContent(FFat.exists("/index.html") ? "EXISTS" : "NOT FOUND");
+            server.sendContent(storageFS().exists("/index.html") ? "EXISTS" : "NOT FOUND");
             server.sendContent("\n");
             server.sendContent("index.html: ");
-            server.sendContent(FFat.exists("index.html") ? "EXISTS" : "NOT FOUND");
+            server.sendContent(storageFS().exists("index.html") ? "EXISTS" : "NOT FOUND");
             server.sendContent("\n");
         }
     });
     
     // Simple file upload interface
-    server.on("/upload", HTTP_GET, [&](){
+    routeOn(server, "/upload", HTTP_GET, [&](){
         String html = R"rawliteral(
 <!DOCTYPE html>
 <html>
@@ -516,25 +609,29 @@ void coreEndpoints(WebServer& server) {
         server.send(200, "text/html", html);
     });
     
-    server.on("/api/restart", HTTP_POST, [&](){
+    routeOn(server, "/api/restart", HTTP_POST, [&](){
         server.send(200, "application/json", "{\"status\":\"restarting\"}");
         delay(1000);
+        persistFlushAll();
+        logFlush();
         ESP.restart();
     });
 
     // GET-based restart endpoint (crash workaround)
-    server.on("/api/restart-get", HTTP_GET, [&](){
+    routeOn(server, "/api/restart-get", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[DEBUG] /api/restart-get GET requested"));
         server.send(200, "application/json", "{\"status\":\"restarting\"}");
         delay(1000);
+        persistFlushAll();
+        logFlush();
         ESP.restart();
     });
     
-    server.on("/api/output_mode", HTTP_GET, [&](){
+    onControl(server, "/api/output_mode", HTTP_GET, [&](){
         server.send(200, "application/json", "{\"mode\":\"digital\"}");
     });
     
-    server.on("/api/output_mode", HTTP_POST, [&](){
+    onControl(server, "/api/output_mode", HTTP_POST, [&](){
         if (server.hasArg("plain")) {
             DynamicJsonDocument doc(256);
             DeserializationError err = deserializeJson(doc, server.arg("plain"));
@@ -552,7 +649,7 @@ void coreEndpoints(WebServer& server) {
     });
 
     // GET-based output mode endpoint (crash workaround)
-    server.on("/api/output_mode/set", HTTP_GET, [&](){
+    onControl(server, "/api/output_mode/set", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[DEBUG] /api/output_mode/set GET requested"));
         
         if (server.hasArg("mode")) {
@@ -571,7 +668,7 @@ void coreEndpoints(WebServer& server) {
 
 // State Machine Endpoints
 void stateMachineEndpoints(WebServer& server) {
-    server.on("/start", HTTP_GET, [&](){
+    onControl(server, "/start", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[ACTION] /start called"));
         
         if (server.hasArg("time")) {
@@ -692,52 +789,24 @@ void stateMachineEndpoints(WebServer& server) {
                 server.send(400, "application/json", "{\"error\":\"Invalid stage index\"}");
                 return;
             }
-            programState.customStageIdx = stageIdx;
+            beginProgramRun(stageIdx);
         } else {
-            programState.customStageIdx = 0;
-        }
-        
-        programState.isRunning = true;
-        programState.customMixIdx = 0;
-        programState.customStageStart = millis();
-        programState.customMixStepStart = 0;
-        programState.programStartTime = time(nullptr);
-        
-        // Clear all timing arrays when starting/restarting
-        for (int i = 0; i < 20; i++) {
-            programState.actualStageStartTimes[i] = 0;
-            programState.actualStageEndTimes[i] = 0;
-        }
-        // Record the start time for the current stage
-        programState.actualStageStartTimes[programState.customStageIdx] = programState.programStartTime;
-        
-        // Initialize stage duration arrays with current fermentation conditions
-        initializeStageArrays();
-        
-        if (debugSerial) {
-            Serial.printf("[TIMING] Program started at stage %d, time %lu\n", programState.customStageIdx, (unsigned long)programState.programStartTime);
+            beginProgramRun(0);
         }
-        
-        // Log program start
-        String programName = getProgramName(programState.activeProgramId);
-        logProgramStart(programName, programState.activeProgramId);
-        
-        resetFermentationTracking(getAveragedTemperature());
-        invalidateStatusCache();
         saveResumeState();
         
         server.send(200, "application/json", "{\"status\":\"started\"}");
         if (debugSerial) Serial.println(F("[START] Breadmaker started"));
     });
     
-    server.on("/stop", HTTP_GET, [&](){
+    onControl(server, "/stop", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[ACTION] /stop called"));
         stopBreadmaker();
         server.send(200, "application/json", "{\"status\":\"stopped\"}");
     });
 
     // Finish-by configuration API endpoints
-    server.on("/api/finish-by/config", HTTP_GET, [&](){
+    onControl(server, "/api/finish-by/config", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[API] GET /api/finish-by/config"));
         
         String json = "{";
@@ -753,7 +822,7 @@ void stateMachineEndpoints(WebServer& server) {
         server.send(200, "application/json", json);
     });
 
-    server.on("/api/finish-by/config", HTTP_POST, [&](){
+    onControl(server, "/api/finish-by/config", HTTP_POST, [&](){
         if (debugSerial) Serial.println(F("[API] POST /api/finish-by/config"));
         
         // Parse form parameters
@@ -789,7 +858,7 @@ void stateMachineEndpoints(WebServer& server) {
     });
 
     // Clear finish-by state endpoint
-    server.on("/api/finish-by/clear", HTTP_POST, [&](){
+    onControl(server, "/api/finish-by/clear", HTTP_POST, [&](){
         if (debugSerial) Serial.println(F("[API] POST /api/finish-by/clear"));
         
         // Clear finish-by state
@@ -805,7 +874,7 @@ void stateMachineEndpoints(WebServer& server) {
     });
     
     // Set scheduled start time only (no stage)
-    server.on("/setStartAt", HTTP_GET, [&](){
+    onControl(server, "/setStartAt", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[ACTION] /setStartAt called"));
         
         if (!server.hasArg("time")) {
@@ -865,7 +934,7 @@ void stateMachineEndpoints(WebServer& server) {
     });
     
     // Set scheduled start time and stage
-    server.on("/setStartAtStage", HTTP_GET, [&](){
+    onControl(server, "/setStartAtStage", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[ACTION] /setStartAtStage called"));
         
         if (!server.hasArg("time") || !server.hasArg("stage")) {
@@ -946,7 +1015,7 @@ void stateMachineEndpoints(WebServer& server) {
     });
     
     // Cancel scheduled start
-    server.on("/cancelScheduledStart", HTTP_GET, [&](){
+    onControl(server, "/cancelScheduledStart", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[ACTION] /cancelScheduledStart called"));
         
         if (scheduledStart == 0) {
@@ -966,59 +1035,13 @@ void stateMachineEndpoints(WebServer& server) {
         invalidateStatusCache();
     });
     
-    server.on("/advance", HTTP_GET, [&](){
+    routeOn(server, "/advance", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[ACTION] /advance called"));
-        
-        if (!programState.isRunning) {
-            server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"Program not running\"}");
-            return;
-        }
-        
-        Program* p = getActiveProgramMutable();
-        if (!p || p->customStages.empty()) {
-            server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"No active program\"}");
-            return;
-        }
-        
-        if (programState.customStageIdx >= p->customStages.size() - 1) {
-            server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"Already at last stage\"}");
-            return;
-        }
-        
-        // Record when current stage ended (BEFORE advancing)
-        time_t now = time(nullptr);
-        if (now > 1640995200 && programState.customStageIdx < 20) { // Valid NTP time and within bounds
-            programState.actualStageEndTimes[programState.customStageIdx] = now;
-            if (debugSerial) Serial.printf("[TIMING] Manual advance - Stage %d ended at %lu\n", programState.customStageIdx, (unsigned long)now);
-        }
-        
-        // Save resume state BEFORE advancing (FIX: prevents stage skipping during firmware uploads)
-        saveResumeState();
-        
-        // Manually advance to next stage
-        programState.customStageIdx++;
-        programState.customStageStart = millis();
-        
-        // Update actual stage start times array
-        if (programState.customStageIdx < 20) {
-            programState.actualStageStartTimes[programState.customStageIdx] = now;
-            if (debugSerial) Serial.printf("[TIMING] Manual advance - Stage %d started at %lu\n", programState.customStageIdx, (unsigned long)now);
-        }
-        
-        resetFermentationTracking(getAveragedTemperature());
-        invalidateStatusCache();
-        saveResumeState();
-
-        if (debugSerial) Serial.printf("[MANUAL ADVANCE] Advanced to stage %d\n", (int)programState.customStageIdx);
-
-        // Stream status response directly - no buffer needed
-        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
-        server.send(200, "application/json", "");
-        WebServerPrint webPrint(server);
-        streamStatusJson(webPrint);
-        server.sendContent(""); // End chunked response
+        ControlCommand cmd;
+        cmd.type = CMD_ADVANCE;
+        sendCommandResult(server, cmd);
     });    // Override stage duration endpoint
-    server.on("/api/override_stage_duration", HTTP_GET, [&](){
+    onControl(server, "/api/override_stage_duration", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[ACTION] /api/override_stage_duration called"));
         
         if (!programState.isRunning) {
@@ -1077,31 +1100,9 @@ void stateMachineEndpoints(WebServer& server) {
     });
 
     // Endpoint to add pre-fermentation time to current fermentation tracking
-    server.on("/api/add_prefermentation", HTTP_GET, [&](){
+    routeOn(server, "/api/add_prefermentation", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[ACTION] /api/add_prefermentation called"));
         
-        if (!programState.isRunning) {
-            server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"Program not running\"}");
-            return;
-        }
-        
-        Program* p = getActiveProgramMutable();
-        if (!p || p->customStages.empty()) {
-            server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"No active program\"}");
-            return;
-        }
-        
-        if (programState.customStageIdx >= p->customStages.size()) {
-            server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"Invalid stage index\"}");
-            return;
-        }
-        
-        // Only allow on fermentation stages
-        if (!p->customStages[programState.customStageIdx].isFermentation) {
-            server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"Current stage is not a fermentation stage\"}");
-            return;
-        }
-        
         // Get the seconds parameter
         String secondsParam = server.arg("seconds");
         if (secondsParam.length() == 0) {
@@ -1115,56 +1116,45 @@ void stateMachineEndpoints(WebServer& server) {
             return;
         }
         
-        // Add the pre-fermentation time to scheduled elapsed seconds
-        fermentState.scheduledElapsedSeconds += addSeconds;
-        
-        // Save the state
-        invalidateStatusCache();
-        saveResumeState();
-        
-        if (debugSerial) Serial.printf("[PRE-FERMENTATION] Added %.1f seconds to fermentation tracking (now %.1f total)\n", 
-                                     addSeconds, fermentState.scheduledElapsedSeconds);
-
-        // Stream status response directly - no buffer needed
-        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
-        server.send(200, "application/json", "");
-        WebServerPrint webPrint(server);
-        streamStatusJson(webPrint);
-        server.sendContent(""); // End chunked response
+        // Running/fermentation-stage checks happen when the command is applied
+        ControlCommand cmd;
+        cmd.type = CMD_ADD_PREFERMENTATION;
+        cmd.floatArg = addSeconds;
+        sendCommandResult(server, cmd);
     });
 }
 
 // Manual Output Endpoints
 void manualOutputEndpoints(WebServer& server) {
-    server.on("/toggle_heater", HTTP_GET, [&](){
+    onControl(server, "/toggle_heater", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[MANUAL] Toggle heater"));
         setHeater(!heaterState);
         // Ultra-efficient: Use static strings instead of String concatenation
         server.send(200, "application/json", heaterState ? "{\"heater\":true}" : "{\"heater\":false}");
     });
     
-    server.on("/toggle_motor", HTTP_GET, [&](){
+    onControl(server, "/toggle_motor", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[MANUAL] Toggle motor"));
         setMotor(!motorState);
         // Ultra-efficient: Use static strings instead of String concatenation
         server.send(200, "application/json", motorState ? "{\"motor\":true}" : "{\"motor\":false}");
     });
     
-    server.on("/toggle_light", HTTP_GET, [&](){
+    onControl(server, "/toggle_light", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[MANUAL] Toggle light"));
         setLight(!lightState);
         // Ultra-efficient: Use static strings instead of String concatenation
         server.send(200, "application/json", lightState ? "{\"light\":true}" : "{\"light\":false}");
     });
     
-    server.on("/toggle_buzzer", HTTP_GET, [&](){
+    onControl(server, "/toggle_buzzer", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[MANUAL] Toggle buzzer"));
         setBuzzer(!buzzerState);
         // Ultra-efficient: Use static strings instead of String concatenation
         server.send(200, "application/json", buzzerState ? "{\"buzzer\":true}" : "{\"buzzer\":false}");
     });
     
-    server.on("/beep", HTTP_GET, [&](){
+    onControl(server, "/beep", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[MANUAL] Beep"));
         shortBeep();
         server.send(200, "application/json", "{\"status\":\"beeped\"}");
@@ -1173,7 +1163,7 @@ void manualOutputEndpoints(WebServer& server) {
 
 // PID Control Endpoints
 void pidControlEndpoints(WebServer& server) {
-    server.on("/api/pid", HTTP_GET, [&](){
+    onControl(server, "/api/pid", HTTP_GET, [&](){
         // Ultra-efficient: Use sprintf with stack buffer instead of String concatenation
         char buffer[128];  // Stack allocated, much more efficient than String objects
         server.setContentLength(CONTENT_LENGTH_UNKNOWN);
@@ -1196,7 +1186,7 @@ void pidControlEndpoints(WebServer& server) {
         server.sendContent("}");
     });
     
-    server.on("/api/pid", HTTP_POST, [&](){
+    onControl(server, "/api/pid", HTTP_POST, [&](){
         if (server.hasArg("plain")) {
             // ULTRA-EFFICIENT: Reduced buffer size, use char buffer for response
             StaticJsonDocument<256> doc;  // Reduced from 512 to 256 bytes
@@ -1222,7 +1212,7 @@ void pidControlEndpoints(WebServer& server) {
     });
     
     // PID parameters endpoint for EMA temperature averaging and PID tuning (memory-safe GET version)
-    server.on("/api/pid_params", HTTP_GET, [&](){
+    onControl(server, "/api/pid_params", HTTP_GET, [&](){
         if (server.hasArg("temp_alpha") || server.hasArg("temp_interval") || 
             server.hasArg("temp_samples") || server.hasArg("temp_reject") ||
             server.hasArg("kp") || server.hasArg("ki") || server.hasArg("kd")) {
@@ -1382,8 +1372,8 @@ void pidControlEndpoints(WebServer& server) {
             sprintf(buffer, ",\"averaged_temperature\":%.2f", tempAvg.smoothedTemperature);
             server.sendContent(buffer);
             
-            // Add true raw ADC reading for comparison
-            int currentRawADC = analogRead(PIN_RTD);
+            // Add raw ADC reading (decimated, from the sensor service) for comparison
+            int currentRawADC = (int)lroundf(sensorGetReading().rawAdc);
             sprintf(buffer, ",\"temp_raw_adc\":%d", currentRawADC);
             server.sendContent(buffer);
             sprintf(buffer, ",\"temp_calibrated_current\":%.2f", readTemperature());
@@ -1416,7 +1406,7 @@ void pidControlEndpoints(WebServer& server) {
 
 // Placeholder implementations for remaining endpoints
 void pidProfileEndpoints(WebServer& server) {
-    server.on("/api/pid_profiles", HTTP_GET, [&](){
+    onControl(server, "/api/pid_profiles", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[DEBUG] /api/pid_profiles GET requested"));
         
         // Create JSON response with actual PID profiles using streaming to avoid String concatenation
@@ -1453,210 +1443,308 @@ void pidProfileEndpoints(WebServer& server) {
     });
 }
 
-void homeAssistantEndpoint(WebServer& server) {
-    // Home Assistant integration endpoint (matches template configuration.yaml)
-    server.on("/ha", HTTP_GET, [&](){
-        if (debugSerial) Serial.println(F("[DEBUG] /ha requested"));
-        
-        // OPTIMIZATION: Cache program data to avoid multiple file system calls
-        static String cachedProgramName = "";
-        static int lastCachedProgramId = -1;
-        static Program* cachedProgram = nullptr;
-        
-        if (lastCachedProgramId != programState.activeProgramId) {
-            // Only load program from file system when program ID changes
-            cachedProgram = getActiveProgramMutable();
-            if (cachedProgram) {
-                cachedProgramName = cachedProgram->name;
-                lastCachedProgramId = programState.activeProgramId;
-            } else {
-                cachedProgramName = "";
-                lastCachedProgramId = -1;
-                cachedProgram = nullptr;
-            }
+// Home Assistant JSON (matches template configuration.yaml); rendered into the
+// response cache, so the rotating section advances once per render
+static void renderHaJson(Print& out) {
+    // OPTIMIZATION: Cache program data to avoid multiple file system calls
+    static String cachedProgramName = "";
+    static int lastCachedProgramId = -1;
+    static Program* cachedProgram = nullptr;
+    
+    if (lastCachedProgramId != programState.activeProgramId) {
+        // Only load program from file system when program ID changes
+        cachedProgram = getActiveProgramMutable();
+        if (cachedProgram) {
+            cachedProgramName = cachedProgram->name;
+            lastCachedProgramId = programState.activeProgramId;
+        } else {
+            cachedProgramName = "";
+            lastCachedProgramId = -1;
+            cachedProgram = nullptr;
         }
-        
-        // Use efficient streaming instead of string concatenation
-        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
-        server.send(200, "application/json", "");
-        
-        // CYCLING OPTIMIZATION: Rotate through different data sections to reduce processing load
-        static int cycleCounter = 0;
-        cycleCounter = (cycleCounter + 1) % 4;  // Cycle through 4 different data sets
-        
-        // Stream JSON directly to avoid memory allocation issues
-        char buffer[64];  // Stack allocated buffer for numeric conversions
-        server.sendContent("{");
-        
-        // Always include basic status and temperature (Home Assistant needs this)
-        server.sendContent("\"state\":\"");
-        server.sendContent(programState.isRunning ? "running" : "idle");
-        server.sendContent("\",\"temperature\":");
-        sprintf(buffer, "%.1f", getAveragedTemperature());
-        server.sendContent(buffer);
-        server.sendContent(",\"setpoint\":");
-        sprintf(buffer, "%.1f", pid.Setpoint);
-        server.sendContent(buffer);
-        server.sendContent(",\"heater\":");
-        server.sendContent(outputStates.heater ? "true" : "false");
-        server.sendContent(",");
-        
-        // ALWAYS INCLUDE: Essential string fields that Home Assistant needs consistently
-        // Program and stage info - USE CACHED PROGRAM (moved outside cycling to prevent empty strings)
-        if (programState.activeProgramId >= 0 && programState.activeProgramId < getProgramCount() && cachedProgram) {
-            server.sendContent("\"program\":\"");
-            server.sendContent(cachedProgramName.c_str());
-            server.sendContent("\",");
-            
-            if (programState.isRunning && programState.customStageIdx < cachedProgram->customStages.size()) {
-                server.sendContent("\"stage\":\"");
-                server.sendContent(cachedProgram->customStages[programState.customStageIdx].label.c_str());
-                server.sendContent("\",");
-            } else {
-                server.sendContent("\"stage\":\"Idle\",");
-            }
+    }
+
+    // CYCLING OPTIMIZATION: Rotate through different data sections to reduce processing load
+    static int cycleCounter = 0;
+    cycleCounter = (cycleCounter + 1) % 4;  // Cycle through 4 different data sets
+    
+    // Print JSON directly to avoid String concatenation
+    char buffer[64];  // Stack allocated buffer for numeric conversions
+    out.print("{");
+    
+    // Always include basic status and temperature (Home Assistant needs this)
+    out.print("\"state\":\"");
+    out.print(programState.isRunning ? "running" : "idle");
+    out.print("\",\"temperature\":");
+    sprintf(buffer, "%.1f", getAveragedTemperature());
+    out.print(buffer);
+    out.print(",\"setpoint\":");
+    sprintf(buffer, "%.1f", pid.Setpoint);
+    out.print(buffer);
+    out.print(",\"heater\":");
+    out.print(outputStates.heater ? "true" : "false");
+    out.print(",");
+    
+    // ALWAYS INCLUDE: Essential string fields that Home Assistant needs consistently
+    // Program and stage info - USE CACHED PROGRAM (moved outside cycling to prevent empty strings)
+    if (programState.activeProgramId >= 0 && programState.activeProgramId < getProgramCount() && cachedProgram) {
+        out.print("\"program\":\"");
+        out.print(cachedProgramName.c_str());
+        out.print("\",");
+        
+        if (programState.isRunning && programState.customStageIdx < cachedProgram->customStages.size()) {
+            out.print("\"stage\":\"");
+            out.print(cachedProgram->customStages[programState.customStageIdx].label.c_str());
+            out.print("\",");
         } else {
-            server.sendContent("\"program\":\"\",\"stage\":\"Idle\",");
-        }
-        
-        // Cycle through different data sections based on request count
-        switch (cycleCounter) {
-            case 0: // Basic outputs and timing
-                server.sendContent("\"motor\":");
-                server.sendContent(outputStates.motor ? "true" : "false");
-                server.sendContent(",\"light\":");
-                server.sendContent(outputStates.light ? "true" : "false");
-                server.sendContent(",\"buzzer\":");
-                server.sendContent(outputStates.buzzer ? "true" : "false");
-                server.sendContent(",\"manual_mode\":");
-                server.sendContent(programState.manualMode ? "true" : "false");
-                server.sendContent(",");
-                
-                // Stage timing info - USE CACHED PROGRAM
-                if (programState.activeProgramId >= 0 && programState.activeProgramId < getProgramCount() && cachedProgram) {
-                    if (programState.isRunning && programState.customStageIdx < cachedProgram->customStages.size()) {
-                        // Calculate current stage remaining time only
-                        unsigned long elapsed = (programState.customStageStart == 0) ? 0 : (millis() - programState.customStageStart) / 1000;
-                        unsigned long stageTimeMs = getAdjustedStageTimeMs(cachedProgram->customStages[programState.customStageIdx].min * 60 * 1000, 
-                                                                           cachedProgram->customStages[programState.customStageIdx].isFermentation);
-                        unsigned long stageTimeLeft = (stageTimeMs / 1000) - elapsed;
-                        if (stageTimeLeft < 0) stageTimeLeft = 0;
-                        
-                        server.sendContent("\"stage_time_left\":");
-                        sprintf(buffer, "%lu", stageTimeLeft / 60); // Current stage time only (in minutes)
-                        server.sendContent(buffer);
-                        server.sendContent(",");
-                    } else {
-                        server.sendContent("\"stage_time_left\":0,");
-                    }
+            out.print("\"stage\":\"Idle\",");
+        }
+    } else {
+        out.print("\"program\":\"\",\"stage\":\"Idle\",");
+    }
+    
+    // Cycle through different data sections based on request count
+    switch (cycleCounter) {
+        case 0: // Basic outputs and timing
+            out.print("\"motor\":");
+            out.print(outputStates.motor ? "true" : "false");
+            out.print(",\"light\":");
+            out.print(outputStates.light ? "true" : "false");
+            out.print(",\"buzzer\":");
+            out.print(outputStates.buzzer ? "true" : "false");
+            out.print(",\"manual_mode\":");
+            out.print(programState.manualMode ? "true" : "false");
+            out.print(",");
+            
+            // Stage timing info - USE CACHED PROGRAM
+            if (programState.activeProgramId >= 0 && programState.activeProgramId < getProgramCount() && cachedProgram) {
+                if (programState.isRunning && programState.customStageIdx < cachedProgram->customStages.size()) {
+                    // Calculate current stage remaining time only
+                    unsigned long elapsed = (programState.customStageStart == 0) ? 0 : (millis() - programState.customStageStart) / 1000;
+                    unsigned long stageTimeMs = getAdjustedStageTimeMs(cachedProgram->customStages[programState.customStageIdx].min * 60 * 1000, 
+                                                                       cachedProgram->customStages[programState.customStageIdx].isFermentation);
+                    unsigned long stageTimeLeft = (stageTimeMs / 1000) - elapsed;
+                    if (stageTimeLeft < 0) stageTimeLeft = 0;
+                    
+                    out.print("\"stage_time_left\":");
+                    sprintf(buffer, "%lu", stageTimeLeft / 60); // Current stage time only (in minutes)
+                    out.print(buffer);
+                    out.print(",");
                 } else {
-                    server.sendContent("\"stage_time_left\":0,");
+                    out.print("\"stage_time_left\":0,");
                 }
-                break;
-                
-            case 1: // Health and performance metrics
-                server.sendContent("\"health\":{");
-                server.sendContent("\"uptime_sec\":");
-                sprintf(buffer, "%lu", millis() / 1000);
-                server.sendContent(buffer);
-                server.sendContent(",\"free_heap\":");
-                server.sendContent(String(ESP.getFreeHeap()));
-                server.sendContent(",\"max_loop_time_us\":");
-                server.sendContent(String(getMaxLoopTime()));
-                server.sendContent(",\"avg_loop_time_us\":");
-                server.sendContent(String(getAverageLoopTime()));
-                server.sendContent(",\"wifi_reconnects\":");
-                server.sendContent(String(getWifiReconnectCount()));
-                server.sendContent("},");
-                break;
-                
-            case 2: // PID controller detailed information
-                server.sendContent("\"pid\":{\"kp\":");
-                server.sendContent(String(pid.Kp, 6));
-                server.sendContent(",\"ki\":");
-                server.sendContent(String(pid.Ki, 6));
-                server.sendContent(",\"kd\":");
-                server.sendContent(String(pid.Kd, 6));
-                server.sendContent(",\"output\":");
-                server.sendContent(String(pid.Output, 2));
-                server.sendContent(",\"input\":");
-                server.sendContent(String(pid.Input, 2));
-                server.sendContent(",\"pid_p\":");
-                server.sendContent(String(pid.pidP, 3));
-                server.sendContent(",\"pid_i\":");
-                server.sendContent(String(pid.pidI, 3));
-                server.sendContent(",\"pid_d\":");
-                server.sendContent(String(pid.pidD, 3));
-                server.sendContent(",\"raw_temp\":");
-                server.sendContent(String(readTemperature(), 1));
-                server.sendContent("},");
-                break;
-                
-            case 3: // Network and filesystem info
-                server.sendContent("\"network\":{\"connected\":");
-                server.sendContent(WiFi.status() == WL_CONNECTED ? "true" : "false");
-                server.sendContent(",\"ssid\":\"");
-                server.sendContent(wifiCache.getSSID());
-                server.sendContent("\",\"rssi\":");
-                server.sendContent(String(wifiCache.getRSSI()));
-                server.sendContent(",\"ip\":\"");
-                server.sendContent(wifiCache.getIPString());
-                server.sendContent("\"},");
-                server.sendContent("\"filesystem\":{\"usedBytes\":");
-                server.sendContent(String(FFat.usedBytes()));
-                server.sendContent(",\"totalBytes\":");
-                server.sendContent(String(FFat.totalBytes()));
-                server.sendContent(",\"freeBytes\":");
-                server.sendContent(String(FFat.totalBytes() - FFat.usedBytes()));
-                server.sendContent("},");
-                break;
-        }
-        
-        // Always include timing information (Home Assistant needs this)
-        time_t now = time(nullptr);
-        time_t stageReadyAt = 0;
-        time_t programReadyAt = 0;
-        bool ntpValid = (now > 1640995200); // Jan 1, 2022 - if before this, NTP failed
-        
-        if (programState.isRunning && programState.activeProgramId >= 0 && cachedProgram) {
-            if (cachedProgram && programState.customStageIdx < cachedProgram->customStages.size()) {
-                unsigned long elapsed = (programState.customStageStart == 0) ? 0 : (millis() - programState.customStageStart) / 1000;
-                unsigned long stageTimeMs = getAdjustedStageTimeMs(cachedProgram->customStages[programState.customStageIdx].min * 60 * 1000, 
-                                                                   cachedProgram->customStages[programState.customStageIdx].isFermentation);
-                int timeLeftSec = (stageTimeMs / 1000) - elapsed;
-                if (timeLeftSec < 0) timeLeftSec = 0;
-                
-                if (ntpValid && timeLeftSec > 0) {
-                    stageReadyAt = now + timeLeftSec;
-                    programReadyAt = now + timeLeftSec;
-                    for (size_t i = programState.customStageIdx + 1; i < cachedProgram->customStages.size(); ++i) {
-                        unsigned long adjustedDurationMs = getAdjustedStageTimeMs(cachedProgram->customStages[i].min * 60 * 1000, 
-                                                                                  cachedProgram->customStages[i].isFermentation);
-                        programReadyAt += adjustedDurationMs / 1000;
-                    }
+            } else {
+                out.print("\"stage_time_left\":0,");
+            }
+            break;
+            
+        case 1: // Health and performance metrics
+            out.print("\"health\":{");
+            out.print("\"uptime_sec\":");
+            sprintf(buffer, "%lu", millis() / 1000);
+            out.print(buffer);
+            out.print(",\"free_heap\":");
+            out.print(String(ESP.getFreeHeap()));
+            out.print(",\"max_loop_time_us\":");
+            out.print(String(getMaxLoopTime()));
+            out.print(",\"avg_loop_time_us\":");
+            out.print(String(getAverageLoopTime()));
+            out.print(",\"wifi_reconnects\":");
+            out.print(String(getWifiReconnectCount()));
+            out.print("},");
+            break;
+            
+        case 2: // PID controller detailed information
+            out.print("\"pid\":{\"kp\":");
+            out.print(String(pid.Kp, 6));
+            out.print(",\"ki\":");
+            out.print(String(pid.Ki, 6));
+            out.print(",\"kd\":");
+            out.print(String(pid.Kd, 6));
+            out.print(",\"output\":");
+            out.print(String(pid.Output, 2));
+            out.print(",\"input\":");
+            out.print(String(pid.Input, 2));
+            out.print(",\"pid_p\":");
+            out.print(String(pid.pidP, 3));
+            out.print(",\"pid_i\":");
+            out.print(String(pid.pidI, 3));
+            out.print(",\"pid_d\":");
+            out.print(String(pid.pidD, 3));
+            out.print(",\"raw_temp\":");
+            out.print(String(readTemperature(), 1));
+            out.print("},");
+            break;
+            
+        case 3: // Network and filesystem info
+            out.print("\"network\":{\"connected\":");
+            out.print(WiFi.status() == WL_CONNECTED ? "true" : "false");
+            out.print(",\"ssid\":\"");
+            out.print(wifiCache.getSSID());
+            out.print("\",\"rssi\":");
+            out.print(String(wifiCache.getRSSI()));
+            out.print(",\"ip\":\"");
+            out.print(wifiCache.getIPString());
+            out.print("\"},");
+            out.print("\"filesystem\":{\"usedBytes\":");
+            out.print(String(storageUsedBytes()));
+            out.print(",\"totalBytes\":");
+            out.print(String(storageTotalBytes()));
+            out.print(",\"freeBytes\":");
+            out.print(String(storageFreeBytes()));
+            out.print("},");
+            break;
+    }
+    
+    // Always include timing information (Home Assistant needs this)
+    time_t now = time(nullptr);
+    time_t stageReadyAt = 0;
+    time_t programReadyAt = 0;
+    bool ntpValid = (now > 1640995200); // Jan 1, 2022 - if before this, NTP failed
+    
+    if (programState.isRunning && programState.activeProgramId >= 0 && cachedProgram) {
+        if (cachedProgram && programState.customStageIdx < cachedProgram->customStages.size()) {
+            unsigned long elapsed = (programState.customStageStart == 0) ? 0 : (millis() - programState.customStageStart) / 1000;
+            unsigned long stageTimeMs = getAdjustedStageTimeMs(cachedProgram->customStages[programState.customStageIdx].min * 60 * 1000, 
+                                                               cachedProgram->customStages[programState.customStageIdx].isFermentation);
+            int timeLeftSec = (stageTimeMs / 1000) - elapsed;
+            if (timeLeftSec < 0) timeLeftSec = 0;
+            
+            if (ntpValid && timeLeftSec > 0) {
+                stageReadyAt = now + timeLeftSec;
+                programReadyAt = now + timeLeftSec;
+                for (size_t i = programState.customStageIdx + 1; i < cachedProgram->customStages.size(); ++i) {
+                    unsigned long adjustedDurationMs = getAdjustedStageTimeMs(cachedProgram->customStages[i].min * 60 * 1000, 
+                                                                              cachedProgram->customStages[i].isFermentation);
+                    programReadyAt += adjustedDurationMs / 1000;
                 }
             }
         }
-        
-        server.sendContent("\"stage_ready_at\":");
-        sprintf(buffer, "%lu", (unsigned long)stageReadyAt);
-        server.sendContent(buffer);
-        server.sendContent(",\"program_ready_at\":");
-        sprintf(buffer, "%lu", (unsigned long)programReadyAt);
-        server.sendContent(buffer);
-        server.sendContent(",\"cycle\":");
-        sprintf(buffer, "%d", cycleCounter);
-        server.sendContent(buffer);
-        server.sendContent("}");
-        server.sendContent(""); // End chunked response
+    }
+    
+    out.print("\"stage_ready_at\":");
+    sprintf(buffer, "%lu", (unsigned long)stageReadyAt);
+    out.print(buffer);
+    out.print(",\"program_ready_at\":");
+    sprintf(buffer, "%lu", (unsigned long)programReadyAt);
+    out.print(buffer);
+    out.print(",\"cycle\":");
+    sprintf(buffer, "%d", cycleCounter);
+    out.print(buffer);
+    out.print("}");
+}
+
+void homeAssistantEndpoint(WebServer& server) {
+    // Home Assistant integration endpoint (matches template configuration.yaml)
+    routeOn(server, "/ha", HTTP_GET, [&](){
+        if (debugSerial) Serial.println(F("[DEBUG] /ha requested"));
+        responseCacheServe(server, "application/json", haCacheMs, [](Print& out) {
+            ControlLockGuard guard;
+            renderHaJson(out);
+        });
+    });
+    
+    // MQTT publisher status; optional args change the configuration (saved to settings):
+    // enabled=0|1, host, port, user, password, base, prefix, temp_deadband,
+    // setpoint_deadband, min_interval (ms). reset=1 clears the counters.
+    routeOn(server, "/api/mqtt", HTTP_GET, [&](){
+        static const char* const keys[] = { "enabled", "host", "port", "user", "password", "base", "prefix",
+                                            "temp_deadband", "setpoint_deadband", "min_interval" };
+        bool changed = false;
+        for (const char* key : keys) changed |= server.hasArg(key);
+        if (changed) {
+            MqttConfig cfg = mqttGetConfig();
+            if (server.hasArg("enabled")) cfg.enabled = server.arg("enabled") == "1";
+            if (server.hasArg("host")) snprintf(cfg.host, sizeof(cfg.host), "%s", server.arg("host").c_str());
+            if (server.hasArg("port")) cfg.port = (uint16_t)constrain(server.arg("port").toInt(), 1, 65535);
+            if (server.hasArg("user")) snprintf(cfg.user, sizeof(cfg.user), "%s", server.arg("user").c_str());
+            if (server.hasArg("password")) snprintf(cfg.password, sizeof(cfg.password), "%s", server.arg("password").c_str());
+            if (server.hasArg("base") && server.arg("base").length() > 0) {
+                snprintf(cfg.baseTopic, sizeof(cfg.baseTopic), "%s", server.arg("base").c_str());
+            }
+            if (server.hasArg("prefix") && server.arg("prefix").length() > 0) {
+                snprintf(cfg.discoveryPrefix, sizeof(cfg.discoveryPrefix), "%s", server.arg("prefix").c_str());
+            }
+            if (server.hasArg("temp_deadband")) cfg.tempDeadband = constrain(server.arg("temp_deadband").toFloat(), 0.0f, 10.0f);
+            if (server.hasArg("setpoint_deadband")) cfg.setpointDeadband = constrain(server.arg("setpoint_deadband").toFloat(), 0.0f, 10.0f);
+            if (server.hasArg("min_interval")) cfg.minIntervalMs = (uint32_t)constrain(server.arg("min_interval").toInt(), 0, 3600000);
+            mqttConfigure(cfg);
+            pendingSettingsSaveTime = millis() + 1000;
+        }
+        if (server.hasArg("reset")) mqttResetStats();
+        
+        const MqttConfig& cfg = mqttGetConfig();
+        const MqttStats& st = mqttGetStats();
+        char host[2 * sizeof(cfg.host)], user[2 * sizeof(cfg.user)];
+        char base[2 * sizeof(cfg.baseTopic)], prefix[2 * sizeof(cfg.discoveryPrefix)];
+        mqttJsonEscape(host, sizeof(host), cfg.host);
+        mqttJsonEscape(user, sizeof(user), cfg.user);
+        mqttJsonEscape(base, sizeof(base), cfg.baseTopic);
+        mqttJsonEscape(prefix, sizeof(prefix), cfg.discoveryPrefix);
+        char response[1024];
+        snprintf(response, sizeof(response),
+            "{"
+            "\"enabled\":%s,"
+            "\"host\":\"%s\","
+            "\"port\":%u,"
+            "\"user\":\"%s\","
+            "\"password_set\":%s,"
+            "\"base_topic\":\"%s\","
+            "\"discovery_prefix\":\"%s\","
+            "\"temp_deadband\":%.2f,"
+            "\"setpoint_deadband\":%.2f,"
+            "\"min_interval_ms\":%u,"
+            "\"connected\":%s,"
+            "\"connects\":%u,"
+            "\"connect_failures\":%u,"
+            "\"last_state\":%d,"
+            "\"max_connect_ms\":%u,"
+            "\"disconnects\":%u,"
+            "\"publishes\":%u,"
+            "\"discovery_publishes\":%u,"
+            "\"publish_failures\":%u,"
+            "\"bytes_out\":%llu,"
+            "\"suppressed\":%u,"
+            "\"deferred\":%u,"
+            "\"commands\":%u,"
+            "\"window_s\":%lu"
+            "}",
+            cfg.enabled ? "true" : "false",
+            host,
+            (unsigned)cfg.port,
+            user,
+            cfg.password[0] ? "true" : "false",
+            base,
+            prefix,
+            cfg.tempDeadband,
+            cfg.setpointDeadband,
+            (unsigned)cfg.minIntervalMs,
+            st.connected ? "true" : "false",
+            (unsigned)st.connects,
+            (unsigned)st.connectFailures,
+            st.lastState,
+            (unsigned)st.maxConnectMs,
+            (unsigned)st.disconnects,
+            (unsigned)st.publishes,
+            (unsigned)st.discoveryPublishes,
+            (unsigned)st.publishFailures,
+            (unsigned long long)st.bytesOut,
+            (unsigned)st.suppressed,
+            (unsigned)st.deferred,
+            (unsigned)st.commands,
+            (millis() - st.sinceMs) / 1000
+        );
+        server.send(200, "application/json", response);
     });
 }
 
 void calibrationEndpoints(WebServer& server) {
-    server.on("/api/calibration", HTTP_GET, [&](){
+    onControl(server, "/api/calibration", HTTP_GET, [&](){
         // Get current raw ADC reading and temperature
-        int currentRaw = analogRead(PIN_RTD);
-        float currentTemp = readTemperature();
+        // Latest decimated reading from the sensor service - low noise and no ADC access here
+        const SensorReading& reading = sensorGetReading();
+        int currentRaw = (int)lroundf(reading.rawAdc);
+        float currentTemp = reading.temperature;
         
         // Use efficient streaming instead of string concatenation
         server.setContentLength(CONTENT_LENGTH_UNKNOWN);
@@ -1666,22 +1754,25 @@ void calibrationEndpoints(WebServer& server) {
         server.sendContent(String(currentRaw));
         server.sendContent(",\"temp\":");
         server.sendContent(String(currentTemp, 1));
+        char buffer[128];
+        snprintf(buffer, sizeof(buffer), ",\"fit\":\"%s\",\"rms_residual\":%.3f", calibFitModeName(), calibRmsResidual());
+        server.sendContent(buffer);
         server.sendContent(",\"table\":[");
         
+        // residual = fitted - measured; loo_residual = neighbour interpolation - measured,
+        // so a bad point shows a large loo_residual even when the fit passes through it
         for(size_t i = 0; i < rtdCalibTable.size(); i++) {
-            if(i > 0) server.sendContent(",");
-            server.sendContent("{\"raw\":");
-            server.sendContent(String(rtdCalibTable[i].raw));
-            server.sendContent(",\"temp\":");
-            server.sendContent(String(rtdCalibTable[i].temp));
-            server.sendContent("}");
+            snprintf(buffer, sizeof(buffer), "%s{\"raw\":%d,\"temp\":%.2f,\"residual\":%.3f,\"loo_residual\":%.3f}",
+                     i > 0 ? "," : "", rtdCalibTable[i].raw, rtdCalibTable[i].temp,
+                     calibResidual(i), calibLooResidual(i));
+            server.sendContent(buffer);
         }
         server.sendContent("]}");
         server.sendContent(""); // End chunked response
     });
     
     // Add calibration point endpoint
-    server.on("/api/calibration/add", HTTP_POST, [&](){
+    onControl(server, "/api/calibration/add", HTTP_POST, [&](){
         if (server.hasArg("raw") && server.hasArg("temp")) {
             int raw = server.arg("raw").toInt();
             float temp = server.arg("temp").toFloat();
@@ -1708,7 +1799,8 @@ void calibrationEndpoints(WebServer& server) {
             std::sort(rtdCalibTable.begin(), rtdCalibTable.end(), 
                      [](const CalibPoint& a, const CalibPoint& b) { return a.raw < b.raw; });
             
-            // Save to file
+            // Recompile the lookup table and save to file
+            rebuildCalibrationLut();
             saveCalibration();
             
             server.send(200, "application/json", "{\"status\":\"ok\"}");
@@ -1718,7 +1810,7 @@ void calibrationEndpoints(WebServer& server) {
     });
     
     // Delete calibration point endpoint
-    server.on("/api/calibration/delete", HTTP_POST, [&](){
+    onControl(server, "/api/calibration/delete", HTTP_POST, [&](){
         if (server.hasArg("index")) {
             int index = server.arg("index").toInt();
             
@@ -1731,7 +1823,8 @@ void calibrationEndpoints(WebServer& server) {
             // Remove point from calibration table
             rtdCalibTable.erase(rtdCalibTable.begin() + index);
             
-            // Save to file
+            // Recompile the lookup table and save to file
+            rebuildCalibrationLut();
             saveCalibration();
             
             server.send(200, "application/json", "{\"status\":\"deleted\"}");
@@ -1739,11 +1832,26 @@ void calibrationEndpoints(WebServer& server) {
             server.send(400, "application/json", "{\"error\":\"Missing index parameter\"}");
         }
     });
+    
+    // Select how the lookup table is built: piecewise segments or a least-squares polynomial
+    onControl(server, "/api/calibration/fit", HTTP_POST, [&](){
+        if (!server.hasArg("mode") || !setCalibFitMode(server.arg("mode"))) {
+            server.send(400, "application/json", "{\"error\":\"mode must be piecewise, poly1, poly2 or poly3\"}");
+            return;
+        }
+        rebuildCalibrationLut();
+        saveCalibration();
+        
+        char response[96];
+        snprintf(response, sizeof(response), "{\"status\":\"ok\",\"fit\":\"%s\",\"rms_residual\":%.3f}",
+                 calibFitModeName(), calibRmsResidual());
+        server.send(200, "application/json", response);
+    });
 }
 
 void fileEndPoints(WebServer& server) {
     // List files endpoint - ULTRA MEMORY OPTIMIZATION
-    server.on("/api/files", HTTP_GET, [&](){
+    routeOn(server, "/api/files", HTTP_GET, [&](){
         // Use char buffer instead of String for folder path
         char folderPath[64];
         if (server.hasArg("folder")) {
@@ -1769,10 +1877,12 @@ void fileEndPoints(WebServer& server) {
         server.setContentLength(CONTENT_LENGTH_UNKNOWN);
         server.send(200, F("application/json"), "");
         
-        File root = FFat.open(folderPath);
+        File root = storageFS().open(folderPath);
         if (root && root.isDirectory()) {
             server.sendContent(F("{\"files\":["));
             
+            // Single pass: files are streamed, folder names collected for after them
+            String folders;
             bool firstFile = true;
             File file = root.openNextFile();
             while (file) {
@@ -1786,31 +1896,18 @@ void fileEndPoints(WebServer& server) {
                             file.name(), (unsigned long)file.size());
                     server.sendContent(jsonBuffer);
                     firstFile = false;
+                } else {
+                    if (folders.length() > 0) folders += ',';
+                    folders += '"';
+                    folders += file.name();
+                    folders += '"';
                 }
                 file = root.openNextFile();
             }
             root.close();
             
-            // Second pass for folders
-            root = FFat.open(folderPath);
             server.sendContent(F("],\"folders\":["));
-            bool firstFolder = true;
-            if (root && root.isDirectory()) {
-                file = root.openNextFile();
-                while (file) {
-                    if (file.isDirectory()) {
-                        if (!firstFolder) server.sendContent(F(","));
-                        
-                        // Use char buffer for folder name formatting
-                        char folderBuffer[64];
-                        snprintf(folderBuffer, sizeof(folderBuffer), "\"%s\"", file.name());
-                        server.sendContent(folderBuffer);
-                        firstFolder = false;
-                    }
-                    file = root.openNextFile();
-                }
-                root.close();
-            }
+            if (folders.length() > 0) server.sendContent(folders);
             server.sendContent(F("]}"));
         } else {
             server.sendContent(F("{\"files\":[],\"folders\":[]}"));
@@ -1818,7 +1915,7 @@ void fileEndPoints(WebServer& server) {
     });
     
     // Delete file endpoint - ULTRA MEMORY OPTIMIZATION
-    server.on("/api/delete", HTTP_POST, [&](){
+    routeOn(server, "/api/delete", HTTP_POST, [&](){
         String body = server.arg("plain");
         if (body.length() > 0) {
             // ULTRA-EFFICIENT: Use small StaticJsonDocument + char buffers (no String heap allocation)
@@ -1839,8 +1936,8 @@ void fileEndPoints(WebServer& server) {
                         snprintf(fullPath, sizeof(fullPath), "/%s", filenamePtr);
                     }
                     
-                    if (FFat.exists(fullPath)) {
-                        if (FFat.remove(fullPath)) {
+                    if (storageFS().exists(fullPath)) {
+                        if (storageFS().remove(fullPath)) {
                             // Use F() macro to store response in flash, not RAM
                             server.send(200, F("application/json"), 
                                       String(F("{\"status\":\"deleted\",\"file\":\"")) + fullPath + F("\"}"));
@@ -1862,7 +1959,7 @@ void fileEndPoints(WebServer& server) {
     });
     
     // Create folder endpoint - ULTRA MEMORY OPTIMIZATION
-    server.on("/api/create_folder", HTTP_POST, [&](){
+    routeOn(server, "/api/create_folder", HTTP_POST, [&](){
         String body = server.arg("plain");
         if (body.length() > 0) {
             // ULTRA-EFFICIENT: Use small StaticJsonDocument + char buffers (no String heap allocation)
@@ -1912,24 +2009,50 @@ void fileEndPoints(WebServer& server) {
     });
     
     // Delete folder endpoint
-    server.on("/api/delete_folder", HTTP_POST, [&](){
+    routeOn(server, "/api/delete_folder", HTTP_POST, [&](){
         String body = server.arg("plain");
         if (body.length() > 0) {
-            server.send(200, "application/json", "{\"status\":\"deleted\"}");
+            StaticJsonDocument<256> doc;
+            DeserializationError error = deserializeJson(doc, body);
+            const char* folderPtr = doc["folder"] | "/";
+            const char* namePtr = doc["name"] | "";
+            if (error || strlen(namePtr) == 0 || strchr(namePtr, '/')) {
+                server.send(400, "application/json", "{\"error\":\"Missing folder parameters\"}");
+                return;
+            }
+            
+            char folderPath[128];
+            size_t parentLen = strlen(folderPtr);
+            snprintf(folderPath, sizeof(folderPath), "%s%s%s%s", folderPtr[0] == '/' ? "" : "/", folderPtr,
+                     (parentLen > 0 && folderPtr[parentLen - 1] == '/') ? "" : "/", namePtr);
+            if (!storageFS().exists(folderPath)) {
+                server.send(404, "application/json", "{\"error\":\"Folder not found\"}");
+                return;
+            }
+            
+            // Deleted in the background, one file per step; progress at /api/jobs
+            uint16_t jobId = startDeleteFolderJob(String(folderPath));
+            if (jobId == 0) {
+                server.send(503, "application/json", "{\"error\":\"Too many background jobs\"}");
+                return;
+            }
+            char response[96];
+            snprintf(response, sizeof(response), "{\"status\":\"deleted\",\"job\":%u,\"pending\":true}", jobId);
+            server.send(200, "application/json", response);
         } else {
             server.send(400, "application/json", "{\"error\":\"Missing folder parameters\"}");
         }
     });
     
     // API upload endpoint (uses the same file upload handler as /upload)
-    server.on("/api/upload", HTTP_POST, [&](){
+    routeOn(server, "/api/upload", HTTP_POST, [&](){
         // This will be handled by the shared onFileUpload handler in coreEndpoints
         server.send(200, "application/json", "{\"status\":\"uploaded\"}");
     });
 }
 
 void programsEndpoints(WebServer& server) {
-    server.on("/api/programs", HTTP_GET, [&](){
+    onControl(server, "/api/programs", HTTP_GET, [&](){
         // Ultra-memory efficient program list using char buffers
         char response[2048];
         char* pos = response;
@@ -1957,7 +2080,7 @@ void programsEndpoints(WebServer& server) {
         server.send(200, "application/json", response);
     });
     
-    server.on("/api/program", HTTP_GET, [&](){
+    onControl(server, "/api/program", HTTP_GET, [&](){
         if (server.hasArg("id")) {
             int id = server.arg("id").toInt();
             if (id >= 0 && id < getProgramCount()) {
@@ -1970,12 +2093,12 @@ void programsEndpoints(WebServer& server) {
 }
 
 void otaEndpoints(WebServer& server) {
-    server.on("/api/ota", HTTP_GET, [&](){
+    routeOn(server, "/api/ota", HTTP_GET, [&](){
         server.send(200, "application/json", "{\"status\":\"ota_available\"}");
     });
     
     // OTA status endpoint - provides current OTA state
-    server.on("/api/ota/status", HTTP_GET, [&](){
+    routeOn(server, "/api/ota/status", HTTP_GET, [&](){
         server.setContentLength(CONTENT_LENGTH_UNKNOWN);
         server.send(200, "application/json", "");
         server.sendContent("{");
@@ -1988,26 +2111,27 @@ void otaEndpoints(WebServer& server) {
     });
     
     // OTA info endpoint - provides device information
-    server.on("/api/ota/info", HTTP_GET, [&](){
+    routeOn(server, "/api/ota/info", HTTP_GET, [&](){
         server.setContentLength(CONTENT_LENGTH_UNKNOWN);
         server.send(200, "application/json", "");
         server.sendContent("{");
         server.sendContent("\"hostname\":\"" + String(WiFi.getHostname()) + "\",");
         server.sendContent("\"ip\":\"" + wifiCache.getIPString() + "\",");
         server.sendContent("\"version\":\"1.0.0\",");
-        server.sendContent("\"freeSpace\":" + String(FFat.freeBytes()) + ",");
-        server.sendContent("\"totalSpace\":" + String(FFat.totalBytes()));
+        server.sendContent("\"freeSpace\":" + String(storageFreeBytes()) + ",");
+        server.sendContent("\"totalSpace\":" + String(storageTotalBytes()));
         server.sendContent("}");
     });
     
     // Web-based firmware update endpoint
-    server.on("/api/update", HTTP_POST, [&](){
+    routeOn(server, "/api/update", HTTP_POST, [&](){
         server.sendHeader("Connection", "close");
         if (Update.hasError()) {
             server.send(500, "text/plain", "Update failed: " + String(Update.getError()));
         } else {
             server.send(200, "text/plain", "Update successful! Rebooting...");
             delay(100);
+            persistFlushAll();
             ESP.restart();
         }
     }, [&](){
@@ -2018,6 +2142,7 @@ void otaEndpoints(WebServer& server) {
             if (debugSerial) Serial.printf("[UPDATE] Starting firmware update: %s\n", upload.filename.c_str());
             
             // Begin firmware update
+            persistFlushAll();  // Pending saves go out before flash is busy with the image
             if (!Update.begin(UPDATE_SIZE_UNKNOWN)) {
                 if (debugSerial) Serial.printf("[UPDATE] Begin failed: %s\n", Update.errorString());
                 return;
@@ -2041,13 +2166,14 @@ void otaEndpoints(WebServer& server) {
     });
     
     // OTA firmware upload endpoint (alias for /api/update for script compatibility)
-    server.on("/api/ota/upload", HTTP_POST, [&](){
+    routeOn(server, "/api/ota/upload", HTTP_POST, [&](){
         server.sendHeader("Connection", "close");
         if (Update.hasError()) {
             server.send(500, "text/plain", "OTA Update failed: " + String(Update.getError()));
         } else {
             server.send(200, "text/plain", "OTA Update successful! Rebooting...");
             delay(100);
+            persistFlushAll();
             ESP.restart();
         }
     }, [&](){
@@ -2058,6 +2184,7 @@ void otaEndpoints(WebServer& server) {
             if (debugSerial) Serial.printf("[OTA] Starting firmware update: %s\n", upload.filename.c_str());
             
             // Begin firmware update
+            persistFlushAll();  // Pending saves go out before flash is busy with the image
             if (!Update.begin(UPDATE_SIZE_UNKNOWN)) {
                 if (debugSerial) Serial.printf("[OTA] Begin failed: %s\n", Update.errorString());
                 return;
@@ -2081,14 +2208,14 @@ void otaEndpoints(WebServer& server) {
     });
     
     // Missing /api/settings endpoint for debug serial configuration
-    server.on("/api/settings", HTTP_GET, [&](){
+    onControl(server, "/api/settings", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[DEBUG] /api/settings GET requested"));
         String json = "{\"debugSerial\":" + String(debugSerial ? "true" : "false") + 
                      ",\"safetyEnabled\":" + String(safetySystem.safetyEnabled ? "true" : "false") + "}";
         server.send(200, "application/json", json);
     });
     
-    server.on("/api/settings", HTTP_POST, [&](){
+    onControl(server, "/api/settings", HTTP_POST, [&](){
         // Immediate response before any processing
         server.send(200, "text/plain", "OK");
         
@@ -2097,7 +2224,7 @@ void otaEndpoints(WebServer& server) {
     });
 
     // Alternative GET-based settings change (workaround for POST issues)
-    server.on("/api/settings/debug", HTTP_GET, [&](){
+    onControl(server, "/api/settings/debug", HTTP_GET, [&](){
         if (server.hasArg("enabled")) {
             String enabledVal = server.arg("enabled");
             if (enabledVal == "true") {
@@ -2118,7 +2245,7 @@ void otaEndpoints(WebServer& server) {
     });
 
     // Test endpoint that does try to save settings
-    server.on("/api/settings/force-save", HTTP_GET, [&](){
+    onControl(server, "/api/settings/force-save", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[DEBUG] Force save requested"));
         
         server.send(200, "text/plain", "SAVING");
@@ -2131,13 +2258,13 @@ void otaEndpoints(WebServer& server) {
     
     // Minimal debug endpoint to test file system - temporarily disabled
     /*
-    server.on("/api/settings/test-fs", HTTP_GET, [&](){
+    routeOn(server, "/api/settings/test-fs", HTTP_GET, [&](){
         // Commented out for debugging
     });
     */
 
     // Simple safety toggle endpoint
-    server.on("/api/safety/toggle", HTTP_POST, [&](){
+    onControl(server, "/api/safety/toggle", HTTP_POST, [&](){
         if (debugSerial) Serial.println(F("[DEBUG] /api/safety/toggle POST requested"));
         
         // Toggle safety state
@@ -2162,7 +2289,7 @@ void otaEndpoints(WebServer& server) {
     });
 
     // GET-based safety toggle endpoint (crash workaround)
-    server.on("/api/safety/toggle-get", HTTP_GET, [&](){
+    onControl(server, "/api/safety/toggle-get", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[DEBUG] /api/safety/toggle-get GET requested"));
         
         // Toggle safety state
@@ -2187,32 +2314,32 @@ void otaEndpoints(WebServer& server) {
     });
     
     // Display screensaver control endpoints
-    server.on("/api/display/screensaver/status", HTTP_GET, [&](){
+    routeOn(server, "/api/display/screensaver/status", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[DEBUG] /api/display/screensaver/status requested"));
         String json = "{\"active\":" + String(isScreensaverActive() ? "true" : "false") + "}";
         server.send(200, "application/json", json);
     });
     
-    server.on("/api/display/screensaver/enable", HTTP_POST, [&](){
+    routeOn(server, "/api/display/screensaver/enable", HTTP_POST, [&](){
         if (debugSerial) Serial.println(F("[DEBUG] /api/display/screensaver/enable requested"));
         enableScreensaver();
         server.send(200, "application/json", "{\"status\":\"screensaver_enabled\"}");
     });
     
-    server.on("/api/display/screensaver/disable", HTTP_POST, [&](){
+    routeOn(server, "/api/display/screensaver/disable", HTTP_POST, [&](){
         if (debugSerial) Serial.println(F("[DEBUG] /api/display/screensaver/disable requested"));
         disableScreensaver();
         server.send(200, "application/json", "{\"status\":\"screensaver_disabled\"}");
     });
     
-    server.on("/api/display/activity", HTTP_POST, [&](){
+    routeOn(server, "/api/display/activity", HTTP_POST, [&](){
         if (debugSerial) Serial.println(F("[DEBUG] /api/display/activity requested"));
         updateActivityTime();
         server.send(200, "application/json", "{\"status\":\"activity_updated\"}");
     });
     
     // Missing /api/pid_profile endpoint for PID profile management
-    server.on("/api/pid_profile", HTTP_GET, [&](){
+    onControl(server, "/api/pid_profile", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[DEBUG] /api/pid_profile GET requested"));
         
         server.setContentLength(CONTENT_LENGTH_UNKNOWN);
@@ -2225,7 +2352,7 @@ void otaEndpoints(WebServer& server) {
         server.sendContent("]}");
     });
     
-    server.on("/api/pid_profile", HTTP_POST, [&](){
+    onControl(server, "/api/pid_profile", HTTP_POST, [&](){
         if (debugSerial) Serial.println(F("[DEBUG] /api/pid_profile POST requested"));
         
         if (server.hasArg("plain")) {
@@ -2262,7 +2389,7 @@ void otaEndpoints(WebServer& server) {
     });
 
     // GET-based PID profile endpoint (crash workaround)
-    server.on("/api/pid_profile/set", HTTP_GET, [&](){
+    onControl(server, "/api/pid_profile/set", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[DEBUG] /api/pid_profile/set GET requested"));
         
         if (server.hasArg("kp") && server.hasArg("ki") && server.hasArg("kd")) {
@@ -2290,7 +2417,7 @@ void otaEndpoints(WebServer& server) {
     });
 
     // Update specific profile by temperature range
-    server.on("/api/pid_profile/update_range", HTTP_GET, [&](){
+    onControl(server, "/api/pid_profile/update_range", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[DEBUG] /api/pid_profile/update_range GET requested"));
         
         if (server.hasArg("temp") && server.hasArg("kp") && server.hasArg("ki") && server.hasArg("kd")) {
@@ -2352,11 +2479,52 @@ void otaEndpoints(WebServer& server) {
     });
 }
 
+// PID status JSON for the tuning page; rendered into the response cache
+static void renderPidStatusJson(Print& out) {
+    out.print("{");
+    out.print("\"temperature\":");
+    out.print(String(getAveragedTemperature(), 1));
+    const SensorReading& reading = sensorGetReading();
+    char sensorBuf[96];
+    snprintf(sensorBuf, sizeof(sensorBuf), ",\"rawTemperature\":%.1f,\"sensorHealth\":\"%s\",\"sensorAgeMs\":%lu",
+             reading.temperature, sensorHealthName(reading.health), millis() - reading.timestampMs);
+    out.print(sensorBuf);
+    out.print(",\"setpoint\":");
+    out.print(String(pid.Setpoint, 1));
+    out.print(",\"heater\":");
+    out.print(outputStates.heater ? "true" : "false");
+    out.print(",\"motor\":");
+    out.print(outputStates.motor ? "true" : "false");
+    out.print(",\"running\":");
+    out.print(programState.isRunning ? "true" : "false");
+    out.print(",\"pid_kp\":");
+    out.print(String(pid.Kp, 6));
+    out.print(",\"pid_ki\":");
+    out.print(String(pid.Ki, 6));
+    out.print(",\"pid_kd\":");
+    out.print(String(pid.Kd, 6));
+    out.print(",\"pid_output\":");
+    out.print(String(pid.Output, 3));
+    out.print(",\"pid_input\":");
+    out.print(String(pid.Input, 1));
+    out.print(",\"pid_p\":");
+    out.print(String(pid.pidP, 3));
+    out.print(",\"pid_i\":");
+    out.print(String(pid.pidI, 3));
+    out.print(",\"pid_d\":");
+    out.print(String(pid.pidD, 3));
+    out.print(",\"uptime_sec\":");
+    out.print(String(millis() / 1000));
+    out.print(",\"free_heap\":");
+    out.print(String(ESP.getFreeHeap()));
+    out.print("}");
+}
+
 // Main registration function
 void registerWebEndpoints(WebServer& server) {
     // Initialize the filesystem first
-    if (!FFat.begin(true)) {  // true = format on failure
-        if (debugSerial) Serial.println(F("[ERROR] Failed to mount FFat filesystem"));
+    if (!storageBegin(true)) {  // true = format on failure
+        if (debugSerial) Serial.println(F("[ERROR] Failed to mount filesystem"));
     }
     
     // Configure server for better reliability
@@ -2380,7 +2548,7 @@ void registerWebEndpoints(WebServer& server) {
     // Missing endpoints that script.js needs
     
     // Serve programs.json file
-    server.on("/programs.json", HTTP_GET, [&](){
+    routeOn(server, "/programs.json", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[DEBUG] /programs.json requested"));
         if (serveStaticFile(server, "/programs.json")) {
             return;
@@ -2389,7 +2557,7 @@ void registerWebEndpoints(WebServer& server) {
         server.send(200, "application/json", "[]");
     });
     
-    server.on("/select", HTTP_GET, [&](){
+    onControl(server, "/select", HTTP_GET, [&](){
         if (server.hasArg("idx")) {
             int programId = server.arg("idx").toInt();
             // Handle migration from array index to ID-based system
@@ -2432,178 +2600,53 @@ void registerWebEndpoints(WebServer& server) {
         }
     });
     
-    server.on("/start_at_stage", HTTP_GET, [&](){
+    routeOn(server, "/start_at_stage", HTTP_GET, [&](){
         if (server.hasArg("stage")) {
             int stage = server.arg("stage").toInt();
             // Implement start at stage based on historical patterns
             if (debugSerial) {
                 Serial.printf("[DEBUG] Start at stage: %d\n", stage);
             }
-            
-            if (programState.activeProgramId >= getProgramCount()) { 
-                stopBreadmaker();
-                server.send(400, "application/json", "{\"error\":\"No valid program selected\"}");
-                return; 
-            }
-            
-            Program *p = getActiveProgramMutable();
-            if (!p) {
-                Serial.printf_P(PSTR("[ERROR] /start_at_stage: Unable to get active program\n"));
-                stopBreadmaker();
-                server.send(400, "application/json", "{\"error\":\"Cannot access active program\"}");
-                return;
-            }
-            
-            size_t numStages = p->customStages.size();
-            if (numStages == 0) {
-                Serial.printf_P(PSTR("[ERROR] /start_at_stage: Program has zero stages\n"));
-                stopBreadmaker();
-                server.send(400, "application/json", "{\"error\":\"Program has no stages\"}");
-                return;
-            }
-            
-            if (stage < 0 || stage >= (int)numStages) {
-                server.send(400, "application/json", "{\"error\":\"Invalid stage number\"}");
-                return;
-            }
-            
-            // Set the starting stage
-            programState.customStageIdx = stage;
-            programState.customStageStart = millis();
-            programState.customMixStepStart = 0;
-            programState.isRunning = true;
-            if (stage == 0) {
-                programState.programStartTime = time(nullptr);
-                // Initialize stage arrays for new program
-                initializeStageArrays();
-            } else {
-                // Ensure stage arrays are initialized for manual starts
-                if (!programState.adjustedStageDurations || programState.adjustedStageDurations[stage] == 0) {
-                    initializeStageArrays();
-                }
-                
-                // If starting at a fermentation stage, reset fermentation timing
-                if (stage < (int)numStages && p->customStages[stage].isFermentation) {
-                    // Force complete fermentation state reset for manual stage starts
-                    fermentState.lastFermentStageIdx = -1;  // Force reset detection
-                    fermentState.fermentLastUpdateMs = 0;
-                    fermentState.scheduledElapsedSeconds = 0.0;
-                    fermentState.realElapsedSeconds = 0.0;
-                    fermentState.accumulatedFermentMinutes = 0.0;
-                    fermentState.fermentationFactor = 0.0;
-                    if (debugSerial) Serial.printf("[MANUAL-START] Reset fermentation timing for stage %d\n", stage);
-                }
-            }
-            invalidateStatusCache();
-            
-            // Record actual start time only for the current stage being entered
-            if (stage == programState.customStageIdx && stage < (int)numStages && stage < MAX_PROGRAM_STAGES) {
-                programState.actualStageStartTimes[stage] = time(nullptr);
-                
-                // Clear any future stage timestamps to prevent timing corruption
-                for (int i = stage + 1; i < MAX_PROGRAM_STAGES; i++) {
-                    programState.actualStageStartTimes[i] = 0;
-                }
-            }
-            
-            saveResumeState();
-            server.send(200, "application/json", "{\"status\":\"ok\",\"stage\":" + String(stage) + "}");
+            ControlCommand cmd;
+            cmd.type = CMD_START_AT_STAGE;
+            cmd.intArg = stage;
+            sendCommandResult(server, cmd);
         } else {
             server.send(400, "application/json", "{\"error\":\"Missing stage parameter\"}");
         }
     });
     
-    server.on("/pause", HTTP_GET, [&](){
+    routeOn(server, "/pause", HTTP_GET, [&](){
         // Implement pause based on historical patterns
         if (debugSerial) {
             Serial.println("[DEBUG] Pause requested");
         }
-        programState.isRunning = false;
-        invalidateStatusCache();
-        setMotor(false);
-        setHeater(false);
-        setLight(false);
-        saveResumeState();
-        server.send(200, "application/json", "{\"status\":\"paused\"}");
+        ControlCommand cmd;
+        cmd.type = CMD_PAUSE;
+        sendCommandResult(server, cmd);
     });
     
-    server.on("/resume", HTTP_GET, [&](){
+    routeOn(server, "/resume", HTTP_GET, [&](){
         // Implement resume based on historical patterns
         if (debugSerial) {
             Serial.println("[DEBUG] Resume requested");
         }
-        programState.isRunning = true;
-        invalidateStatusCache();
-        // Do NOT reset actualStageStartTimes[customStageIdx] on resume if it was already set.
-        // Only set it if it was never set (i.e., just started this stage for the first time).
-        if (programState.customStageIdx < MAX_PROGRAM_STAGES && 
-            programState.actualStageStartTimes[programState.customStageIdx] == 0) {
-            programState.actualStageStartTimes[programState.customStageIdx] = time(nullptr);
-        }
-        saveResumeState();
-        server.send(200, "application/json", "{\"status\":\"running\"}");
+        ControlCommand cmd;
+        cmd.type = CMD_RESUME;
+        sendCommandResult(server, cmd);
     });
     
-    server.on("/back", HTTP_GET, [&](){
+    routeOn(server, "/back", HTTP_GET, [&](){
         // Implement back/previous stage based on historical patterns
         if (debugSerial) {
             Serial.println("[DEBUG] Back/previous stage requested");
         }
-        
-        if (programState.activeProgramId >= getProgramCount()) { 
-            stopBreadmaker();
-            server.send(200, "application/json", "{\"status\":\"error\",\"message\":\"No valid program\"}");
-            return; 
-        }
-        
-        Program *p = getActiveProgramMutable();
-        if (!p) {
-            Serial.printf_P(PSTR("[ERROR] /back: Unable to get active program\n"));
-            stopBreadmaker();
-            server.send(200, "application/json", "{\"status\":\"error\",\"message\":\"Cannot access active program\"}");
-            return;
-        }
-        
-        size_t numStages = p->customStages.size();
-        if (numStages == 0) {
-            Serial.printf_P(PSTR("[ERROR] /back: Program at id %u has zero stages\n"), 
-                           (unsigned)programState.activeProgramId);
-            stopBreadmaker();
-            server.send(200, "application/json", "{\"status\":\"error\",\"message\":\"Program has no stages\"}");
-            return;
-        }
-        
-        // Go to previous stage (wrap to last stage if at beginning)
-        if (programState.customStageIdx > 0) {
-            programState.customStageIdx--;
-        } else {
-            programState.customStageIdx = numStages - 1;
-        }
-        
-        programState.customStageStart = millis();
-        programState.customMixStepStart = 0;
-        programState.isRunning = true;
-        if (programState.customStageIdx == 0) {
-            programState.programStartTime = time(nullptr);
-        }
-        invalidateStatusCache();
-        
-        // Record actual start time of this stage when going back
-        if (programState.customStageIdx < numStages && 
-            programState.customStageIdx < MAX_PROGRAM_STAGES) {
-            programState.actualStageStartTimes[programState.customStageIdx] = time(nullptr);
-            
-            // Clear any future stage timestamps to prevent timing corruption
-            for (size_t i = programState.customStageIdx + 1; i < MAX_PROGRAM_STAGES; i++) {
-                programState.actualStageStartTimes[i] = 0;
-            }
-        }
-        
-        saveResumeState();
-        server.send(200, "application/json", "{\"status\":\"ok\",\"stage\":" + String(programState.customStageIdx) + "}");
+        ControlCommand cmd;
+        cmd.type = CMD_BACK;
+        sendCommandResult(server, cmd);
     });
     
-    server.on("/api/manual_mode", HTTP_GET, [&](){
+    onControl(server, "/api/manual_mode", HTTP_GET, [&](){
         if (server.hasArg("on")) {
             bool manualMode = server.arg("on") == "1";
             // Implement manual mode toggle based on historical patterns
@@ -2620,27 +2663,27 @@ void registerWebEndpoints(WebServer& server) {
         }
     });
     
-    server.on("/api/temperature", HTTP_GET, [&](){
+    routeOn(server, "/api/temperature", HTTP_GET, [&](){
         if (server.hasArg("setpoint")) {
             float setpoint = server.arg("setpoint").toFloat();
             // Implement temperature setpoint based on historical patterns
             if (debugSerial) {
                 Serial.printf("[DEBUG] Temperature setpoint: %.1f\n", setpoint);
             }
-            // Set PID setpoint for manual temperature control
-            pid.Setpoint = setpoint;
-            checkAndSwitchPIDProfile(); // Auto-switch profile based on new setpoint
-            invalidateStatusCache();
-            server.send(200, "application/json", "{\"status\":\"ok\",\"setpoint\":" + String(setpoint) + "}");
+            ControlCommand cmd;
+            cmd.type = CMD_SET_SETPOINT;
+            cmd.floatArg = setpoint;
+            sendCommandResult(server, cmd);
         } else {
             // Return current temperature and setpoint
+            ControlLockGuard guard;
             float currentTemp = getAveragedTemperature();
             server.send(200, "application/json", "{\"temperature\":" + String(currentTemp) + ",\"setpoint\":" + String(pid.Setpoint) + "}");
         }
     });
     
     // EWMA Temperature Monitoring endpoint for debugging convergence issues
-    server.on("/api/ewma_status", HTTP_GET, [&](){
+    onControl(server, "/api/ewma_status", HTTP_GET, [&](){
         float currentRaw = readTemperature();
         float currentAvg = getAveragedTemperature();
         float difference = currentRaw - currentAvg;
@@ -2657,7 +2700,8 @@ void registerWebEndpoints(WebServer& server) {
             "\"initialized\":%s,"
             "\"last_update\":%lu,"
             "\"spike_threshold\":%.2f,"
-            "\"pid_initialized\":%s"
+            "\"pid_initialized\":%s,"
+            "\"filter\":\"%s\""
             "}",
             currentRaw,
             currentAvg, 
@@ -2668,13 +2712,948 @@ void registerWebEndpoints(WebServer& server) {
             tempAvg.initialized ? "true" : "false",
             tempAvg.lastUpdate,
             tempAvg.spikeThreshold,
-            pid.initialized ? "true" : "false"
+            pid.initialized ? "true" : "false",
+            tempKalman.enabled ? "kalman" : "ema"
+        );
+        server.send(200, "application/json", response);
+    });
+    
+    // Oversampled RTD acquisition status; optional args reconfigure the pipeline
+    // (burst=4..64 samples, decimation=1..32 bursts, interval=5..1000 ms, reject=0..0.45)
+    onControl(server, "/api/adc_status", HTTP_GET, [&](){
+        if (server.hasArg("burst") || server.hasArg("decimation") || server.hasArg("interval") || server.hasArg("reject")) {
+            RTDSamplerConfig cfg = rtdSamplerGetConfig();
+            if (server.hasArg("burst")) cfg.burstSamples = (uint8_t)constrain(server.arg("burst").toInt(), 4, (int)RTD_BURST_MAX_SAMPLES);
+            if (server.hasArg("decimation")) cfg.decimation = (uint8_t)constrain(server.arg("decimation").toInt(), 1, 32);
+            if (server.hasArg("interval")) cfg.burstIntervalMs = (uint16_t)constrain(server.arg("interval").toInt(), 5, 1000);
+            if (server.hasArg("reject")) cfg.rejectFraction = server.arg("reject").toFloat();
+            rtdSamplerConfigure(cfg);
+            pendingSettingsSaveTime = millis() + 1000;
+        }
+        if (server.hasArg("reset")) rtdSamplerResetStats();
+
+        const RTDSamplerConfig& cfg = rtdSamplerGetConfig();
+        const RTDSamplerStats& st = rtdSamplerGetStats();
+        char response[640];
+        snprintf(response, sizeof(response),
+            "{"
+            "\"raw_reading\":%.2f,"
+            "\"temperature\":%.2f,"
+            "\"burst_samples\":%u,"
+            "\"decimation\":%u,"
+            "\"burst_interval_ms\":%u,"
+            "\"output_interval_ms\":%u,"
+            "\"reject_fraction\":%.2f,"
+            "\"burst_noise_counts\":%.2f,"
+            "\"output_noise_counts\":%.2f,"
+            "\"last_burst_min\":%u,"
+            "\"last_burst_max\":%u,"
+            "\"burst_count\":%u,"
+            "\"output_count\":%u,"
+            "\"total_samples\":%u,"
+            "\"rejected_samples\":%u,"
+            "\"last_burst_us\":%u,"
+            "\"max_burst_us\":%u,"
+            "\"reading_age_ms\":%lu"
+            "}",
+            st.rawReading,
+            tempFromRaw(st.rawReading),
+            cfg.burstSamples,
+            cfg.decimation,
+            cfg.burstIntervalMs,
+            (unsigned)(cfg.burstIntervalMs * cfg.decimation),
+            cfg.rejectFraction,
+            st.burstNoise,
+            st.outputNoise,
+            st.lastBurstMin,
+            st.lastBurstMax,
+            st.burstCount,
+            st.outputCount,
+            st.totalSamples,
+            st.rejectedSamples,
+            st.lastBurstMicros,
+            st.maxBurstMicros,
+            millis() - st.lastOutputMs
+        );
+        server.send(200, "application/json", response);
+    });
+    
+    // Kalman temperature estimator status; optional args select the filter and tune the model
+    // (filter=ema|kalman, heat_rate, loss_rate, ambient, q, q_bias, r)
+    onControl(server, "/api/kalman_status", HTTP_GET, [&](){
+        bool changed = false;
+        if (server.hasArg("filter")) {
+            bool wantKalman = server.arg("filter") == "kalman";
+            if (wantKalman && !tempKalman.enabled) temperatureEstimatorReset(readTemperature());
+            tempKalman.enabled = wantKalman;
+            changed = true;
+        }
+        if (server.hasArg("heat_rate")) { tempKalman.heatRate = constrain(server.arg("heat_rate").toFloat(), 0.0f, 5.0f); changed = true; }
+        if (server.hasArg("loss_rate")) { tempKalman.lossRate = constrain(server.arg("loss_rate").toFloat(), 0.0f, 0.1f); changed = true; }
+        if (server.hasArg("ambient")) { tempKalman.ambient = server.arg("ambient").toFloat(); changed = true; }
+        if (server.hasArg("q")) { tempKalman.processNoise = max(1e-6f, server.arg("q").toFloat()); changed = true; }
+        if (server.hasArg("q_bias")) { tempKalman.biasNoise = max(1e-8f, server.arg("q_bias").toFloat()); changed = true; }
+        if (server.hasArg("r")) { tempKalman.measurementNoise = max(1e-4f, server.arg("r").toFloat()); changed = true; }
+        if (changed) pendingSettingsSaveTime = millis() + 1000;
+
+        char response[640];
+        snprintf(response, sizeof(response),
+            "{"
+            "\"filter\":\"%s\","
+            "\"initialized\":%s,"
+            "\"estimate\":%.3f,"
+            "\"measured\":%.3f,"
+            "\"ema\":%.3f,"
+            "\"rate_c_per_s\":%.4f,"
+            "\"rate_c_per_min\":%.2f,"
+            "\"bias\":%.5f,"
+            "\"variance\":%.5f,"
+            "\"innovation\":%.3f,"
+            "\"innovation_variance\":%.4f,"
+            "\"heat_rate\":%.4f,"
+            "\"loss_rate\":%.6f,"
+            "\"ambient\":%.1f,"
+            "\"q\":%.6f,"
+            "\"q_bias\":%.6f,"
+            "\"r\":%.6f,"
+            "\"updates\":%u,"
+            "\"skipped\":%u"
+            "}",
+            tempKalman.enabled ? "kalman" : "ema",
+            tempKalman.initialized ? "true" : "false",
+            tempKalman.temperature,
+            readTemperature(),
+            tempAvg.smoothedTemperature,
+            tempKalman.rate,
+            tempKalman.rate * 60.0,
+            tempKalman.bias,
+            tempKalman.P[0][0],
+            tempKalman.lastInnovation,
+            tempKalman.innovationVariance,
+            tempKalman.heatRate,
+            tempKalman.lossRate,
+            tempKalman.ambient,
+            tempKalman.processNoise,
+            tempKalman.biasNoise,
+            tempKalman.measurementNoise,
+            tempKalman.updateCount,
+            tempKalman.skippedMeasurements
+        );
+        server.send(200, "application/json", response);
+    });
+    
+    // Hardware heater window: edge timing versus the loop gaps a loop-driven window would suffer (reset=1 clears)
+    onControl(server, "/api/heater_timer", HTTP_GET, [&](){
+        if (server.hasArg("reset")) heaterTimerResetStats();
+        const HeaterTimerStats& st = heaterTimerGetStats();
+        char response[512];
+        snprintf(response, sizeof(response),
+            "{"
+            "\"active\":%s,"
+            "\"output\":%s,"
+            "\"window_ms\":%lu,"
+            "\"tick_us\":%lu,"
+            "\"windows\":%u,"
+            "\"edges\":%u,"
+            "\"edge_error_last_us\":%u,"
+            "\"edge_error_max_us\":%u,"
+            "\"edge_error_avg_us\":%.1f,"
+            "\"last_pulse_ms\":%.1f,"
+            "\"pulse_error_max_us\":%u,"
+            "\"lease_expiries\":%u,"
+            "\"loop_gap_last_ms\":%u,"
+            "\"loop_gap_max_ms\":%u"
+            "}",
+            heaterTimerActive() ? "true" : "false",
+            heaterTimerOutput() ? "true" : "false",
+            windowSize,
+            HEATER_TIMER_TICK_US,
+            (unsigned)st.windows,
+            (unsigned)st.edges,
+            (unsigned)st.lastEdgeErrorUs,
+            (unsigned)st.maxEdgeErrorUs,
+            st.edges ? (double)st.totalEdgeErrorUs / st.edges : 0.0,
+            st.lastPulseUs / 1000.0,
+            (unsigned)st.maxPulseErrorUs,
+            (unsigned)st.leaseExpiries,
+            (unsigned)st.lastLoopGapMs,
+            (unsigned)st.loopGapMaxMs
+        );
+        server.send(200, "application/json", response);
+    });
+    
+    // Hardware motor pulse engine: per-edge timing error and the most recent edges (reset=1 clears)
+    onControl(server, "/api/motor_pulse", HTTP_GET, [&](){
+        if (server.hasArg("reset")) motorPulseResetStats();
+        const MotorPulseStats& st = motorPulseGetStats();
+        MotorEdgeRecord edges[MOTOR_EDGE_LOG_SIZE];
+        uint8_t n = motorPulseRecentEdges(edges, MOTOR_EDGE_LOG_SIZE);
+        char response[2048];
+        int len = snprintf(response, sizeof(response),
+            "{"
+            "\"active\":%s,"
+            "\"running\":%s,"
+            "\"output\":%s,"
+            "\"segment\":%u,"
+            "\"edges\":%u,"
+            "\"edge_error_last_us\":%u,"
+            "\"edge_error_max_us\":%u,"
+            "\"edge_error_avg_us\":%.1f,"
+            "\"last_pulse_ms\":%.1f,"
+            "\"pulse_error_max_us\":%u,"
+            "\"segments_completed\":%u,"
+            "\"patterns_loaded\":%u,"
+            "\"lease_expiries\":%u,"
+            "\"recent\":[",
+            motorPulseActive() ? "true" : "false",
+            motorPulseRunning() ? "true" : "false",
+            motorPulseOutput() ? "true" : "false",
+            (unsigned)motorPulseSegment(),
+            (unsigned)st.edges,
+            (unsigned)st.lastEdgeErrorUs,
+            (unsigned)st.maxEdgeErrorUs,
+            st.edges ? (double)st.totalEdgeErrorUs / st.edges : 0.0,
+            st.lastPulseUs / 1000.0,
+            (unsigned)st.maxPulseErrorUs,
+            (unsigned)st.segmentsCompleted,
+            (unsigned)st.patternsLoaded,
+            (unsigned)st.leaseExpiries
+        );
+        for (uint8_t i = 0; i < n && len < (int)sizeof(response) - 64; i++) {
+            len += snprintf(response + len, sizeof(response) - len, "%s{\"at\":%lu,\"on\":%s,\"seg\":%u,\"err_us\":%ld}",
+                            i ? "," : "", (unsigned long)edges[i].atMs, edges[i].on ? "true" : "false",
+                            (unsigned)edges[i].segment, (long)edges[i].errorUs);
+        }
+        snprintf(response + len, sizeof(response) - len, "]}");
+        server.send(200, "application/json", response);
+    });
+    
+    // Control task timing and its latest snapshot. Reads only the lock-free snapshot, so it
+    // never waits for a tick (reset=1 clears the timing stats)
+    routeOn(server, "/api/control_task", HTTP_GET, [&](){
+        if (server.hasArg("reset")) controlTaskResetStats();
+        const ControlTaskStats& st = controlTaskGetStats();
+        ControlSnapshot snap;
+        bool haveSnap = controlSnapshotRead(snap);
+        char response[768];
+        snprintf(response, sizeof(response),
+            "{"
+            "\"running\":%s,"
+            "\"core\":%d,"
+            "\"period_ms\":%lu,"
+            "\"ticks\":%u,"
+            "\"overruns\":%u,"
+            "\"tick_last_us\":%u,"
+            "\"tick_max_us\":%u,"
+            "\"lateness_last_us\":%u,"
+            "\"lateness_max_us\":%u,"
+            "\"lateness_avg_us\":%.1f,"
+            "\"lock_wait_max_us\":%u,"
+            "\"stack_free_bytes\":%u,"
+            "\"snapshot\":{\"valid\":%s,\"tick\":%u,\"age_ms\":%lu,\"temperature\":%.2f,\"setpoint\":%.1f,"
+            "\"output\":%.3f,\"running\":%s,\"heater\":%s,\"motor\":%s,\"stage\":%u,\"mix\":%u}"
+            "}",
+            controlTaskRunning() ? "true" : "false",
+            (int)CONTROL_TASK_CORE,
+            CONTROL_TICK_MS,
+            (unsigned)st.ticks,
+            (unsigned)st.overruns,
+            (unsigned)st.lastTickUs,
+            (unsigned)st.maxTickUs,
+            (unsigned)st.lastLatenessUs,
+            (unsigned)st.maxLatenessUs,
+            st.ticks ? (double)st.totalLatenessUs / st.ticks : 0.0,
+            (unsigned)st.maxLockWaitUs,
+            (unsigned)st.stackFreeBytes,
+            haveSnap ? "true" : "false",
+            (unsigned)snap.tick,
+            haveSnap ? millis() - snap.atMs : 0UL,
+            snap.temperature,
+            snap.setpoint,
+            snap.pidOutput,
+            snap.running ? "true" : "false",
+            snap.heater ? "true" : "false",
+            snap.motor ? "true" : "false",
+            (unsigned)snap.stageIdx,
+            (unsigned)snap.mixIdx
+        );
+        server.send(200, "application/json", response);
+    });
+    
+    // Command queue stats (web handlers -> control tick)
+    routeOn(server, "/api/command_queue", HTTP_GET, [&](){
+        if (server.hasArg("reset")) controlCommandsResetStats();
+        ControlCommandStats st = controlCommandsGetStats();
+        char response[384];
+        snprintf(response, sizeof(response),
+            "{"
+            "\"capacity\":%u,"
+            "\"submitted\":%u,"
+            "\"applied\":%u,"
+            "\"rejected_full\":%u,"
+            "\"timeouts\":%u,"
+            "\"batches\":%u,"
+            "\"batch_skipped\":%u,"
+            "\"max_batch\":%u,"
+            "\"latency_last_us\":%u,"
+            "\"latency_max_us\":%u,"
+            "\"latency_avg_us\":%.1f"
+            "}",
+            (unsigned)CONTROL_COMMAND_QUEUE_SIZE,
+            (unsigned)st.submitted,
+            (unsigned)st.applied,
+            (unsigned)st.rejectedFull,
+            (unsigned)st.timeouts,
+            (unsigned)st.batches,
+            (unsigned)st.skipped,
+            (unsigned)st.maxDepth,
+            (unsigned)st.lastLatencyUs,
+            (unsigned)st.maxLatencyUs,
+            st.applied ? (double)st.totalLatencyUs / st.applied : 0.0
+        );
+        server.send(200, "application/json", response);
+    });
+    
+    // Multi-action UI operations (select + start, stop + light off, ...) as one request.
+    // Body: a JSON array (or {"commands":[...]}) of up to CONTROL_COMMAND_MAX_BATCH
+    // {"cmd":"<name>", ...} entries using the command names above, e.g.
+    //   [{"cmd":"select_program","program":3},{"cmd":"set_setpoint","value":28},{"cmd":"start"}]
+    // Args: stage, value (setpoint °C / prefermentation seconds), program,
+    // output + on (set_output), time "HH:MM" + stage (schedule_start; no time cancels).
+    // Every entry is parsed and checked before anything is queued; the batch is then
+    // applied in one control tick and a failing command skips the rest (424), while
+    // the commands before it stay applied. The response holds each command's result
+    // and one status snapshot taken after the batch.
+    routeOn(server, "/api/batch", HTTP_POST, [&](){
+        StaticJsonDocument<1024> doc;
+        DeserializationError err = deserializeJson(doc, server.arg("plain"));
+        if (err) {
+            server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"Invalid JSON\"}");
+            return;
+        }
+        JsonArray list = doc.is<JsonArray>() ? doc.as<JsonArray>() : doc["commands"].as<JsonArray>();
+        if (list.size() == 0 || list.size() > CONTROL_COMMAND_MAX_BATCH) {
+            char response[96];
+            snprintf(response, sizeof(response), "{\"status\":\"error\",\"message\":\"Expected 1 to %u commands\"}",
+                     (unsigned)CONTROL_COMMAND_MAX_BATCH);
+            server.send(400, "application/json", response);
+            return;
+        }
+        
+        ControlCommand cmds[CONTROL_COMMAND_MAX_BATCH];
+        uint8_t count = 0;
+        for (JsonVariant v : list) {
+            const char* error = parseBatchCommand(v, cmds[count]);
+            if (!error && cmds[count].type == CMD_SELECT_PROGRAM &&
+                (cmds[count].intArg < 0 || (size_t)cmds[count].intArg >= getProgramCount())) {
+                error = "Invalid program ID";   // The tick loads the program when it applies the command
+            }
+            if (error) {
+                char response[128];
+                snprintf(response, sizeof(response), "{\"status\":\"error\",\"index\":%u,\"message\":\"%s\"}", (unsigned)count, error);
+                server.send(400, "application/json", response);
+                return;
+            }
+            count++;
+        }
+        
+        uint32_t token = controlCommandSubmitBatch(cmds, count);
+        if (token == 0) {
+            server.send(503, "application/json", "{\"status\":\"error\",\"message\":\"Command queue full\"}");
+            return;
+        }
+        ControlCommandResult results[CONTROL_COMMAND_MAX_BATCH];
+        if (!controlCommandWaitBatch(token, count, results)) {
+            server.send(503, "application/json", "{\"status\":\"queued\",\"message\":\"Batch will apply on the next control tick\"}");
+            return;
+        }
+        int code = 200;
+        for (uint8_t i = 0; i < count && code == 200; i++) {
+            if (results[i].httpCode >= 400) code = results[i].httpCode;
+        }
+        
+        // Built in RAM and sent once the status snapshot has released the lock
+        String json;
+        json.reserve(4096);
+        char buffer[192];
+        for (uint8_t i = 0; i < count; i++) {
+            snprintf(buffer, sizeof(buffer), "%s{\"cmd\":\"%s\",\"code\":%d,\"result\":%s}",
+                     i ? "," : "{\"results\":[", controlCommandName(cmds[i].type), results[i].httpCode,
+                     results[i].body[0] ? results[i].body : "null");
+            json += buffer;
+        }
+        json += "],\"status\":";
+        {
+            ControlLockGuard guard;
+            StringPrint jsonPrint(json);
+            streamStatusJson(jsonPrint);
+        }
+        json += "}";
+        server.send(code, "application/json", json);
+    });
+    
+    // Incremental file transfer stats; optional args set the per-loop budget
+    // (bytes=1024..65536 per pass, us=500..50000 per pass)
+    routeOn(server, "/api/file_transfers", HTTP_GET, [&](){
+        if (server.hasArg("bytes") || server.hasArg("us")) {
+            size_t bytes = server.hasArg("bytes") ? server.arg("bytes").toInt() : fileTransferBudgetBytes();
+            uint32_t us = server.hasArg("us") ? server.arg("us").toInt() : fileTransferBudgetUs();
+            fileTransferSetBudget(std::min<size_t>(bytes, 65536), std::min<uint32_t>(us, 50000));
+        }
+        if (server.hasArg("reset")) fileTransferResetStats();
+        const FileTransferStats& st = fileTransferGetStats();
+        char response[512];
+        snprintf(response, sizeof(response),
+            "{"
+            "\"active\":%u,"
+            "\"max_active\":%u,"
+            "\"slots\":%u,"
+            "\"budget_bytes\":%u,"
+            "\"budget_us\":%u,"
+            "\"started\":%u,"
+            "\"completed\":%u,"
+            "\"aborted\":%u,"
+            "\"fallbacks\":%u,"
+            "\"bytes_sent\":%llu,"
+            "\"passes\":%u,"
+            "\"pass_last_us\":%u,"
+            "\"pass_max_us\":%u,"
+            "\"pass_avg_us\":%.1f,"
+            "\"pass_last_bytes\":%u,"
+            "\"pass_max_bytes\":%u,"
+            "\"would_block\":%u"
+            "}",
+            (unsigned)fileTransfersActive(),
+            (unsigned)st.maxActive,
+            (unsigned)MAX_FILE_TRANSFERS,
+            (unsigned)fileTransferBudgetBytes(),
+            (unsigned)fileTransferBudgetUs(),
+            (unsigned)st.started,
+            (unsigned)st.completed,
+            (unsigned)st.aborted,
+            (unsigned)st.fallbacks,
+            (unsigned long long)st.bytesSent,
+            (unsigned)st.passes,
+            (unsigned)st.lastPassUs,
+            (unsigned)st.maxPassUs,
+            st.passes ? (double)st.totalPassUs / st.passes : 0.0,
+            (unsigned)st.lastPassBytes,
+            (unsigned)st.maxPassBytes,
+            (unsigned)st.wouldBlock
+        );
+        server.send(200, "application/json", response);
+    });
+    
+    // Background jobs: list with progress; cancel=<id>, start=split_programs|truncate_log,
+    // slice=500..50000 us per loop pass
+    routeOn(server, "/api/jobs", HTTP_GET, [&](){
+        if (server.hasArg("slice")) {
+            backgroundJobSetSlice(std::min<uint32_t>(server.arg("slice").toInt(), 50000));
+        }
+        if (server.hasArg("cancel")) {
+            if (!backgroundJobCancel(server.arg("cancel").toInt())) {
+                server.send(404, "application/json", "{\"error\":\"No such running job\"}");
+                return;
+            }
+        }
+        if (server.hasArg("start")) {
+            const String& kind = server.arg("start");
+            uint16_t id = 0;
+            if (kind == "split_programs") id = startSplitProgramsJsonJob();
+            else if (kind == "truncate_log") id = startTruncateActivityLogJob();
+            else {
+                server.send(400, "application/json", "{\"error\":\"Unknown job\"}");
+                return;
+            }
+            if (id == 0) {
+                server.send(503, "application/json", "{\"error\":\"Too many background jobs\"}");
+                return;
+            }
+        }
+        
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(200, "application/json", "");
+        char buffer[320];
+        snprintf(buffer, sizeof(buffer), "{\"active\":%u,\"slice_us\":%u,\"jobs\":[",
+                 (unsigned)backgroundJobsActive(), (unsigned)backgroundJobSlice());
+        server.sendContent(buffer);
+        bool first = true;
+        for (uint8_t i = 0; i < MAX_BACKGROUND_JOBS; i++) {
+            const BackgroundJob* job = backgroundJobAt(i);
+            if (!job) continue;
+            unsigned long endMs = job->finishedMs ? job->finishedMs : millis();
+            snprintf(buffer, sizeof(buffer),
+                "%s{\"id\":%u,\"name\":\"%s\",\"state\":\"%s\",\"done\":%u,\"total\":%u,"
+                "\"progress\":%.1f,\"elapsed_ms\":%lu,\"steps\":%u,\"step_max_us\":%u,"
+                "\"busy_ms\":%.1f,\"message\":\"%s\"}",
+                first ? "" : ",",
+                (unsigned)job->id,
+                job->name,
+                backgroundJobStateName(job->state),
+                (unsigned)job->done,
+                (unsigned)job->total,
+                job->state == JOB_DONE ? 100.0 : (job->total ? 100.0 * job->done / job->total : 0.0),
+                job->startedMs ? endMs - job->startedMs : 0UL,
+                (unsigned)job->steps,
+                (unsigned)job->maxStepUs,
+                job->busyUs / 1000.0,
+                job->message
+            );
+            server.sendContent(buffer);
+            first = false;
+        }
+        server.sendContent("]}");
+        server.sendContent(""); // End chunked response
+    });
+    
+    // Deferred flash writes: queue depth and per-object write latency; flush=1 writes everything pending
+    routeOn(server, "/api/persistence", HTTP_GET, [&](){
+        if (server.hasArg("flush")) persistFlushAll();
+        if (server.hasArg("reset")) persistResetStats();
+        const PersistStats& ps = persistGetStats();
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(200, "application/json", "");
+        char buffer[384];
+        snprintf(buffer, sizeof(buffer), "{\"depth\":%u,\"max_depth\":%u,\"flush_alls\":%u,\"objects\":{",
+                 (unsigned)persistQueueDepth(), (unsigned)ps.maxDepth, (unsigned)ps.flushAlls);
+        server.sendContent(buffer);
+        for (uint8_t i = 0; i < PERSIST_OBJECT_COUNT; i++) {
+            const PersistObjectStats& st = persistGetObjectStats((PersistObject)i);
+            snprintf(buffer, sizeof(buffer),
+                "%s\"%s\":{\"marks\":%u,\"writes\":%u,\"coalesced\":%u,\"failures\":%u,"
+                "\"last_bytes\":%u,\"serialize_last_us\":%u,\"write_last_us\":%u,\"write_max_us\":%u,"
+                "\"write_avg_us\":%.1f,\"delay_max_ms\":%u}",
+                i ? "," : "",
+                persistObjectName((PersistObject)i),
+                (unsigned)st.marks,
+                (unsigned)st.writes,
+                (unsigned)(st.marks > st.writes ? st.marks - st.writes : 0),
+                (unsigned)st.failures,
+                (unsigned)st.lastBytes,
+                (unsigned)st.lastSerializeUs,
+                (unsigned)st.lastWriteUs,
+                (unsigned)st.maxWriteUs,
+                st.writes ? (double)st.totalWriteUs / st.writes : 0.0,
+                (unsigned)st.maxDelayMs
+            );
+            server.sendContent(buffer);
+        }
+        server.sendContent("}}");
+        server.sendContent(""); // End chunked response
+    });
+    
+    // Flash write accounting: bytes, opens and estimated sector erases per file and
+    // caller, lifetime and for the current run; flush=1 saves the counters now
+    routeOn(server, "/api/storage_stats", HTTP_GET, [&](){
+        if (server.hasArg("reset")) storageStatsReset();
+        if (server.hasArg("flush")) persistFlush(PERSIST_STORAGE_STATS);
+        StorageCounters total, run;
+        storageStatsTotals(total, run);
+        const StorageSummary& sum = storageStatsSummary();
+        time_t now = time(nullptr);
+        bool clockValid = sum.runStarted > 1000000000 && now > sum.runStarted;
+        double runHours = clockValid ? (now - sum.runStarted) / 3600.0 : 0.0;
+        double erasesPerHour = runHours > 0.01 ? run.erases / runHours : 0.0;
+        uint64_t eraseBudget = (uint64_t)(storageTotalBytes() / STORAGE_SECTOR_SIZE) * STORAGE_SECTOR_ENDURANCE;
+        
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(200, "application/json", "");
+        char buffer[384];
+        snprintf(buffer, sizeof(buffer),
+            "{\"boots\":%u,\"runs\":%u,\"run_hours\":%.2f,\"erase_budget\":%llu,"
+            "\"total\":{\"opens\":%u,\"bytes\":%llu,\"erases\":%u,\"failures\":%u,\"amplification\":%.2f},"
+            "\"run\":{\"opens\":%u,\"bytes\":%llu,\"erases\":%u,\"failures\":%u,\"amplification\":%.2f,"
+            "\"erases_per_hour\":%.1f,\"projected_years\":%.1f},\"callers\":{",
+            (unsigned)sum.boots, (unsigned)sum.runs, runHours, (unsigned long long)eraseBudget,
+            (unsigned)total.opens, (unsigned long long)total.bytes, (unsigned)total.erases, (unsigned)total.failures,
+            total.bytes ? (double)total.erases * STORAGE_SECTOR_SIZE / total.bytes : 0.0,
+            (unsigned)run.opens, (unsigned long long)run.bytes, (unsigned)run.erases, (unsigned)run.failures,
+            run.bytes ? (double)run.erases * STORAGE_SECTOR_SIZE / run.bytes : 0.0,
+            erasesPerHour,
+            erasesPerHour > 0 ? eraseBudget / (erasesPerHour * 24 * 365) : 0.0
+        );
+        server.sendContent(buffer);
+        
+        // Per-caller sums; each caller is reported at its first entry
+        uint8_t count = storageStatsCount();
+        bool first = true;
+        for (uint8_t i = 0; i < count; i++) {
+            const StorageEntry& e = storageStatsEntry(i);
+            bool seen = false;
+            for (uint8_t j = 0; j < i && !seen; j++) seen = strcmp(storageStatsEntry(j).caller, e.caller) == 0;
+            if (seen) continue;
+            StorageCounters c, r;
+            for (uint8_t j = i; j < count; j++) {
+                const StorageEntry& o = storageStatsEntry(j);
+                if (strcmp(o.caller, e.caller) != 0) continue;
+                c.opens += o.total.opens; c.bytes += o.total.bytes; c.erases += o.total.erases;
+                r.opens += o.run.opens; r.bytes += o.run.bytes; r.erases += o.run.erases;
+            }
+            snprintf(buffer, sizeof(buffer),
+                "%s\"%s\":{\"opens\":%u,\"bytes\":%llu,\"erases\":%u,\"run_opens\":%u,\"run_bytes\":%llu,\"run_erases\":%u}",
+                first ? "" : ",", e.caller,
+                (unsigned)c.opens, (unsigned long long)c.bytes, (unsigned)c.erases,
+                (unsigned)r.opens, (unsigned long long)r.bytes, (unsigned)r.erases);
+            server.sendContent(buffer);
+            first = false;
+        }
+        server.sendContent("},\"files\":[");
+        for (uint8_t i = 0; i < count; i++) {
+            const StorageEntry& e = storageStatsEntry(i);
+            snprintf(buffer, sizeof(buffer),
+                "%s{\"path\":\"%s\",\"caller\":\"%s\",\"opens\":%u,\"bytes\":%llu,\"erases\":%u,\"failures\":%u,"
+                "\"run_opens\":%u,\"run_bytes\":%llu,\"run_erases\":%u}",
+                i ? "," : "", e.path, e.caller,
+                (unsigned)e.total.opens, (unsigned long long)e.total.bytes, (unsigned)e.total.erases, (unsigned)e.total.failures,
+                (unsigned)e.run.opens, (unsigned long long)e.run.bytes, (unsigned)e.run.erases);
+            server.sendContent(buffer);
+        }
+        server.sendContent("]}");
+        server.sendContent(""); // End chunked response
+    });
+    
+    // Filesystem benchmark: start=1 queues a run as a background job (opens, appends,
+    // append_bytes, large_kb, chunk tune it); without it, returns the last results
+    routeOn(server, "/api/storage_bench", HTTP_GET, [&](){
+        if (server.hasArg("start")) {
+            StorageBenchConfig cfg;
+            if (server.hasArg("opens")) cfg.opens = server.arg("opens").toInt();
+            if (server.hasArg("appends")) cfg.appends = server.arg("appends").toInt();
+            if (server.hasArg("append_bytes")) cfg.appendBytes = server.arg("append_bytes").toInt();
+            if (server.hasArg("large_kb")) cfg.largeBytes = server.arg("large_kb").toInt() * 1024;
+            if (server.hasArg("chunk")) cfg.chunkBytes = server.arg("chunk").toInt();
+            if (storageBenchStart(cfg) == 0) {
+                server.send(409, "application/json", "{\"error\":\"Benchmark already running or no job slot free\"}");
+                return;
+            }
+        }
+        const StorageBenchResult& r = storageBenchResult();
+        const BackgroundJob* job = backgroundJobGet(r.jobId);
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(200, "application/json", "");
+        char buffer[320];
+        snprintf(buffer, sizeof(buffer),
+            "{\"backend\":\"%s\",\"job\":%u,\"state\":\"%s\",\"progress\":%.1f,\"message\":\"%s\","
+            "\"config\":{\"opens\":%u,\"appends\":%u,\"append_bytes\":%u,\"large_bytes\":%u,\"chunk\":%u},\"phases\":{",
+            storageBackendName(), (unsigned)r.jobId,
+            job ? backgroundJobStateName(job->state) : "none",
+            job && job->total ? 100.0 * job->done / job->total : 0.0,
+            job ? job->message : "",
+            (unsigned)r.config.opens, (unsigned)r.config.appends, (unsigned)r.config.appendBytes,
+            (unsigned)r.config.largeBytes, (unsigned)r.config.chunkBytes);
+        server.sendContent(buffer);
+        for (uint8_t i = 0; i < BENCH_PHASE_COUNT; i++) {
+            const StorageBenchPhase& p = r.phases[i];
+            snprintf(buffer, sizeof(buffer),
+                "%s\"%s\":{\"ops\":%u,\"bytes\":%llu,\"avg_us\":%.1f,\"max_us\":%u,"
+                "\"ops_per_s\":%.1f,\"kb_per_s\":%.1f}",
+                i ? "," : "",
+                storageBenchPhaseName(i),
+                (unsigned)p.ops,
+                (unsigned long long)p.bytes,
+                p.ops ? (double)p.totalUs / p.ops : 0.0,
+                (unsigned)p.maxUs,
+                p.totalUs ? p.ops * 1000000.0 / p.totalUs : 0.0,
+                p.totalUs ? p.bytes * 1000000.0 / 1024 / p.totalUs : 0.0
+            );
+            server.sendContent(buffer);
+        }
+        server.sendContent("}}");
+        server.sendContent(""); // End chunked response
+    });
+    
+    // Prometheus scrape target: the counters above in text exposition format, streamed
+    // uncached (TTL 0) through the response writer without heap allocation
+    routeOn(server, "/metrics", HTTP_GET, [&](){
+        server.sendHeader("Cache-Control", "no-cache");
+        responseCacheServe(server, METRICS_CONTENT_TYPE, 0, metricsRender);
+    });
+    
+    // Binary telemetry over Serial: enable=0|1 starts/stops the stream, interval=ms
+    // (default 20, every control tick); reset=1 clears the counters
+    routeOn(server, "/api/telemetry", HTTP_GET, [&](){
+        if (server.hasArg("enable")) {
+            if (server.arg("enable") == "1") {
+                long interval = server.hasArg("interval") ? server.arg("interval").toInt() : TELEMETRY_DEFAULT_INTERVAL_MS;
+                telemetryStart((uint16_t)constrain(interval, 1L, (long)TELEMETRY_MAX_INTERVAL_MS));
+            } else {
+                telemetryStop();
+            }
+        }
+        if (server.hasArg("reset")) telemetryResetStats();
+        
+        const TelemetryStats& st = telemetryGetStats();
+        unsigned long elapsed = millis() - st.sinceMs;
+        char response[320];
+        snprintf(response, sizeof(response),
+            "{"
+            "\"active\":%s,"
+            "\"interval_ms\":%u,"
+            "\"format_version\":%u,"
+            "\"frame_bytes\":%u,"
+            "\"frames\":%lu,"
+            "\"dropped\":%lu,"
+            "\"bytes\":%llu,"
+            "\"bytes_per_second\":%.1f,"
+            "\"elapsed_ms\":%lu"
+            "}",
+            telemetryActive() ? "true" : "false",
+            (unsigned)telemetryIntervalMs(),
+            (unsigned)TELEMETRY_FORMAT_VERSION,
+            (unsigned)TELEMETRY_FRAME_MAX,
+            (unsigned long)st.frames,
+            (unsigned long)st.dropped,
+            (unsigned long long)st.bytes,
+            elapsed ? st.bytes * 1000.0 / elapsed : 0.0,
+            elapsed
+        );
+        server.send(200, "application/json", response);
+    });
+    
+    // Debug log: per-category levels and queue stats; category=<name>&level=<name|0-5> sets
+    // a level ("all" for every category), reset=1 clears the counters
+    routeOn(server, "/api/log", HTTP_GET, [&](){
+        if (server.hasArg("level")) {
+            uint8_t level;
+            String category = server.hasArg("category") ? server.arg("category") : String("all");
+            LogCategory cat;
+            if (!logLevelFromName(server.arg("level").c_str(), level)) {
+                server.send(400, "application/json", "{\"error\":\"Unknown level\"}");
+                return;
+            }
+            if (category == "all") {
+                for (uint8_t i = 0; i < LOG_CATEGORY_COUNT; i++) logSetLevel((LogCategory)i, level);
+            } else if (logCategoryFromName(category.c_str(), cat)) {
+                logSetLevel(cat, level);
+            } else {
+                server.send(400, "application/json", "{\"error\":\"Unknown category\"}");
+                return;
+            }
+        }
+        if (server.hasArg("reset")) logResetStats();
+        
+        const LogStats& st = logGetStats();
+        char response[768];
+        int len = snprintf(response, sizeof(response),
+            "{"
+            "\"debug_serial\":%s,"
+            "\"compiled_max_level\":\"%s\","
+            "\"messages\":%lu,"
+            "\"bytes\":%llu,"
+            "\"dropped\":%lu,"
+            "\"truncated\":%lu,"
+            "\"suppressed\":%lu,"
+            "\"pending_bytes\":%lu,"
+            "\"high_water_bytes\":%lu,"
+            "\"ring_bytes\":%u,"
+            "\"elapsed_ms\":%lu,"
+            "\"categories\":{",
+            telemetryDebugSerialSetting() ? "true" : "false",
+            logLevelName(LOG_MIN_LEVEL),
+            (unsigned long)st.messages,
+            (unsigned long long)st.bytes,
+            (unsigned long)st.dropped,
+            (unsigned long)st.truncated,
+            (unsigned long)st.suppressed,
+            (unsigned long)logPendingBytes(),
+            (unsigned long)st.highWater,
+            (unsigned)LOG_RING_SIZE,
+            millis() - st.sinceMs
+        );
+        for (uint8_t i = 0; i < LOG_CATEGORY_COUNT && len < (int)sizeof(response); i++) {
+            len += snprintf(response + len, sizeof(response) - len, "%s\"%s\":{\"level\":\"%s\",\"suppressed\":%lu}",
+                            i ? "," : "", logCategoryName((LogCategory)i), logLevelName(logCategoryLevels[i]),
+                            (unsigned long)st.categorySuppressed[i]);
+        }
+        if (len < (int)sizeof(response)) snprintf(response + len, sizeof(response) - len, "}}");
+        server.send(200, "application/json", response);
+    });
+    
+    // Span trace as Chrome trace-event JSON (save it and open in chrome://tracing or
+    // ui.perfetto.dev); enable=0/1 and min_us=N set the recorder, reset=1 empties the ring
+    routeOn(server, "/api/trace", HTTP_GET, [&](){
+        if (server.hasArg("enable")) traceSetEnabled(server.arg("enable") == "1");
+        if (server.hasArg("min_us")) traceSetMinUs((uint32_t)constrain(server.arg("min_us").toInt(), 0L, 1000000L));
+        if (server.hasArg("reset")) traceClear();
+        server.sendHeader("Cache-Control", "no-cache");
+        responseCacheServe(server, "application/json", 0, traceRender);
+    });
+    
+    // Route table: per-route requests, bytes, errors and latency histogram; reset=1 clears,
+    // active=1 lists only routes that have served requests
+    routeOn(server, "/api/routes", HTTP_GET, [&](){
+        if (server.hasArg("reset")) routesResetStats();
+        bool activeOnly = server.hasArg("active");
+        const WebRouteTableStats& t = routeTableStats();
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(200, "application/json", "");
+        char buffer[384];
+        snprintf(buffer, sizeof(buffer),
+            "{\"routes\":%u,\"max_routes\":%u,\"trie_nodes\":%u,\"duplicates\":%u,\"overflow\":%u,"
+            "\"lookups\":%lu,\"lookup_avg_us\":%.2f,\"unmatched\":%lu,\"deferred\":%lu,\"defer_overflows\":%lu,"
+            "\"bucket_bounds_us\":[",
+            (unsigned)t.routes, (unsigned)MAX_WEB_ROUTES, (unsigned)t.nodes, (unsigned)t.duplicates, (unsigned)t.overflow,
+            (unsigned long)t.lookups, t.lookups ? (double)t.lookupUs / t.lookups : 0.0, (unsigned long)t.unmatched,
+            (unsigned long)t.deferred, (unsigned long)t.deferOverflows);
+        server.sendContent(buffer);
+        for (uint8_t b = 0; b < ROUTE_LATENCY_BUCKETS - 1; b++) {
+            snprintf(buffer, sizeof(buffer), "%s%lu", b ? "," : "", (unsigned long)ROUTE_LATENCY_BOUNDS_US[b]);
+            server.sendContent(buffer);
+        }
+        server.sendContent("],\"list\":[");
+        bool first = true;
+        for (uint8_t i = 0; i < routeCount(); i++) {
+            const WebRoute& r = routeGet(i);
+            const WebRouteStats& st = r.stats;
+            if (activeOnly && st.requests == 0) continue;
+            int n = snprintf(buffer, sizeof(buffer),
+                "%s{\"uri\":\"%s\",\"method\":\"%s\",\"requests\":%lu,\"bytes\":%llu,\"errors\":%lu,"
+                "\"uploads\":%lu,\"avg_us\":%.0f,\"max_us\":%lu,\"duplicates\":%u,\"hist\":[",
+                first ? "" : ",", r.uri, routeMethodName(r.method), (unsigned long)st.requests,
+                (unsigned long long)st.bytesOut, (unsigned long)st.errors, (unsigned long)st.uploads,
+                st.requests ? (double)st.totalUs / st.requests : 0.0, (unsigned long)st.maxUs, (unsigned)r.duplicates);
+            for (uint8_t b = 0; b < ROUTE_LATENCY_BUCKETS && n < (int)sizeof(buffer); b++) {
+                n += snprintf(buffer + n, sizeof(buffer) - n, "%s%lu", b ? "," : "", (unsigned long)st.histogram[b]);
+            }
+            server.sendContent(buffer);
+            server.sendContent("]}");
+            first = false;
+        }
+        server.sendContent("]}");
+        server.sendContent(""); // End chunked response
+    });
+    
+    // HTTP connections: keep-alive reuse, accept rate and pool state; reset=1 clears the
+    // counters, keepalive=0|1 switches to the core's one-request-per-connection handling
+    // (on ::server, the RoutedWebServer itself; the parameter is its WebServer base)
+    routeOn(server, "/api/connections", HTTP_GET, [&](){
+        if (server.hasArg("reset")) webConnectionResetStats();
+        if (server.hasArg("keepalive")) ::server.setKeepAlive(server.arg("keepalive").toInt() != 0);
+        const WebConnectionStats& c = webConnectionStats();
+        float seconds = (millis() - c.sinceMs) / 1000.0f;
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(200, "application/json", "");
+        char buffer[640];
+        snprintf(buffer, sizeof(buffer),
+            "{\"keepalive\":%s,\"pool\":%u,\"idle_timeout_ms\":%lu,\"max_requests\":%u,\"window_s\":%.1f,"
+            "\"accepted\":%lu,\"accepts_per_s\":%.2f,\"requests\":%lu,\"requests_per_s\":%.2f,"
+            "\"reused\":%lu,\"reuse_ratio\":%.3f,\"kept_alive\":%lu,\"open\":%u,\"max_open\":%u,"
+            "\"closed\":{\"not_framed\":%lu,\"client\":%lu,\"limit\":%lu,\"crowded\":%lu,\"peer\":%lu,"
+            "\"idle\":%lu,\"evicted\":%lu,\"bad_request\":%lu}}",
+            ::server.keepAlive() ? "true" : "false", (unsigned)WEB_KEEPALIVE_POOL, WEB_KEEPALIVE_IDLE_MS,
+            (unsigned)WEB_KEEPALIVE_MAX_REQUESTS, seconds,
+            (unsigned long)c.accepted, seconds > 0 ? c.accepted / seconds : 0.0f,
+            (unsigned long)c.requests, seconds > 0 ? c.requests / seconds : 0.0f,
+            (unsigned long)c.reused, c.requests ? (float)c.reused / c.requests : 0.0f, (unsigned long)c.keptAlive,
+            (unsigned)c.open, (unsigned)c.maxOpen,
+            (unsigned long)c.notFramed, (unsigned long)c.clientClose, (unsigned long)c.limitClose,
+            (unsigned long)c.crowdedClose, (unsigned long)c.peerClosed, (unsigned long)c.idleTimeouts,
+            (unsigned long)c.evictions, (unsigned long)c.badRequests);
+        server.sendContent(buffer);
+        server.sendContent(""); // End chunked response
+    });
+    
+    // Response cache: hit ratio and bytes served from cache; reset=1 clears the counters,
+    // clear=1 drops the entries, enable=0|1, status_ms / ha_ms set the TTLs (0..60000, 0 = off)
+    routeOn(server, "/api/response_cache", HTTP_GET, [&](){
+        if (server.hasArg("reset")) responseCacheResetStats();
+        if (server.hasArg("clear")) responseCacheClear();
+        if (server.hasArg("enable")) responseCacheSetEnabled(server.arg("enable").toInt() != 0);
+        if (server.hasArg("status_ms")) statusCacheMs = constrain(server.arg("status_ms").toInt(), 0, 60000);
+        if (server.hasArg("ha_ms")) haCacheMs = constrain(server.arg("ha_ms").toInt(), 0, 60000);
+        const ResponseCacheStats& st = responseCacheGetStats();
+        uint32_t served = st.hits + st.misses;
+        unsigned long now = millis();
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(200, "application/json", "");
+        char buffer[448];
+        snprintf(buffer, sizeof(buffer),
+            "{\"enabled\":%s,\"status_ms\":%lu,\"ha_ms\":%lu,\"version\":%lu,"
+            "\"hits\":%lu,\"misses\":%lu,\"hit_ratio\":%.3f,\"cold\":%lu,\"expired\":%lu,\"invalidated\":%lu,"
+            "\"bypassed\":%lu,\"evictions\":%lu,\"bytes_from_cache\":%llu,\"render_avg_us\":%.0f,"
+            "\"render_saved_ms\":%.1f,\"entries\":[",
+            responseCacheEnabled() ? "true" : "false", statusCacheMs, haCacheMs, (unsigned long)responseCacheVersion(),
+            (unsigned long)st.hits, (unsigned long)st.misses, served ? (double)st.hits / served : 0.0,
+            (unsigned long)st.cold, (unsigned long)st.expired, (unsigned long)st.invalidated,
+            (unsigned long)st.bypassed, (unsigned long)st.evictions, (unsigned long long)st.bytesFromCache,
+            st.misses ? (double)st.renderUs / st.misses : 0.0,
+            st.misses ? (double)st.renderUs / st.misses * st.hits / 1000.0 : 0.0);
+        server.sendContent(buffer);
+        for (uint8_t i = 0; i < responseCacheEntryCount(); i++) {
+            const ResponseCacheEntry& e = responseCacheEntry(i);
+            snprintf(buffer, sizeof(buffer),
+                "%s{\"key\":\"%s\",\"bytes\":%u,\"age_ms\":%lu,\"current\":%s,\"hits\":%lu,\"renders\":%lu}",
+                i ? "," : "", e.key, (unsigned)e.length, now - e.renderedMs,
+                e.version == responseCacheVersion() ? "true" : "false",
+                (unsigned long)e.hits, (unsigned long)e.renders);
+            server.sendContent(buffer);
+        }
+        server.sendContent("]}");
+        server.sendContent(""); // End chunked response
+    });
+    
+    // Predictive thermal monitor status; optional args tune thresholds
+    // (min_gain, runaway_slope, horizon) or clear a latched fault (clear=1)
+    onControl(server, "/api/thermal_monitor", HTTP_GET, [&](){
+        ThermalMonitorConfig& cfg = thermalMonitor.config;
+        bool changed = false;
+        if (server.hasArg("min_gain")) { cfg.minHeaterGain = constrain(server.arg("min_gain").toFloat(), 0.0005f, 0.1f); changed = true; }
+        if (server.hasArg("runaway_slope")) { cfg.runawaySlope = constrain(server.arg("runaway_slope").toFloat(), 0.005f, 1.0f); changed = true; }
+        if (server.hasArg("horizon")) { cfg.predictionHorizon = constrain(server.arg("horizon").toFloat(), 0.0f, 600.0f); changed = true; }
+        if (server.hasArg("clear")) thermalMonitor.clearFault();
+        if (changed) pendingSettingsSaveTime = millis() + 1000;
+
+        const ThermalMonitorStats& st = thermalMonitor.stats;
+        char response[900];
+        snprintf(response, sizeof(response),
+            "{"
+            "\"fault\":\"%s\","
+            "\"fault_time\":%.0f,"
+            "\"decision_latency\":%.1f,"
+            "\"heater_gain\":%.5f,"
+            "\"drift_slope\":%.5f,"
+            "\"slope\":%.5f,"
+            "\"duty\":%.3f,"
+            "\"gain_identifiable\":%s,"
+            "\"residual_std\":%.3f,"
+            "\"cusum_no_rise\":%.2f,"
+            "\"cusum_runaway\":%.2f,"
+            "\"seconds_to_emergency\":%.0f,"
+            "\"stuck_for\":%.0f,"
+            "\"heater_on_seconds\":%lu,"
+            "\"heater_cycles\":%u,"
+            "\"updates\":%u,"
+            "\"alarms\":{\"heater_no_rise\":%u,\"runaway\":%u,\"predicted_overtemp\":%u,\"stuck_sensor\":%u},"
+            "\"config\":{\"window\":%u,\"min_gain\":%.4f,\"min_heater_on\":%.0f,\"runaway_slope\":%.4f,"
+            "\"settle\":%.0f,\"k\":%.2f,\"h_no_rise\":%.1f,\"h_runaway\":%.1f,\"horizon\":%.0f,\"stuck_seconds\":%.0f}"
+            "}",
+            thermalFaultName(st.fault),
+            st.faultTimeSec,
+            st.lastDecisionLatency,
+            st.heaterGain,
+            st.driftSlope,
+            st.slope,
+            st.dutyMean,
+            st.gainIdentifiable ? "true" : "false",
+            st.residualStd,
+            st.cusumNoRise,
+            st.cusumRunaway,
+            st.secondsToEmergency,
+            st.stuckForSeconds,
+            getHeaterOnTimeMs() / 1000UL,
+            (unsigned)getHeaterCycleCount(),
+            (unsigned)st.updates,
+            (unsigned)st.alarms[THERMAL_HEATER_NO_RISE], (unsigned)st.alarms[THERMAL_RUNAWAY],
+            (unsigned)st.alarms[THERMAL_PREDICTED_OVERTEMP], (unsigned)st.alarms[THERMAL_STUCK_SENSOR],
+            (unsigned)cfg.windowSamples, cfg.minHeaterGain, cfg.minHeaterOnSeconds, cfg.runawaySlope,
+            cfg.heaterOffSettleSeconds, cfg.cusumSlack, cfg.noRiseThreshold, cfg.runawayThreshold,
+            cfg.predictionHorizon, cfg.stuckSeconds
         );
         server.send(200, "application/json", response);
     });
     
     // Missing API endpoints for output control (expected by script.js)
-    server.on("/api/heater", HTTP_GET, [&](){
+    onControl(server, "/api/heater", HTTP_GET, [&](){
         if (server.hasArg("on")) {
             bool on = server.arg("on") == "1";
             setHeater(on);
@@ -2685,7 +3664,7 @@ void registerWebEndpoints(WebServer& server) {
         }
     });
     
-    server.on("/api/motor", HTTP_GET, [&](){
+    onControl(server, "/api/motor", HTTP_GET, [&](){
         if (server.hasArg("on")) {
             bool on = server.arg("on") == "1";
             setMotor(on);
@@ -2696,7 +3675,7 @@ void registerWebEndpoints(WebServer& server) {
         }
     });
     
-    server.on("/api/light", HTTP_GET, [&](){
+    onControl(server, "/api/light", HTTP_GET, [&](){
         if (server.hasArg("on")) {
             bool on = server.arg("on") == "1";
             setLight(on);
@@ -2708,7 +3687,7 @@ void registerWebEndpoints(WebServer& server) {
         }
     });
     
-    server.on("/api/buzzer", HTTP_GET, [&](){
+    onControl(server, "/api/buzzer", HTTP_GET, [&](){
         if (server.hasArg("on")) {
             bool on = server.arg("on") == "1";
             setBuzzer(on);
@@ -2721,69 +3700,32 @@ void registerWebEndpoints(WebServer& server) {
     
     // Handle static files (catch-all)
     // Force save PID profiles (for testing/debugging)
-    server.on("/api/force_save_profiles", HTTP_GET, [&](){
+    onControl(server, "/api/force_save_profiles", HTTP_GET, [&](){
         savePIDProfiles();
         server.send(200, "application/json", "{\"status\":\"profiles saved\"}");
     });
     
     // Force load PID profiles (for testing/debugging)
-    server.on("/api/force_load_profiles", HTTP_GET, [&](){
+    onControl(server, "/api/force_load_profiles", HTTP_GET, [&](){
         loadPIDProfiles();
         server.send(200, "application/json", "{\"status\":\"profiles loaded\"}");
     });
     
     // Lightweight status endpoint for PID tuning (excludes large arrays)
-    server.on("/api/pid_status", HTTP_GET, [&](){
+    routeOn(server, "/api/pid_status", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[DEBUG] /api/pid_status requested"));
         
         server.sendHeader("Cache-Control", "no-cache, no-store, must-revalidate");
         server.sendHeader("Pragma", "no-cache");
         server.sendHeader("Expires", "-1");
-        
-        // Use streaming response to avoid memory allocations
-        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
-        server.send(200, "application/json", "");
-        
-        // Stream JSON directly without String concatenation
-        server.sendContent("{");
-        server.sendContent("\"temperature\":");
-        server.sendContent(String(getAveragedTemperature(), 1));
-        server.sendContent(",\"rawTemperature\":");
-        server.sendContent(String(readTemperature(), 1));
-        server.sendContent(",\"setpoint\":");
-        server.sendContent(String(pid.Setpoint, 1));
-        server.sendContent(",\"heater\":");
-        server.sendContent(outputStates.heater ? "true" : "false");
-        server.sendContent(",\"motor\":");
-        server.sendContent(outputStates.motor ? "true" : "false");
-        server.sendContent(",\"running\":");
-        server.sendContent(programState.isRunning ? "true" : "false");
-        server.sendContent(",\"pid_kp\":");
-        server.sendContent(String(pid.Kp, 6));
-        server.sendContent(",\"pid_ki\":");
-        server.sendContent(String(pid.Ki, 6));
-        server.sendContent(",\"pid_kd\":");
-        server.sendContent(String(pid.Kd, 6));
-        server.sendContent(",\"pid_output\":");
-        server.sendContent(String(pid.Output, 3));
-        server.sendContent(",\"pid_input\":");
-        server.sendContent(String(pid.Input, 1));
-        server.sendContent(",\"pid_p\":");
-        server.sendContent(String(pid.pidP, 3));
-        server.sendContent(",\"pid_i\":");
-        server.sendContent(String(pid.pidI, 3));
-        server.sendContent(",\"pid_d\":");
-        server.sendContent(String(pid.pidD, 3));
-        server.sendContent(",\"uptime_sec\":");
-        server.sendContent(String(millis() / 1000));
-        server.sendContent(",\"free_heap\":");
-        server.sendContent(String(ESP.getFreeHeap()));
-        server.sendContent("}");
-        server.sendContent("");  // End chunked response
+        responseCacheServe(server, "application/json", statusCacheMs, [](Print& out) {
+            ControlLockGuard guard;
+            renderPidStatusJson(out);
+        });
     });
 
     // Fast status endpoint - essential data only, no arrays
-    server.on("/api/status_fast", HTTP_GET, [&](){
+    onControl(server, "/api/status_fast", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[DEBUG] /api/status_fast requested"));
         
         server.sendHeader("Cache-Control", "no-cache, no-store, must-revalidate");
@@ -2915,7 +3857,7 @@ void registerWebEndpoints(WebServer& server) {
     });
 
     // PID Debug endpoint - Enhanced debugging information for PID tuning interfaces
-    server.on("/api/pid_debug", HTTP_GET, [&](){
+    onControl(server, "/api/pid_debug", HTTP_GET, [&](){
         if (debugSerial) Serial.println(F("[DEBUG] /api/pid_debug requested"));
         
         server.sendHeader("Cache-Control", "no-cache, no-store, must-revalidate");
@@ -2988,15 +3930,16 @@ void registerWebEndpoints(WebServer& server) {
     });
     
     // Activity log management endpoints
-    server.on("/api/activity/log", HTTP_GET, [&](){
+    routeOn(server, "/api/activity/log", HTTP_GET, [&](){
         trackWebActivity();
+        persistFlush(PERSIST_ACTIVITY_LOG);  // Include buffered lines
         if (serveStaticFile(server, "/activity.log")) {
             return;
         }
         server.send(404, "text/plain", "Activity log not found");
     });
     
-    server.on("/api/activity/info", HTTP_GET, [&](){
+    routeOn(server, "/api/activity/info", HTTP_GET, [&](){
         trackWebActivity();
         String response = "{";
         response += "\"enabled\":" + String(isActivityLogEnabled() ? "true" : "false") + ",";
@@ -3005,13 +3948,13 @@ void registerWebEndpoints(WebServer& server) {
         server.send(200, "application/json", response);
     });
     
-    server.on("/api/activity/clear", HTTP_POST, [&](){
+    onControl(server, "/api/activity/clear", HTTP_POST, [&](){
         trackWebActivity();
         clearActivityLog();
         server.send(200, "application/json", "{\"status\":\"cleared\"}");
     });
     
-    server.on("/api/activity/enable", HTTP_POST, [&](){
+    onControl(server, "/api/activity/enable", HTTP_POST, [&](){
         trackWebActivity();
         bool enable = true;
         if (server.hasArg("enabled")) {
@@ -3021,12 +3964,15 @@ void registerWebEndpoints(WebServer& server) {
         server.send(200, "application/json", "{\"status\":\"" + String(enable ? "enabled" : "disabled") + "\"}");
     });
     
-    server.on("/api/activity/test", HTTP_POST, [&](){
+    onControl(server, "/api/activity/test", HTTP_POST, [&](){
         trackWebActivity();
         logSystemEvent("Activity log test event triggered from web interface");
         server.send(200, "application/json", "{\"status\":\"test event logged\"}");
     });
     
+    // Everything is registered: build the route table
+    routesBegin(server);
+    
     server.onNotFound([&](){
         String path = server.uri();
         
@@ -0,0 +1,427 @@
+#include "web_routes.h"
+#include "route_trie.h"
+#include "trace_recorder.h"
+#ifndef NATIVE_SIMULATION
+#include <esp_timer.h>
+#endif
+
+extern bool debugSerial;
+
+const uint32_t ROUTE_LATENCY_BOUNDS_US[ROUTE_LATENCY_BUCKETS - 1] = {
+  500, 1000, 2000, 5000, 10000, 20000, 50000, 100000, 500000
+};
+
+static_assert(MAX_WEB_ROUTES <= ROUTE_TRIE_MAX_PATHS, "route trie too small for the route table");
+
+static const size_t MAX_ROUTE_URI = 200;   // Trie labels are at most 255 bytes
+
+static WebRoute routes[MAX_WEB_ROUTES];
+static WebServer::THandlerFunction handlers[MAX_WEB_ROUTES];
+static WebServer::THandlerFunction uploadHandlers[MAX_WEB_ROUTES];
+static int16_t nextRoute[MAX_WEB_ROUTES];   // Other methods of the same path, in registration order
+static RouteTrie trie;                      // Node value: first route registered for that path
+static WebRouteTableStats tableStats;
+static bool built = false;
+
+// Request being served; set by the lookup, read by the byte counter until the next request
+static int16_t current = -1;
+static bool statusSeen = false;
+
+static WebConnectionStats connStats;
+
+// Server whose handleClient() is running, for webResponseDefer()
+static RoutedWebServer* serving = nullptr;
+
+// Framing of the response being served from the keep-alive pool
+static bool headerSeen = false;
+static bool chunkedResponse = false;
+static int64_t declaredLength = -1;
+static uint64_t bodyBytes = 0;
+
+static void buildTrie() {
+  trie.clear();
+  for (uint8_t i = 0; i < tableStats.routes; i++) nextRoute[i] = -1;
+  for (uint8_t i = 0; i < tableStats.routes; i++) {
+    int16_t* tail = &trie.value(trie.insert(routes[i].uri));
+    while (*tail >= 0) tail = &nextRoute[*tail];
+    *tail = i;
+  }
+  tableStats.nodes = trie.nodeCount();
+  built = true;
+}
+
+static int16_t lookup(const char* uri, HTTPMethod method) {
+  int16_t n = trie.find(uri);
+  if (n < 0) return -1;
+  for (int16_t r = trie.value(n); r >= 0; r = nextRoute[r]) {
+    if (routes[r].method == HTTP_ANY || routes[r].method == method) return r;
+  }
+  return -1;
+}
+
+static void chargeWrite(const char* b, size_t l) {
+  if (current < 0) return;
+  WebRouteStats& st = routes[current].stats;
+  st.bytesOut += l;
+  if (!statusSeen && l > 12 && strncmp(b, "HTTP/1.", 7) == 0) {
+    statusSeen = true;
+    if (atoi(b + 9) >= 400) st.errors++;
+  }
+}
+
+static const char* findIn(const char* b, size_t l, const char* needle) {
+  size_t n = strlen(needle);
+  for (size_t i = 0; i + n <= l; i++) {
+    if (memcmp(b + i, needle, n) == 0) return b + i;
+  }
+  return nullptr;
+}
+
+// The header goes out in one write. Note its framing and, when the connection may
+// stay open, swap the core's "Connection: close" for keep-alive.
+size_t RoutedWebServer::writeHeader(const char* b, size_t l) {
+  headerSeen = true;
+  chunkedResponse = findIn(b, l, "\r\nTransfer-Encoding: chunked\r\n") != nullptr;
+  const char* cl = findIn(b, l, "\r\nContent-Length: ");
+  declaredLength = cl ? strtoll(cl + 18, nullptr, 10) : -1;
+
+  static const char CLOSE[] = "Connection: close\r\n";
+  const char* close = offerKeepAlive ? findIn(b, l, CLOSE) : nullptr;
+  size_t head = close ? close - b : 0;
+  size_t tail = close ? l - head - (sizeof(CLOSE) - 1) : 0;
+  char out[1024];
+  if (!close || head + 64 + tail > sizeof(out)) {
+    offerKeepAlive = false;  // Keep-alive not offered (or an unusually large header): close after it
+    chargeWrite(b, l);
+    return WebServer::_currentClientWrite(b, l);
+  }
+  memcpy(out, b, head);
+  size_t n = head + snprintf(out + head, 64, "Connection: keep-alive\r\nKeep-Alive: timeout=%lu, max=%u\r\n",
+                             WEB_KEEPALIVE_IDLE_MS / 1000, (unsigned)WEB_KEEPALIVE_MAX_REQUESTS);
+  memcpy(out + n, close + sizeof(CLOSE) - 1, tail);
+  n += tail;
+  chargeWrite(out, n);
+  return WebServer::_currentClientWrite(out, n) == n ? l : 0;
+}
+
+size_t RoutedWebServer::writeDeferred(const char* b, size_t l) {
+  if (deferred.size() + l > WEB_DEFER_MAX_BYTES) {
+    tableStats.deferOverflows++;
+    sendDeferred();                 // What was held goes first, then this and the rest directly
+    return _currentClientWrite(b, l);
+  }
+  if (!l) return 0;
+  size_t at = deferred.size();
+  deferred.resize(at + l);
+  memcpy(deferred.data() + at, b, l);   // Also for _P writes: flash is memory-mapped on the ESP32
+  deferredEnds.push_back((uint16_t)deferred.size());
+  return l;
+}
+
+void RoutedWebServer::deferResponse() {
+  deferring = true;
+  tableStats.deferred++;
+}
+
+// Replays the held writes as they were made, so the header is detected and rewritten
+// for keep-alive and every byte is charged to the route as if sent directly
+void RoutedWebServer::sendDeferred() {
+  if (!deferring) return;
+  deferring = false;
+  size_t start = 0;
+  for (uint16_t end : deferredEnds) {
+    _currentClientWrite(deferred.data() + start, end - start);
+    start = end;
+  }
+  deferred.clear();
+  deferredEnds.clear();
+  if (deferred.capacity() > 4096) {
+    std::vector<char>().swap(deferred);   // Don't keep the largest response's buffer
+    std::vector<uint16_t>().swap(deferredEnds);
+  }
+}
+
+size_t RoutedWebServer::_currentClientWrite(const char* b, size_t l) {
+  if (deferring) return writeDeferred(b, l);
+  if (!headerSeen && l > 12 && strncmp(b, "HTTP/1.", 7) == 0) return writeHeader(b, l);
+  bodyBytes += l;
+  chargeWrite(b, l);
+  return WebServer::_currentClientWrite(b, l);
+}
+
+#ifndef NATIVE_SIMULATION
+size_t RoutedWebServer::_currentClientWrite_P(PGM_P b, size_t l) {
+  if (deferring) return writeDeferred(b, l);
+  bodyBytes += l;      // The core writes headers from RAM; only bodies come from flash
+  chargeWrite(b, l);   // Flash is memory-mapped on the ESP32, so the header check can read it
+  return WebServer::_currentClientWrite_P(b, l);
+}
+#endif
+
+void RoutedWebServer::begin() {
+  static const char* keys[] = { "Connection" };
+  collectHeaders(keys, 1);
+  WebServer::begin();
+  connStats.sinceMs = millis();
+}
+
+// Applied by handleClient() between requests, so a handler can switch it
+void RoutedWebServer::setKeepAlive(bool enabled) {
+  wantKeepAlive = enabled;
+}
+
+void RoutedWebServer::applyKeepAlive() {
+  keepAliveEnabled = wantKeepAlive;
+  if (keepAliveEnabled) {
+    _currentClient = WiFiClient();  // Leave the core's state machine
+    _currentStatus = HC_NONE;
+    return;
+  }
+  for (Connection& c : pool) {
+    if (c.open) drop(c);
+  }
+}
+
+void RoutedWebServer::drop(Connection& c) {
+  c.client.stop();   // Only this copy: a file transfer holding the client keeps it open
+  c = Connection();
+}
+
+void RoutedWebServer::serve(Connection& c) {
+  _currentClient = c.client;
+  if (!_parseRequest(_currentClient)) {
+    connStats.badRequests++;
+    _currentClient = WiFiClient();
+    drop(c);
+    return;
+  }
+  connStats.requests++;
+  if (c.requests++) connStats.reused++;
+
+  bool clientClose = _currentVersion == 0 || strcasecmp(header("Connection").c_str(), "close") == 0;
+  bool atLimit = c.requests >= WEB_KEEPALIVE_MAX_REQUESTS;
+  offerKeepAlive = !clientClose && !atLimit && !crowded;
+  headerSeen = false;
+  chunkedResponse = false;
+  declaredLength = -1;
+  bodyBytes = 0;
+  _contentLength = CONTENT_LENGTH_NOT_SET;
+  _handleRequest();
+  sendDeferred();   // A handler that deferred and didn't send
+
+  bool framed = headerSeen && (chunkedResponse || (declaredLength >= 0 && bodyBytes == (uint64_t)declaredLength));
+  if (offerKeepAlive && framed && c.client.connected()) {
+    connStats.keptAlive++;
+    c.lastActiveMs = millis();
+  } else {
+    if (!framed) connStats.notFramed++;
+    else if (clientClose) connStats.clientClose++;
+    else if (atLimit) connStats.limitClose++;
+    else if (crowded) connStats.crowdedClose++;
+    drop(c);
+  }
+  offerKeepAlive = false;
+  headerSeen = false;
+  _currentClient = WiFiClient();
+}
+
+void RoutedWebServer::handleClient() {
+  serving = this;
+  if (wantKeepAlive != keepAliveEnabled) applyKeepAlive();
+  if (!keepAliveEnabled) {
+    WebServer::handleClient();
+    return;
+  }
+  unsigned long now = millis();
+
+  // Accept only when a slot can be had: a free one, or the least recently active
+  // kept-alive connection with no request waiting (a new connection's first request
+  // may still be in flight). Otherwise the client waits in the backlog.
+  Connection* slot = nullptr;
+  for (Connection& c : pool) {
+    if (!c.open) { slot = &c; break; }
+    if (!c.requests || c.client.available()) continue;
+    if (!slot || now - c.lastActiveMs > now - slot->lastActiveMs) slot = &c;
+  }
+  crowded = !slot && _server.hasClient();
+  if (slot) {
+    WiFiClient client = _server.available();
+    if (client) {
+      if (slot->open) {
+        connStats.evictions++;
+        drop(*slot);
+      }
+      connStats.accepted++;
+      slot->client = client;
+      slot->open = true;
+      slot->lastActiveMs = now;
+    }
+  }
+
+  // One request per call, round robin over the connections with one waiting
+  for (uint8_t i = 0; i < WEB_KEEPALIVE_POOL; i++) {
+    uint8_t s = (nextSlot + i) % WEB_KEEPALIVE_POOL;
+    if (pool[s].open && pool[s].client.available()) {
+      nextSlot = (s + 1) % WEB_KEEPALIVE_POOL;
+      serve(pool[s]);
+      break;
+    }
+  }
+
+  now = millis();
+  uint8_t open = 0;
+  for (Connection& c : pool) {
+    if (!c.open) continue;
+    if (!c.client.connected()) {
+      connStats.peerClosed++;
+      drop(c);
+      continue;
+    }
+    // A new connection gets the core's request timeout, a used one the idle timeout
+    unsigned long limit = c.requests ? WEB_KEEPALIVE_IDLE_MS : HTTP_MAX_DATA_WAIT;
+    if (now - c.lastActiveMs > limit && !c.client.available()) {
+      connStats.idleTimeouts++;
+      drop(c);
+      continue;
+    }
+    open++;
+  }
+  connStats.open = open;
+  if (open > connStats.maxOpen) connStats.maxOpen = open;
+}
+
+// The whole table as the server's single RequestHandler
+class RouteTableHandler : public RequestHandler {
+  public:
+    bool canHandle(HTTPMethod method, String uri) override {
+      int64_t startUs = esp_timer_get_time();
+      current = lookup(uri.c_str(), method);
+      tableStats.lookups++;
+      tableStats.lookupUs += esp_timer_get_time() - startUs;
+      statusSeen = false;
+      if (current < 0) tableStats.unmatched++;
+      return current >= 0;
+    }
+
+    bool canUpload(String /*uri*/) override {
+      return current >= 0 && uploadHandlers[current];
+    }
+
+    bool handle(WebServer& /*server*/, HTTPMethod /*requestMethod*/, String /*requestUri*/) override {
+      if (current < 0) return false;
+      int64_t startUs = esp_timer_get_time();
+      handlers[current]();
+      uint32_t us = (uint32_t)(esp_timer_get_time() - startUs);
+      traceComplete(TRACE_HTTP, routes[current].uri, startUs, us);
+      WebRouteStats& st = routes[current].stats;
+      st.requests++;
+      st.totalUs += us;
+      if (us > st.maxUs) st.maxUs = us;
+      uint8_t bucket = 0;
+      while (bucket < ROUTE_LATENCY_BUCKETS - 1 && us > ROUTE_LATENCY_BOUNDS_US[bucket]) bucket++;
+      st.histogram[bucket]++;
+      return true;
+    }
+
+    void upload(WebServer& /*server*/, String /*requestUri*/, HTTPUpload& upload) override {
+      if (current < 0 || !uploadHandlers[current]) return;
+      if (upload.status == UPLOAD_FILE_START) routes[current].stats.uploads++;
+      uploadHandlers[current]();
+    }
+};
+
+static RouteTableHandler tableHandler;
+
+void routeOn(WebServer& server, const char* uri, HTTPMethod method, WebServer::THandlerFunction handler,
+             WebServer::THandlerFunction uploadHandler) {
+  for (uint8_t i = 0; i < tableStats.routes; i++) {
+    WebRoute& r = routes[i];
+    if (strcmp(r.uri, uri) != 0) continue;
+    if (r.method == method || r.method == HTTP_ANY || method == HTTP_ANY) {
+      r.duplicates++;
+      tableStats.duplicates++;
+      Serial.printf("[ROUTES] Duplicate route %s %s ignored (already registered as %s)\n",
+                    routeMethodName(method), uri, routeMethodName(r.method));
+      return;
+    }
+  }
+  if (tableStats.routes >= MAX_WEB_ROUTES || strlen(uri) > MAX_ROUTE_URI) {
+    tableStats.overflow++;
+    Serial.printf("[ROUTES] Route table full, %s %s registered unmetered\n", routeMethodName(method), uri);
+    if (uploadHandler) server.on(uri, method, handler, uploadHandler);
+    else server.on(uri, method, handler);
+    return;
+  }
+  uint8_t i = tableStats.routes++;
+  routes[i] = WebRoute();
+  routes[i].uri = strdup(uri);
+  routes[i].method = method;
+  handlers[i] = handler;
+  uploadHandlers[i] = uploadHandler;
+  if (built) buildTrie();  // Late registration
+}
+
+void routesBegin(WebServer& server) {
+  if (built) return;
+  buildTrie();
+  server.addHandler(&tableHandler);
+  if (debugSerial) {
+    Serial.printf("[ROUTES] %u routes in %u trie nodes, %u duplicates ignored\n",
+                  (unsigned)tableStats.routes, (unsigned)tableStats.nodes, (unsigned)tableStats.duplicates);
+  }
+}
+
+uint8_t routeCount() {
+  return tableStats.routes;
+}
+
+const WebRoute& routeGet(uint8_t i) {
+  return routes[i < tableStats.routes ? i : 0];
+}
+
+const WebRouteTableStats& routeTableStats() {
+  return tableStats;
+}
+
+const char* routeMethodName(HTTPMethod method) {
+  switch (method) {
+    case HTTP_GET: return "GET";
+    case HTTP_HEAD: return "HEAD";
+    case HTTP_POST: return "POST";
+    case HTTP_PUT: return "PUT";
+    case HTTP_PATCH: return "PATCH";
+    case HTTP_DELETE: return "DELETE";
+    case HTTP_OPTIONS: return "OPTIONS";
+    case HTTP_ANY: return "ANY";
+    default: return "OTHER";
+  }
+}
+
+void routesResetStats() {
+  for (uint8_t i = 0; i < tableStats.routes; i++) routes[i].stats = WebRouteStats();
+  tableStats.lookups = 0;
+  tableStats.lookupUs = 0;
+  tableStats.unmatched = 0;
+  tableStats.deferred = 0;
+  tableStats.deferOverflows = 0;
+}
+
+void webResponseDefer() {
+  if (serving) serving->deferResponse();
+}
+
+void webResponseSend() {
+  if (serving) serving->sendDeferred();
+}
+
+const WebConnectionStats& webConnectionStats() {
+  return connStats;
+}
+
+void webConnectionResetStats() {
+  uint8_t open = connStats.open;
+  connStats = WebConnectionStats();
+  connStats.open = open;
+  connStats.maxOpen = open;
+  connStats.sinceMs = millis();
+}
@@ -0,0 +1,164 @@
+#pragma once
+#include <Arduino.h>
+#include <WebServer.h>
+#include <vector>
+
+// HTTP route table.
+// The core WebServer keeps one RequestHandler per server.on() in a linked list and,
+// for every request, walks it comparing String URIs until one matches - about 100
+// comparisons for the last route registered. Endpoints register with routeOn()
+// instead; routesBegin() builds a radix trie (route_trie.h) over the paths once at setup and installs
+// the table as the server's only handler, so a lookup is one walk down the trie and a
+// pick among the methods registered for that path.
+//
+// Registering a method+path that is already taken (or overlaps via HTTP_ANY) is a
+// duplicate: it is logged and ignored, so the first registration wins, as it did in
+// the list. Each route counts requests, response bytes (everything written through
+// the server, headers and chunk framing included), error statuses and a latency
+// histogram of its handler. Bodies streamed later from loop() by file_transfer.cpp
+// are not charged to the route; /api/file_transfers reports those.
+//
+// Keep-alive. The core answers every request with "Connection: close" and serves one
+// connection at a time, so each poll of /api/status paid a TCP handshake and, after
+// the response, up to HTTP_MAX_CLOSE_WAIT with no new client accepted. RoutedWebServer
+// replaces handleClient() with a bounded pool of WEB_KEEPALIVE_POOL connections: a
+// new connection takes a free slot (or the least recently active idle one), one
+// request is served per call, round robin over connections with data waiting, and a
+// connection idle for WEB_KEEPALIVE_IDLE_MS is closed. A response keeps its connection
+// only when it is framed - its body matched the Content-Length it declared, or it was
+// chunked (the core terminates those) - the request was HTTP/1.1 without
+// "Connection: close", the connection is under WEB_KEEPALIVE_MAX_REQUESTS, and the
+// pool isn't crowded: when every slot has a request waiting and another client is
+// waiting to connect, responses close their connection until a slot frees, so more
+// pollers than slots share the server instead of the first four keeping it. The
+// header write is rewritten from "Connection: close" to keep-alive when it is kept.
+// Responses whose body goes out on client() directly (file_transfer.cpp, streamFile)
+// don't match their Content-Length and are closed as before.
+//
+// Deferred responses. A handler that runs under the control lock shouldn't wait on a
+// slow client's socket with the lock held. webResponseDefer() makes the server keep
+// what the handler writes in RAM, one segment per write so the header is still seen
+// on its own, and webResponseSend() writes it out later through the same path, so
+// byte counts and keep-alive framing are unchanged. A response that outgrows
+// WEB_DEFER_MAX_BYTES is sent as far as it got and the rest goes out directly.
+
+constexpr uint8_t MAX_WEB_ROUTES = 128;        // Further routes fall back to server.on(), unmetered
+constexpr uint8_t ROUTE_LATENCY_BUCKETS = 10;
+extern const uint32_t ROUTE_LATENCY_BOUNDS_US[ROUTE_LATENCY_BUCKETS - 1];   // Upper bounds; last bucket is open
+
+constexpr uint8_t WEB_KEEPALIVE_POOL = 4;                // Open connections (lwIP allows 16 sockets in all)
+constexpr unsigned long WEB_KEEPALIVE_IDLE_MS = 5000;    // Idle connection closed after this
+constexpr uint16_t WEB_KEEPALIVE_MAX_REQUESTS = 100;     // Then the connection is closed after the response
+constexpr size_t WEB_DEFER_MAX_BYTES = 16384;            // Largest deferred response held in RAM
+
+struct WebRouteStats {
+  uint32_t requests = 0;
+  uint64_t bytesOut = 0;
+  uint32_t errors = 0;            // Status 400 and above
+  uint32_t uploads = 0;           // Multipart file uploads received
+  uint64_t totalUs = 0;
+  uint32_t maxUs = 0;
+  uint32_t histogram[ROUTE_LATENCY_BUCKETS] = {};
+};
+
+struct WebRoute {
+  const char* uri = nullptr;
+  HTTPMethod method = HTTP_ANY;
+  uint16_t duplicates = 0;        // Later registrations of the same method+path that were ignored
+  WebRouteStats stats;
+};
+
+struct WebRouteTableStats {
+  uint16_t routes = 0;
+  uint16_t nodes = 0;             // Trie nodes, root included
+  uint16_t duplicates = 0;
+  uint16_t overflow = 0;          // Registered with server.on() because the table was full
+  uint32_t lookups = 0;
+  uint64_t lookupUs = 0;
+  uint32_t unmatched = 0;         // Requests no route accepted (onNotFound / 404)
+  uint32_t deferred = 0;          // Responses held back and sent after the handler (webResponseDefer)
+  uint32_t deferOverflows = 0;    // Deferred responses that outgrew WEB_DEFER_MAX_BYTES
+};
+
+// Counted while keep-alive is on
+struct WebConnectionStats {
+  uint32_t accepted = 0;          // New TCP connections
+  uint32_t requests = 0;
+  uint32_t reused = 0;            // Requests on a connection that had already served one
+  uint32_t keptAlive = 0;         // Responses that left their connection open
+  uint32_t notFramed = 0;         // Closed: body didn't match its Content-Length (or nothing was sent)
+  uint32_t clientClose = 0;       // Closed: HTTP/1.0 or "Connection: close" request
+  uint32_t limitClose = 0;        // Closed: WEB_KEEPALIVE_MAX_REQUESTS reached
+  uint32_t crowdedClose = 0;      // Closed: pool full and another client waiting to connect
+  uint32_t peerClosed = 0;        // Client closed an open connection
+  uint32_t idleTimeouts = 0;
+  uint32_t evictions = 0;         // Idle connection closed to make room for a new one
+  uint32_t badRequests = 0;       // Request unreadable, connection dropped
+  uint8_t open = 0;
+  uint8_t maxOpen = 0;
+  unsigned long sinceMs = 0;      // Start of the counting window, for rates
+};
+
+// WebServer that counts the bytes each response writes, for the route table, and
+// keeps connections alive (see above)
+class RoutedWebServer : public WebServer {
+  public:
+    RoutedWebServer(int port = 80) : WebServer(port) {}
+
+    void begin();                 // Also collects the Connection request header
+    void handleClient();
+    void setKeepAlive(bool enabled);   // Off: the core's handleClient(), one request per connection
+    bool keepAlive() const { return wantKeepAlive; }
+    void deferResponse();         // Hold this request's output until sendDeferred()
+    void sendDeferred();
+
+  protected:
+    size_t _currentClientWrite(const char* b, size_t l) override;
+#ifndef NATIVE_SIMULATION
+    size_t _currentClientWrite_P(PGM_P b, size_t l) override;
+#endif
+
+  private:
+    struct Connection {
+      WiFiClient client;
+      bool open = false;
+      unsigned long lastActiveMs = 0;
+      uint16_t requests = 0;
+    };
+
+    void serve(Connection& c);
+    void drop(Connection& c);
+    void applyKeepAlive();
+    size_t writeHeader(const char* b, size_t l);
+    size_t writeDeferred(const char* b, size_t l);
+
+    Connection pool[WEB_KEEPALIVE_POOL];
+    uint8_t nextSlot = 0;
+    bool keepAliveEnabled = true;
+    bool wantKeepAlive = true;
+    bool offerKeepAlive = false;  // Current response may keep its connection
+    bool crowded = false;         // Every slot busy and a client waiting to connect
+    bool deferring = false;
+    std::vector<char> deferred;             // Output held by deferResponse()
+    std::vector<uint16_t> deferredEnds;     // End offset of each write in it
+};
+
+// Adds a route; duplicates are logged and ignored
+void routeOn(WebServer& server, const char* uri, HTTPMethod method, WebServer::THandlerFunction handler,
+             WebServer::THandlerFunction uploadHandler = nullptr);
+
+// Builds the trie and installs the table on the server (call once, after the last routeOn)
+void routesBegin(WebServer& server);
+
+uint8_t routeCount();
+const WebRoute& routeGet(uint8_t i);
+const WebRouteTableStats& routeTableStats();
+const char* routeMethodName(HTTPMethod method);
+void routesResetStats();
+
+// Defer / send the response of the request being handled (see above); no-ops outside a request
+void webResponseDefer();
+void webResponseSend();
+
+const WebConnectionStats& webConnectionStats();
+void webConnectionResetStats();
@@ -1,8 +1,10 @@
 #include "wifi_manager.h"
-#include <FFat.h>           // Use FATFS instead of LittleFS
+#include "storage_backend.h"  // Filesystem backend
 #include <ArduinoJson.h>
 #include <WiFi.h>           // ESP32 WiFi library
 #include <WiFiManager.h>    // tzapu WiFiManager library
+#include "persistence_manager.h"
+#include "storage_stats.h"
 
 // External variables
 extern bool debugSerial;
@@ -11,7 +13,7 @@ const byte DNS_PORT = 53;
 const char* WIFI_FILE = "/wifi.json";
 
 bool loadWiFiCreds(String &ssid, String &pass) {
-  File f = FFat.open(WIFI_FILE, "r");
+  File f = storageFS().open(WIFI_FILE, "r");
   if (!f) return false;
   DynamicJsonDocument doc(256);
   if (deserializeJson(doc, f)) { f.close(); return false; }
@@ -74,7 +76,7 @@ void startWiFiManagerPortal() {
     doc["ssid"] = ssid;
     doc["pass"] = pass;
     
-    File f = FFat.open(WIFI_FILE, "w");
+    StorageFile f = storageOpen(WIFI_FILE, "w", "wifi");
     if (f) {
       serializeJson(doc, f);
       f.close();
@@ -86,6 +88,7 @@ void startWiFiManagerPortal() {
       Serial.println("[WiFi] Device will restart...");
     }
     delay(3000);
+    persistFlushAll();
     ESP.restart();
   }
 }